@@ -69,44 +69,31 @@ static void lcd_print_line16(uint8_t row, const char* s, size_t len)
     lcd1602rgb_draw_text(0, row, tmp);
 }
 
-static inline void tail16_push_(char* buf, size_t* len_io, char c)
-{
-    if (*len_io < 16) {
-        buf[*len_io] = c;
-        (*len_io)++;
-        return;
-    }
-    memmove(buf, buf + 1, 15);
-    buf[15] = c;
-}
-
 static void drain_log_stream_to_lcd_(void)
 {
-    static char   tail[16];
-    static size_t tail_len = 0;
-
-    for (;;) {
+    // Rekord = cała linia; na LCD idzie ostatnie 16 znaków ostatniej linii,
+    // wcześniejsze są tylko przeskakiwane (bez kopiowania i szukania '\n').
+    char   tail[16];
+    size_t tail_len = 0;
+    bool   any = false;
+
+    // Do pustego ringu i ponowne uzbrojenie dzwonka: kolejne EV_LOG_READY
+    // przyjdzie dopiero z pierwszą linią po tym miejscu (raz na paczkę).
+    do {
         size_t n = 0;
-        const uint8_t* p = infra_log_stream_peek(&n);
-        if (!p || n == 0) break;
-
-        for (size_t i = 0; i < n; ++i) {
-            const char c = (char)p[i];
-            if (c == '\n') {
-                char tmp[17];
-                memcpy(tmp, tail, tail_len);
-                tmp[tail_len] = '\0';
-                // Wyświetlamy logi w wierszu ROW_LOGS (0)
-                lcd_print_line16(ROW_LOGS, tmp, tail_len);
-                lcd1602rgb_request_flush();
-                tail_len = 0;
-                continue;
-            }
-
-            if (c == '\r') continue;
-            tail16_push_(tail, &tail_len, c);
+        const uint8_t* rec;
+        while ((rec = infra_log_stream_peek_record(&n)) != NULL) {
+            tail_len = n > sizeof(tail) ? sizeof(tail) : n;
+            memcpy(tail, rec + (n - tail_len), tail_len);
+            infra_log_stream_consume_record();
+            any = true;
         }
-        infra_log_stream_consume(n);
+    } while (!infra_log_stream_arm_ready());
+
+    if (any) {
+        // Wyświetlamy logi w wierszu ROW_LOGS (0)
+        lcd_print_line16(ROW_LOGS, tail, tail_len);
+        lcd1602rgb_request_flush();
     }
 }
 
@@ -127,7 +114,9 @@ static void app_demo_lcd_task(void* arg)
     ev_msg_t m;
 
     for (;;) {
-        if (xQueueReceive(q, &m, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        if (!ev_bus_recv(s_evb, q, &m, pdMS_TO_TICKS(1000))) {
+            // Asekuracja: EV_LOG_READY zgubione przy pełnej kolejce nie zatrzyma ogona logów.
+            drain_log_stream_to_lcd_();
             wdt_reset(); 
             continue;
         }
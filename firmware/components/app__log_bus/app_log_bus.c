@@ -12,57 +12,26 @@ static const char* TAG = "APP_LOG_BUS";
 // Poprzedni vprintf z IDF / własnej infrastruktury – wołamy go, by nie psuć konsoli i ringa
 static int (*s_prev_vprintf)(const char *fmt, va_list) = NULL;
 
-// Bufor akumulujący znaki do końca linii (prosty FIFO ogon)
-static portMUX_TYPE s_log_mux = portMUX_INITIALIZER_UNLOCKED;
-#define ACC_CAP 512
-static char   s_acc[ACC_CAP];
-static size_t s_acc_len = 0;
-
 static const ev_bus_t* s_evb = NULL;
 
-static void logbus_flush_line_locked(void)
+static void logbus_publish_line(const char* line, size_t len)
 {
-    size_t len = s_acc_len;
-    if (len == 0) return;
-
     // Usuń opcjonalne '\r' na końcu
-    if (len > 0 && s_acc[len - 1] == '\r') {
+    if (len > 0 && line[len - 1] == '\r') {
         len--;
     }
 
-    // STREAM: zapis do SPSC ring-buffer (bez alokacji) + lekka notyfikacja READY.
-    // Jeżeli bufor jest pełny, dropujemy linię – kolejny READY i tak pozwoli konsumentowi nadrobić.
-    const size_t free = infra_log_stream_capacity() - infra_log_stream_used();
-    if (free >= (len + 1u)) {
-        bool ok = infra_log_stream_write_all(s_acc, len);
-        if (ok) {
-            const char nl = '\n';
-            ok = infra_log_stream_write_all(&nl, 1u);
-        }
-        if (ok) {
-            (void)ev_bus_post(s_evb, EV_SRC_LOG, EV_LOG_READY, 0, 0);
-        }
+    // STREAM: linia = jeden rekord w MPSC ringu (bez alokacji i blokady). READY tylko, gdy
+    // konsument uzbroił dzwonek (opróżnił ring) — jeden broadcast na paczkę linii, nie na linię.
+    // Za długa linia traci początek; pełny ring -> drop linii.
+    const size_t max = infra_log_stream_record_max();
+    if (len > max) {
+        line += len - max;
+        len = max;
     }
-    s_acc_len = 0;
-}
-
-static void logbus_append_chunk_locked(const char* chunk, size_t n)
-{
-    for (size_t i = 0; i < n; ++i) {
-        char c = chunk[i];
-        if (c == '\n') {
-            // kończymy linię i publikujemy
-            logbus_flush_line_locked();
-        } else {
-            if (s_acc_len < ACC_CAP) {
-                s_acc[s_acc_len++] = c;
-            } else {
-                // proste "drop-head": przesuwamy o 1, żeby zachować ogon linii
-                memmove(s_acc, s_acc + 1, ACC_CAP - 1);
-                s_acc[ACC_CAP - 1] = c;
-                // s_acc_len pozostaje == ACC_CAP
-            }
-        }
+    bool ready = false;
+    if (len > 0 && infra_log_stream_write_record(line, len, &ready) && ready) {
+        (void)ev_bus_post(s_evb, EV_SRC_LOG, EV_LOG_READY, 0, 0);
     }
 }
 
@@ -77,14 +46,22 @@ static int logbus_vprintf(const char* fmt, va_list ap)
         va_end(ap_fwd);
     }
 
-    // 2) sformatuj do bufora tymczasowego i dołóż do akumulatora linii
+    // 2) sformatuj na stosie wołającego i publikuj linie bez wspólnego akumulatora:
+    //    ring jest MPSC, więc taski/rdzenie logują równolegle. Wywołanie bez '\n' na końcu
+    //    (rzadkie w ESP_LOGx) daje osobny rekord zamiast sklejania z następnym.
     char tmp[256];
     int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
     if (n > 0) {
-        // Chronimy tylko akumulator (enqueue na busie jest nieblokujące)
-        portENTER_CRITICAL(&s_log_mux);
-        logbus_append_chunk_locked(tmp, (size_t)n);
-        portEXIT_CRITICAL(&s_log_mux);
+        size_t len = (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1u;
+        const char* p = tmp;
+        while (len > 0) {
+            const char* nl = memchr(p, '\n', len);
+            const size_t line = nl ? (size_t)(nl - p) : len;
+            logbus_publish_line(p, line);
+            if (!nl) break;
+            p   += line + 1u;
+            len -= line + 1u;
+        }
     }
     return ret;
 }
@@ -97,6 +74,6 @@ bool app_log_bus_start(const ev_bus_t* bus)
     infra_log_stream_init();
     // Wrapujemy aktualny vprintf
     s_prev_vprintf = esp_log_set_vprintf(logbus_vprintf);
-    LOGI(TAG, "Log-bus ready: vprintf wrapped -> EV_LOG_READY (STREAM, SPSC ring, newline-delimited).");
+    LOGI(TAG, "Log-bus ready: vprintf wrapped -> EV_LOG_READY (STREAM, MPSC ring, one record per line).");
     return true;
 }
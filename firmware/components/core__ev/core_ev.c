@@ -29,9 +29,15 @@
 
 typedef struct {
     ev_queue_t q;
+    ev_queue_t lane;   /* pas priorytetowy (EVF_CRITICAL), NULL gdy wyłączony */
+    QueueSetHandle_t set; /* != NULL: q i pas są w QueueSet (bez dzwonków, ev_recv_set()) */
     uint16_t   depth;
 } ev_sub_t;
 
+/* Dzwonek pasa priorytetowego: budzi konsumenta śpiącego na kolejce głównej.
+ * Nigdy nie wychodzi z ev_recv*(); surowy xQueueReceive() zobaczy src=EV_SRC_NONE. */
+#define EV_LANE_DOORBELL_CODE 0xFFFFu
+
 static ev_sub_t  s_subs[EV_MAX_SUBS];
 static uint16_t  s_subs_cnt;
 static uint16_t  s_q_depth_max;
@@ -39,6 +45,19 @@ static uint16_t  s_q_depth_max;
 static uint32_t  s_posts_ok;
 static uint32_t  s_posts_drop;
 static uint32_t  s_enq_fail;
+static uint32_t  s_expired;
+static uint32_t  s_lost;
+static uint32_t  s_lane_delivered;
+static uint32_t  s_lane_full;
+
+/* Migawki s_subs używane poza sekcją krytyczną (nadawcy, odczyt pasu w ev_recv*()) są
+ * liczone w dwóch epokach. ev_unsubscribe() przełącza epokę i czeka, aż stara opadnie do
+ * zera — nowe migawki widzą już pusty slot, więc nikt nie trzyma wypiętej kolejki ani pasu.
+ * Wypięcia są szeregowane (s_unsub_busy od przełączenia do końca czekania): drugie
+ * przełączenie w trakcie czekania wrzuciłoby nowe migawki z powrotem do starej epoki. */
+static uint32_t  s_snap_users[2];
+static uint8_t   s_snap_epoch;
+static bool      s_unsub_busy;
 
 #if defined(portMUX_INITIALIZER_UNLOCKED)
 static portMUX_TYPE s_ev_mux = portMUX_INITIALIZER_UNLOCKED;
@@ -83,8 +102,8 @@ static const char* ev_qos_str_(ev_qos_t qos)
 /* ===================== SCHEMA ===================== */
 
 static const ev_meta_t s_ev_meta[] = {
-#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, DOC) \
-    { .src = (SRC), .code = (CODE), .kind = EVK_##KIND, .qos = EVQ_##QOS, .flags = (uint16_t)(FLAGS), .name = #NAME, .doc = (DOC) },
+#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, TTL_MS, DOC) \
+    { .src = (SRC), .code = (CODE), .kind = EVK_##KIND, .qos = EVQ_##QOS, .flags = (uint16_t)(FLAGS), .ttl_ms = (uint16_t)(TTL_MS), .name = #NAME, .doc = (DOC) },
     EV_SCHEMA(X)
 #undef X
 };
@@ -97,6 +116,39 @@ static uint32_t s_ev_posts_ok[EV_META_LEN];
 static uint32_t s_ev_posts_drop[EV_META_LEN];
 static uint32_t s_ev_enq_fail[EV_META_LEN];
 static uint32_t s_ev_delivered[EV_META_LEN];
+static uint32_t s_ev_expired[EV_META_LEN];
+static uint32_t s_ev_lost[EV_META_LEN];
+
+/* Numeracja per-event: nadawana przy post (0 = brak numeru). */
+static uint32_t s_ev_seq[EV_META_LEN];
+
+/* Okno zaległych luk za last_seq: bit k = seq (last_seq - 1 - k) policzony jako strata. */
+#define EV_RX_MISS_WINDOW 32u
+
+/* Stan odbiorcy per-subskrybent: ostatni widziany seq per-event, jego luki + liczniki. */
+typedef struct {
+    uint32_t last_seq[EV_META_LEN];
+    uint32_t miss[EV_META_LEN];
+    uint32_t received;
+    uint32_t lost;
+    uint32_t expired;
+} ev_sub_rx_t;
+
+static ev_sub_rx_t s_sub_rx[EV_MAX_SUBS];
+
+static inline size_t ev_meta_idx_(const ev_meta_t* meta)
+{
+    return meta ? (size_t)(meta - s_ev_meta) : (size_t)-1;
+}
+
+/* Wołane w sekcji krytycznej (EV_CS_*). */
+static inline uint32_t ev_seq_next_locked_(size_t idx)
+{
+    if (idx == (size_t)-1) return 0;
+    uint32_t v = ++s_ev_seq[idx];
+    if (v == 0) v = ++s_ev_seq[idx];  // 0 zarezerwowane dla "brak numeru"
+    return v;
+}
 
 const ev_meta_t* ev_meta_find(ev_src_t src, uint16_t code)
 {
@@ -263,16 +315,81 @@ static void ev_schema_selftest_or_abort_(void)
 
 /* ====== BUS LOGIC ====== */
 
+/* Wołane w sekcji krytycznej (EV_CS_*). */
+static inline uint8_t ev_snap_enter_locked_(void)
+{
+    const uint8_t e = s_snap_epoch;
+    s_snap_users[e]++;
+    return e;
+}
+
+static inline void ev_snap_exit_locked_(uint8_t e)
+{
+    s_snap_users[e]--;
+}
+
 typedef struct {
     uint16_t delivered;
     uint16_t enq_fail;
+    uint16_t lane;       /* ile z delivered poszło pasem priorytetowym */
+    uint16_t lane_full;  /* ile razy pas był pełny (degradacja do kolejki głównej) */
+    uint8_t  snap;       /* epoka migawki s_subs — zwalniana przy księgowaniu */
 } ev_fanout_t;
 
-static ev_fanout_t ev_broadcast(const ev_msg_t* m, ev_qos_t qos)
+static const ev_msg_t s_lane_doorbell = { .src = EV_SRC_NONE, .code = EV_LANE_DOORBELL_CODE };
+
+/* Pas priorytetowy obsługuje zdarzenia EVF_CRITICAL z QoS DROP_NEW
+ * (REPLACE_LAST ma już semantykę "najnowsza wartość" na kolejce depth=1). */
+static inline bool ev_use_lane_(const ev_meta_t* meta)
+{
+#if EV_PRIO_LANE_DEPTH > 0
+    return meta && ((meta->flags & EVF_CRITICAL) != 0) && meta->qos == EVQ_DROP_NEW;
+#else
+    (void)meta;
+    return false;
+#endif
+}
+
+/* Doręczenie do jednego subskrybenta (kontekst taska). */
+static BaseType_t ev_send_one_(const ev_sub_t* sub, const ev_msg_t* m, ev_qos_t qos, bool lane, ev_fanout_t* r)
+{
+    if (lane && sub->lane) {
+        if (xQueueSend(sub->lane, m, 0) == pdTRUE) {
+            // Dzwonek tylko gdy kolejka główna jest pusta (konsument może na niej spać).
+            // Niepusta kolejka = konsument i tak wróci do ev_recv(), który najpierw czyta pas.
+            // Subskrybenta na QueueSet budzi token pasu — dzwonek byłby elementem bez odbiorcy.
+            if (!sub->set && uxQueueMessagesWaiting(sub->q) == 0) (void)xQueueSend(sub->q, &s_lane_doorbell, 0);
+            r->lane++;
+            return pdTRUE;
+        }
+        r->lane_full++;
+    }
+    if (qos == EVQ_REPLACE_LAST && sub->depth == 1) return xQueueOverwrite(sub->q, m);
+    return xQueueSend(sub->q, m, 0);
+}
+
+static BaseType_t ev_send_one_isr_(const ev_sub_t* sub, const ev_msg_t* m, ev_qos_t qos, bool lane, ev_fanout_t* r, BaseType_t* hpw)
+{
+    if (lane && sub->lane) {
+        if (xQueueSendFromISR(sub->lane, m, hpw) == pdTRUE) {
+            if (!sub->set && uxQueueMessagesWaitingFromISR(sub->q) == 0) (void)xQueueSendFromISR(sub->q, &s_lane_doorbell, hpw);
+            r->lane++;
+            return pdTRUE;
+        }
+        r->lane_full++;
+    }
+    if (qos == EVQ_REPLACE_LAST && sub->depth == 1) return xQueueOverwriteFromISR(sub->q, m, hpw);
+    return xQueueSendFromISR(sub->q, m, hpw);
+}
+
+static ev_fanout_t ev_broadcast(ev_msg_t* m, const ev_meta_t* meta, ev_qos_t qos)
 {
     ev_fanout_t r = {0};
+    const bool lane = ev_use_lane_(meta);
 
     EV_CS_ENTER();
+    m->seq = ev_seq_next_locked_(ev_meta_idx_(meta));
+    r.snap = ev_snap_enter_locked_();
     uint16_t n = s_subs_cnt;
     ev_sub_t local[EV_MAX_SUBS];
     if (n > EV_MAX_SUBS) n = EV_MAX_SUBS;
@@ -282,43 +399,66 @@ static ev_fanout_t ev_broadcast(const ev_msg_t* m, ev_qos_t qos)
     for (uint16_t i = 0; i < n; ++i) {
         if (local[i].q == NULL) continue;
 
-        BaseType_t ok = pdFALSE;
-        if (qos == EVQ_REPLACE_LAST && local[i].depth == 1) {
-            ok = xQueueOverwrite(local[i].q, m);
-        } else {
-            ok = xQueueSend(local[i].q, m, 0);
-        }
-
-        if (ok == pdTRUE) r.delivered++;
-        else              r.enq_fail++;
+        if (ev_send_one_(&local[i], m, qos, lane, &r) == pdTRUE) r.delivered++;
+        else                                                    r.enq_fail++;
     }
     return r;
 }
 
-static ev_fanout_t ev_broadcast_lease(const ev_msg_t* m, lp_handle_t h)
+/* Referencje rozliczane zbiorczo: jedna addref na wszystkich aktywnych subskrybentów przed
+ * wysyłką (odbiorca może zwolnić od razu) i jedno lp_release_ref_n() na końcu — nieudane
+ * enqueue + referencja producenta. Zużywa referencję producenta. */
+static ev_fanout_t ev_broadcast_lease(ev_msg_t* m, const ev_meta_t* meta, lp_handle_t h)
 {
     ev_fanout_t r = {0};
     ev_sub_t local[EV_MAX_SUBS] = { 0 };
-    uint16_t n = 0;
+    uint16_t n = 0, active = 0;
+    const bool lane = ev_use_lane_(meta);
 
     EV_CS_ENTER();
+    m->seq = ev_seq_next_locked_(ev_meta_idx_(meta));
+    r.snap = ev_snap_enter_locked_();
     n = s_subs_cnt;
-    for (uint16_t i = 0; i < n && i < EV_MAX_SUBS; ++i) local[i] = s_subs[i];
+    if (n > EV_MAX_SUBS) n = EV_MAX_SUBS;
+    for (uint16_t i = 0; i < n; ++i) {
+        local[i] = s_subs[i];
+        if (local[i].q != NULL) active++;
+    }
     EV_CS_EXIT();
 
-    for (uint16_t i = 0; i < n && i < EV_MAX_SUBS; ++i) {
+    lp_addref_n(h, active);
+
+    for (uint16_t i = 0; i < n; ++i) {
         if (local[i].q == NULL) continue;
-        lp_addref_n(h, 1);
-        if (xQueueSend(local[i].q, m, 0) == pdTRUE) {
-            r.delivered++;
-            continue;
-        }
-        r.enq_fail++;
-        lp_release(h);
+        if (ev_send_one_(&local[i], m, EVQ_DROP_NEW, lane, &r) == pdTRUE) r.delivered++;
+        else                                                               r.enq_fail++;
     }
+
+    lp_release_ref_n(h, (uint16_t)(r.enq_fail + 1u));
     return r;
 }
 
+/* Wołane w sekcji krytycznej (EV_CS_*). */
+static inline void ev_account_fanout_locked_(size_t idx, const ev_fanout_t* fo)
+{
+    s_lane_delivered += fo->lane;
+    s_lane_full      += fo->lane_full;
+    if (fo->enq_fail) {
+        s_enq_fail += fo->enq_fail;
+        if (idx != (size_t)-1) s_ev_enq_fail[idx] += (uint32_t)fo->enq_fail;
+    }
+    if (fo->delivered > 0) {
+        s_posts_ok++;
+        if (idx != (size_t)-1) {
+            s_ev_posts_ok[idx]++;
+            s_ev_delivered[idx] += (uint32_t)fo->delivered;
+        }
+    } else {
+        s_posts_drop++;
+        if (idx != (size_t)-1) s_ev_posts_drop[idx]++;
+    }
+}
+
 /* ====== PUBLIC API ====== */
 
 void ev_init(void)
@@ -330,11 +470,19 @@ void ev_init(void)
     s_posts_ok    = 0;
     s_posts_drop  = 0;
     s_enq_fail    = 0;
+    s_expired     = 0;
+    s_lost        = 0;
+    s_lane_delivered = 0;
+    s_lane_full      = 0;
     
     memset(s_ev_posts_ok,   0, sizeof(s_ev_posts_ok));
     memset(s_ev_posts_drop, 0, sizeof(s_ev_posts_drop));
     memset(s_ev_enq_fail,   0, sizeof(s_ev_enq_fail));
     memset(s_ev_delivered,  0, sizeof(s_ev_delivered));
+    memset(s_ev_expired,    0, sizeof(s_ev_expired));
+    memset(s_ev_lost,       0, sizeof(s_ev_lost));
+    memset(s_ev_seq,        0, sizeof(s_ev_seq));
+    memset(s_sub_rx,        0, sizeof(s_sub_rx));
     EV_CS_EXIT();
 
 #if defined(CONFIG_CORE_EV_SCHEMA_SELFTEST_ON_BOOT) && CONFIG_CORE_EV_SCHEMA_SELFTEST_ON_BOOT
@@ -342,40 +490,147 @@ void ev_init(void)
 #endif
 }
 
-bool ev_subscribe(ev_queue_t* out_q, size_t depth)
+static void ev_sub_queues_delete_(ev_queue_t q, ev_queue_t lane, QueueSetHandle_t set)
+{
+    if (set) {
+        if (lane) (void)xQueueRemoveFromSet(lane, set);
+        (void)xQueueRemoveFromSet(q, set);
+    }
+    if (lane) vQueueDelete(lane);
+    vQueueDelete(q);
+}
+
+static bool ev_subscribe_(ev_queue_t* out_q, size_t depth, QueueSetHandle_t set)
 {
     if (!out_q) return false;
     if (depth == 0) depth = 8;
     ev_queue_t q = xQueueCreate((UBaseType_t)depth, sizeof(ev_msg_t));
     if (q == NULL) return false;
+    ev_queue_t lane = NULL;
+#if EV_PRIO_LANE_DEPTH > 0
+    lane = xQueueCreate((UBaseType_t)EV_PRIO_LANE_DEPTH, sizeof(ev_msg_t));
+    if (lane == NULL) { vQueueDelete(q); return false; }
+#endif
+    // Do zbioru przed podpięciem do busa: xQueueAddToSet() wymaga pustych kolejek.
+    if (set) {
+        if (xQueueAddToSet(q, set) != pdPASS) {
+            ev_sub_queues_delete_(q, lane, NULL);
+            return false;
+        }
+        if (lane && xQueueAddToSet(lane, set) != pdPASS) {
+            (void)xQueueRemoveFromSet(q, set);
+            ev_sub_queues_delete_(q, lane, NULL);
+            return false;
+        }
+    }
     bool attached = false;
     EV_CS_ENTER();
     if (s_subs_cnt < EV_MAX_SUBS) {
         s_subs[s_subs_cnt].q     = q;
+        s_subs[s_subs_cnt].lane  = lane;
+        s_subs[s_subs_cnt].set   = set;
         s_subs[s_subs_cnt].depth = (uint16_t)depth;
+        memset(&s_sub_rx[s_subs_cnt], 0, sizeof(s_sub_rx[0]));
         s_subs_cnt++;
         if (depth > s_q_depth_max) s_q_depth_max = (uint16_t)depth;
         attached = true;
     }
     EV_CS_EXIT();
-    if (!attached) { vQueueDelete(q); return false; }
+    if (!attached) {
+        ev_sub_queues_delete_(q, lane, set);
+        return false;
+    }
     *out_q = q;
     return true;
 }
 
+bool ev_subscribe(ev_queue_t* out_q, size_t depth)
+{
+    return ev_subscribe_(out_q, depth, NULL);
+}
+
+bool ev_subscribe_set(ev_queue_t* out_q, size_t depth, QueueSetHandle_t set)
+{
+    if (!set) return false;
+    return ev_subscribe_(out_q, depth, set);
+}
+
+/* Pas wypięty z busa (nikt nie trzyma migawki): oddajemy referencje LEASE, które w nim
+ * utknęły (partiami), i usuwamy go. */
+static void ev_lane_drain_delete_(ev_queue_t lane, QueueSetHandle_t set)
+{
+    ev_msg_t m;
+    lp_handle_t hs[8];
+    size_t nh = 0;
+    while (xQueueReceive(lane, &m, 0) == pdTRUE) {
+        const ev_meta_t* meta = ev_meta_find(m.src, m.code);
+        if (!meta || meta->kind != EVK_LEASE) continue;
+        hs[nh++] = lp_unpack_handle_u32(m.a0);
+        if (nh == sizeof(hs) / sizeof(hs[0])) {
+            lp_release_n(hs, nh);
+            nh = 0;
+        }
+    }
+    lp_release_n(hs, nh);
+    if (set) (void)xQueueRemoveFromSet(lane, set);
+    vQueueDelete(lane);
+}
+
 bool ev_unsubscribe(ev_queue_t q)
 {
     if (!q) return false;
     bool found = false;
+    ev_queue_t lane = NULL;
+    QueueSetHandle_t set = NULL;
+    uint8_t old = 0;
+
+    // Tylko jedno wypięcie naraz: czekanie na starą epokę jest poprawne, dopóki nikt
+    // nie przełączy jej ponownie (patrz s_unsub_busy).
+    for (;;) {
+        EV_CS_ENTER();
+        const bool busy = s_unsub_busy;
+        s_unsub_busy = true;
+        EV_CS_EXIT();
+        if (!busy) break;
+        vTaskDelay(1);
+    }
+
     EV_CS_ENTER();
     for (uint16_t i = 0; i < s_subs_cnt; ++i) {
         if (s_subs[i].q == q) {
             s_subs[i].q = NULL;
+            lane = s_subs[i].lane;
+            s_subs[i].lane = NULL;
+            s_subs[i].set  = NULL;
             found = true;
             break;
         }
     }
+    if (found) {
+        old = s_snap_epoch;
+        s_snap_epoch ^= 1u;
+    } else {
+        s_unsub_busy = false;
+    }
     EV_CS_EXIT();
+    if (!found) return false;
+
+    // Migawki sprzed wypięcia (broadcast/ISR w locie, odczyt pasu) mogą jeszcze pisać do q
+    // i pasu. Nowe trafiają do drugiej epoki, a do końca czekania nikt jej nie przełączy,
+    // więc stara tylko maleje.
+    for (;;) {
+        EV_CS_ENTER();
+        const uint32_t users = s_snap_users[old];
+        EV_CS_EXIT();
+        if (users == 0) break;
+        vTaskDelay(1);
+    }
+    EV_CS_ENTER();
+    s_unsub_busy = false;
+    EV_CS_EXIT();
+
+    // Pas należy do busa; drenaż jest teraz ostateczny (spóźniony LEASE już nie dojdzie).
+    if (lane) ev_lane_drain_delete_(lane, set);
     return found;
 }
 
@@ -390,27 +645,15 @@ bool ev_post(ev_src_t src, uint16_t code, uint32_t a0, uint32_t a1)
     meta = ev_meta_find(src, code);
 #endif
 
-    const size_t idx = (meta ? (size_t)(meta - s_ev_meta) : (size_t)-1);
+    const size_t idx = ev_meta_idx_(meta);
     const ev_qos_t qos = (meta ? meta->qos : EVQ_DROP_NEW);
 
     ev_msg_t m = { .src=src, .code=code, .a0=a0, .a1=a1, .t_ms=now_ms() };
-    const ev_fanout_t fo = ev_broadcast(&m, qos);
+    const ev_fanout_t fo = ev_broadcast(&m, meta, qos);
 
     EV_CS_ENTER();
-    if (fo.enq_fail) {
-        s_enq_fail += fo.enq_fail;
-        if (idx != (size_t)-1) s_ev_enq_fail[idx] += (uint32_t)fo.enq_fail;
-    }
-    if (fo.delivered > 0) {
-        s_posts_ok++;
-        if (idx != (size_t)-1) {
-            s_ev_posts_ok[idx]++;
-            s_ev_delivered[idx] += (uint32_t)fo.delivered;
-        }
-    } else {
-        s_posts_drop++;
-        if (idx != (size_t)-1) s_ev_posts_drop[idx]++;
-    }
+    ev_account_fanout_locked_(idx, &fo);
+    ev_snap_exit_locked_(fo.snap);
     EV_CS_EXIT();
 
     return (fo.delivered > 0);
@@ -433,26 +676,13 @@ bool ev_post_lease(ev_src_t src, uint16_t code, lp_handle_t h, uint16_t len)
 #endif
 
     ev_msg_t m = { .src=src, .code=code, .a0=packed, .a1=(uint32_t)len, .t_ms=now_ms() };
-    const size_t idx = meta ? (size_t)(meta - s_ev_meta) : (size_t)-1;
+    const size_t idx = ev_meta_idx_(meta);
 
-    const ev_fanout_t fo = ev_broadcast_lease(&m, h);
-    lp_release(h);
+    const ev_fanout_t fo = ev_broadcast_lease(&m, meta, h);
 
     EV_CS_ENTER();
-    if (fo.enq_fail) {
-        s_enq_fail += fo.enq_fail;
-        if (idx != (size_t)-1) s_ev_enq_fail[idx] += (uint32_t)fo.enq_fail;
-    }
-    if (fo.delivered > 0) {
-        s_posts_ok++;
-        if (idx != (size_t)-1) {
-            s_ev_posts_ok[idx]++;
-            s_ev_delivered[idx] += (uint32_t)fo.delivered;
-        }
-    } else {
-        s_posts_drop++;
-        if (idx != (size_t)-1) s_ev_posts_drop[idx]++;
-    }
+    ev_account_fanout_locked_(idx, &fo);
+    ev_snap_exit_locked_(fo.snap);
     EV_CS_EXIT();
 
     return (fo.delivered > 0);
@@ -470,48 +700,242 @@ bool ev_post_from_isr(ev_src_t src, uint16_t code, uint32_t a0, uint32_t a1)
 
     ev_msg_t m = { .src=src, .code=code, .a0=a0, .a1=a1, .t_ms=(uint32_t)(xTaskGetTickCountFromISR()*portTICK_PERIOD_MS) };
     const ev_qos_t qos = meta ? meta->qos : EVQ_DROP_NEW;
-    const size_t idx = meta ? (size_t)(meta - s_ev_meta) : (size_t)-1;
+    const size_t idx = ev_meta_idx_(meta);
+
+    ev_fanout_t fo = {0};
 
     EV_CS_ENTER_ISR();
+    m.seq = ev_seq_next_locked_(idx);
+    fo.snap = ev_snap_enter_locked_();
     uint16_t n = s_subs_cnt;
     ev_sub_t local[EV_MAX_SUBS];
     if (n > EV_MAX_SUBS) n = EV_MAX_SUBS;
     memcpy(local, s_subs, n * sizeof(ev_sub_t));
     EV_CS_EXIT_ISR();
 
-    uint16_t delivered = 0;
-    uint16_t enq_fail  = 0;
+    const bool lane = ev_use_lane_(meta);
     BaseType_t hpw = pdFALSE;
 
     for (uint16_t i = 0; i < n; ++i) {
         if (local[i].q == NULL) continue;
-        BaseType_t ok;
-        if (qos == EVQ_REPLACE_LAST && local[i].depth == 1) ok = xQueueOverwriteFromISR(local[i].q, &m, &hpw);
-        else ok = xQueueSendFromISR(local[i].q, &m, &hpw);
-
-        if (ok == pdTRUE) delivered++;
-        else enq_fail++;
+        if (ev_send_one_isr_(&local[i], &m, qos, lane, &fo, &hpw) == pdTRUE) fo.delivered++;
+        else                                                               fo.enq_fail++;
     }
 
     EV_CS_ENTER_ISR();
-    if (enq_fail) {
-        s_enq_fail += (uint32_t)enq_fail;
-        if (idx != (size_t)-1) s_ev_enq_fail[idx] += (uint32_t)enq_fail;
+    ev_account_fanout_locked_(idx, &fo);
+    ev_snap_exit_locked_(fo.snap);
+    EV_CS_EXIT_ISR();
+
+    if (hpw == pdTRUE) portYIELD_FROM_ISR();
+    return (fo.delivered > 0);
+}
+
+/* ====== RECV (TTL + seq) ====== */
+
+static bool ev_msg_expired_(const ev_msg_t* m, const ev_meta_t* meta)
+{
+    if (!meta || meta->ttl_ms == 0) return false;
+    // Arytmetyka modulo 2^32: poprawna także po zawinięciu licznika ms.
+    const uint32_t age_ms = now_ms() - m->t_ms;
+    return (age_ms > (uint32_t)meta->ttl_ms);
+}
+
+static int ev_sub_find_locked_(ev_queue_t q)
+{
+    for (uint16_t i = 0; i < s_subs_cnt && i < EV_MAX_SUBS; ++i) {
+        if (s_subs[i].q == q) return (int)i;
     }
-    if (delivered > 0) {
-        s_posts_ok++;
-        if (idx != (size_t)-1) {
-            s_ev_posts_ok[idx]++;
-            s_ev_delivered[idx] += (uint32_t)delivered;
+    return -1;
+}
+
+/**
+ * Księgowanie odbioru: detekcja luk w numeracji per (subskrybent, event).
+ * Zwraca liczbę zgubionych wiadomości tego eventu przed bieżącą.
+ *
+ * REPLACE_LAST celowo nadpisuje — luki nie są tam stratą.
+ * Kolejność enqueue dwóch równoległych postów może się odwrócić względem seq;
+ * "spóźniona" wiadomość koryguje wtedy stratę, ale tylko gdy jej seq leży w luce
+ * naliczonej dla tego samego eventu (bitmapa miss, ostatnie EV_RX_MISS_WINDOW numerów).
+ * Duplikat (seq == last) i seq spoza naliczonej luki niczego nie zmieniają.
+ */
+static uint32_t ev_rx_account_(int si, const ev_msg_t* m, const ev_meta_t* meta, bool expired)
+{
+    const size_t idx = ev_meta_idx_(meta);
+    uint32_t gap = 0;
+
+    EV_CS_ENTER();
+    if (si >= 0) {
+        ev_sub_rx_t* rx = &s_sub_rx[si];
+        if (expired) rx->expired++;
+        else         rx->received++;
+
+        if (idx != (size_t)-1 && m->seq != 0) {
+            const uint32_t last = rx->last_seq[idx];
+            const int32_t  d    = (int32_t)(m->seq - last);
+            if (last == 0 || d > 0) {
+                if (last != 0 && meta->qos == EVQ_DROP_NEW) gap = (uint32_t)d - 1u;
+                rx->last_seq[idx] = m->seq;
+                // Okno przesuwa się o d; nowa luka to najmłodsze bity (seq-1 .. last+1).
+                uint32_t miss = (last != 0 && (uint32_t)d < EV_RX_MISS_WINDOW) ? rx->miss[idx] << d : 0u;
+                if (gap) {
+                    miss |= (gap >= EV_RX_MISS_WINDOW) ? UINT32_MAX : ((1u << gap) - 1u);
+                    rx->lost       += gap;
+                    s_ev_lost[idx] += gap;
+                    s_lost         += gap;
+                }
+                rx->miss[idx] = miss;
+            } else if (d < 0 && meta->qos == EVQ_DROP_NEW) {
+                const uint32_t k = (uint32_t)(-(d + 1));
+                if (k < EV_RX_MISS_WINDOW && (rx->miss[idx] & (1u << k))) {
+                    rx->miss[idx] &= ~(1u << k);
+                    if (rx->lost)       rx->lost--;
+                    if (s_ev_lost[idx]) s_ev_lost[idx]--;
+                    if (s_lost)         s_lost--;
+                }
+            }
         }
+    }
+    if (expired && idx != (size_t)-1) {
+        s_expired++;
+        s_ev_expired[idx]++;
+    }
+    EV_CS_EXIT();
+
+    return gap;
+}
+
+/* Pas subskrybenta przypięty na czas odczytu (NULL = brak albo slot już wypięty). */
+static ev_queue_t ev_lane_pin_(int si, ev_queue_t q, uint8_t* snap)
+{
+#if EV_PRIO_LANE_DEPTH > 0
+    if (si < 0) return NULL;
+    ev_queue_t lane = NULL;
+    EV_CS_ENTER();
+    if (s_subs[si].q == q && s_subs[si].lane != NULL) {
+        lane  = s_subs[si].lane;
+        *snap = ev_snap_enter_locked_();
+    }
+    EV_CS_EXIT();
+    return lane;
+#else
+    (void)si; (void)q; (void)snap;
+    return NULL;
+#endif
+}
+
+static void ev_lane_unpin_(uint8_t snap)
+{
+    EV_CS_ENTER();
+    ev_snap_exit_locked_(snap);
+    EV_CS_EXIT();
+}
+
+/* Odebrany element: dzwonek / przeterminowany (false) albo świeże zdarzenie (true). */
+static bool ev_recv_accept_(int si, const ev_msg_t* m, bool from_lane, ev_recv_info_t* info)
+{
+    if (!from_lane && m->src == EV_SRC_NONE && m->code == EV_LANE_DOORBELL_CODE) return false;
+
+    const ev_meta_t* meta = ev_meta_find(m->src, m->code);
+    const bool expired = ev_msg_expired_(m, meta);
+    const uint32_t gap = ev_rx_account_(si, m, meta, expired);
+    // Strata przed przeterminowanym też trafia do info (przeciążenie = luka + TTL naraz).
+    if (info) info->lost += gap;
+
+    if (!expired) return true;
+
+    // Przeterminowany LEASE: zwalniamy referencję, którą dostał ten subskrybent.
+    if (meta->kind == EVK_LEASE) {
+        lp_release(lp_unpack_handle_u32(m->a0));
+    }
+    if (info) info->expired++;
+    return false;
+}
+
+bool ev_recv_ex(ev_queue_t q, ev_msg_t* out, TickType_t timeout, ev_recv_info_t* info)
+{
+    if (info) { info->lost = 0; info->expired = 0; }
+    if (!q || !out) return false;
+
+    // Indeks slotu subskrybenta jest stabilny (sloty nie są przesuwane).
+    EV_CS_ENTER();
+    const int si = ev_sub_find_locked_(q);
+    EV_CS_EXIT();
+
+    const TickType_t t0 = xTaskGetTickCount();
+    TickType_t wait = timeout;
+
+    for (;;) {
+        // Pas priorytetowy zawsze pierwszy: krytyczne omijają zaległości kolejki głównej.
+        // Przypięty tylko na czas odczytu — ev_unsubscribe() może go potem usunąć.
+        uint8_t snap = 0;
+        const ev_queue_t lane = ev_lane_pin_(si, q, &snap);
+        bool from_lane = false;
+        if (lane) {
+            from_lane = (xQueueReceive(lane, out, 0) == pdTRUE);
+            ev_lane_unpin_(snap);
+        }
+        if (!from_lane) {
+            if (xQueueReceive(q, out, wait) != pdTRUE) return false;
+        }
+
+        if (ev_recv_accept_(si, out, from_lane, info)) return true;
+
+        // Pozostały budżet oczekiwania (portMAX_DELAY = bez limitu).
+        if (timeout != portMAX_DELAY) {
+            const TickType_t spent = xTaskGetTickCount() - t0;
+            wait = (spent >= timeout) ? 0 : (TickType_t)(timeout - spent);
+        }
+    }
+}
+
+bool ev_recv_set(ev_queue_t q, QueueSetMemberHandle_t member, ev_msg_t* out, ev_recv_info_t* info)
+{
+    if (info) { info->lost = 0; info->expired = 0; }
+    if (!q || !out || !member) return false;
+
+    EV_CS_ENTER();
+    const int si = ev_sub_find_locked_(q);
+    EV_CS_EXIT();
+
+    // Dokładnie jeden element na token — bez pętli po przeterminowanych.
+    const bool from_lane = (member != q);
+    if (!from_lane) {
+        if (xQueueReceive(q, out, 0) != pdTRUE) return false;
     } else {
-        s_posts_drop++;
-        if (idx != (size_t)-1) s_ev_posts_drop[idx]++;
+        // Token pasu: tylko bieżący, przypięty pas tego q (token po ev_unsubscribe() pomijamy).
+        uint8_t snap = 0;
+        const ev_queue_t lane = ev_lane_pin_(si, q, &snap);
+        if (lane == NULL) return false;
+        const bool got = (lane == member) && (xQueueReceive(lane, out, 0) == pdTRUE);
+        ev_lane_unpin_(snap);
+        if (!got) return false;
     }
-    EV_CS_EXIT_ISR();
+    return ev_recv_accept_(si, out, from_lane, info);
+}
 
-    if (hpw == pdTRUE) portYIELD_FROM_ISR();
-    return (delivered > 0);
+bool ev_recv(ev_queue_t q, ev_msg_t* out, TickType_t timeout)
+{
+    return ev_recv_ex(q, out, timeout, NULL);
+}
+
+size_t ev_get_sub_stats(ev_sub_stats_t* out, size_t max)
+{
+    if (!out || max == 0) return 0;
+    size_t n = 0;
+
+    EV_CS_ENTER();
+    for (uint16_t i = 0; i < s_subs_cnt && i < EV_MAX_SUBS && n < max; ++i) {
+        if (s_subs[i].q == NULL) continue;
+        out[n].q        = s_subs[i].q;
+        out[n].depth    = s_subs[i].depth;
+        out[n].received = s_sub_rx[i].received;
+        out[n].lost     = s_sub_rx[i].lost;
+        out[n].expired  = s_sub_rx[i].expired;
+        n++;
+    }
+    EV_CS_EXIT();
+    return n;
 }
 
 void ev_get_stats(ev_stats_t* out)
@@ -528,6 +952,10 @@ void ev_get_stats(ev_stats_t* out)
     out->posts_ok    = s_posts_ok;
     out->posts_drop  = s_posts_drop;
     out->enq_fail    = s_enq_fail;
+    out->expired     = s_expired;
+    out->lost        = s_lost;
+    out->lane_delivered = s_lane_delivered;
+    out->lane_full   = s_lane_full;
     EV_CS_EXIT();
 }
 
@@ -537,11 +965,22 @@ void ev_reset_stats(void)
     s_posts_ok   = 0;
     s_posts_drop = 0;
     s_enq_fail   = 0;
+    s_expired    = 0;
+    s_lost       = 0;
+    s_lane_delivered = 0;
+    s_lane_full      = 0;
     
     memset(s_ev_posts_ok,   0, sizeof(s_ev_posts_ok));
     memset(s_ev_posts_drop, 0, sizeof(s_ev_posts_drop));
     memset(s_ev_enq_fail,   0, sizeof(s_ev_enq_fail));
     memset(s_ev_delivered,  0, sizeof(s_ev_delivered));
+    memset(s_ev_expired,    0, sizeof(s_ev_expired));
+    memset(s_ev_lost,       0, sizeof(s_ev_lost));
+    for (uint16_t i = 0; i < EV_MAX_SUBS; ++i) {
+        s_sub_rx[i].received = 0;
+        s_sub_rx[i].lost     = 0;
+        s_sub_rx[i].expired  = 0;
+    }
     EV_CS_EXIT();
 }
 
@@ -568,6 +1007,8 @@ size_t ev_get_event_stats(ev_event_stats_t* out, size_t max)
         out[i].posts_drop = s_ev_posts_drop[i];
         out[i].enq_fail   = s_ev_enq_fail[i];
         out[i].delivered  = s_ev_delivered[i];
+        out[i].expired    = s_ev_expired[i];
+        out[i].lost       = s_ev_lost[i];
     }
     EV_CS_EXIT();
     return n;
@@ -614,12 +1055,33 @@ static bool bus_unsubscribe_(void* self, ev_queue_t q)
     return ev_unsubscribe(q);
 }
 
+static bool bus_recv_(void* self, ev_queue_t q, ev_msg_t* out, TickType_t timeout, ev_recv_info_t* info)
+{
+    (void)self;
+    return ev_recv_ex(q, out, timeout, info);
+}
+
+static bool bus_subscribe_set_(void* self, ev_queue_t* out_q, size_t depth, QueueSetHandle_t set)
+{
+    (void)self;
+    return ev_subscribe_set(out_q, depth, set);
+}
+
+static bool bus_recv_set_(void* self, ev_queue_t q, QueueSetMemberHandle_t member, ev_msg_t* out, ev_recv_info_t* info)
+{
+    (void)self;
+    return ev_recv_set(q, member, out, info);
+}
+
 static const ev_bus_vtbl_t s_bus_vtbl = {
     .post         = bus_post_,
     .post_lease   = bus_post_lease_,
     .post_from_isr= bus_post_from_isr_,
     .subscribe    = bus_subscribe_,
     .unsubscribe  = bus_unsubscribe_,
+    .recv         = bus_recv_,
+    .subscribe_set= bus_subscribe_set_,
+    .recv_set     = bus_recv_set_,
 };
 
 static const ev_bus_t s_bus = {
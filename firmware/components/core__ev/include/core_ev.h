@@ -21,9 +21,19 @@ extern "C" {
 #  endif
 #endif
 
+/* Pas priorytetowy per-subskrybent dla zdarzeń EVF_CRITICAL (0 = wyłączony). */
+#ifndef EV_PRIO_LANE_DEPTH
+#  ifdef CONFIG_CORE_EV_PRIO_LANE_DEPTH
+#    define EV_PRIO_LANE_DEPTH CONFIG_CORE_EV_PRIO_LANE_DEPTH
+#  else
+#    define EV_PRIO_LANE_DEPTH 4
+#  endif
+#endif
+
 typedef uint16_t ev_src_t;
 
 enum {
+    EV_SRC_NONE  = 0x00, /* wewnętrzne komunikaty busa (poza schemą) */
     EV_SRC_SYS   = 0x01,
     EV_SRC_TIMER = 0x02,
     EV_SRC_I2C   = 0x03,
@@ -49,6 +59,8 @@ typedef enum {
 /* Flagi metadanych zdarzeń */
 enum {
     EVF_NONE     = 0u,
+    /* Krytyczne: (DROP_NEW) doręczane pasem priorytetowym subskrybenta —
+     * omijają zaległości kolejki głównej i są odbierane przez ev_recv() jako pierwsze. */
     EVF_CRITICAL = (1u << 0),
     EVF_ALL      = EVF_CRITICAL,
 };
@@ -56,7 +68,7 @@ enum {
 #include "core_ev_schema.h"
 
 enum {
-#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, DOC) NAME = (CODE),
+#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, TTL_MS, DOC) NAME = (CODE),
     EV_SCHEMA(X)
 #undef X
 };
@@ -67,6 +79,7 @@ typedef struct {
     ev_kind_t   kind;
     ev_qos_t    qos;
     uint16_t    flags;
+    uint16_t    ttl_ms;   /* 0 = bez TTL (patrz ev_recv()) */
     const char* name;
     const char* doc;
 } ev_meta_t;
@@ -85,6 +98,8 @@ typedef struct {
     uint32_t posts_drop;
     uint32_t enq_fail;
     uint32_t delivered;
+    uint32_t expired;   /* odrzucone przez ev_recv() po przekroczeniu TTL */
+    uint32_t lost;      /* luki w numeracji wykryte przez ev_recv() (suma po subskrybentach) */
 } ev_event_stats_t;
 
 size_t ev_get_event_stats(ev_event_stats_t* out, size_t max);
@@ -95,17 +110,88 @@ typedef struct {
     uint32_t  a0;
     uint32_t  a1;
     uint32_t  t_ms;
+    uint32_t  seq;   /* numer kolejny per-event nadany przy post (0 = brak) */
 } ev_msg_t;
 
 typedef QueueHandle_t ev_queue_t;
 
 void ev_init(void);
 bool ev_subscribe(ev_queue_t* out_q, size_t depth);
+
+/**
+ * @brief Odpina subskrybenta (kontekst taska, nie ISR).
+ *
+ * Własność kolejek: q należy do wywołującego, pas priorytetowy do busa. Przed powrotem bus
+ * czeka (vTaskDelay(1)), aż skończą się posty i odczyty pasu, które zdążyły skopiować slot
+ * subskrybenta — potem nic w busie nie trzyma już q ani pasu. Wypięcia z kilku tasków są
+ * szeregowane (każde czeka na swoją epokę migawek do końca). Pas jest wtedy opróżniany
+ * (referencje LEASE wracają do puli) i usuwany, a wywołujący może usunąć q
+ * (vQueueDelete(); dla ev_subscribe_set() najpierw xQueueRemoveFromSet()). Nie może jednak
+ * tego zrobić, dopóki jego własny task nadal czeka w ev_recv*() na tej kolejce.
+ */
 bool ev_unsubscribe(ev_queue_t q);
 bool ev_post(ev_src_t src, uint16_t code, uint32_t a0, uint32_t a1);
 bool ev_post_lease(ev_src_t src, uint16_t code, lp_handle_t h, uint16_t len);
 bool ev_post_from_isr(ev_src_t src, uint16_t code, uint32_t a0, uint32_t a1);
 
+/**
+ * @brief Odbiór zdarzenia z kolejki subskrybenta z egzekwowaniem TTL ze schemy.
+ *
+ * Działa jak xQueueReceive(), ale zdarzenia starsze niż ttl_ms (ze schemy) są
+ * pomijane: dla LEASE wykonywany jest lp_release(), a licznik 'expired' rośnie.
+ * Dzięki temu zaległy aktor szybko nadrabia zamiast odtwarzać nieaktualną pracę.
+ *
+ * @param timeout łączny limit oczekiwania (ticki), także po pominięciu przeterminowanych.
+ * @return true jeśli w *out jest świeże zdarzenie.
+ */
+bool ev_recv(ev_queue_t q, ev_msg_t* out, TickType_t timeout);
+
+/* Wynik pojedynczego ev_recv_ex(). */
+typedef struct {
+    uint32_t lost;     /* luki w seq wykryte w tym wywołaniu: przed *out i przed pominiętymi przeterminowanymi */
+    uint32_t expired;  /* ile przeterminowanych zdarzeń pominięto w tym wywołaniu */
+} ev_recv_info_t;
+
+/**
+ * @brief ev_recv() z informacją o stracie (luka w seq per-event) — pozwala
+ *        konsumentowi tanio zresynchronizować strumień (np. mostek UART).
+ *
+ * Luki liczone są tylko dla QoS DROP_NEW (REPLACE_LAST nadpisuje celowo).
+ */
+bool ev_recv_ex(ev_queue_t q, ev_msg_t* out, TickType_t timeout, ev_recv_info_t* info);
+
+/**
+ * @brief Subskrypcja dla konsumenta czekającego na QueueSet (xQueueSelectFromSet()).
+ *
+ * QueueSet daje jeden token na element dodany do członka, a odbierać wolno tylko z członka
+ * zwróconego przez xQueueSelectFromSet(). ev_recv() tego nie spełnia (czyta najpierw pas,
+ * pomija dzwonki i przeterminowane), więc tu kolejka i pas trafiają do zbioru, bus nie
+ * wysyła dzwonków, a odbiór idzie przez ev_recv_set(). Zbiór musi pomieścić
+ * depth + EV_PRIO_LANE_DEPTH tokenów (plus tokeny pozostałych członków).
+ */
+bool ev_subscribe_set(ev_queue_t* out_q, size_t depth, QueueSetHandle_t set);
+
+/**
+ * @brief Odbiór dokładnie jednego elementu z członka wybranego przez xQueueSelectFromSet()
+ *        (q albo jego pas), bez czekania. Kolejność krytycznych względem zwykłych wyznacza
+ *        zbiór (FIFO tokenów); pas nadal omija pełną kolejkę główną.
+ *
+ * @return true jeśli w *out jest świeże zdarzenie; false także po pominięciu
+ *         przeterminowanego (info->expired). info->lost jest ustawiane w obu przypadkach.
+ */
+bool ev_recv_set(ev_queue_t q, QueueSetMemberHandle_t member, ev_msg_t* out, ev_recv_info_t* info);
+
+/* Liczniki odbioru per-subskrybent (księgowane w ev_recv*()). */
+typedef struct {
+    ev_queue_t q;
+    uint16_t   depth;
+    uint32_t   received;
+    uint32_t   lost;
+    uint32_t   expired;
+} ev_sub_stats_t;
+
+size_t ev_get_sub_stats(ev_sub_stats_t* out, size_t max);
+
 /* =========================
  * PR7: EventBus jako port (vtbl) — dependency injection
  * ========================= */
@@ -116,6 +202,9 @@ typedef struct ev_bus_vtbl {
     bool (*post_from_isr)(void* self, ev_src_t src, uint16_t code, uint32_t a0, uint32_t a1);
     bool (*subscribe)(void* self, ev_queue_t* out_q, size_t depth);
     bool (*unsubscribe)(void* self, ev_queue_t q);
+    bool (*recv)(void* self, ev_queue_t q, ev_msg_t* out, TickType_t timeout, ev_recv_info_t* info);
+    bool (*subscribe_set)(void* self, ev_queue_t* out_q, size_t depth, QueueSetHandle_t set);
+    bool (*recv_set)(void* self, ev_queue_t q, QueueSetMemberHandle_t member, ev_msg_t* out, ev_recv_info_t* info);
 } ev_bus_vtbl_t;
 
 typedef struct ev_bus {
@@ -150,6 +239,26 @@ static inline bool ev_bus_unsubscribe(const ev_bus_t* bus, ev_queue_t q)
     return (bus && bus->vtbl && bus->vtbl->unsubscribe) ? bus->vtbl->unsubscribe(bus->self, q) : false;
 }
 
+static inline bool ev_bus_recv(const ev_bus_t* bus, ev_queue_t q, ev_msg_t* out, TickType_t timeout)
+{
+    return (bus && bus->vtbl && bus->vtbl->recv) ? bus->vtbl->recv(bus->self, q, out, timeout, NULL) : false;
+}
+
+static inline bool ev_bus_recv_ex(const ev_bus_t* bus, ev_queue_t q, ev_msg_t* out, TickType_t timeout, ev_recv_info_t* info)
+{
+    return (bus && bus->vtbl && bus->vtbl->recv) ? bus->vtbl->recv(bus->self, q, out, timeout, info) : false;
+}
+
+static inline bool ev_bus_subscribe_set(const ev_bus_t* bus, ev_queue_t* out_q, size_t depth, QueueSetHandle_t set)
+{
+    return (bus && bus->vtbl && bus->vtbl->subscribe_set) ? bus->vtbl->subscribe_set(bus->self, out_q, depth, set) : false;
+}
+
+static inline bool ev_bus_recv_set(const ev_bus_t* bus, ev_queue_t q, QueueSetMemberHandle_t member, ev_msg_t* out, ev_recv_info_t* info)
+{
+    return (bus && bus->vtbl && bus->vtbl->recv_set) ? bus->vtbl->recv_set(bus->self, q, member, out, info) : false;
+}
+
 /* Statystyki globalne busa */
 typedef struct {
     uint16_t subs_active;
@@ -157,6 +266,10 @@ typedef struct {
     uint32_t posts_ok;
     uint32_t posts_drop;
     uint32_t enq_fail;
+    uint32_t expired;
+    uint32_t lost;
+    uint32_t lane_delivered; /* doręczenia pasem priorytetowym (EVF_CRITICAL) */
+    uint32_t lane_full;      /* pas pełny -> degradacja do kolejki głównej */
     uint16_t q_depth_max;
 } ev_stats_t;
 
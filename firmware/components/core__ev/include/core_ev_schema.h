@@ -1,50 +1,55 @@
 #pragma once
 
 // PR2: Event schema (single source of truth) jako X-macro.
+//
+// Kolumny: X(NAME, SRC, CODE, KIND, QOS, FLAGS, TTL_MS, DOC)
+//  - TTL_MS: maksymalny wiek zdarzenia w kolejce subskrybenta (0 = bez limitu).
+//    Egzekwowany przy odbiorze przez ev_recv(): przeterminowane zdarzenie jest
+//    pomijane (LEASE zwalniany automatycznie) i liczone jako 'expired'.
 
 #define EV_SCHEMA(X) \
     /* SYS */ \
-    X(EV_SYS_START,        EV_SRC_SYS,   0x0001, NONE,  DROP_NEW,     EVF_CRITICAL, "start systemu") \
+    X(EV_SYS_START,        EV_SRC_SYS,   0x0001, NONE,  DROP_NEW,     EVF_CRITICAL, 0,    "start systemu") \
     \
     /* TIMER */ \
-    X(EV_TICK_100MS,       EV_SRC_TIMER, 0x1000, NONE,  DROP_NEW,     0,           "tick 100ms (legacy; domyślnie OFF)") \
-    X(EV_TICK_1S,          EV_SRC_TIMER, 0x1001, NONE,  DROP_NEW,     0,           "tick 1s (legacy; domyślnie OFF)") \
+    X(EV_TICK_100MS,       EV_SRC_TIMER, 0x1000, NONE,  DROP_NEW,     0,            0,    "tick 100ms (legacy; domyślnie OFF)") \
+    X(EV_TICK_1S,          EV_SRC_TIMER, 0x1001, NONE,  DROP_NEW,     0,            0,    "tick 1s (legacy; domyślnie OFF)") \
     \
     /* I2C */ \
-    X(EV_I2C_DONE,         EV_SRC_I2C,   0x2000, COPY,  DROP_NEW,     0,           "I2C done: a0=user, a1=0") \
-    X(EV_I2C_ERROR,        EV_SRC_I2C,   0x2001, COPY,  DROP_NEW,     EVF_CRITICAL, "I2C error: a0=user, a1=esp_err_t") \
+    X(EV_I2C_DONE,         EV_SRC_I2C,   0x2000, COPY,  DROP_NEW,     0,            0,    "I2C done: a0=user, a1=0") \
+    X(EV_I2C_ERROR,        EV_SRC_I2C,   0x2001, COPY,  DROP_NEW,     EVF_CRITICAL, 0,    "I2C error: a0=user, a1=esp_err_t") \
     \
     /* LCD status */ \
-    X(EV_LCD_READY,        EV_SRC_LCD,   0x3001, NONE,  DROP_NEW,     0,           "LCD ready") \
-    X(EV_LCD_UPDATED,      EV_SRC_LCD,   0x3002, NONE,  DROP_NEW,     0,           "LCD updated/internal tick") \
-    X(EV_LCD_ERROR,        EV_SRC_LCD,   0x30FF, COPY,  DROP_NEW,     EVF_CRITICAL, "LCD error: a0=code, a1=detail") \
+    X(EV_LCD_READY,        EV_SRC_LCD,   0x3001, NONE,  DROP_NEW,     0,            0,    "LCD ready") \
+    X(EV_LCD_UPDATED,      EV_SRC_LCD,   0x3002, NONE,  DROP_NEW,     0,            0,    "LCD updated/internal tick") \
+    X(EV_LCD_ERROR,        EV_SRC_LCD,   0x30FF, COPY,  DROP_NEW,     EVF_CRITICAL, 0,    "LCD error: a0=code, a1=detail") \
     \
     /* LCD commands (adapter) */ \
-    X(EV_LCD_CMD_DRAW_ROW, EV_SRC_LCD,   0x3010, LEASE, DROP_NEW,     0,           "LCD cmd: draw row (lease)") \
-    X(EV_LCD_CMD_SET_RGB,  EV_SRC_LCD,   0x3011, COPY,  REPLACE_LAST, 0,           "LCD cmd: set rgb (a0=packRGB)") \
-    X(EV_LCD_CMD_FLUSH,    EV_SRC_LCD,   0x3012, NONE,  DROP_NEW,     0,           "LCD cmd: flush") \
+    X(EV_LCD_CMD_DRAW_ROW, EV_SRC_LCD,   0x3010, LEASE, DROP_NEW,     0,            1000, "LCD cmd: draw row (lease)") \
+    X(EV_LCD_CMD_SET_RGB,  EV_SRC_LCD,   0x3011, COPY,  REPLACE_LAST, 0,            0,    "LCD cmd: set rgb (a0=packRGB)") \
+    X(EV_LCD_CMD_FLUSH,    EV_SRC_LCD,   0x3012, NONE,  DROP_NEW,     0,            1000, "LCD cmd: flush") \
     \
     /* DS18B20 */ \
-    X(EV_DS18_READY,       EV_SRC_DS18,  0x4000, LEASE, DROP_NEW,     0,           "DS18 ready (lease payload: ds18_result_t)") \
-    X(EV_DS18_ERROR,       EV_SRC_DS18,  0x4001, COPY,  DROP_NEW,     EVF_CRITICAL, "DS18 error (a0=err)") \
-    X(EV_DS18_DRV_TICK,    EV_SRC_DS18,  0x4002, NONE,  DROP_NEW,     0,           "DS18 internal driver tick") \
+    X(EV_DS18_READY,       EV_SRC_DS18,  0x4000, LEASE, DROP_NEW,     0,            0,    "DS18 ready (lease payload: ds18_result_t)") \
+    X(EV_DS18_ERROR,       EV_SRC_DS18,  0x4001, COPY,  DROP_NEW,     EVF_CRITICAL, 0,    "DS18 error (a0=err)") \
+    X(EV_DS18_DRV_TICK,    EV_SRC_DS18,  0x4002, NONE,  DROP_NEW,     0,            0,    "DS18 internal driver tick") \
     \
     /* LOG */ \
-    X(EV_LOG_NEW,          EV_SRC_LOG,   0x5000, LEASE, DROP_NEW,     EVF_CRITICAL, "log line (lease payload)") \
-    X(EV_LOG_READY,        EV_SRC_LOG,   0x5001, STREAM, REPLACE_LAST, EVF_CRITICAL, "log stream ready (payload in SPSC ring)") \
+    X(EV_LOG_NEW,          EV_SRC_LOG,   0x5000, LEASE, DROP_NEW,     EVF_CRITICAL, 0,    "log line (lease payload)") \
+    X(EV_LOG_READY,        EV_SRC_LOG,   0x5001, STREAM, REPLACE_LAST, EVF_CRITICAL, 0,    "log stream ready (payload in SPSC ring)") \
     \
     /* UART (M2M) */ \
-    X(EV_UART_FRAME,       EV_SRC_UART,  0x6000, LEASE, DROP_NEW,     0,           "UART RX frame (lease payload)") \
-    X(EV_UART_ERROR,       EV_SRC_UART,  0x6001, COPY,  DROP_NEW,     0,           "UART error (a0=err_code)") \
-    X(EV_UART_TX_REQ,      EV_SRC_UART,  0x6002, LEASE, DROP_NEW,     0,           "UART TX request (lease payload)") \
+    X(EV_UART_FRAME,       EV_SRC_UART,  0x6000, LEASE, DROP_NEW,     0,            0,    "UART RX frame (lease payload)") \
+    X(EV_UART_ERROR,       EV_SRC_UART,  0x6001, COPY,  DROP_NEW,     0,            0,    "UART error (a0=err_code)") \
+    X(EV_UART_TX_REQ,      EV_SRC_UART,  0x6002, LEASE, DROP_NEW,     0,            2000, "UART TX request (lease payload)") \
     \
     /* GPIO */ \
-    X(EV_GPIO_INPUT,       EV_SRC_GPIO,  0x7000, COPY,  DROP_NEW,     0,           "GPIO input changed: a0=pin, a1=val") \
+    X(EV_GPIO_INPUT,       EV_SRC_GPIO,  0x7000, COPY,  DROP_NEW,     0,            0,    "GPIO input changed: a0=pin, a1=val") \
     \
     /* LED CONTROL */ \
-    X(EV_LED_SET_RGB,      EV_SRC_SYS,   0x8000, COPY,  REPLACE_LAST, 0,           "Set LED RGB: a0=packed(0x00BBGGRR)") \
-    X(EV_LED_UPDATED,      EV_SRC_SYS,   0x8001, NONE,  DROP_NEW,     0,           "LED refresh done") \
+    X(EV_LED_SET_RGB,      EV_SRC_SYS,   0x8000, COPY,  REPLACE_LAST, 0,            0,    "Set LED RGB: a0=packed(0x00BBGGRR)") \
+    X(EV_LED_UPDATED,      EV_SRC_SYS,   0x8001, NONE,  DROP_NEW,     0,            0,    "LED refresh done") \
     \
     /* INTERNAL SENSORS */ \
-    X(EV_SYS_TEMP_UPDATE,  EV_SRC_SYS,   0x0020, COPY,  DROP_NEW,     0,           "Internal Temp update: a0=IEEE754_float_as_u32")
+    X(EV_SYS_TEMP_UPDATE,  EV_SRC_SYS,   0x0020, COPY,  DROP_NEW,     0,            0,    "Internal Temp update: a0=IEEE754_float_as_u32")
 
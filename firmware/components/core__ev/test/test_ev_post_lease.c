@@ -18,7 +18,7 @@ static void task_hi(void *arg)
     TaskHandle_t parent = (TaskHandle_t)arg;
 
     ev_msg_t m = {0};
-    if (xQueueReceive(s_hi_q, &m, pdMS_TO_TICKS(1000)) == pdTRUE) {
+    if (ev_recv(s_hi_q, &m, pdMS_TO_TICKS(1000))) {
         lp_handle_t h = lp_unpack_handle_u32(m.a0);
 
         lp_view_t v = {0};
@@ -42,7 +42,7 @@ static void task_lo(void *arg)
     TaskHandle_t parent = (TaskHandle_t)arg;
 
     ev_msg_t m = {0};
-    if (xQueueReceive(s_lo_q, &m, pdMS_TO_TICKS(1000)) == pdTRUE) {
+    if (ev_recv(s_lo_q, &m, pdMS_TO_TICKS(1000))) {
         lp_handle_t h = lp_unpack_handle_u32(m.a0);
 
         lp_view_t v = {0};
@@ -0,0 +1,99 @@
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+
+#include "core_ev.h"
+
+#include <stdio.h>
+
+#if EV_PRIO_LANE_DEPTH > 0
+
+TEST_CASE("ev_recv: EVF_CRITICAL bypasses saturated subscriber queue", "[core__ev]")
+{
+    ev_init();
+
+    ev_queue_t q = NULL;
+    TEST_ASSERT_TRUE(ev_subscribe(&q, 8));
+
+    // Zaległości zwykłego ruchu: kolejka główna pełna.
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, i & 1u));
+    }
+    TEST_ASSERT_FALSE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 0));
+
+    // Krytyczne nie giną i są odbierane przed zaległościami.
+    const int64_t t0 = esp_timer_get_time();
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_I2C, EV_I2C_ERROR, 7, 0));
+
+    ev_msg_t m = {0};
+    TEST_ASSERT_TRUE(ev_recv(q, &m, pdMS_TO_TICKS(100)));
+    const int64_t t1 = esp_timer_get_time();
+
+    TEST_ASSERT_EQUAL_UINT16(EV_SRC_I2C, m.src);
+    TEST_ASSERT_EQUAL_UINT16(EV_I2C_ERROR, m.code);
+    TEST_ASSERT_EQUAL_UINT32(7u, m.a0);
+
+    // Potem zwykły ruch w niezmienionej kolejności.
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(ev_recv(q, &m, pdMS_TO_TICKS(100)));
+        TEST_ASSERT_EQUAL_UINT16(EV_GPIO_INPUT, m.code);
+        TEST_ASSERT_EQUAL_UINT32(i & 1u, m.a1);
+    }
+    TEST_ASSERT_FALSE(ev_recv(q, &m, 0));
+
+    ev_stats_t s = {0};
+    ev_get_stats(&s);
+    TEST_ASSERT_EQUAL_UINT32(1u, s.lane_delivered);
+    TEST_ASSERT_EQUAL_UINT32(0u, s.lane_full);
+
+    printf("ev_prio_lane: backlog=8 crit_latency_us=%lld\n", (long long)(t1 - t0));
+
+    ev_unsubscribe(q);
+    vQueueDelete(q);
+}
+
+static ev_queue_t s_wait_q = NULL;
+static volatile int64_t s_wake_us = 0;
+static volatile bool s_wake_ok = false;
+
+static void task_waiter(void* arg)
+{
+    TaskHandle_t parent = (TaskHandle_t)arg;
+
+    ev_msg_t m = {0};
+    s_wake_ok = ev_recv(s_wait_q, &m, pdMS_TO_TICKS(1000)) && m.code == EV_I2C_ERROR;
+    s_wake_us = esp_timer_get_time();
+
+    xTaskNotifyGive(parent);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("ev_recv: blocked receiver wakes on lane delivery (doorbell)", "[core__ev]")
+{
+    ev_init();
+    TEST_ASSERT_TRUE(ev_subscribe(&s_wait_q, 4));
+
+    s_wake_ok = false;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(task_waiter, "ev_wait", 3072, xTaskGetCurrentTaskHandle(),
+                                          uxTaskPriorityGet(NULL) + 1, NULL));
+    vTaskDelay(pdMS_TO_TICKS(10)); // waiter blokuje się na kolejce głównej
+
+    const int64_t t0 = esp_timer_get_time();
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_I2C, EV_I2C_ERROR, 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(1u, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000)));
+
+    TEST_ASSERT_TRUE(s_wake_ok);
+    printf("ev_prio_lane: wake_latency_us=%lld\n", (long long)(s_wake_us - t0));
+
+    // Dzwonek został skonsumowany razem z doręczeniem — kolejka pusta.
+    ev_msg_t m = {0};
+    TEST_ASSERT_FALSE(ev_recv(s_wait_q, &m, 0));
+
+    ev_unsubscribe(s_wait_q);
+    vQueueDelete(s_wait_q);
+}
+
+#endif /* EV_PRIO_LANE_DEPTH > 0 */
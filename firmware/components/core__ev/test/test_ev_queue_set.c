@@ -0,0 +1,76 @@
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "core_ev.h"
+
+/* Jak worker services_uart: jeden token ze zbioru = jeden ev_recv_set(). */
+static uint32_t drain_set_(QueueSetHandle_t set, ev_queue_t q, uint32_t* crit, uint32_t* normal)
+{
+    uint32_t tokens = 0;
+    QueueSetMemberHandle_t member;
+    while ((member = xQueueSelectFromSet(set, 0)) != NULL) {
+        tokens++;
+        ev_msg_t m = {0};
+        ev_recv_info_t info = {0};
+        if (!ev_recv_set(q, member, &m, &info)) continue;
+        if (m.code == EV_I2C_ERROR)  (*crit)++;
+        if (m.code == EV_GPIO_INPUT) (*normal)++;
+    }
+    return tokens;
+}
+
+TEST_CASE("ev_recv_set: critical and normal events on a queue-set subscriber", "[core__ev]")
+{
+    ev_init();
+
+    QueueSetHandle_t set = xQueueCreateSet(8 + EV_PRIO_LANE_DEPTH);
+    TEST_ASSERT_NOT_NULL(set);
+
+    ev_queue_t q = NULL;
+    TEST_ASSERT_TRUE(ev_subscribe_set(&q, 8, set));
+
+    // Więcej rund niż depth: każdy "zjedzony" token zostawiłby element w kolejce na stałe.
+    for (uint32_t round = 0; round < 32; round++) {
+        TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, round & 1u));
+        TEST_ASSERT_TRUE(ev_post(EV_SRC_I2C, EV_I2C_ERROR, round, 0));
+        TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 0));
+
+        uint32_t crit = 0, normal = 0;
+        TEST_ASSERT_EQUAL_UINT32(3u, drain_set_(set, q, &crit, &normal));
+        TEST_ASSERT_EQUAL_UINT32(1u, crit);
+        TEST_ASSERT_EQUAL_UINT32(2u, normal);
+        TEST_ASSERT_EQUAL_UINT32(0u, (uint32_t)uxQueueMessagesWaiting(q));
+    }
+
+    // Kolejka główna pełna: krytyczne nadal wchodzą pasem i dostają własny token.
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, i & 1u));
+    }
+    TEST_ASSERT_FALSE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 0));
+#if EV_PRIO_LANE_DEPTH > 0
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_I2C, EV_I2C_ERROR, 99, 0));
+    const uint32_t crit_want = 1u;
+#else
+    const uint32_t crit_want = 0u;
+#endif
+
+    uint32_t crit = 0, normal = 0;
+    TEST_ASSERT_EQUAL_UINT32(8u + crit_want, drain_set_(set, q, &crit, &normal));
+    TEST_ASSERT_EQUAL_UINT32(crit_want, crit);
+    TEST_ASSERT_EQUAL_UINT32(8u, normal);
+    TEST_ASSERT_NULL(xQueueSelectFromSet(set, 0));
+
+    // Po opróżnieniu zwykły ruch znowu przechodzi.
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 1));
+    crit = normal = 0;
+    TEST_ASSERT_EQUAL_UINT32(1u, drain_set_(set, q, &crit, &normal));
+    TEST_ASSERT_EQUAL_UINT32(1u, normal);
+
+    ev_unsubscribe(q);
+    TEST_ASSERT_EQUAL(pdPASS, xQueueRemoveFromSet(q, set));
+    vQueueDelete(q);
+    vQueueDelete(set);
+}
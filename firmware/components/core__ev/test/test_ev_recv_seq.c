@@ -0,0 +1,155 @@
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "core_ev.h"
+
+TEST_CASE("ev_recv_ex: detects per-subscriber seq gaps (DROP_NEW)", "[core__ev]")
+{
+    ev_init();
+
+    ev_queue_t q = NULL;
+    TEST_ASSERT_TRUE(ev_subscribe(&q, 1));
+
+    // depth=1: pierwszy post trafia do kolejki, dwa kolejne to enq_fail.
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 1));
+    TEST_ASSERT_FALSE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 0));
+    TEST_ASSERT_FALSE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 1));
+
+    ev_msg_t m = {0};
+    ev_recv_info_t info = {0};
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, pdMS_TO_TICKS(100), &info));
+    TEST_ASSERT_EQUAL_UINT32(1u, m.seq);
+    TEST_ASSERT_EQUAL_UINT32(0u, info.lost);
+
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 0));
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, pdMS_TO_TICKS(100), &info));
+    TEST_ASSERT_EQUAL_UINT32(4u, m.seq);
+    TEST_ASSERT_EQUAL_UINT32(2u, info.lost);
+
+    ev_sub_stats_t ss[EV_MAX_SUBS];
+    const size_t n = ev_get_sub_stats(ss, EV_MAX_SUBS);
+    TEST_ASSERT_EQUAL_UINT32(1u, (uint32_t)n);
+    TEST_ASSERT_EQUAL_UINT32(2u, ss[0].received);
+    TEST_ASSERT_EQUAL_UINT32(2u, ss[0].lost);
+
+    ev_stats_t s = {0};
+    ev_get_stats(&s);
+    TEST_ASSERT_EQUAL_UINT32(2u, s.lost);
+    TEST_ASSERT_EQUAL_UINT32(2u, s.enq_fail);
+
+    ev_unsubscribe(q);
+    vQueueDelete(q);
+}
+
+TEST_CASE("ev_recv_ex: seq gap before an expired message is still reported", "[core__ev]")
+{
+    ev_init();
+
+    ev_queue_t q = NULL;
+    TEST_ASSERT_TRUE(ev_subscribe(&q, 2));
+
+    const ev_meta_t* meta = ev_meta_find(EV_SRC_LCD, EV_LCD_CMD_FLUSH);
+    TEST_ASSERT_NOT_NULL(meta);
+    TEST_ASSERT_TRUE(meta->ttl_ms > 0);
+
+    // depth=2: seq 1 i 2 w kolejce, seq 3 to enq_fail.
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_LCD, EV_LCD_CMD_FLUSH, 0, 0));
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_LCD, EV_LCD_CMD_FLUSH, 0, 0));
+    TEST_ASSERT_FALSE(ev_post(EV_SRC_LCD, EV_LCD_CMD_FLUSH, 0, 0));
+
+    ev_msg_t m = {0};
+    ev_recv_info_t info = {0};
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, pdMS_TO_TICKS(100), &info));
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, pdMS_TO_TICKS(100), &info));
+    TEST_ASSERT_EQUAL_UINT32(2u, m.seq);
+
+    // seq 4 (za luką) przeterminuje się, za nim świeże zdarzenie innego typu.
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_LCD, EV_LCD_CMD_FLUSH, 0, 0));
+    vTaskDelay(pdMS_TO_TICKS(meta->ttl_ms + 50));
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 1));
+
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, pdMS_TO_TICKS(100), &info));
+    TEST_ASSERT_EQUAL_UINT16(EV_GPIO_INPUT, m.code);
+    TEST_ASSERT_EQUAL_UINT32(1u, info.expired);
+    TEST_ASSERT_EQUAL_UINT32(1u, info.lost);
+
+    ev_stats_t s = {0};
+    ev_get_stats(&s);
+    TEST_ASSERT_EQUAL_UINT32(1u, s.lost);
+    TEST_ASSERT_EQUAL_UINT32(1u, s.expired);
+
+    ev_unsubscribe(q);
+    vQueueDelete(q);
+}
+
+/* Wiadomość z zadanym seq prosto do kolejki — symuluje odwróconą kolejność enqueue dwóch postów. */
+static void push_seq_(ev_queue_t q, ev_src_t src, uint16_t code, uint32_t seq)
+{
+    const ev_msg_t m = { .src = src, .code = code, .t_ms = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS), .seq = seq };
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueSend(q, &m, 0));
+}
+
+static uint32_t sub_lost_(void)
+{
+    ev_sub_stats_t ss[EV_MAX_SUBS];
+    TEST_ASSERT_EQUAL_UINT32(1u, (uint32_t)ev_get_sub_stats(ss, EV_MAX_SUBS));
+    return ss[0].lost;
+}
+
+TEST_CASE("ev_recv_ex: late seq only cancels a gap counted for the same event", "[core__ev]")
+{
+    ev_init();
+
+    ev_queue_t q = NULL;
+    TEST_ASSERT_TRUE(ev_subscribe(&q, 8));
+
+    ev_msg_t m = {0};
+    ev_recv_info_t info = {0};
+
+    // GPIO: seq 1, 3 — seq 2 policzony jako strata.
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 1);
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 3);
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_EQUAL_UINT32(1u, info.lost);
+    TEST_ASSERT_EQUAL_UINT32(1u, sub_lost_());
+
+    // Inny event przychodzi w odwróconej kolejności bez naliczonej luki: strata GPIO zostaje.
+    push_seq_(q, EV_SRC_LCD, EV_LCD_CMD_FLUSH, 5);
+    push_seq_(q, EV_SRC_LCD, EV_LCD_CMD_FLUSH, 4);
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_EQUAL_UINT32(4u, m.seq);
+    TEST_ASSERT_EQUAL_UINT32(1u, sub_lost_());
+
+    // Duplikat ostatniego seq też nie.
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 3);
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_EQUAL_UINT32(1u, sub_lost_());
+
+    // Spóźniony seq 2 trafia w naliczoną lukę — raz.
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 2);
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 2);
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_EQUAL_UINT32(0u, sub_lost_());
+    TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_EQUAL_UINT32(0u, sub_lost_());
+
+    // Luka przesuwa się w oknie: po 5, 7, 8 brakuje 4 i 6; spóźniony 4 zostawia stratę seq 6.
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 5);
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 7);
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 8);
+    push_seq_(q, EV_SRC_GPIO, EV_GPIO_INPUT, 4);
+    for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(ev_recv_ex(q, &m, 0, &info));
+    TEST_ASSERT_EQUAL_UINT32(1u, sub_lost_());
+
+    ev_stats_t s = {0};
+    ev_get_stats(&s);
+    TEST_ASSERT_EQUAL_UINT32(1u, s.lost);
+
+    ev_unsubscribe(q);
+    vQueueDelete(q);
+}
@@ -0,0 +1,51 @@
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "core_ev.h"
+
+#include <string.h>
+
+TEST_CASE("ev_recv: drops expired LEASE (TTL) and releases slot", "[core__ev]")
+{
+    lp_init();
+    ev_init();
+
+    ev_queue_t q = NULL;
+    TEST_ASSERT_TRUE(ev_subscribe(&q, 4));
+
+    const ev_meta_t* meta = ev_meta_find(EV_SRC_LCD, EV_LCD_CMD_DRAW_ROW);
+    TEST_ASSERT_NOT_NULL(meta);
+    TEST_ASSERT_TRUE(meta->ttl_ms > 0);
+
+    // Zaległy (stary) DRAW_ROW...
+    lp_handle_t h = lp_alloc_try(4);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    lp_view_t v = {0};
+    TEST_ASSERT_TRUE(lp_acquire(h, &v));
+    memcpy(v.ptr, "OLD!", 4);
+    lp_commit(h, 4);
+    TEST_ASSERT_TRUE(ev_post_lease(EV_SRC_LCD, EV_LCD_CMD_DRAW_ROW, h, 4));
+
+    vTaskDelay(pdMS_TO_TICKS(meta->ttl_ms + 50));
+
+    // ...i świeże zdarzenie bez TTL za nim.
+    TEST_ASSERT_TRUE(ev_post(EV_SRC_LCD, EV_LCD_CMD_SET_RGB, 0x00010203u, 0));
+
+    ev_msg_t m = {0};
+    TEST_ASSERT_TRUE(ev_recv(q, &m, pdMS_TO_TICKS(100)));
+    TEST_ASSERT_EQUAL_UINT16(EV_LCD_CMD_SET_RGB, m.code);
+
+    // Lease przeterminowanego zdarzenia wrócił do puli.
+    lp_stats_t st = {0};
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT16(st.slots_total, st.slots_free);
+
+    ev_stats_t s = {0};
+    ev_get_stats(&s);
+    TEST_ASSERT_EQUAL_UINT32(1u, s.expired);
+
+    ev_unsubscribe(q);
+    vQueueDelete(q);
+}
@@ -0,0 +1,114 @@
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "core_ev.h"
+
+#include <string.h>
+
+#define UNSUB_TASKS_    2
+#define UNSUB_PER_TASK_ (EV_MAX_SUBS / UNSUB_TASKS_)
+
+typedef struct {
+    TaskHandle_t parent;
+    ev_queue_t   qs[UNSUB_PER_TASK_];
+    bool         ok;
+} unsub_job_t;
+
+static volatile bool s_stop = false;
+static volatile uint32_t s_posts = 0;
+
+/* Odbiór z wypiętej kolejki: oddaje referencje LEASE, które zdążyły do niej dojść. */
+static void drain_(ev_queue_t q)
+{
+    ev_msg_t m;
+    while (xQueueReceive(q, &m, 0) == pdTRUE) {
+        if (m.src == EV_SRC_LOG && m.code == EV_LOG_NEW) lp_release(lp_unpack_handle_u32(m.a0));
+    }
+}
+
+static void task_broadcaster(void* arg)
+{
+    TaskHandle_t parent = (TaskHandle_t)arg;
+
+    while (!s_stop) {
+        // LEASE i krytyczne idą pasem, zwykłe kolejką główną; pełne kolejki nie przeszkadzają.
+        const lp_handle_t h = lp_alloc_try(8);
+        lp_view_t v;
+        if (lp_acquire(h, &v)) {
+            memset(v.ptr, 0x5A, 8);
+            lp_commit(h, 8);
+            (void)ev_post_lease(EV_SRC_LOG, EV_LOG_NEW, h, 8);
+        }
+        (void)ev_post_from_isr(EV_SRC_I2C, EV_I2C_ERROR, 1, 0);
+        (void)ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 0);
+        s_posts++;
+    }
+
+    xTaskNotifyGive(parent);
+    vTaskDelete(NULL);
+}
+
+static void task_unsubscriber(void* arg)
+{
+    unsub_job_t* job = (unsub_job_t*)arg;
+
+    job->ok = true;
+    for (size_t i = 0; i < UNSUB_PER_TASK_; i++) {
+        vTaskDelay(1);
+        job->ok = ev_unsubscribe(job->qs[i]) && job->ok;
+        // Po powrocie bus nie trzyma już q ani pasu: drenaż i usunięcie są bezpieczne.
+        drain_(job->qs[i]);
+        vQueueDelete(job->qs[i]);
+    }
+
+    xTaskNotifyGive(job->parent);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("ev_unsubscribe: two tasks unsubscribe concurrently under broadcast traffic", "[core__ev]")
+{
+    ev_init();
+    lp_init();
+
+    static unsub_job_t jobs[UNSUB_TASKS_];
+    for (size_t t = 0; t < UNSUB_TASKS_; t++) {
+        jobs[t].parent = xTaskGetCurrentTaskHandle();
+        for (size_t i = 0; i < UNSUB_PER_TASK_; i++) {
+            TEST_ASSERT_TRUE(ev_subscribe(&jobs[t].qs[i], 4));
+        }
+    }
+
+    s_stop = false;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(task_broadcaster, "ev_bcast", 3072, xTaskGetCurrentTaskHandle(),
+                                          uxTaskPriorityGet(NULL), NULL));
+    vTaskDelay(pdMS_TO_TICKS(5)); // kolejki i pasy zapełnione, nadawca w pętli
+
+    // Wypięcia nakładają się; przy ciągłym ruchu żadne nie może utknąć w czekaniu.
+    for (size_t t = 0; t < UNSUB_TASKS_; t++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(task_unsubscriber, "ev_unsub", 3072, &jobs[t],
+                                              uxTaskPriorityGet(NULL), NULL));
+    }
+    // Notyfikacje się sumują: jedno ulTaskNotifyTake() może zebrać oba zakończenia.
+    uint32_t done = 0;
+    while (done < UNSUB_TASKS_) {
+        const uint32_t n = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000));
+        TEST_ASSERT_TRUE(n > 0u);
+        done += n;
+    }
+    for (size_t t = 0; t < UNSUB_TASKS_; t++) {
+        TEST_ASSERT_TRUE(jobs[t].ok);
+    }
+
+    s_stop = true;
+    TEST_ASSERT_EQUAL_UINT32(1u, ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2000)));
+    TEST_ASSERT_TRUE(s_posts > 0u);
+
+    // Nikt już nie subskrybuje: każda referencja LEASE wróciła do puli.
+    lp_stats_t st;
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(0u, st.slots_used);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
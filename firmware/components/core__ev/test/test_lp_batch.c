@@ -0,0 +1,80 @@
+#include "unity.h"
+
+#include "core/leasepool.h"
+
+TEST_CASE("lp_release_ref_n: drops several references in one call", "[core__leasepool]")
+{
+    lp_init();
+    const uint16_t free0 = lp_free_count();
+
+    lp_handle_t h = lp_alloc_try(8);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+
+    // Rozgłoszenie do 4 odbiorców: addref z góry, 2 enqueue nieudane + referencja producenta.
+    lp_addref_n(h, 4);
+    lp_release_ref_n(h, 3);
+    lp_view_t v;
+    TEST_ASSERT_TRUE(lp_acquire(h, &v));
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+
+    // Dwaj odbiorcy, którzy dostali lease.
+    lp_release(h);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+    lp_release_ref_n(h, 1);
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+    TEST_ASSERT_FALSE(lp_acquire(h, &v));
+
+    // n == 0: no-op (brak nieudanych enqueue).
+    lp_release_ref_n(h, 0);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp_release_n: releases a drained batch, chains included", "[core__leasepool]")
+{
+    lp_init();
+    const uint16_t free0 = lp_free_count();
+
+    lp_class_stats_t top = {0};
+    TEST_ASSERT_TRUE(lp_get_class_stats(lp_class_count() - 1, &top));
+
+    lp_handle_t hs[4];
+    hs[0] = lp_alloc_try(8);
+    hs[1] = lp_alloc_chain_try(top.cap * 2u);
+    hs[2] = lp_invalid_handle(); // pomijany
+    hs[3] = lp_alloc_try(8);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(hs[0]));
+    TEST_ASSERT_TRUE(lp_handle_is_valid(hs[1]));
+    TEST_ASSERT_TRUE(lp_handle_is_valid(hs[3]));
+    TEST_ASSERT_EQUAL_UINT16(free0 - 4u, lp_free_count());
+
+    // Drugi konsument trzyma hs[3]: partia zdejmuje tylko jego referencję.
+    lp_addref_n(hs[3], 1);
+    lp_release_n(hs, 4);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+
+    lp_release_n(&hs[3], 1);
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp_release: generation wrap skips 0 (packed handle never 0)", "[core__leasepool]")
+{
+    lp_init();
+
+    // Zwolniony slot wraca na początek free‑listy: ten sam idx przechodzi przez wszystkie generacje.
+    lp_handle_t h = lp_alloc_try(8);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    const uint16_t idx = h.idx;
+    uint32_t same = 0;
+    for (uint32_t i = 0; i < 70000u; i++) {
+        TEST_ASSERT_NOT_EQUAL(0u, lp_pack_handle_u32(h));
+        TEST_ASSERT_NOT_EQUAL(0u, h.gen);
+        if (h.idx == idx) same++;
+        lp_release(h);
+        h = lp_alloc_try(8);
+        TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    }
+    lp_release(h);
+    TEST_ASSERT_TRUE(same > 65536u);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
@@ -0,0 +1,108 @@
+#include "unity.h"
+
+#include "core/leasepool.h"
+
+#include <stdint.h>
+#include <string.h>
+
+TEST_CASE("lp_alloc_chain_try: payload larger than a slot spans segments, released as a unit", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_class_stats_t top = {0};
+    TEST_ASSERT_TRUE(lp_get_class_stats(lp_class_count() - 1, &top));
+
+    const uint16_t free0 = lp_free_count();
+    const uint32_t want = top.cap * 2u + 10u;
+
+    lp_handle_t h = lp_alloc_chain_try(want);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    TEST_ASSERT_EQUAL_UINT16(free0 - 3u, lp_free_count());
+
+    lp_iov_t iov[4];
+    TEST_ASSERT_EQUAL_UINT32(3u, (uint32_t)lp_acquire_iov(h, iov, 4));
+
+    // Zapis wzorca przez segmenty, commit całości.
+    uint32_t off = 0;
+    for (size_t i = 0; i < 3; i++) {
+        const uint32_t n = (want - off < iov[i].cap) ? (want - off) : iov[i].cap;
+        for (uint32_t j = 0; j < n; j++) ((uint8_t*)iov[i].ptr)[j] = (uint8_t)(off + j);
+        off += n;
+    }
+    TEST_ASSERT_EQUAL_UINT32(want, off);
+    lp_commit(h, want);
+
+    // Współdzielenie: jeden refcount dla całego łańcucha.
+    lp_addref_n(h, 1);
+    lp_release(h);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 3u, lp_free_count());
+
+    TEST_ASSERT_EQUAL_UINT32(3u, (uint32_t)lp_acquire_iov(h, iov, 4));
+    off = 0;
+    for (size_t i = 0; i < 3; i++) {
+        for (uint32_t j = 0; j < iov[i].len; j++) {
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)(off + j), ((const uint8_t*)iov[i].ptr)[j]);
+        }
+        off += iov[i].len;
+    }
+    TEST_ASSERT_EQUAL_UINT32(want, off);
+    TEST_ASSERT_EQUAL_UINT32(10u, iov[2].len);
+
+    // Ostatni release zwalnia wszystkie segmenty; uchwyt staje się nieważny.
+    lp_release(h);
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+    TEST_ASSERT_EQUAL_UINT32(0u, (uint32_t)lp_acquire_iov(h, iov, 4));
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp_alloc_chain_try: all-or-nothing when the pool cannot hold the payload", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_stats_t st = {0};
+    lp_get_stats(&st);
+
+    uint32_t total_cap = 0;
+    for (size_t k = 0; k < lp_class_count(); k++) {
+        lp_class_stats_t cs = {0};
+        TEST_ASSERT_TRUE(lp_get_class_stats(k, &cs));
+        total_cap += cs.cap * cs.slots_total;
+    }
+
+    lp_handle_t h = lp_alloc_chain_try(total_cap + 1u);
+    TEST_ASSERT_FALSE(lp_handle_is_valid(h));
+    TEST_ASSERT_EQUAL_UINT16(st.slots_total, lp_free_count());
+
+    // Pojedynczy slot: lp_acquire_iov zwraca 1 segment.
+    h = lp_alloc_chain_try(8);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    lp_iov_t iov[1];
+    TEST_ASSERT_EQUAL_UINT32(1u, (uint32_t)lp_acquire_iov(h, iov, 1));
+    lp_release(h);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp buffers: every class and chain segment starts on LP_BUF_ALIGN", "[core__leasepool]")
+{
+    lp_init();
+
+    for (size_t k = 0; k < lp_class_count(); k++) {
+        lp_class_stats_t cs = {0};
+        TEST_ASSERT_TRUE(lp_get_class_stats(k, &cs));
+        lp_handle_t h = lp_alloc_try(cs.cap);
+        lp_view_t v;
+        TEST_ASSERT_TRUE(lp_acquire(h, &v));
+        TEST_ASSERT_EQUAL_UINT32(0u, (uint32_t)((uintptr_t)v.ptr % LP_BUF_ALIGN));
+        lp_release(h);
+    }
+
+    lp_class_stats_t top = {0};
+    TEST_ASSERT_TRUE(lp_get_class_stats(lp_class_count() - 1, &top));
+    lp_handle_t h = lp_alloc_chain_try(top.cap * 2u + 1u);
+    lp_iov_t iov[4];
+    const size_t n = lp_acquire_iov(h, iov, 4);
+    TEST_ASSERT_TRUE(n >= 2u && n <= 4u);
+    for (size_t i = 0; i < n; i++) TEST_ASSERT_EQUAL_UINT32(0u, (uint32_t)((uintptr_t)iov[i].ptr % LP_BUF_ALIGN));
+    lp_release(h);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
@@ -0,0 +1,113 @@
+#include "unity.h"
+
+#include "core/leasepool.h"
+
+#include <string.h>
+
+static lp_handle_t alloc_text_(const char* s)
+{
+    const uint32_t n = (uint32_t)strlen(s);
+    lp_handle_t h = lp_alloc_try(n);
+    lp_view_t v;
+    TEST_ASSERT_TRUE(lp_acquire(h, &v));
+    memcpy(v.ptr, s, n);
+    lp_commit(h, n);
+    return h;
+}
+
+TEST_CASE("lp_make_writable: sole holder gets the same lease, no copy", "[core__leasepool]")
+{
+    lp_init();
+    lp_reset_stats();
+    const uint16_t free0 = lp_free_count();
+
+    lp_handle_t h = alloc_text_("frame");
+    lp_handle_t w = lp_make_writable(h);
+    TEST_ASSERT_EQUAL_UINT16(h.idx, w.idx);
+    TEST_ASSERT_EQUAL_UINT16(h.gen, w.gen);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+
+    lp_stats_t st = {0};
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(1u, st.cow_inplace);
+    TEST_ASSERT_EQUAL_UINT32(0u, st.cow_copies);
+
+    lp_release(w);
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+}
+
+TEST_CASE("lp_make_writable: shared lease is copied, other holders keep the original", "[core__leasepool]")
+{
+    lp_init();
+    lp_reset_stats();
+    const uint16_t free0 = lp_free_count();
+
+    lp_handle_t h = alloc_text_("frame");
+    lp_addref_n(h, 1); // drugi subskrybent
+
+    lp_handle_t w = lp_make_writable(h);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(w));
+    TEST_ASSERT_NOT_EQUAL(h.idx, w.idx);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 2u, lp_free_count());
+
+    lp_view_t v;
+    TEST_ASSERT_TRUE(lp_acquire(w, &v));
+    TEST_ASSERT_EQUAL_UINT32(5u, v.len);
+    memcpy(v.ptr, "FRAME", 5);
+
+    TEST_ASSERT_TRUE(lp_acquire(h, &v));
+    TEST_ASSERT_EQUAL_MEMORY("frame", v.ptr, 5);
+
+    // Referencja wołającego do h przeszła na kopię: zostaje tylko drugi subskrybent.
+    lp_release(h);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+    lp_release(w);
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+
+    lp_stats_t st = {0};
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(0u, st.cow_inplace);
+    TEST_ASSERT_EQUAL_UINT32(1u, st.cow_copies);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp_make_writable: slice of a chain becomes a private copy of its range", "[core__leasepool]")
+{
+    lp_init();
+    const uint16_t free0 = lp_free_count();
+
+    lp_class_stats_t top = {0};
+    TEST_ASSERT_TRUE(lp_get_class_stats(lp_class_count() - 1, &top));
+
+    // Łańcuch 2 x cap z wzorcem i slice przez granicę segmentów.
+    const uint32_t want = top.cap * 2u;
+    lp_handle_t h = lp_alloc_chain_try(want);
+    lp_iov_t iov[4];
+    const size_t n = lp_acquire_iov(h, iov, 4);
+    TEST_ASSERT_TRUE(n >= 2u && n <= 4u);
+    uint32_t off = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < iov[i].cap && off < want; j++, off++) ((uint8_t*)iov[i].ptr)[j] = (uint8_t)off;
+    }
+    lp_commit(h, want);
+
+    lp_handle_t sl = lp_slice(h, top.cap - 3u, 10u);
+    if (!lp_handle_is_valid(sl)) {
+        lp_release(h); // build bez slice'ów
+        return;
+    }
+    lp_release(h); // slice trzyma rodzica
+
+    lp_handle_t w = lp_make_writable(sl);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(w));
+    lp_view_t v;
+    TEST_ASSERT_TRUE(lp_acquire(w, &v));
+    TEST_ASSERT_EQUAL_UINT32(10u, v.len);
+    for (uint32_t j = 0; j < 10u; j++) TEST_ASSERT_EQUAL_UINT8((uint8_t)(top.cap - 3u + j), ((uint8_t*)v.ptr)[j]);
+
+    // Slice oddany -> rodzic zwolniony; zostaje sama kopia.
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+    lp_release(w);
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
@@ -0,0 +1,66 @@
+#include "unity.h"
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "core/leasepool.h"
+
+#if defined(CONFIG_CORE_LEASEPOOL_HIST) && CONFIG_CORE_LEASEPOOL_HIST
+
+TEST_CASE("lp_hist: lifetime lands in the log2 microsecond bucket", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_handle_t h = lp_alloc_try(8);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    lp_addref_n(h, 1);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    lp_release(h); // nie ostatnia referencja — nic nie liczy
+    lp_release(h);
+
+    lp_lifetime_hist_t lh;
+    TEST_ASSERT_TRUE(lp_get_lifetime_hist(lp_handle_class(h), &lh));
+    TEST_ASSERT_EQUAL_UINT32(1u, lh.count);
+
+    // ~20 ms = kubełek 15 ([2^14, 2^15) µs); z zapasem na ziarnistość ticka i planistę: 14..18.
+    uint32_t hit = 0;
+    for (uint32_t b = 14; b <= 18; b++) hit += lh.bucket[b];
+    TEST_ASSERT_EQUAL_UINT32(1u, hit);
+
+    lp_reset_stats();
+    TEST_ASSERT_TRUE(lp_get_lifetime_hist(0, &lh));
+    TEST_ASSERT_EQUAL_UINT32(0u, lh.count);
+}
+
+TEST_CASE("lp_hist: occupancy ring keeps the newest samples in order", "[core__leasepool]")
+{
+    lp_init();
+
+    enum { N = 3 };
+    lp_handle_t hs[N];
+    for (uint32_t i = 0; i < N; i++) {
+        hs[i] = lp_alloc_try(8);
+        TEST_ASSERT_TRUE(lp_handle_is_valid(hs[i]));
+        lp_occ_sample();
+    }
+
+    lp_occ_sample_t smp[CONFIG_CORE_LEASEPOOL_HIST_OCC_SAMPLES];
+    size_t n = lp_get_occupancy(smp, CONFIG_CORE_LEASEPOOL_HIST_OCC_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(N, (uint32_t)n);
+    for (uint32_t i = 0; i < N; i++) TEST_ASSERT_EQUAL_UINT16(i + 1u, smp[i].used);
+
+    // Przepełnienie ringu: zostają najnowsze, od najstarszej.
+    for (uint32_t i = 0; i < CONFIG_CORE_LEASEPOOL_HIST_OCC_SAMPLES; i++) lp_occ_sample();
+    lp_release(hs[0]);
+    lp_occ_sample();
+    n = lp_get_occupancy(smp, CONFIG_CORE_LEASEPOOL_HIST_OCC_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(CONFIG_CORE_LEASEPOOL_HIST_OCC_SAMPLES, (uint32_t)n);
+    TEST_ASSERT_EQUAL_UINT16(N, smp[0].used);
+    TEST_ASSERT_EQUAL_UINT16(N - 1u, smp[n - 1].used);
+
+    lp_release(hs[1]);
+    lp_release(hs[2]);
+}
+
+#endif /* CONFIG_CORE_LEASEPOOL_HIST */
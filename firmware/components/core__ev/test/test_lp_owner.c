@@ -0,0 +1,87 @@
+#include "unity.h"
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "core/leasepool.h"
+
+#include <string.h>
+
+#if defined(CONFIG_CORE_LEASEPOOL_OWNERS) && CONFIG_CORE_LEASEPOOL_OWNERS >= 3
+
+static const lp_owner_stats_t* find_owner_(const lp_owner_stats_t* os, size_t n, const char* tag)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(os[i].tag, tag) == 0) return &os[i];
+    }
+    return NULL;
+}
+
+TEST_CASE("lp_owner: per-owner outstanding counts follow alloc/release", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_handle_t a = lp_alloc_try(8);
+    lp_handle_t b = lp_alloc_try(8);
+    lp_handle_t u = lp_alloc_try(8);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(a) && lp_handle_is_valid(b) && lp_handle_is_valid(u));
+    TEST_ASSERT_TRUE(lp_set_owner(a, "test_a"));
+    TEST_ASSERT_TRUE(lp_set_owner(b, "test_b"));
+
+    lp_owner_stats_t os[8];
+    size_t n = lp_get_owner_stats(os, 8);
+    TEST_ASSERT_EQUAL_UINT32(3u, (uint32_t)n);
+    TEST_ASSERT_EQUAL_STRING("-", os[0].tag);
+    TEST_ASSERT_EQUAL_UINT16(1u, os[0].leases);
+
+    const lp_owner_stats_t* oa = find_owner_(os, n, "test_a");
+    TEST_ASSERT_NOT_NULL(oa);
+    TEST_ASSERT_EQUAL_UINT16(1u, oa->slots_held);
+    TEST_ASSERT_EQUAL_UINT32(1u, oa->tagged);
+
+    lp_release(a);
+    n = lp_get_owner_stats(os, 8);
+    oa = find_owner_(os, n, "test_a");
+    TEST_ASSERT_NOT_NULL(oa);
+    TEST_ASSERT_EQUAL_UINT16(0u, oa->slots_held);
+    TEST_ASSERT_EQUAL_UINT16(1u, find_owner_(os, n, "test_b")->leases);
+
+    // Po zwolnieniu uchwyt jest nieważny — tagowanie odmawia.
+    TEST_ASSERT_FALSE(lp_set_owner(a, "test_a"));
+
+    lp_release(b);
+    lp_release(u);
+}
+
+TEST_CASE("lp_owner: leak detector reports a held lease once", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_handle_t h = lp_alloc_try(8);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    TEST_ASSERT_TRUE(lp_set_owner(h, "test_leak"));
+
+    // Świeży lease nie jest wyciekiem.
+    TEST_ASSERT_EQUAL_UINT16(0u, lp_leak_scan(1000, false));
+
+    vTaskDelay(pdMS_TO_TICKS(30));
+    TEST_ASSERT_EQUAL_UINT16(1u, lp_leak_scan(20, true));
+    TEST_ASSERT_EQUAL_UINT16(1u, lp_leak_scan(20, true)); // nadal stary, ale zgłoszony raz
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(1u, st.leaks_detected);
+
+    lp_owner_stats_t os[8];
+    const size_t n = lp_get_owner_stats(os, 8);
+    const lp_owner_stats_t* o = find_owner_(os, n, "test_leak");
+    TEST_ASSERT_NOT_NULL(o);
+    TEST_ASSERT_EQUAL_UINT32(1u, o->leaks);
+    TEST_ASSERT_TRUE(o->oldest_ms >= 20u);
+
+    lp_release(h);
+    TEST_ASSERT_EQUAL_UINT16(0u, lp_leak_scan(20, false));
+}
+
+#endif /* CONFIG_CORE_LEASEPOOL_OWNERS >= 3 */
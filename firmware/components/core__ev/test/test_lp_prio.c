@@ -0,0 +1,65 @@
+#include "unity.h"
+
+#include "sdkconfig.h"
+#include "core/leasepool.h"
+
+#if defined(CONFIG_CORE_LEASEPOOL_RESERVE_CRITICAL) && CONFIG_CORE_LEASEPOOL_RESERVE_CRITICAL > 0
+
+enum { MAX_HELD = 512 };
+static lp_handle_t s_held[MAX_HELD];
+
+/* Alokuje z danym priorytetem aż do porażki; zwraca liczbę udanych. */
+static uint32_t fill_(lp_prio_t prio, uint32_t* held)
+{
+    uint32_t n = 0;
+    while (*held < MAX_HELD) {
+        lp_handle_t h = lp_alloc_try_prio(8, prio);
+        if (!lp_handle_is_valid(h)) break;
+        s_held[(*held)++] = h;
+        n++;
+    }
+    return n;
+}
+
+TEST_CASE("lp_alloc_try_prio: low-priority flood cannot take reserved slots", "[core__leasepool]")
+{
+    lp_init();
+
+    uint32_t res_crit = 0, res_norm = 0;
+    for (size_t k = 0; k < lp_class_count(); k++) {
+        lp_class_stats_t cs = {0};
+        TEST_ASSERT_TRUE(lp_get_class_stats(k, &cs));
+        res_crit += cs.reserve_critical;
+        res_norm += cs.reserve_normal;
+    }
+    TEST_ASSERT_TRUE(res_crit > 0);
+
+    uint32_t held = 0;
+    const uint32_t low = fill_(LP_PRIO_LOW, &held);
+    TEST_ASSERT_TRUE(low > 0);
+
+    // Po zalewie LOW zostały dokładnie rezerwy: najpierw NORMAL, potem CRITICAL.
+    TEST_ASSERT_EQUAL_UINT32(res_norm, fill_(LP_PRIO_NORMAL, &held));
+    TEST_ASSERT_EQUAL_UINT32(res_crit, fill_(LP_PRIO_CRITICAL, &held));
+    TEST_ASSERT_EQUAL_UINT16(0u, lp_free_count());
+
+    lp_stats_t st = {0};
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT32(1u, st.drops_prio[LP_PRIO_LOW]);
+    TEST_ASSERT_EQUAL_UINT32(1u, st.drops_prio[LP_PRIO_NORMAL]);
+    TEST_ASSERT_EQUAL_UINT32(1u, st.drops_prio[LP_PRIO_CRITICAL]);
+    TEST_ASSERT_EQUAL_UINT32(3u, st.drops_alloc_fail);
+
+    // Zwolniony slot wraca do rezerwy: LOW dalej odmawia, CRITICAL dostaje.
+    lp_release(s_held[--held]);
+    TEST_ASSERT_FALSE(lp_handle_is_valid(lp_alloc_try_prio(8, LP_PRIO_LOW)));
+    lp_handle_t c = lp_alloc_try_prio(8, LP_PRIO_CRITICAL);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(c));
+    lp_release(c);
+
+    while (held > 0) lp_release(s_held[--held]);
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT16(st.slots_total, lp_free_count());
+}
+
+#endif /* CONFIG_CORE_LEASEPOOL_RESERVE_CRITICAL > 0 */
@@ -0,0 +1,119 @@
+#include "unity.h"
+
+#include "core/leasepool.h"
+
+#include <string.h>
+
+TEST_CASE("lp_ring: leases released in order are reused without the free list", "[core__leasepool]")
+{
+    lp_init();
+    lp_reset_stats();
+    const uint16_t free0 = lp_free_count();
+
+    lp_ring_t r;
+    TEST_ASSERT_TRUE(lp_ring_init(&r, 16u, 4u));
+    TEST_ASSERT_EQUAL_UINT16(free0 - 4u, lp_free_count());
+
+    lp_class_stats_t cs = {0};
+    TEST_ASSERT_TRUE(lp_get_class_stats(r.cls, &cs));
+    TEST_ASSERT_EQUAL_UINT16(4u, cs.ring_slots);
+    const uint16_t fl0 = cs.free_global;
+
+    // Trzy okrążenia: acquire -> zapis -> commit -> release, po kolei.
+    lp_handle_t first = lp_invalid_handle();
+    for (uint32_t i = 0; i < 12u; i++) {
+        lp_handle_t h = lp_ring_acquire(&r);
+        TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+        if (i == 0) first = h;
+        if (i == 4u) {
+            TEST_ASSERT_EQUAL_UINT16(first.idx, h.idx);           // ten sam slot po okrążeniu
+            TEST_ASSERT_NOT_EQUAL(first.gen, h.gen);              // nowa generacja
+        }
+
+        lp_view_t v;
+        TEST_ASSERT_TRUE(lp_acquire(h, &v));
+        memcpy(v.ptr, "seg", 3);
+        lp_commit(h, 3);
+        lp_release(h);
+    }
+    TEST_ASSERT_EQUAL_UINT32(12u, r.acquired);
+
+    // Stary uchwyt nieważny; pula i free‑lista nietknięte.
+    lp_view_t v;
+    TEST_ASSERT_FALSE(lp_acquire(first, &v));
+    TEST_ASSERT_TRUE(lp_get_class_stats(r.cls, &cs));
+    TEST_ASSERT_EQUAL_UINT16(fl0, cs.free_global);
+    TEST_ASSERT_EQUAL_UINT32(0u, cs.alloc_ok);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+
+    TEST_ASSERT_TRUE(lp_ring_deinit(&r));
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp_ring: slow consumer makes acquire fail until the oldest lease is released", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_ring_t r;
+    TEST_ASSERT_TRUE(lp_ring_init(&r, 16u, 2u));
+
+    lp_handle_t a = lp_ring_acquire(&r);
+    lp_handle_t b = lp_ring_acquire(&r);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(a));
+    TEST_ASSERT_TRUE(lp_handle_is_valid(b));
+
+    TEST_ASSERT_FALSE(lp_handle_is_valid(lp_ring_acquire(&r)));
+    TEST_ASSERT_EQUAL_UINT32(1u, r.full);
+
+    // Zwolnienie poza kolejnością nie odblokowuje ringu (następny w obiegu to a).
+    lp_release(b);
+    TEST_ASSERT_FALSE(lp_handle_is_valid(lp_ring_acquire(&r)));
+
+    // Drugi subskrybent trzyma a: slot wraca dopiero po ostatniej referencji.
+    lp_addref_n(a, 1);
+    lp_release(a);
+    TEST_ASSERT_FALSE(lp_ring_deinit(&r));
+    TEST_ASSERT_FALSE(lp_handle_is_valid(lp_ring_acquire(&r)));
+    lp_release(a);
+
+    lp_handle_t c = lp_ring_acquire(&r);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(c));
+    TEST_ASSERT_EQUAL_UINT16(a.idx, c.idx);
+    TEST_ASSERT_EQUAL_UINT32(3u, r.full);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+
+    lp_release(c);
+    TEST_ASSERT_TRUE(lp_ring_deinit(&r));
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp_ring: slices keep the ring slot until the last frame is released", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_ring_t r;
+    TEST_ASSERT_TRUE(lp_ring_init(&r, 16u, 1u));
+
+    lp_handle_t h = lp_ring_acquire(&r);
+    lp_view_t v;
+    TEST_ASSERT_TRUE(lp_acquire(h, &v));
+    memcpy(v.ptr, "a\nb\n", 4);
+    lp_commit(h, 4);
+
+    lp_handle_t f = lp_slice(h, 2u, 2u);
+    if (!lp_handle_is_valid(f)) { // build bez slice'ów
+        lp_release(h);
+        TEST_ASSERT_TRUE(lp_ring_deinit(&r));
+        return;
+    }
+    lp_release(h);
+    TEST_ASSERT_FALSE(lp_handle_is_valid(lp_ring_acquire(&r)));
+
+    lp_release(f);
+    h = lp_ring_acquire(&r);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    lp_release(h);
+    TEST_ASSERT_TRUE(lp_ring_deinit(&r));
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
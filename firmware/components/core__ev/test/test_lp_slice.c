@@ -0,0 +1,96 @@
+#include "unity.h"
+
+#include "sdkconfig.h"
+#include "core/leasepool.h"
+
+#include <string.h>
+
+#if defined(CONFIG_CORE_LEASEPOOL_SLICES) && CONFIG_CORE_LEASEPOOL_SLICES >= 3
+
+TEST_CASE("lp_slice: frames share the parent buffer and keep it alive", "[core__leasepool]")
+{
+    lp_init();
+    const uint16_t free0 = lp_free_count();
+
+    static const char batch[] = "AT\nOK\nERR";
+    const uint32_t n = (uint32_t)strlen(batch);
+
+    lp_handle_t h = lp_alloc_try(n);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    lp_view_t v;
+    TEST_ASSERT_TRUE(lp_acquire(h, &v));
+    memcpy(v.ptr, batch, n);
+    lp_commit(h, n);
+
+    lp_handle_t f0 = lp_slice(h, 0, 3);
+    lp_handle_t f1 = lp_slice(h, 3, 3);
+    lp_handle_t f2 = lp_slice(h, 6, 3);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(f0) && lp_handle_is_valid(f1) && lp_handle_is_valid(f2));
+    TEST_ASSERT_TRUE(lp_handle_is_slice(f1));
+
+    // Poza zatwierdzonymi danymi -> odmowa.
+    TEST_ASSERT_FALSE(lp_handle_is_valid(lp_slice(h, 6, 4)));
+
+    // Producent oddaje swoją referencję; rodzic żyje dzięki slice'om.
+    lp_release(h);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+
+    lp_view_t fv;
+    TEST_ASSERT_TRUE(lp_acquire(f1, &fv));
+    TEST_ASSERT_EQUAL_UINT32(3u, fv.len);
+    TEST_ASSERT_EQUAL_MEMORY("OK\n", fv.ptr, 3);
+    TEST_ASSERT_EQUAL_PTR((const uint8_t*)v.ptr + 3, fv.ptr); // bez kopii
+
+    // Slice ze slice'a: zakres względem slice'a, rodzicem jest korzeń.
+    lp_handle_t f2b = lp_slice(f2, 1, 2);
+    TEST_ASSERT_TRUE(lp_acquire(f2b, &fv));
+    TEST_ASSERT_EQUAL_MEMORY("RR", fv.ptr, 2);
+
+    lp_release(f0);
+    lp_release(f1);
+    lp_release(f2);
+    TEST_ASSERT_EQUAL_UINT16(free0 - 1u, lp_free_count());
+    lp_release(f2b);
+    TEST_ASSERT_EQUAL_UINT16(free0, lp_free_count());
+
+    // Stary uchwyt slice'a jest nieważny.
+    TEST_ASSERT_FALSE(lp_acquire(f1, &fv));
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    TEST_ASSERT_EQUAL_UINT16(0u, st.slices_used);
+    TEST_ASSERT_EQUAL_UINT16(4u, st.slices_peak_used);
+    TEST_ASSERT_EQUAL_INT(0, lp_check(false));
+}
+
+TEST_CASE("lp_slice: range spanning chained segments", "[core__leasepool]")
+{
+    lp_init();
+
+    lp_class_stats_t top = {0};
+    TEST_ASSERT_TRUE(lp_get_class_stats(lp_class_count() - 1, &top));
+    const uint32_t want = top.cap * 2u;
+
+    lp_handle_t h = lp_alloc_chain_try(want);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(h));
+    lp_iov_t iov[2];
+    TEST_ASSERT_EQUAL_UINT32(2u, (uint32_t)lp_acquire_iov(h, iov, 2));
+    memset(iov[0].ptr, 'a', iov[0].cap);
+    memset(iov[1].ptr, 'b', iov[1].cap);
+    lp_commit(h, want);
+
+    lp_handle_t s = lp_slice(h, top.cap - 2u, 4u);
+    TEST_ASSERT_TRUE(lp_handle_is_valid(s));
+    lp_release(h);
+
+    TEST_ASSERT_EQUAL_UINT32(2u, (uint32_t)lp_acquire_iov(s, iov, 2));
+    TEST_ASSERT_EQUAL_UINT32(2u, iov[0].len);
+    TEST_ASSERT_EQUAL_UINT32(2u, iov[1].len);
+    TEST_ASSERT_EQUAL_MEMORY("aa", iov[0].ptr, 2);
+    TEST_ASSERT_EQUAL_MEMORY("bb", iov[1].ptr, 2);
+
+    lp_release(s);
+    TEST_ASSERT_EQUAL_UINT16(0u, lp_used_count());
+}
+
+#endif /* CONFIG_CORE_LEASEPOOL_SLICES >= 3 */
@@ -0,0 +1,85 @@
+#include "unity.h"
+
+#include "core/mpsc_ring.h"
+
+#include <string.h>
+
+static uint8_t s_storage[32] __attribute__((aligned(4)));
+
+TEST_CASE("mpsc_ring: records are delivered in reservation order once committed", "[core__spsc_ring]")
+{
+    mpsc_ring_t rb;
+    TEST_ASSERT_TRUE(mpsc_ring_init(&rb, s_storage, sizeof(s_storage)));
+    TEST_ASSERT_EQUAL_UINT32(12u, mpsc_ring_record_max(&rb));
+
+    // Dwóch producentów: B zatwierdza pierwszy, ale A (wcześniejsza rezerwacja) wstrzymuje odczyt.
+    mpsc_ring_resv_t res_a, res_b;
+    uint8_t* a = mpsc_ring_reserve(&rb, 8, &res_a);
+    uint8_t* b = mpsc_ring_reserve(&rb, 8, &res_b);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    memcpy(b, "bbbbbbbb", 8);
+    mpsc_ring_commit(&rb, &res_b, 8);
+
+    size_t n = 1;
+    TEST_ASSERT_NULL(mpsc_ring_peek(&rb, &n));
+    TEST_ASSERT_EQUAL_UINT32(0u, n);
+
+    memcpy(a, "aaaa", 4);
+    mpsc_ring_commit(&rb, &res_a, 4);
+    const uint8_t* r = mpsc_ring_peek(&rb, &n);
+    TEST_ASSERT_EQUAL_UINT32(4u, n);
+    TEST_ASSERT_EQUAL_MEMORY("aaaa", r, 4);
+    mpsc_ring_consume(&rb);
+    r = mpsc_ring_peek(&rb, &n);
+    TEST_ASSERT_EQUAL_UINT32(8u, n);
+    TEST_ASSERT_EQUAL_MEMORY("bbbbbbbb", r, 8);
+    mpsc_ring_consume(&rb);
+    TEST_ASSERT_EQUAL_UINT32(0u, mpsc_ring_used(&rb));
+
+    // 8 B do końca bufora nie mieści rekordu 6 B (12 z nagłówkiem) -> wypełniacz, rekord od 0.
+    mpsc_ring_resv_t res_c;
+    uint8_t* c = mpsc_ring_reserve(&rb, 6, &res_c);
+    TEST_ASSERT_EQUAL_PTR(s_storage + 4, c);
+    memcpy(c, "wrappd", 6);
+    mpsc_ring_commit(&rb, &res_c, 6);
+    TEST_ASSERT_EQUAL_UINT32(20u, mpsc_ring_used(&rb));
+    r = mpsc_ring_peek(&rb, &n);
+    TEST_ASSERT_EQUAL_UINT32(6u, n);
+    TEST_ASSERT_EQUAL_MEMORY("wrappd", r, 6);
+    TEST_ASSERT_EQUAL_UINT32(12u, mpsc_ring_used(&rb));
+    mpsc_ring_consume(&rb);
+    TEST_ASSERT_NULL(mpsc_ring_peek(&rb, &n));
+}
+
+TEST_CASE("mpsc_ring: full ring, oversize and abandoned reservations", "[core__spsc_ring]")
+{
+    mpsc_ring_t rb;
+    TEST_ASSERT_TRUE(mpsc_ring_init(&rb, s_storage, sizeof(s_storage)));
+
+    mpsc_ring_resv_t r0, r1, r2;
+    TEST_ASSERT_NULL(mpsc_ring_reserve(&rb, 0, &r0));
+    TEST_ASSERT_NULL(mpsc_ring_reserve(&rb, 13, &r0));
+
+    TEST_ASSERT_NOT_NULL(mpsc_ring_reserve(&rb, 12, &r0));
+    uint8_t* w = mpsc_ring_reserve(&rb, 12, &r1);
+    TEST_ASSERT_NOT_NULL(w);
+    TEST_ASSERT_NULL(mpsc_ring_reserve(&rb, 1, &r2));
+
+    // Porzucony rekord jest pomijany przez konsumenta i oddaje miejsce.
+    memset(w, 'b', 12);
+    mpsc_ring_commit(&rb, &r1, 12);
+    mpsc_ring_commit(&rb, &r0, 0);
+
+    size_t n = 0;
+    const uint8_t* r = mpsc_ring_peek(&rb, &n);
+    TEST_ASSERT_EQUAL_UINT32(12u, n);
+    TEST_ASSERT_EQUAL_UINT8('b', r[11]);
+    TEST_ASSERT_EQUAL_UINT32(16u, mpsc_ring_used(&rb));
+    mpsc_ring_consume(&rb);
+
+    // Oddane bajty są wyzerowane (nagłówek w nowym miejscu = niezatwierdzony).
+    static const uint8_t zero[sizeof(s_storage)];
+    TEST_ASSERT_EQUAL_UINT32(0u, mpsc_ring_used(&rb));
+    TEST_ASSERT_EQUAL_MEMORY(zero, s_storage, sizeof(s_storage));
+}
@@ -0,0 +1,89 @@
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "core/spsc_ring.h"
+#include "core/mpsc_ring.h"
+
+#include <string.h>
+
+static uint8_t s_storage[64] __attribute__((aligned(4)));
+static spsc_ring_t s_rb;
+
+static void task_writer(void* arg)
+{
+    (void)arg;
+    // 4 x 8 B z przerwami: czekający na 24 B nie budzi się po pierwszej porcji.
+    for (int i = 0; i < 4; i++) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+        (void)spsc_ring_write(&s_rb, "01234567", 8, true);
+    }
+    vTaskDelete(NULL);
+}
+
+static void task_reader(void* arg)
+{
+    (void)arg;
+    uint8_t out[16];
+    vTaskDelay(pdMS_TO_TICKS(5));
+    (void)spsc_ring_read(&s_rb, out, sizeof(out));
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("spsc_ring_wait_readable/writable: block until the threshold, time out otherwise", "[core__spsc_ring]")
+{
+    TEST_ASSERT_TRUE(spsc_ring_init(&s_rb, s_storage, sizeof(s_storage)));
+    TEST_ASSERT_FALSE(spsc_ring_wait_readable(&s_rb, 1, pdMS_TO_TICKS(10))); // bez enable_wait
+    spsc_ring_enable_wait(&s_rb);
+
+    TEST_ASSERT_FALSE(spsc_ring_wait_readable(&s_rb, 1, pdMS_TO_TICKS(10)));
+    TEST_ASSERT_FALSE(spsc_ring_wait_readable(&s_rb, sizeof(s_storage) + 1u, portMAX_DELAY));
+
+    (void)xTaskCreate(task_writer, "rw_w", 2048, NULL, tskIDLE_PRIORITY + 2, NULL);
+    TEST_ASSERT_TRUE(spsc_ring_wait_readable(&s_rb, 24, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_TRUE(spsc_ring_used(&s_rb) >= 24u);
+    TEST_ASSERT_TRUE(spsc_ring_wait_readable(&s_rb, 32, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL_UINT32(32u, spsc_ring_used(&s_rb));
+
+    // Pełny ring: producent czeka na 16 B miejsca, aż konsument odczyta.
+    uint8_t fill[32];
+    memset(fill, 'x', sizeof(fill));
+    TEST_ASSERT_EQUAL_UINT32(32u, spsc_ring_write(&s_rb, fill, sizeof(fill), true));
+    TEST_ASSERT_FALSE(spsc_ring_wait_writable(&s_rb, 16, pdMS_TO_TICKS(10)));
+    (void)xTaskCreate(task_reader, "rw_r", 2048, NULL, tskIDLE_PRIORITY + 2, NULL);
+    TEST_ASSERT_TRUE(spsc_ring_wait_writable(&s_rb, 16, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_free(&s_rb));
+}
+
+TEST_CASE("mpsc_ring_arm_readable: one doorbell per batch", "[core__spsc_ring]")
+{
+    static mpsc_ring_t rb;
+    TEST_ASSERT_TRUE(mpsc_ring_init(&rb, s_storage, sizeof(s_storage)));
+    mpsc_ring_enable_wait(&rb);
+    TEST_ASSERT_TRUE(mpsc_ring_arm_readable(&rb));
+
+    // Pierwszy commit po uzbrojeniu dzwoni, kolejne już nie.
+    mpsc_ring_resv_t r;
+    for (int i = 0; i < 3; i++) {
+        uint8_t* w = mpsc_ring_reserve(&rb, 4, &r);
+        TEST_ASSERT_NOT_NULL(w);
+        memcpy(w, "line", 4);
+        TEST_ASSERT_EQUAL(i == 0, mpsc_ring_commit(&rb, &r, 4));
+    }
+
+    // Uzbrojenie przy niepustym ringu odmawia (czytaj dalej), po opróżnieniu się udaje.
+    TEST_ASSERT_FALSE(mpsc_ring_arm_readable(&rb));
+    size_t n = 0;
+    while (mpsc_ring_peek(&rb, &n)) mpsc_ring_consume(&rb);
+    TEST_ASSERT_TRUE(mpsc_ring_arm_readable(&rb));
+
+    // Niezatwierdzony najstarszy rekord: commit za nim nie dzwoni, dopiero jego commit.
+    mpsc_ring_resv_t a, b;
+    TEST_ASSERT_NOT_NULL(mpsc_ring_reserve(&rb, 4, &a));
+    TEST_ASSERT_NOT_NULL(mpsc_ring_reserve(&rb, 4, &b));
+    TEST_ASSERT_FALSE(mpsc_ring_commit(&rb, &b, 4));
+    TEST_ASSERT_TRUE(mpsc_ring_commit(&rb, &a, 4));
+
+    TEST_ASSERT_TRUE(mpsc_ring_wait_readable(&rb, 0));
+}
@@ -0,0 +1,209 @@
+#include "unity.h"
+
+#include "core/spsc_ring.h"
+
+#include <string.h>
+
+static uint8_t s_storage[16];
+static uint8_t s_rec_storage[32] __attribute__((aligned(4)));
+
+TEST_CASE("spsc_ring_write/read: block across the wrap, all-or-nothing write", "[core__spsc_ring]")
+{
+    spsc_ring_t rb;
+    TEST_ASSERT_TRUE(spsc_ring_init(&rb, s_storage, sizeof(s_storage)));
+
+    uint8_t out[16];
+    // Przesunięcie indeksów tak, żeby kolejny blok zawinął się przez koniec bufora.
+    TEST_ASSERT_EQUAL_UINT32(12u, spsc_ring_write(&rb, "0123456789ab", 12, true));
+    TEST_ASSERT_EQUAL_UINT32(12u, spsc_ring_read(&rb, out, sizeof(out)));
+
+    TEST_ASSERT_EQUAL_UINT32(10u, spsc_ring_write(&rb, "ABCDEFGHIJ", 10, true));
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_write(&rb, "0123456789", 7, true)); // 6 wolnych
+    TEST_ASSERT_EQUAL_UINT32(10u, spsc_ring_used(&rb));
+    TEST_ASSERT_EQUAL_UINT32(6u, spsc_ring_write(&rb, "klmnopqr", 8, false));
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_free(&rb));
+
+    TEST_ASSERT_EQUAL_UINT32(4u, spsc_ring_read(&rb, out, 4));
+    TEST_ASSERT_EQUAL_MEMORY("ABCD", out, 4);
+    TEST_ASSERT_EQUAL_UINT32(12u, spsc_ring_read(&rb, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY("EFGHIJklmnop", out, 12);
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_read(&rb, out, sizeof(out)));
+}
+
+TEST_CASE("spsc_ring_read_until: stops after the delimiter, also across the wrap", "[core__spsc_ring]")
+{
+    spsc_ring_t rb;
+    TEST_ASSERT_TRUE(spsc_ring_init(&rb, s_storage, sizeof(s_storage)));
+
+    uint8_t out[16];
+    bool found = true;
+    TEST_ASSERT_EQUAL_UINT32(13u, spsc_ring_write(&rb, "xxxxxxxxxxxxx", 13, true));
+    TEST_ASSERT_EQUAL_UINT32(13u, spsc_ring_read(&rb, out, sizeof(out)));
+
+    // "ab\n" na końcu bufora, "cd\n" zawinięte, potem niedokończona linia.
+    TEST_ASSERT_EQUAL_UINT32(8u, spsc_ring_write(&rb, "ab\ncd\nef", 8, true));
+
+    TEST_ASSERT_EQUAL_UINT32(3u, spsc_ring_read_until(&rb, out, sizeof(out), '\n', &found));
+    TEST_ASSERT_TRUE(found);
+    TEST_ASSERT_EQUAL_MEMORY("ab\n", out, 3);
+
+    TEST_ASSERT_EQUAL_UINT32(3u, spsc_ring_read_until(&rb, out, sizeof(out), '\n', &found));
+    TEST_ASSERT_TRUE(found);
+    TEST_ASSERT_EQUAL_MEMORY("cd\n", out, 3);
+
+    // Bez delimitera: fragment linii zostaje skopiowany i zużyty.
+    TEST_ASSERT_EQUAL_UINT32(1u, spsc_ring_read_until(&rb, out, 1, '\n', &found));
+    TEST_ASSERT_FALSE(found);
+    TEST_ASSERT_EQUAL_UINT32(1u, spsc_ring_read_until(&rb, out, sizeof(out), '\n', &found));
+    TEST_ASSERT_FALSE(found);
+    TEST_ASSERT_EQUAL_UINT8('f', out[0]);
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_read_until(&rb, out, sizeof(out), '\n', &found));
+}
+
+TEST_CASE("spsc_ring records: wrap marker keeps every record contiguous", "[core__spsc_ring]")
+{
+    spsc_ring_t rb;
+    TEST_ASSERT_TRUE(spsc_ring_init(&rb, s_rec_storage, sizeof(s_rec_storage)));
+    TEST_ASSERT_EQUAL_UINT32(12u, spsc_ring_record_max(&rb));
+
+    size_t n = 0;
+    uint8_t* w = spsc_ring_reserve_record(&rb, 10);
+    TEST_ASSERT_NOT_NULL(w);
+    memcpy(w, "0123456789", 10);
+    spsc_ring_commit_record(&rb, 10);
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_used(&rb)); // nagłówek + wyrównanie
+    TEST_ASSERT_NOT_NULL(spsc_ring_peek_record(&rb, &n));
+    TEST_ASSERT_EQUAL_UINT32(10u, n);
+    spsc_ring_consume_record(&rb);
+
+    // 8 B do offsetu 28; kolejny rekord nie mieści się w 4 B do końca -> WRAP, start od 0.
+    w = spsc_ring_reserve_record(&rb, 8);
+    memcpy(w, "abcdefgh", 8);
+    spsc_ring_commit_record(&rb, 8);
+    w = spsc_ring_reserve_record(&rb, 6);
+    TEST_ASSERT_EQUAL_PTR(s_rec_storage + 4, w);
+    memcpy(w, "WRAPPD", 6);
+    spsc_ring_commit_record(&rb, 6);
+    TEST_ASSERT_EQUAL_UINT32(28u, spsc_ring_used(&rb));
+
+    const uint8_t* r = spsc_ring_peek_record(&rb, &n);
+    TEST_ASSERT_EQUAL_UINT32(8u, n);
+    TEST_ASSERT_EQUAL_MEMORY("abcdefgh", r, 8);
+    spsc_ring_consume_record(&rb);
+
+    r = spsc_ring_peek_record(&rb, &n);
+    TEST_ASSERT_EQUAL_UINT32(6u, n);
+    TEST_ASSERT_EQUAL_MEMORY("WRAPPD", r, 6);
+    TEST_ASSERT_EQUAL_UINT32(12u, spsc_ring_used(&rb)); // pominięty ogon oddany już przy peek
+    spsc_ring_consume_record(&rb);
+    TEST_ASSERT_NULL(spsc_ring_peek_record(&rb, &n));
+    TEST_ASSERT_EQUAL_UINT32(0u, n);
+}
+
+TEST_CASE("spsc_ring records: full ring, oversize, abandoned and shortened reservations", "[core__spsc_ring]")
+{
+    spsc_ring_t rb;
+    TEST_ASSERT_TRUE(spsc_ring_init(&rb, s_rec_storage, sizeof(s_rec_storage)));
+
+    TEST_ASSERT_NULL(spsc_ring_reserve_record(&rb, 0));
+    TEST_ASSERT_NULL(spsc_ring_reserve_record(&rb, 13));
+
+    for (int i = 0; i < 2; i++) {
+        uint8_t* w = spsc_ring_reserve_record(&rb, 12);
+        TEST_ASSERT_NOT_NULL(w);
+        memset(w, 'a' + i, 12);
+        spsc_ring_commit_record(&rb, 12);
+    }
+    TEST_ASSERT_NULL(spsc_ring_reserve_record(&rb, 1));
+
+    size_t n = 0;
+    TEST_ASSERT_EQUAL_UINT8('a', spsc_ring_peek_record(&rb, &n)[0]);
+    spsc_ring_consume_record(&rb);
+
+    // Porzucona rezerwacja nie zmienia ringu; krótszy commit zajmuje mniej miejsca.
+    TEST_ASSERT_NOT_NULL(spsc_ring_reserve_record(&rb, 12));
+    spsc_ring_commit_record(&rb, 0);
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_used(&rb));
+    uint8_t* w = spsc_ring_reserve_record(&rb, 12);
+    memcpy(w, "xyz", 3);
+    spsc_ring_commit_record(&rb, 3);
+    TEST_ASSERT_EQUAL_UINT32(24u, spsc_ring_used(&rb));
+
+    TEST_ASSERT_EQUAL_UINT8('b', spsc_ring_peek_record(&rb, &n)[11]);
+    spsc_ring_consume_record(&rb);
+    const uint8_t* r = spsc_ring_peek_record(&rb, &n);
+    TEST_ASSERT_EQUAL_UINT32(3u, n);
+    TEST_ASSERT_EQUAL_MEMORY("xyz", r, 3);
+    spsc_ring_consume_record(&rb);
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_used(&rb));
+}
+
+TEST_CASE("spsc_ring overwrite: keeps the newest bytes, reports what was lost", "[core__spsc_ring]")
+{
+    spsc_ring_t rb;
+    TEST_ASSERT_TRUE(spsc_ring_init(&rb, s_storage, sizeof(s_storage)));
+
+    uint8_t out[32];
+    uint32_t lost = 99u;
+    spsc_ring_write_overwrite(&rb, "0123456789", 10);
+    TEST_ASSERT_EQUAL_UINT32(4u, spsc_ring_read_overwrite(&rb, out, 4, &lost));
+    TEST_ASSERT_EQUAL_MEMORY("0123", out, 4);
+    TEST_ASSERT_EQUAL_UINT32(0u, lost);
+
+    // 6 nieprzeczytanych + 14 nowych > 16: cztery najstarsze ("4567") nadpisane.
+    spsc_ring_write_overwrite(&rb, "abcdefghijklmn", 14);
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_used(&rb));
+    TEST_ASSERT_EQUAL_UINT32(4u, spsc_ring_overwritten(&rb));
+
+    // Migawki nie zużywają danych.
+    TEST_ASSERT_EQUAL_UINT32(5u, spsc_ring_copy_overwrite(&rb, out, 5, true));
+    TEST_ASSERT_EQUAL_MEMORY("jklmn", out, 5);
+    TEST_ASSERT_EQUAL_UINT32(4u, spsc_ring_copy_overwrite(&rb, out, 4, false));
+    TEST_ASSERT_EQUAL_MEMORY("89ab", out, 4);
+
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_read_overwrite(&rb, out, sizeof(out), &lost));
+    TEST_ASSERT_EQUAL_MEMORY("89abcdefghijklmn", out, 16);
+    TEST_ASSERT_EQUAL_UINT32(4u, lost);
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_used(&rb));
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_overwritten(&rb));
+
+    // Blok dłuższy niż cap: zostaje końcówka; discard czyści ring.
+    spsc_ring_write_overwrite(&rb, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26);
+    TEST_ASSERT_EQUAL_UINT32(10u, spsc_ring_overwritten(&rb));
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_copy_overwrite(&rb, out, sizeof(out), true));
+    TEST_ASSERT_EQUAL_MEMORY("KLMNOPQRSTUVWXYZ", out, 16);
+    spsc_ring_discard(&rb);
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_used(&rb));
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_read_overwrite(&rb, out, sizeof(out), &lost));
+}
+
+TEST_CASE("spsc_ring overwrite: 4 GiB without a read still reports a full ring", "[core__spsc_ring]")
+{
+    static uint8_t blk[4096];
+    spsc_ring_t rb;
+    TEST_ASSERT_TRUE(spsc_ring_init(&rb, s_storage, sizeof(s_storage)));
+
+    // 2^20 bloków po 4 KiB: head okrąża 2^32 i wraca na tail. Bez podciągania tail
+    // ring wyglądałby na pusty, a overwritten() na 0.
+    for (uint32_t i = 0; i < (1u << 20); i++) {
+        spsc_ring_write_overwrite(&rb, blk, sizeof(blk));
+    }
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_used(&rb));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFF0u, spsc_ring_overwritten(&rb));
+
+    uint8_t out[16];
+    spsc_ring_write_overwrite(&rb, "0123456789", 10);
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_copy_overwrite(&rb, out, sizeof(out), false));
+    TEST_ASSERT_EQUAL_MEMORY("0123456789", out + 6, 10);
+
+    // Licznik strat nasyca się zamiast zawijać.
+    for (uint32_t i = 0; i < 2u; i++) {
+        spsc_ring_write_overwrite(&rb, blk, sizeof(blk));
+    }
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, spsc_ring_overwritten(&rb));
+
+    uint32_t lost = 0;
+    TEST_ASSERT_EQUAL_UINT32(16u, spsc_ring_read_overwrite(&rb, out, sizeof(out), &lost));
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_overwritten(&rb));
+    TEST_ASSERT_EQUAL_UINT32(0u, spsc_ring_used(&rb));
+}
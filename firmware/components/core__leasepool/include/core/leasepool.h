@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * @file leasepool.h
@@ -8,9 +9,23 @@
  *
  * Założenia:
  *  - brak malloc/free w ścieżce krytycznej
- *  - stała liczba slotów o stałej pojemności (cap)
+ *  - stała liczba slotów w 1..LP_MAX_CLASSES klasach rozmiarów (slab), każda
+ *    z własną free‑list i statystykami; lp_alloc_try() wybiera best‑fit
  *  - ref-count: slot zwalniany dopiero gdy refcnt spadnie do 0
  *  - generacja (gen) chroni przed użyciem starego uchwytu (stale handle)
+ *  - CONFIG_CORE_LEASEPOOL_LOCKFREE: alloc/addref/release bez sekcji krytycznej
+ *    (free‑lista = stos Treibera z tagiem, gen|refcnt w jednym słowie CAS);
+ *    wszystkie API bezpieczne z wielu zadań/rdzeni i z ISR
+ *  - CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE: per‑rdzeniowe magazyny wolnych slotów
+ *    (alloc/release zwykle bez dotykania współdzielonej free‑listy)
+ *  - priorytety alokacji (lp_alloc_try_prio): każda klasa trzyma rezerwę slotów
+ *    dla CRITICAL i NORMAL, której ruch niższego priorytetu nie może zająć
+ *  - CONFIG_CORE_LEASEPOOL_OWNERS: tag właściciela + czas alokacji per slot,
+ *    detektor wycieków (lp_leak_scan, lpstat owners)
+ *  - CONFIG_CORE_LEASEPOOL_HIST: histogram czasu życia i ring zajętości
+ *    do wymiarowania puli (lp_hist_dump, lpstat hist)
+ *  - lp_ring_t: stały zestaw slotów strumienia masowego krążący po kolei
+ *    (acquire -> publish -> release), bez globalnej free‑listy
  *
  * Uwaga: producent zazwyczaj:
  *  1) lp_alloc_try(want_len)
@@ -20,20 +35,62 @@
  *
  * Konsument:
  *  1) lp_acquire() -> odczyt
- *  2) lp_release()
+ *  2) lp_release() (kilka naraz: lp_release_n())
  */
 
+/* Maks. liczba klas rozmiarów (CONFIG_CORE_LEASEPOOL_NUM_CLASSES). */
+#define LP_MAX_CLASSES        4u
+
+/* idx uchwytu = (klasa << LP_HANDLE_CLASS_SHIFT) | slot w klasie; klasa 0 = stary układ. */
+#define LP_HANDLE_CLASS_SHIFT 12u
+#define LP_HANDLE_LOCAL_MASK  0x0FFFu
+
+/* Kubełki histogramu czasu życia (log2 µs): [0] < 1 µs, [b] = [2^(b-1), 2^b) µs, ostatni = reszta. */
+#define LP_HIST_BUCKETS       28u
+
+/*
+ * Wyrównanie bufora slotu (lp_view_t.ptr, także segmentów lp_acquire_iov) = linia cache.
+ * Bufory leżą w pamięci DMA, osobno od metadanych — lease można podać wprost do DMA
+ * SPI/UART (przy cap będącym wielokrotnością LP_BUF_ALIGN bufor zajmuje całe linie).
+ */
+#if defined(ESP_PLATFORM)
+#define LP_BUF_ALIGN          32u
+#else
+#define LP_BUF_ALIGN          64u
+#endif
+
+/* Maks. slotów jednego ringu leasów (lp_ring_init). */
+#define LP_RING_MAX_SLOTS     32u
+
+/* Pseudoklasa uchwytów slice (lp_slice); 0xF zarezerwowane dla lp_invalid_handle(). */
+#define LP_HANDLE_SLICE_CLASS 0xEu
+
+/*
+ * Priorytet alokacji. Każda klasa zostawia na free‑liście rezerwę: LOW (strumienie masowe:
+ * UART RX, logi) nie schodzi poniżej RESERVE_CRITICAL + RESERVE_NORMAL wolnych slotów,
+ * NORMAL (lp_alloc_try) poniżej RESERVE_CRITICAL, CRITICAL może wziąć wszystko.
+ */
+typedef enum {
+    LP_PRIO_LOW = 0,
+    LP_PRIO_NORMAL,
+    LP_PRIO_CRITICAL,
+    LP_PRIO_COUNT
+} lp_prio_t;
+
 typedef struct {
-    uint16_t idx;  /* 0..N-1 */
+    uint16_t idx;  /* klasa | slot (patrz LP_HANDLE_CLASS_SHIFT) */
     uint16_t gen;  /* generacja slotu */
 } lp_handle_t;
 
 typedef struct {
     void*    ptr;
     uint32_t len;
-    uint32_t cap; /* stałe: LP_BUF_SIZE */
+    uint32_t cap; /* pojemność slotu (zależna od klasy) */
 } lp_view_t;
 
+/* Segment leasa łańcuchowego (lp_acquire_iov); jak lp_view_t. */
+typedef lp_view_t lp_iov_t;
+
 typedef struct {
     uint16_t slots_total;
     uint16_t slots_free;
@@ -42,25 +99,249 @@ typedef struct {
 
     uint32_t alloc_ok;
     uint32_t drops_alloc_fail;
+    uint32_t drops_prio[LP_PRIO_COUNT];  /* drops_alloc_fail w podziale na lp_prio_t */
+
+    /* Wejścia w sekcję krytyczną puli (tylko CONFIG_CORE_LEASEPOOL_LOCKFREE=n; inaczej 0). */
+    uint32_t lock_rounds;
+
+    /* lp_make_writable(): zapis w miejscu (jedyny posiadacz) / prywatna kopia. */
+    uint32_t cow_inplace;
+    uint32_t cow_copies;
 
     /* Licznik naruszeń guardów (canary/poison/assert), jeśli włączone. */
     uint32_t guard_failures;
+    uint32_t guard_scrubbed;   /* sloty sprawdzone/zatrute przez lp_scrub_step() (tryb SCRUB) */
+
+    /* Leasy zgłoszone przez detektor wycieków (lp_leak_scan), każdy raz. */
+    uint32_t leaks_detected;
+
+    /* Deskryptory slice (CONFIG_CORE_LEASEPOOL_SLICES). */
+    uint16_t slices_total;
+    uint16_t slices_used;
+    uint16_t slices_peak_used;
+    uint32_t drops_slice_fail;
 } lp_stats_t;
 
+/* Statystyki jednej klasy rozmiarów. */
+typedef struct {
+    uint32_t cap;              /* bajtów na slot */
+    uint16_t slots_total;
+    uint16_t slots_free;
+    uint16_t slots_used;
+    uint16_t slots_peak_used;
+
+    uint32_t alloc_ok;         /* alokacje obsłużone przez tę klasę */
+    uint32_t alloc_spill;      /* best‑fit = ta klasa, ale pusta -> obsłużyła większa */
+    uint32_t drops_alloc_fail; /* best‑fit = ta klasa, brak wolnych slotów w niej i wyżej */
+
+    /* Efektywność pamięci: bytes_req / bytes_cap dla alokacji obsłużonych przez klasę. */
+    uint64_t bytes_req;
+    uint64_t bytes_cap;
+    uint32_t arena_bytes;      /* pamięć statyczna klasy (metadane + bufory + guardy/wyrównanie) */
+
+    /* Rezerwy priorytetów (sloty, których niższy priorytet nie może zająć). */
+    uint16_t free_global;      /* sloty na globalnej free‑liście (poza magazynami) */
+    uint16_t reserve_critical; /* tylko CRITICAL */
+    uint16_t reserve_normal;   /* NORMAL i CRITICAL, nie LOW */
+    uint32_t drops_prio[LP_PRIO_COUNT];
+
+    /* Magazyny per rdzeń (CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE); hit rate = hits / (hits + misses). */
+    uint16_t mag_cap;          /* pojemność magazynu jednego rdzenia (0 = klasa bez magazynów) */
+    uint16_t mag_cached;       /* wolne sloty trzymane teraz w magazynach */
+    uint32_t mag_hits;         /* alloc obsłużony z magazynu bez dotykania free‑listy */
+    uint32_t mag_misses;       /* refill partią z globalnej free‑listy */
+    uint32_t mag_spills;       /* oddanie partii do globalnej free‑listy (magazyn pełny) */
+
+    /* Sloty przypisane do ringów leasów (lp_ring_init); liczone w slots_used do lp_ring_deinit. */
+    uint16_t ring_slots;
+} lp_class_stats_t;
+
+/*
+ * Ring leasów strumienia masowego (lp_ring_init); pamięć wołającego, pola tylko do odczytu.
+ * Jeden producent (lp_ring_acquire), zwolnienia zwykłym lp_release z dowolnego zadania.
+ */
+typedef struct {
+    uint8_t  cls;                        /* klasa slotów */
+    uint16_t count;                      /* sloty ringu */
+    uint16_t head;                       /* następny do wydania (indeks w local) */
+    uint16_t local[LP_RING_MAX_SLOTS];   /* indeksy slotów w klasie, kolejność obiegu */
+    uint32_t acquired;                   /* udane lp_ring_acquire */
+    uint32_t full;                       /* lp_ring_acquire bez wolnego slotu (konsument nie nadąża) */
+} lp_ring_t;
+
+/* Stan jednego tagu właściciela (lp_get_owner_stats); liczone skanem slotów. */
+typedef struct {
+    const char* tag;           /* "-" = nieoznaczone (lp_set_owner nie wołane) */
+    uint16_t slots_held;       /* sloty trzymane teraz (z segmentami łańcuchów) */
+    uint16_t leases;           /* żywe leasy (głowy) */
+    uint16_t stale;            /* leasy starsze niż CONFIG_CORE_LEASEPOOL_LEAK_AGE_MS */
+    uint32_t oldest_ms;        /* wiek najstarszego żywego leasa */
+    uint32_t tagged;           /* lp_set_owner() z tym tagiem od resetu statystyk */
+    uint32_t leaks;            /* wycieki zgłoszone przez lp_leak_scan() */
+} lp_owner_stats_t;
+
+/* Histogram czasu życia slotów klasy (alloc -> ostatni release), CONFIG_CORE_LEASEPOOL_HIST. */
+typedef struct {
+    uint32_t cap;
+    uint32_t count;                    /* zwolnione sloty */
+    uint32_t bucket[LP_HIST_BUCKETS];
+} lp_lifetime_hist_t;
+
+/* Próbka zajętości (lp_occ_sample). */
+typedef struct {
+    uint32_t t_ms;
+    uint16_t used;                     /* wszystkie klasy */
+    uint16_t cls_used[LP_MAX_CLASSES];
+} lp_occ_sample_t;
+
 void      lp_init(void);
 
+/* lp_alloc_try() == lp_alloc_try_prio(want_len, LP_PRIO_NORMAL). */
 lp_handle_t lp_alloc_try(uint32_t want_len);
+lp_handle_t lp_alloc_try_prio(uint32_t want_len, lp_prio_t prio);
 bool      lp_acquire(lp_handle_t h, lp_view_t* out);
 void      lp_commit(lp_handle_t h, uint32_t len);
 
 void      lp_addref_n(lp_handle_t h, uint16_t n);
 void      lp_release(lp_handle_t h);
 
+/**
+ * @brief Operacje zbiorcze na referencjach — jedna sekcja krytyczna zamiast n.
+ *
+ * lp_release_ref_n(h, n): zdejmuje n referencji jednego leasa jednym CAS (para do
+ * lp_addref_n; rozgłoszenie: addref z góry na wszystkich odbiorców, potem jedno
+ * rozliczenie nieudanych enqueue). lp_release_n(hs, n): lp_release() każdego uchwytu
+ * z tablicy (konsument opróżniający kilka leasów naraz; nieważne uchwyty pomijane).
+ */
+void      lp_release_ref_n(lp_handle_t h, uint16_t n);
+void      lp_release_n(const lp_handle_t* hs, size_t n);
+
+/**
+ * @brief Lease łańcuchowy (scatter‑gather) dla payloadów większych niż jeden slot.
+ *
+ * Jeden uchwyt (głowa) = połączone segmenty z największych dostępnych klas; refcount,
+ * addref i release dotyczą całości (ostatni lp_release zwalnia wszystkie segmenty).
+ * Gdy want_len mieści się w jednym slocie — zwykły lp_alloc_try().
+ * lp_commit(h, len) na głowie rozkłada len po segmentach (kolejno do pełna);
+ * lp_acquire() widzi tylko pierwszy segment — dane całości przez lp_acquire_iov().
+ */
+lp_handle_t lp_alloc_chain_try(uint32_t want_len);
+lp_handle_t lp_alloc_chain_try_prio(uint32_t want_len, lp_prio_t prio);
+
+/**
+ * @brief Widok segmentów leasa (także pojedynczego — 1 segment).
+ *
+ * Wypełnia min(iovcnt, liczba segmentów) pozycji iov (ptr, len z lp_commit, cap).
+ * @return liczba segmentów łańcucha (może być > iovcnt); 0 = nieważny uchwyt
+ */
+size_t    lp_acquire_iov(lp_handle_t h, lp_iov_t* iov, size_t iovcnt);
+
+/**
+ * @brief Slice: nowy uchwyt na zakres [off, off+len) zatwierdzonych danych leasa (bez kopii).
+ *
+ * Slice ma własny refcount (addref/release jak zwykły lease) i trzyma jedną referencję
+ * rodzica — rodzic żyje, dopóki żyje którykolwiek slice. Producent może więc pociąć
+ * jeden bufor na ramki, opublikować każdą osobno i oddać własną referencję rodzica.
+ * Działa też na leasach łańcuchowych i na slice'ach (zakres względem slice'a).
+ * Slice jest tylko do odczytu (lp_commit() na nim = błąd guardu); lp_acquire() zwraca
+ * pierwszy ciągły kawałek, całość przez lp_acquire_iov().
+ *
+ * @return uchwyt slice albo lp_invalid_handle() (zakres poza danymi, brak deskryptorów)
+ */
+lp_handle_t lp_slice(lp_handle_t h, uint32_t off, uint32_t len);
+
+/**
+ * @brief Copy‑on‑write: lease, który wołający może modyfikować.
+ *
+ * Przejmuje referencję wołającego do h. Gdy to jedyna referencja (typowo: jeden
+ * subskrybent), zwraca h bez kopii. Gdy lease jest współdzielony albo h to slice,
+ * alokuje prywatną kopię zatwierdzonych danych (lp_alloc_chain_try — także łańcuch,
+ * ten sam tag właściciela), oddaje referencję h i zwraca kopię.
+ *
+ * @return uchwyt do zapisu albo lp_invalid_handle() (nieważny h, brak slotów na kopię —
+ *         wtedy referencja h zostaje u wołającego)
+ */
+lp_handle_t lp_make_writable(lp_handle_t h);
+
+/**
+ * @brief Ring leasów: stały zestaw slotów dla strumienia (UART RX, logi) krążący po kolei.
+ *
+ * lp_ring_init() zabiera z free‑listy `count` slotów klasy mieszczącej seg_bytes (albo
+ * większej), nie sięgając po rezerwy CRITICAL. Producent bierze je po kolei
+ * lp_ring_acquire() — lease jak z lp_alloc_try() (lp_acquire/lp_commit/lp_slice, publikacja,
+ * addref), a ostatni lp_release() odkłada slot z powrotem do ringu zamiast na free‑listę.
+ * Gdy konsumenci zwalniają w kolejności publikacji, kolejny slot jest wolny bez dotykania
+ * współdzielonych list i liczników puli; gdy nie — acquire zwraca nieważny uchwyt
+ * (licznik full), a producent może spaść na lp_alloc_chain_try_prio().
+ *
+ * lp_ring_deinit() oddaje sloty do puli; false = któryś lease wciąż żyje (spróbuj później).
+ * lp_ring_acquire() tylko z jednego zadania naraz (bez ISR).
+ */
+bool        lp_ring_init(lp_ring_t* r, uint32_t seg_bytes, uint16_t count);
+lp_handle_t lp_ring_acquire(lp_ring_t* r);
+bool        lp_ring_deinit(lp_ring_t* r);
+
+/**
+ * @brief Krok scrubbera guardów (CONFIG_CORE_LEASEPOOL_GUARD_POISON_SCRUB).
+ *
+ * Zdejmuje z free‑listy kolejnej klasy najwyżej `budget` slotów (0 = domyślny budżet),
+ * weryfikuje poison zatrutych (UAF‑write) i zatruwa niezatrute, po czym oddaje je
+ * na listę. Koszt kroku ograniczony: budget * cap. Na ESP wołane przez zadanie w tle
+ * uruchamiane w lp_init(); w innych trybach no‑op.
+ * @return liczba sprawdzonych slotów
+ */
+uint16_t  lp_scrub_step(uint16_t budget);
+
+/**
+ * @brief Oznacza lease tagiem właściciela (CONFIG_CORE_LEASEPOOL_OWNERS; inaczej no‑op).
+ *
+ * Wołać zaraz po alloc, przed udostępnieniem uchwytu; tag musi żyć zawsze (literał),
+ * np. lp_set_owner(h, "uart_rx"). Dotyczy wszystkich segmentów łańcucha; slice'y
+ * nie mają własnego tagu (liczą się do rodzica). Nadmiarowe tagi (tablica pełna)
+ * trafiają do "-".
+ * @return false dla nieważnego uchwytu, slice'a albo gdy śledzenie wyłączone
+ */
+bool      lp_set_owner(lp_handle_t h, const char* owner);
+
+/**
+ * @brief Detektor wycieków: szuka leasów trzymanych dłużej niż min_age_ms.
+ *
+ * Nowo wykryte (każdy lease raz) liczy w lp_stats_t.leaks_detected i per tag;
+ * report=true wypisuje je (idx, gen, ref, owner, wiek). Na ESP wołane okresowo
+ * z zadania tła (CONFIG_CORE_LEASEPOOL_LEAK_CHECK_PERIOD_MS).
+ * @param min_age_ms próg wieku (0 = CONFIG_CORE_LEASEPOOL_LEAK_AGE_MS)
+ * @return liczba leasów starszych niż próg (także zgłoszonych wcześniej)
+ */
+uint16_t  lp_leak_scan(uint32_t min_age_ms, bool report);
+
+/**
+ * @brief Stan per tag właściciela; out[0] = nieoznaczone.
+ * @return liczba wypełnionych pozycji (0 = śledzenie wyłączone)
+ */
+size_t    lp_get_owner_stats(lp_owner_stats_t* out, size_t max);
+
+/**
+ * @brief Histogramy do wymiarowania puli (CONFIG_CORE_LEASEPOOL_HIST; inaczej puste).
+ *
+ * lp_occ_sample() dopisuje bieżącą zajętość do ringu (na ESP woła je zadanie tła
+ * co CONFIG_CORE_LEASEPOOL_HIST_OCC_PERIOD_MS). lp_get_occupancy() zwraca najwyżej
+ * max najnowszych próbek od najstarszej. lp_hist_dump() wypisuje percentyle (json=false,
+ * `lpstat hist`) albo JSON Lines `{"lp_hist":"lifetime"|"occupancy",...}` dla narzędzi hosta.
+ * lp_reset_stats() czyści oba.
+ */
+void      lp_occ_sample(void);
+size_t    lp_get_occupancy(lp_occ_sample_t* out, size_t max);
+bool      lp_get_lifetime_hist(size_t cls, lp_lifetime_hist_t* out);
+void      lp_hist_dump(bool json);
+
 uint16_t  lp_free_count(void);
 uint16_t  lp_used_count(void);
 void      lp_get_stats(lp_stats_t* out);
 void      lp_reset_stats(void);
 
+size_t    lp_class_count(void);
+bool      lp_get_class_stats(size_t cls, lp_class_stats_t* out);
+
 /**
  * @brief Sprawdza integralność LeasePool (invariants, free‑list, canary/poison).
  *
@@ -76,6 +357,8 @@ void      lp_dump(void);
 
 static inline lp_handle_t lp_invalid_handle(void) { return (lp_handle_t){ .idx = 0xFFFFu, .gen = 0u }; }
 static inline bool        lp_handle_is_valid(lp_handle_t h) { return (h.idx != 0xFFFFu); }
+static inline size_t      lp_handle_class(lp_handle_t h) { return (size_t)(h.idx >> LP_HANDLE_CLASS_SHIFT); }
+static inline bool        lp_handle_is_slice(lp_handle_t h) { return lp_handle_class(h) == LP_HANDLE_SLICE_CLASS; }
 
 static inline uint32_t lp_pack_handle_u32(lp_handle_t h)
 {
@@ -3,395 +3,2236 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
+#include "freertos/task.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-#if ESP_PLATFORM
+#if defined(ESP_PLATFORM)
 #include "esp_rom_sys.h" // esp_rom_printf
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+/* ===================== klasy rozmiarów (slab) ===================== */
+
+#ifndef CONFIG_CORE_LEASEPOOL_NUM_CLASSES
+#define CONFIG_CORE_LEASEPOOL_NUM_CLASSES 1
+#endif
+
+#define LP_NUM_CLASSES CONFIG_CORE_LEASEPOOL_NUM_CLASSES
+
+#if (LP_NUM_CLASSES < 1) || (LP_NUM_CLASSES > LP_MAX_CLASSES)
+#  error "CORE_LEASEPOOL_NUM_CLASSES must be in 1..LP_MAX_CLASSES"
+#endif
+
+// Klasa 0 = dotychczasowa pula (SLOTS x SLOT_BYTES) — stare sdkconfig pozostają ważne.
+#define LP_C0_SLOTS CONFIG_CORE_LEASEPOOL_SLOTS
+#define LP_C0_BYTES CONFIG_CORE_LEASEPOOL_SLOT_BYTES
+
+#if LP_NUM_CLASSES >= 2
+#  define LP_C1_SLOTS CONFIG_CORE_LEASEPOOL_CLASS1_SLOTS
+#  define LP_C1_BYTES CONFIG_CORE_LEASEPOOL_CLASS1_BYTES
+#  if LP_C1_BYTES <= LP_C0_BYTES
+#    error "LeasePool: CLASS1_BYTES must be > SLOT_BYTES (classes sorted by size)"
+#  endif
+#endif
+#if LP_NUM_CLASSES >= 3
+#  define LP_C2_SLOTS CONFIG_CORE_LEASEPOOL_CLASS2_SLOTS
+#  define LP_C2_BYTES CONFIG_CORE_LEASEPOOL_CLASS2_BYTES
+#  if LP_C2_BYTES <= LP_C1_BYTES
+#    error "LeasePool: CLASS2_BYTES must be > CLASS1_BYTES (classes sorted by size)"
+#  endif
+#endif
+#if LP_NUM_CLASSES >= 4
+#  define LP_C3_SLOTS CONFIG_CORE_LEASEPOOL_CLASS3_SLOTS
+#  define LP_C3_BYTES CONFIG_CORE_LEASEPOOL_CLASS3_BYTES
+#  if LP_C3_BYTES <= LP_C2_BYTES
+#    error "LeasePool: CLASS3_BYTES must be > CLASS2_BYTES (classes sorted by size)"
+#  endif
+#endif
+
+#define LP_MAX_(a, b) ((a) > (b) ? (a) : (b))
+#if LP_NUM_CLASSES == 1
+#  define LP_MAX_CLASS_SLOTS LP_C0_SLOTS
+#elif LP_NUM_CLASSES == 2
+#  define LP_MAX_CLASS_SLOTS LP_MAX_(LP_C0_SLOTS, LP_C1_SLOTS)
+#elif LP_NUM_CLASSES == 3
+#  define LP_MAX_CLASS_SLOTS LP_MAX_(LP_MAX_(LP_C0_SLOTS, LP_C1_SLOTS), LP_C2_SLOTS)
+#else
+#  define LP_MAX_CLASS_SLOTS LP_MAX_(LP_MAX_(LP_C0_SLOTS, LP_C1_SLOTS), LP_MAX_(LP_C2_SLOTS, LP_C3_SLOTS))
 #endif
 
-#define LP_NUM_SLOTS CONFIG_CORE_LEASEPOOL_SLOTS
-#define LP_BUF_SIZE  CONFIG_CORE_LEASEPOOL_SLOT_BYTES
+#if LP_MAX_CLASS_SLOTS > LP_HANDLE_LOCAL_MASK
+#  error "LeasePool: too many slots in one class for the handle encoding"
+#endif
 
 #if CONFIG_CORE_LEASEPOOL_GUARD
 #define LP_CANARY_VALUE 0xC0DEF00Du
-#define LP_MAGIC_FREE   0xFEE1DEADu
+#define LP_MAGIC_FREE   0xFEE1DEADu  /* wolny, bufor zatruty (LP_POISON_FREE) */
+#define LP_MAGIC_DIRTY  0xFEE1D1E7u  /* wolny, bufor niezatruty (tryb sampled/scrub/off) */
 #define LP_MAGIC_USED   0xC0FFEE01u
 #define LP_POISON_FREE  0xA5u
 #define LP_POISON_ALLOC 0xCCu
+#define LP_TAIL_BYTES   4u
+#else
+#define LP_TAIL_BYTES   0u
+#endif
+
+/*
+ * Tryb poison przy GUARD=y. Canary i magic są sprawdzane zawsze (O(1)); poison kosztuje O(cap):
+ *  FULL    — każdy release zatruwa, każdy alloc weryfikuje i wypełnia (jak dotąd)
+ *  SAMPLED — release zatruwa co N‑ty slot; alloc weryfikuje/wypełnia tylko zatrute
+ *  SCRUB   — release/alloc bez poison; lp_scrub_step() (zadanie w tle) zatruwa i weryfikuje
+ *            ograniczoną liczbę wolnych slotów na krok
+ *  OFF     — tylko canary + magic
+ */
+#define LP_POISON_OFF_     0
+#define LP_POISON_FULL_    1
+#define LP_POISON_SAMPLED_ 2
+#define LP_POISON_SCRUB_   3
+
+#if !CONFIG_CORE_LEASEPOOL_GUARD
+#  define LP_POISON_MODE LP_POISON_OFF_
+#elif defined(CONFIG_CORE_LEASEPOOL_GUARD_POISON_SAMPLED) && CONFIG_CORE_LEASEPOOL_GUARD_POISON_SAMPLED
+#  define LP_POISON_MODE LP_POISON_SAMPLED_
+#elif defined(CONFIG_CORE_LEASEPOOL_GUARD_POISON_SCRUB) && CONFIG_CORE_LEASEPOOL_GUARD_POISON_SCRUB
+#  define LP_POISON_MODE LP_POISON_SCRUB_
+#elif defined(CONFIG_CORE_LEASEPOOL_GUARD_POISON_OFF) && CONFIG_CORE_LEASEPOOL_GUARD_POISON_OFF
+#  define LP_POISON_MODE LP_POISON_OFF_
+#else
+#  define LP_POISON_MODE LP_POISON_FULL_
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_GUARD_SAMPLE_RATE)
+#  define LP_GUARD_SAMPLE_RATE CONFIG_CORE_LEASEPOOL_GUARD_SAMPLE_RATE
+#else
+#  define LP_GUARD_SAMPLE_RATE 16
 #endif
 
-#if ESP_PLATFORM
+#if defined(CONFIG_CORE_LEASEPOOL_GUARD_SCRUB_BUDGET)
+#  define LP_SCRUB_BUDGET CONFIG_CORE_LEASEPOOL_GUARD_SCRUB_BUDGET
+#else
+#  define LP_SCRUB_BUDGET 4
+#endif
+#define LP_SCRUB_MAX 32u
+
+#if defined(ESP_PLATFORM)
 #define LP_DIAG_PRINTF(...) esp_rom_printf(__VA_ARGS__)
 #else
 #define LP_DIAG_PRINTF(...) printf(__VA_ARGS__)
 #endif
 
+#if defined(CONFIG_CORE_LEASEPOOL_LOCKFREE) && CONFIG_CORE_LEASEPOOL_LOCKFREE
+#  define LP_LOCKFREE 1
+#else
+#  define LP_LOCKFREE 0
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE)
+#  define LP_MAG_SIZE CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE
+#else
+#  define LP_MAG_SIZE 0
+#endif
+
+#define LP_NUM_CORES portNUM_PROCESSORS
+
+#if defined(CONFIG_CORE_LEASEPOOL_SLICES)
+#  define LP_SLICES CONFIG_CORE_LEASEPOOL_SLICES
+#else
+#  define LP_SLICES 0
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_RESERVE_CRITICAL)
+#  define LP_RESERVE_CRITICAL CONFIG_CORE_LEASEPOOL_RESERVE_CRITICAL
+#else
+#  define LP_RESERVE_CRITICAL 0
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_RESERVE_NORMAL)
+#  define LP_RESERVE_NORMAL CONFIG_CORE_LEASEPOOL_RESERVE_NORMAL
+#else
+#  define LP_RESERVE_NORMAL 0
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_OWNERS)
+#  define LP_OWNERS CONFIG_CORE_LEASEPOOL_OWNERS
+#else
+#  define LP_OWNERS 0
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_LEAK_AGE_MS)
+#  define LP_LEAK_AGE_MS CONFIG_CORE_LEASEPOOL_LEAK_AGE_MS
+#else
+#  define LP_LEAK_AGE_MS 5000
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_LEAK_CHECK_PERIOD_MS) && (LP_OWNERS > 0)
+#  define LP_LEAK_PERIOD_MS CONFIG_CORE_LEASEPOOL_LEAK_CHECK_PERIOD_MS
+#else
+#  define LP_LEAK_PERIOD_MS 0
+#endif
+
+#if defined(CONFIG_CORE_LEASEPOOL_HIST) && CONFIG_CORE_LEASEPOOL_HIST
+#  define LP_HIST 1
+#  define LP_OCC_SAMPLES CONFIG_CORE_LEASEPOOL_HIST_OCC_SAMPLES
+#  if defined(CONFIG_CORE_LEASEPOOL_HIST_OCC_PERIOD_MS)
+#    define LP_OCC_PERIOD_MS CONFIG_CORE_LEASEPOOL_HIST_OCC_PERIOD_MS
+#  else
+#    define LP_OCC_PERIOD_MS 0
+#  endif
+#else
+#  define LP_HIST 0
+#  define LP_OCC_PERIOD_MS 0
+#endif
+
+/*
+ * Zadanie tła LeasePool (ESP): scrubber guardów, okresowy detektor wycieków, próbki zajętości.
+ * Krok pętli = najkrótszy z włączonych okresów (scrub zawsze najczęstszy).
+ */
+#if defined(ESP_PLATFORM) && ((LP_POISON_MODE == LP_POISON_SCRUB_) || (LP_LEAK_PERIOD_MS > 0) || (LP_OCC_PERIOD_MS > 0))
+#  define LP_MAINT_TASK 1
+#  if LP_POISON_MODE == LP_POISON_SCRUB_
+#    define LP_MAINT_PERIOD_MS CONFIG_CORE_LEASEPOOL_GUARD_SCRUB_PERIOD_MS
+#  elif (LP_OCC_PERIOD_MS > 0) && ((LP_LEAK_PERIOD_MS == 0) || (LP_OCC_PERIOD_MS < LP_LEAK_PERIOD_MS))
+#    define LP_MAINT_PERIOD_MS LP_OCC_PERIOD_MS
+#  else
+#    define LP_MAINT_PERIOD_MS LP_LEAK_PERIOD_MS
+#  endif
+#else
+#  define LP_MAINT_TASK 0
+#endif
+
+#define LP_CACHE_LINE LP_BUF_ALIGN
+
+/*
+ * Układ SoA: metadane slotów (lp_slot_t) to gęsta tablica klasy, a bufory (cap bajtów
+ * + canary_tail tuż za buforem) leżą osobno w arenie DMA z krokiem `stride` zaokrąglonym
+ * do linii cache. Każdy bufor zaczyna się więc na granicy linii (DMA SPI/UART bez kopii
+ * pośredniej), a zapisy refcountu/len nie brudzą linii, które czyta konsument payloadu.
+ *
+ * chain_next: następny segment leasa łańcuchowego (spakowany uchwyt) albo LP_CHAIN_END_.
+ * Refcount łańcucha trzyma tylko głowa; segmenty mają refcnt=1 należący do łańcucha.
+ *
+ * state = gen << 16 | refcnt — jedno słowo, więc addref/release to pojedynczy CAS,
+ * a zwolnienie ostatniej referencji atomowo podbija generację (stare uchwyty od razu nieważne).
+ *
+ * t_alloc_ms/owner/own_flags (CONFIG_CORE_LEASEPOOL_OWNERS): czas alokacji i tag właściciela
+ * do diagnostyki (lpstat owners, detektor wycieków); zapisywane relaxed, odczyt best‑effort.
+ * t_alloc_us (CONFIG_CORE_LEASEPOOL_HIST): początek życia slotu dla histogramu czasu życia.
+ *
+ * ring: LP_RING_OWNED_ = slot należy do lp_ring_t (poza free‑listą, liczony jako zajęty);
+ * LP_RING_FREE_ = ostatni release odłożył go do ringu, producent może go wziąć ponownie.
+ */
 typedef struct {
 #if CONFIG_CORE_LEASEPOOL_GUARD
     volatile uint32_t canary_head;
     volatile uint32_t magic;
 #endif
-    volatile uint16_t gen;
-    volatile uint16_t refcnt;
+    uint32_t          state;
     volatile uint32_t len;
-    uint8_t           buf[LP_BUF_SIZE];
-#if CONFIG_CORE_LEASEPOOL_GUARD
-    volatile uint32_t canary_tail;
+    uint32_t          chain_next;
+    uint32_t          ring;
+#if LP_OWNERS > 0
+    uint32_t          t_alloc_ms;
+    uint8_t           owner;      /* indeks w s_owner_tag (0 = nieoznaczony) */
+    uint8_t           own_flags;  /* LP_OWN_SEG_ | LP_OWN_LEAK_ */
+    uint16_t          reserved;
+#endif
+#if LP_HIST
+    uint32_t          t_alloc_us;
 #endif
 } lp_slot_t;
 
-static lp_slot_t          s_slots[LP_NUM_SLOTS] DMA_ATTR;
-static uint16_t           s_free[LP_NUM_SLOTS];
-static volatile uint16_t  s_free_top = 0;
+#define LP_CHAIN_END_ 0x0000FFFFu /* lp_pack_handle_u32(lp_invalid_handle()) */
+
+#define LP_RING_OWNED_ 0x1u
+#define LP_RING_FREE_  0x2u
 
-static volatile uint32_t  s_alloc_ok = 0;
-static volatile uint32_t  s_alloc_fail = 0;
-static volatile uint16_t  s_peak_used = 0;
+#define LP_ST_(gen, ref)  (((uint32_t)(gen) << 16) | (uint32_t)(ref))
+#define LP_ST_GEN_(st)    ((uint16_t)((st) >> 16))
+#define LP_ST_REF_(st)    ((uint16_t)((st) & 0xFFFFu))
+/* Następna generacja z pominięciem 0: uchwyt {idx 0, gen 0} pakuje się do 0,
+ * które ev_post_lease() traktuje jako brak uchwytu (zawinięcie po 65535 użyciach slotu). */
+#define LP_GEN_NEXT_(gen) ((uint16_t)((uint16_t)((gen) + 1u) ? (gen) + 1u : 1u))
+
+#define LP_STRIDE_(bytes) (((uint32_t)(bytes) + LP_TAIL_BYTES + (LP_CACHE_LINE - 1u)) & ~(uint32_t)(LP_CACHE_LINE - 1u))
+
+/*
+ * Free‑list klasy: stos Treibera na indeksach. head = tag << 16 | top; tag rośnie przy
+ * każdej zmianie head, więc CAS nie pomyli "ten sam top" po pop+push (ABA).
+ */
+#define LP_FL_NIL         0xFFFFu
+#define LP_FL_TOP_(head)  ((uint16_t)((head) & 0xFFFFu))
+#define LP_FL_NEXT_(head, top) ((((head) & 0xFFFF0000u) + 0x10000u) | (uint32_t)(top))
+
+typedef struct {
+    lp_slot_t*        meta;      /* metadane slotów (gęsto) */
+    uint8_t*          arena;     /* bufory, krok stride (wielokrotność LP_CACHE_LINE) */
+    uint16_t*         next;      /* link free‑listy (indeksy lokalne) */
+    uint32_t          cap;
+    uint32_t          stride;
+    uint16_t          slots;
+
+    uint16_t          mag_cap;   /* pojemność magazynu per rdzeń (0 = bez magazynów) */
+
+    uint32_t          fl_head;
+    uint16_t          fl_count;  /* sloty na free‑liście (≤ faktyczna długość stosu) */
+    uint16_t          floor[LP_PRIO_COUNT]; /* ile slotów free‑listy priorytet musi zostawić */
+    uint16_t          used;      /* tylko ścieżka globalna; magazyny liczą w lp_mag_t.used */
+    uint16_t          peak_used;
+    uint16_t          ring_slots; /* sloty przypisane do ringów (w used) */
+
+    uint32_t          alloc_ok;
+    uint32_t          alloc_spill;
+    uint32_t          alloc_fail;
+    uint32_t          fail_prio[LP_PRIO_COUNT];
+    uint64_t          bytes_req;
+    uint64_t          bytes_cap;
+} lp_class_t;
+
+#define LP_CLASS_STORAGE_(n)                                                  \
+    static lp_slot_t s_meta##n[LP_C##n##_SLOTS];                              \
+    static uint8_t   s_arena##n[(size_t)LP_C##n##_SLOTS * LP_STRIDE_(LP_C##n##_BYTES)] \
+        DMA_ATTR __attribute__((aligned(LP_CACHE_LINE)));                     \
+    static uint16_t  s_next##n[LP_C##n##_SLOTS];
+
+#define LP_CLASS_INIT_(n)                                                     \
+    { .meta = s_meta##n, .arena = s_arena##n, .next = s_next##n,              \
+      .cap = LP_C##n##_BYTES, .stride = LP_STRIDE_(LP_C##n##_BYTES),          \
+      .slots = LP_C##n##_SLOTS }
+
+LP_CLASS_STORAGE_(0)
+#if LP_NUM_CLASSES >= 2
+LP_CLASS_STORAGE_(1)
+#endif
+#if LP_NUM_CLASSES >= 3
+LP_CLASS_STORAGE_(2)
+#endif
+#if LP_NUM_CLASSES >= 4
+LP_CLASS_STORAGE_(3)
+#endif
+
+static lp_class_t s_cls[LP_NUM_CLASSES] = {
+    LP_CLASS_INIT_(0),
+#if LP_NUM_CLASSES >= 2
+    LP_CLASS_INIT_(1),
+#endif
+#if LP_NUM_CLASSES >= 3
+    LP_CLASS_INIT_(2),
+#endif
+#if LP_NUM_CLASSES >= 4
+    LP_CLASS_INIT_(3),
+#endif
+};
+
+static uint16_t           s_used = 0;
+static uint16_t           s_peak_used = 0;
 static volatile uint32_t  s_guard_failures = 0;
 
+#if LP_MAG_SIZE > 0
+/*
+ * Magazyn = mały stos wolnych indeksów klasy prywatny dla rdzenia. Trafienie (alloc z niepustego,
+ * release do niepełnego) dotyka tylko linii cache tego rdzenia; pudło przenosi partię mag_cap/2
+ * z/do globalnej free‑listy. Dostęp pod maską przerwań bieżącego rdzenia (bez wywłaszczenia
+ * i migracji), więc bez RMW. Liczniki pisze tylko właściciel; odczyt z innego rdzenia
+ * (statystyki) jest best‑effort.
+ */
+typedef struct {
+    uint16_t count;
+    uint16_t idx[LP_MAG_SIZE];
+    int32_t  used;        /* alokacje - zwolnienia przez ten magazyn (może być < 0) */
+    uint32_t alloc_ok;
+    uint32_t hits;
+    uint32_t misses;      /* refill z globalnej free‑listy (także nieudany) */
+    uint32_t spills;      /* oddanie partii do globalnej free‑listy */
+    uint64_t bytes_req;
+    uint64_t bytes_cap;
+} __attribute__((aligned(LP_CACHE_LINE))) lp_mag_t;
+
+static lp_mag_t s_mag[LP_NUM_CORES][LP_NUM_CLASSES];
+
+/*
+ * Pola czytane/zerowane z innych rdzeni (count, liczniki): relaxed load/store zamiast RMW —
+ * na Xtensa to zwykłe l32i/s32i, a odczyt statystyk przestaje być wyścigiem danych (TSAN).
+ * 64‑bit atomowo tylko tam, gdzie są lock‑free; na ESP32 (libcall) zwykły dostęp.
+ */
+#define LP_MAG_GET_(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define LP_MAG_SET_(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define LP_MAG_ADD_(p, v)   LP_MAG_SET_((p), LP_MAG_GET_(p) + (v))
+#if __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+#define LP_MAG_GET64_(p)    LP_MAG_GET_(p)
+#define LP_MAG_SET64_(p, v) LP_MAG_SET_((p), (v))
+#else
+#define LP_MAG_GET64_(p)    (*(p))
+#define LP_MAG_SET64_(p, v) (*(p) = (v))
+#endif
+#define LP_MAG_ADD64_(p, v) LP_MAG_SET64_((p), LP_MAG_GET64_(p) + (v))
+#endif
+
+#if LP_SLICES > 0
+/*
+ * Slice = deskryptor zakresu bajtów rodzica (bez kopii). Ma własne gen|refcnt (jak slot)
+ * i trzyma jedną referencję rodzica, oddawaną przy zwolnieniu ostatniej referencji slice'a.
+ * Rodzic to zawsze lease właściwy (slice ze slice'a wskazuje na korzeń).
+ */
+typedef struct {
+    uint32_t state;
+    uint32_t parent;   /* spakowany uchwyt rodzica */
+    uint32_t off;
+    uint32_t len;
+} lp_slice_t;
+
+static lp_slice_t s_slices[LP_SLICES];
+static uint16_t   s_slice_next[LP_SLICES];
+static uint32_t   s_slice_head = 0;
+static uint16_t   s_slices_used = 0;
+static uint16_t   s_slices_peak = 0;
+static uint32_t   s_slice_fail = 0;
+#endif
+
+#if LP_OWNERS > 0
+/*
+ * Tagi właścicieli: wpis 0 = nieoznaczone (każdy alloc startuje tutaj), kolejne zajmowane
+ * leniwie przez lp_set_owner() (CAS na wskaźniku; tag musi żyć zawsze — literał).
+ * Liczba trzymanych slotów per tag nie jest licznikiem na ścieżce alloc/release,
+ * tylko wynikiem skanu slotów (lp_get_owner_stats) — hot path płaci jedynie odczyt ticka.
+ */
+#define LP_OWN_SEG_  0x01u /* segment łańcucha (nie głowa) — wiek/wyciek liczone na głowie */
+#define LP_OWN_LEAK_ 0x02u /* lease już zgłoszony przez detektor wycieków */
+
+static const char* s_owner_tag[LP_OWNERS];
+static uint32_t    s_owner_tagged[LP_OWNERS];
+static uint32_t    s_owner_leaks[LP_OWNERS];
+static uint32_t    s_leaks = 0;
+#endif
+
+#if LP_HIST
+/*
+ * Histogram czasu życia per klasa (kubełki log2 µs, patrz lp_lifetime_hist_t) i ring próbek
+ * zajętości. Ring pisze zwykle jedno zadanie; s_occ_seq rezerwuje pozycję atomowo, więc
+ * równoległe lp_occ_sample() nie gubią próbek, a odczyt jest best‑effort.
+ */
+static uint32_t        s_life[LP_NUM_CLASSES][LP_HIST_BUCKETS];
+static lp_occ_sample_t s_occ[LP_OCC_SAMPLES];
+static uint32_t        s_occ_seq = 0;
+#endif
+
+/* lp_make_writable: zwrócony ten sam lease (jedyny posiadacz) / prywatna kopia. */
+static uint32_t s_cow_inplace = 0;
+static uint32_t s_cow_copies = 0;
+
+/*
+ * LOCKFREE=n: te same algorytmy (CAS zawsze trafia za pierwszym razem), ale każda operacja
+ * publiczna w sekcji krytycznej s_mux — wariant referencyjny do porównań i dla targetów
+ * bez sprzętowego CAS.
+ */
+#if LP_LOCKFREE
+#  define LP_LOCK()   do { } while (0)
+#  define LP_UNLOCK() do { } while (0)
+#else
 static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_lock_rounds = 0; // wejścia w sekcję krytyczną (lp_stats_t.lock_rounds)
+#  define LP_LOCK()   do { portENTER_CRITICAL(&s_mux); s_lock_rounds++; } while (0)
+#  define LP_UNLOCK() portEXIT_CRITICAL(&s_mux)
+#endif
 
-static inline bool lp_valid_idx_(uint16_t idx)
+#define LP_LOAD_(p)            __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define LP_CAS_(p, exp, des)   __atomic_compare_exchange_n((p), (exp), (des), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define LP_ADD_(p, v)          ((void)__atomic_fetch_add((p), (v), __ATOMIC_RELAXED))
+
+static inline void lp_peak_update_(uint16_t* peak, uint16_t now)
 {
-    return (idx < (uint16_t)LP_NUM_SLOTS);
+    uint16_t cur = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (now > cur && !__atomic_compare_exchange_n(peak, &cur, now, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
 }
 
+static inline bool lp_stack_pop_(uint32_t* fl_head, uint16_t* links, uint16_t* out_local)
+{
+    uint32_t head = __atomic_load_n(fl_head, __ATOMIC_ACQUIRE);
+    for (;;) {
+        const uint16_t top = LP_FL_TOP_(head);
+        if (top == LP_FL_NIL) return false;
+
+        // links[top] może być już nieaktualny (top zdjęty przez innego) — wtedy tag w head się zmienił i CAS nie przejdzie.
+        const uint16_t next = __atomic_load_n(&links[top], __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(fl_head, &head, LP_FL_NEXT_(head, next), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            *out_local = top;
+            return true;
+        }
+    }
+}
+
+static inline void lp_stack_push_(uint32_t* fl_head, uint16_t* links, uint16_t local)
+{
+    uint32_t head = __atomic_load_n(fl_head, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&links[local], LP_FL_TOP_(head), __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(fl_head, &head, LP_FL_NEXT_(head, local), true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*
+ * Rezerwy: fl_count liczy sloty free‑listy klasy. Pop najpierw rezerwuje (claim) licznik
+ * z progiem floor[prio], dopiero potem zdejmuje slot; push najpierw kładzie slot, potem
+ * podbija licznik. Stąd fl_count ≤ długość stosu i udany claim zawsze ma slot do zdjęcia,
+ * a priorytet niższy niż CRITICAL nigdy nie zejdzie poniżej swojego progu (także przy
+ * równoległych alloc z wielu rdzeni). Magazyny trzymają sloty poza free‑listą — rezerwa
+ * leży zawsze na liście globalnej.
+ */
+static inline uint16_t lp_fl_claim_(lp_class_t* c, uint16_t n, uint16_t floor)
+{
+    uint16_t cur = __atomic_load_n(&c->fl_count, __ATOMIC_RELAXED);
+    for (;;) {
+        if (cur <= floor) return 0;
+        const uint16_t take = (uint16_t)((cur - floor) < n ? (cur - floor) : n);
+        if (__atomic_compare_exchange_n(&c->fl_count, &cur, (uint16_t)(cur - take), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return take;
+        }
+    }
+}
+
+/*
+ * Zdejmuje slot zarezerwowany wcześniej przez lp_fl_claim_. Przy niezmienniku
+ * fl_count ≤ długość stosu każdy obserwowany stan listy ma nasz slot — pop nie trafi
+ * na pustą listę (pętla tylko na wypadek uszkodzenia, które wykryje lp_check).
+ */
+static inline uint16_t lp_fl_pop_claimed_(lp_class_t* c)
+{
+    uint16_t local = LP_FL_NIL;
+    while (!lp_stack_pop_(&c->fl_head, c->next, &local)) {
+    }
+    return local;
+}
+
+static inline bool lp_fl_take_(lp_class_t* c, uint16_t floor, uint16_t* out_local)
+{
+    if (!lp_fl_claim_(c, 1u, floor)) return false;
+    *out_local = lp_fl_pop_claimed_(c);
+    return true;
+}
+
+static inline void lp_fl_push_(lp_class_t* c, uint16_t local)
+{
+    lp_stack_push_(&c->fl_head, c->next, local);
+    (void)__atomic_add_fetch(&c->fl_count, 1u, __ATOMIC_RELEASE);
+}
+
+static inline uint16_t lp_make_idx_(size_t cls, uint16_t local)
+{
+    return (uint16_t)(((unsigned)cls << LP_HANDLE_CLASS_SHIFT) | local);
+}
+
+static inline lp_slot_t* lp_slot_at_(const lp_class_t* c, uint16_t local)
+{
+    return &c->meta[local];
+}
+
+/* Mapuje idx uchwytu na (klasa, slot); NULL dla indeksu spoza puli. */
+static inline lp_slot_t* lp_locate_(uint16_t idx, lp_class_t** out_cls)
+{
+    const unsigned cls = (unsigned)idx >> LP_HANDLE_CLASS_SHIFT;
+    const uint16_t local = (uint16_t)(idx & LP_HANDLE_LOCAL_MASK);
+    if (cls >= (unsigned)LP_NUM_CLASSES) return NULL;
+
+    lp_class_t* c = &s_cls[cls];
+    if (local >= c->slots) return NULL;
+
+    if (out_cls) *out_cls = c;
+    return lp_slot_at_(c, local);
+}
+
+static inline uint8_t* lp_buf_(const lp_class_t* c, const lp_slot_t* s)
+{
+    return c->arena + (size_t)(s - c->meta) * c->stride;
+}
+
+/* Zajętość klasy / całej puli: licznik globalny + delty magazynów (best‑effort przy współbieżności). */
+#if (LP_OWNERS > 0) || LP_HIST
+static inline uint32_t lp_now_ms_(void)
+{
+#if defined(ESP_PLATFORM)
+    if (xPortInIsrContext()) return (uint32_t)(xTaskGetTickCountFromISR() * portTICK_PERIOD_MS);
+#endif
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+#endif
+
+#if LP_HIST
+/* Zegar µs (zawija co ~71 min — czasy życia dłuższe lądują w złym kubełku). */
+static inline uint32_t lp_now_us_(void)
+{
+#if defined(ESP_PLATFORM)
+    return (uint32_t)esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+#endif
+}
+
+static inline void lp_hist_record_(size_t k, const lp_slot_t* s)
+{
+    const uint32_t dt = lp_now_us_() - s->t_alloc_us;
+    // kubełek b: [2^(b-1), 2^b) µs; 0 = poniżej 1 µs
+    uint32_t b = dt ? (uint32_t)(32 - __builtin_clz(dt)) : 0u;
+    if (b >= LP_HIST_BUCKETS) b = LP_HIST_BUCKETS - 1u;
+    LP_ADD_(&s_life[k][b], 1u);
+}
+
+static void lp_hist_reset_(void)
+{
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        for (size_t b = 0; b < LP_HIST_BUCKETS; ++b) __atomic_store_n(&s_life[k][b], 0u, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&s_occ_seq, 0u, __ATOMIC_RELAXED);
+}
+#endif
+
+#if LP_OWNERS > 0
+static uint8_t lp_owner_id_(const char* tag)
+{
+    if (!tag) return 0;
+    for (uint8_t i = 1; i < LP_OWNERS; ++i) {
+        const char* cur = __atomic_load_n(&s_owner_tag[i], __ATOMIC_ACQUIRE);
+        if (!cur) {
+            if (__atomic_compare_exchange_n(&s_owner_tag[i], &cur, tag, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return i;
+            }
+            // ktoś zajął wpis równolegle — cur = jego tag
+        }
+        if (cur == tag || strcmp(cur, tag) == 0) return i;
+    }
+    return 0; // tablica pełna -> nieoznaczone
+}
+
+static void lp_owner_reset_(bool tags)
+{
+    for (size_t i = 0; i < LP_OWNERS; ++i) {
+        if (tags) __atomic_store_n(&s_owner_tag[i], (const char*)NULL, __ATOMIC_RELEASE);
+        __atomic_store_n(&s_owner_tagged[i], 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&s_owner_leaks[i], 0u, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&s_leaks, 0u, __ATOMIC_RELAXED);
+}
+#endif
+
+static uint16_t lp_class_used_(size_t k)
+{
+    int32_t used = __atomic_load_n(&s_cls[k].used, __ATOMIC_RELAXED);
+#if LP_MAG_SIZE > 0
+    for (size_t core = 0; core < LP_NUM_CORES; ++core) used += LP_MAG_GET_(&s_mag[core][k].used);
+#endif
+    return (uint16_t)(used > 0 ? used : 0);
+}
+
+static uint16_t lp_used_total_(void)
+{
+    int32_t used = __atomic_load_n(&s_used, __ATOMIC_RELAXED);
+#if LP_MAG_SIZE > 0
+    for (size_t core = 0; core < LP_NUM_CORES; ++core) {
+        for (size_t k = 0; k < LP_NUM_CLASSES; ++k) used += LP_MAG_GET_(&s_mag[core][k].used);
+    }
+#endif
+    return (uint16_t)(used > 0 ? used : 0);
+}
+
+#if LP_MAG_SIZE > 0
+/* Szczyt zajętości w trybie magazynów próbkowany na pudłach (refill/spill), nie przy każdym alloc. */
+static void lp_mag_peak_sample_(size_t k)
+{
+    lp_peak_update_(&s_cls[k].peak_used, lp_class_used_(k));
+    lp_peak_update_(&s_peak_used, lp_used_total_());
+}
+
+/*
+ * Alloc z magazynu bieżącego rdzenia; pusty -> partia z globalnej free‑listy powyżej progu
+ * `floor`. refill=false (CRITICAL): bez partii — rezerwa nie może wyciec do magazynu, z którego
+ * korzystałby potem zwykły ruch; wołający bierze wtedy pojedynczy slot z free‑listy. Pod LP_LOCK.
+ */
+static bool lp_mag_alloc_(size_t k, uint32_t want_len, uint16_t floor, bool refill, uint16_t* out_local)
+{
+    lp_class_t* c = &s_cls[k];
+    bool ok = true;
+    bool miss = false;
+
+    const UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    lp_mag_t* m = &s_mag[xPortGetCoreID()][k];
+
+    uint16_t n = m->count;
+    if (n > 0) {
+        LP_MAG_ADD_(&m->hits, 1u);
+    } else if (!refill) {
+        ok = false;
+    } else {
+        const uint16_t batch = lp_fl_claim_(c, (uint16_t)((c->mag_cap + 1u) / 2u), floor);
+        while (n < batch) m->idx[n++] = lp_fl_pop_claimed_(c);
+
+        LP_MAG_ADD_(&m->misses, 1u);
+        miss = true;
+        ok = (n > 0);
+    }
+
+    if (ok) {
+        *out_local = m->idx[--n];
+        LP_MAG_ADD_(&m->used, 1);
+        LP_MAG_ADD_(&m->alloc_ok, 1u);
+        LP_MAG_ADD64_(&m->bytes_req, want_len);
+        LP_MAG_ADD64_(&m->bytes_cap, c->cap);
+    }
+    LP_MAG_SET_(&m->count, n);
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+
+    if (ok && miss) lp_mag_peak_sample_(k);
+    return ok;
+}
+
+/* Zwrot do magazynu bieżącego rdzenia; pełny -> najpierw oddaje partię do globalnej free‑listy.
+ * Gdy globalna lista jest poniżej progu LOW (rezerwy wyczerpane), slot wraca od razu na nią —
+ * inaczej zwolnienia osiadałyby w magazynie i byłyby zjadane przez ruch LOW. Pod LP_LOCK. */
+static void lp_mag_free_(size_t k, uint16_t local)
+{
+    lp_class_t* c = &s_cls[k];
+    bool spill = false;
+
+    const UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    lp_mag_t* m = &s_mag[xPortGetCoreID()][k];
+
+    if (__atomic_load_n(&c->fl_count, __ATOMIC_RELAXED) < c->floor[LP_PRIO_LOW]) {
+        lp_fl_push_(c, local);
+        LP_MAG_ADD_(&m->used, -1);
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+        return;
+    }
+
+    uint16_t n = m->count;
+    if (n >= c->mag_cap) {
+        const uint16_t batch = (uint16_t)((c->mag_cap + 1u) / 2u);
+
+        for (uint16_t i = 0; i < batch; ++i) lp_fl_push_(c, m->idx[--n]);
+
+        LP_MAG_ADD_(&m->spills, 1u);
+        spill = true;
+    }
+
+    m->idx[n++] = local;
+    LP_MAG_SET_(&m->count, n);
+    LP_MAG_ADD_(&m->used, -1);
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+
+    if (spill) lp_mag_peak_sample_(k);
+}
+#endif // LP_MAG_SIZE > 0
+
 #if CONFIG_CORE_LEASEPOOL_GUARD
+static inline uint32_t lp_tail_get_(const lp_class_t* c, lp_slot_t* s)
+{
+    uint32_t v;
+    memcpy(&v, lp_buf_(c, s) + c->cap, sizeof(v));
+    return v;
+}
+
+static inline void lp_tail_set_(const lp_class_t* c, lp_slot_t* s)
+{
+    const uint32_t v = LP_CANARY_VALUE;
+    memcpy(lp_buf_(c, s) + c->cap, &v, sizeof(v));
+}
+
 static inline void lp_guard_fail_(const char* api, const char* why, lp_handle_t h)
 {
     // Best-effort (debug): liczniki nie muszą być idealnie atomowe.
     s_guard_failures++;
 
-    LP_DIAG_PRINTF("LP GUARD FAIL: %s: %s (idx=%u gen=%u)\n",
-                   api ? api : "?",
-                   why ? why : "?",
-                   (unsigned)h.idx,
-                   (unsigned)h.gen);
-    abort();
+    LP_DIAG_PRINTF("LP GUARD FAIL: %s: %s (idx=0x%04X gen=%u)\n",
+                   api ? api : "?",
+                   why ? why : "?",
+                   (unsigned)h.idx,
+                   (unsigned)h.gen);
+    abort();
+}
+
+static inline void lp_guard_check_canary_(const lp_class_t* c, lp_slot_t* s, const char* api, lp_handle_t h)
+{
+    if (!s) lp_guard_fail_(api, "null slot", h);
+    if (s->canary_head != LP_CANARY_VALUE) lp_guard_fail_(api, "canary_head corrupted", h);
+    if (lp_tail_get_(c, s) != LP_CANARY_VALUE) lp_guard_fail_(api, "canary_tail corrupted", h);
+}
+
+static inline void lp_guard_check_magic_(const lp_slot_t* s, uint32_t expected, const char* api, lp_handle_t h)
+{
+    if (!s) lp_guard_fail_(api, "null slot", h);
+    if (s->magic != expected) lp_guard_fail_(api, (expected == LP_MAGIC_FREE) ? "magic != FREE" : "magic != USED", h);
+}
+
+static inline bool lp_guard_is_free_magic_(uint32_t magic)
+{
+    return magic == LP_MAGIC_FREE || magic == LP_MAGIC_DIRTY;
+}
+
+static inline void lp_guard_check_free_(const lp_slot_t* s, const char* api, lp_handle_t h)
+{
+    if (!s) lp_guard_fail_(api, "null slot", h);
+    if (!lp_guard_is_free_magic_(s->magic)) lp_guard_fail_(api, "magic != FREE", h);
+}
+
+#if LP_POISON_MODE == LP_POISON_SAMPLED_
+static uint32_t s_guard_tick = 0;
+#endif
+
+/* Czy ten release zatruwa bufor (koszt O(cap)). */
+static inline bool lp_guard_poison_now_(void)
+{
+#if LP_POISON_MODE == LP_POISON_FULL_
+    return true;
+#elif LP_POISON_MODE == LP_POISON_SAMPLED_
+    return (__atomic_fetch_add(&s_guard_tick, 1u, __ATOMIC_RELAXED) % LP_GUARD_SAMPLE_RATE) == 0u;
+#else
+    return false;
+#endif
+}
+
+static inline void lp_guard_poison_fill_(uint8_t* p, uint32_t n, uint8_t v)
+{
+    if (!p || n == 0) return;
+    memset(p, (int)v, (size_t)n);
+}
+
+static inline void lp_guard_poison_expect_(const lp_class_t* c, lp_slot_t* s, uint8_t expected, const char* api, lp_handle_t h)
+{
+    // wykrywa UAF-writes: slot powinien być w całości wypełniony wzorcem.
+    const uint8_t* p = lp_buf_(c, s);
+    for (uint32_t i = 0; i < c->cap; ++i) {
+        if (p[i] != expected) {
+            lp_guard_fail_(api, "poison mismatch (UAF write?)", h);
+        }
+    }
+}
+
+static inline void lp_guard_set_free_(const lp_class_t* c, lp_slot_t* s, bool poison)
+{
+    s->canary_head = LP_CANARY_VALUE;
+    lp_tail_set_(c, s);
+    if (poison) {
+        s->magic = LP_MAGIC_FREE;
+        lp_guard_poison_fill_(lp_buf_(c, s), c->cap, (uint8_t)LP_POISON_FREE);
+    } else {
+        s->magic = LP_MAGIC_DIRTY;
+    }
+}
+
+static inline void lp_guard_set_used_(const lp_class_t* c, lp_slot_t* s, bool poison)
+{
+    s->canary_head = LP_CANARY_VALUE;
+    lp_tail_set_(c, s);
+    s->magic = LP_MAGIC_USED;
+    if (poison) lp_guard_poison_fill_(lp_buf_(c, s), c->cap, (uint8_t)LP_POISON_ALLOC);
+}
+#endif // CONFIG_CORE_LEASEPOOL_GUARD
+
+static uint16_t lp_total_slots_(void)
+{
+    uint16_t n = 0;
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) n = (uint16_t)(n + s_cls[k].slots);
+    return n;
+}
+
+#if LP_MAINT_TASK
+static void lp_maint_task_(void* arg)
+{
+    (void)arg;
+#if LP_LEAK_PERIOD_MS > 0
+    TickType_t last_scan = xTaskGetTickCount();
+#endif
+#if LP_OCC_PERIOD_MS > 0
+    TickType_t last_occ = xTaskGetTickCount();
+#endif
+    for (;;) {
+#if LP_POISON_MODE == LP_POISON_SCRUB_
+        for (size_t k = 0; k < LP_NUM_CLASSES; ++k) (void)lp_scrub_step(LP_SCRUB_BUDGET);
+#endif
+#if LP_LEAK_PERIOD_MS > 0
+        const TickType_t now = xTaskGetTickCount();
+        if ((TickType_t)(now - last_scan) >= pdMS_TO_TICKS(LP_LEAK_PERIOD_MS)) {
+            last_scan = now;
+            (void)lp_leak_scan(0, true);
+        }
+#endif
+#if LP_OCC_PERIOD_MS > 0
+        if ((TickType_t)(xTaskGetTickCount() - last_occ) >= pdMS_TO_TICKS(LP_OCC_PERIOD_MS)) {
+            last_occ = xTaskGetTickCount();
+            lp_occ_sample();
+        }
+#endif
+        vTaskDelay(pdMS_TO_TICKS(LP_MAINT_PERIOD_MS));
+    }
+}
+#endif
+
+void lp_init(void)
+{
+    LP_LOCK();
+
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        lp_class_t* c = &s_cls[k];
+
+        for (uint16_t i = 0; i < c->slots; ++i) {
+            c->next[i] = (uint16_t)((i + 1u < c->slots) ? (i + 1u) : LP_FL_NIL);
+
+            lp_slot_t* s = lp_slot_at_(c, i);
+            s->state = LP_ST_(1u, 0u);
+            s->len = 0;
+            s->chain_next = LP_CHAIN_END_;
+            s->ring = 0;
+#if LP_OWNERS > 0
+            s->t_alloc_ms = 0;
+            s->owner = 0;
+            s->own_flags = 0;
+            s->reserved = 0;
+#endif
+
+#if CONFIG_CORE_LEASEPOOL_GUARD
+            lp_guard_set_free_(c, s, LP_POISON_MODE == LP_POISON_FULL_);
+#endif
+        }
+        __atomic_store_n(&c->fl_head, (uint32_t)0u, __ATOMIC_RELEASE);
+        __atomic_store_n(&c->fl_count, c->slots, __ATOMIC_RELEASE);
+
+        // Rezerwy ograniczone do 1/4 klasy każda, żeby mała klasa nie była cała "zarezerwowana".
+        const uint16_t rc = (uint16_t)(LP_RESERVE_CRITICAL < c->slots / 4u ? LP_RESERVE_CRITICAL : c->slots / 4u);
+        const uint16_t rn = (uint16_t)(LP_RESERVE_NORMAL < c->slots / 4u ? LP_RESERVE_NORMAL : c->slots / 4u);
+        c->floor[LP_PRIO_CRITICAL] = 0;
+        c->floor[LP_PRIO_NORMAL] = rc;
+        c->floor[LP_PRIO_LOW] = (uint16_t)(rc + rn);
+        for (size_t p = 0; p < LP_PRIO_COUNT; ++p) c->fail_prio[p] = 0;
+
+#if LP_MAG_SIZE > 0
+        // Magazyny łącznie najwyżej ~1/4 klasy: małe klasy nie mogą utknąć w cache drugiego rdzenia.
+        uint32_t mag_cap = c->slots / (4u * LP_NUM_CORES);
+        if (mag_cap > LP_MAG_SIZE) mag_cap = LP_MAG_SIZE;
+        c->mag_cap = (uint16_t)(mag_cap >= 2u ? mag_cap : 0u);
+
+        for (size_t core = 0; core < LP_NUM_CORES; ++core) {
+            memset(&s_mag[core][k], 0, sizeof(s_mag[core][k]));
+        }
+#else
+        c->mag_cap = 0;
+#endif
+
+        c->used = 0;
+        c->peak_used = 0;
+        c->ring_slots = 0;
+        c->alloc_ok = 0;
+        c->alloc_spill = 0;
+        c->alloc_fail = 0;
+        c->bytes_req = 0;
+        c->bytes_cap = 0;
+    }
+
+    s_used = 0;
+    s_peak_used = 0;
+    s_guard_failures = 0;
+
+#if LP_SLICES > 0
+    for (uint16_t i = 0; i < LP_SLICES; ++i) {
+        s_slice_next[i] = (uint16_t)((i + 1u < LP_SLICES) ? (i + 1u) : LP_FL_NIL);
+        s_slices[i].state = LP_ST_(1u, 0u);
+        s_slices[i].parent = LP_CHAIN_END_;
+        s_slices[i].off = 0;
+        s_slices[i].len = 0;
+    }
+    __atomic_store_n(&s_slice_head, (uint32_t)0u, __ATOMIC_RELEASE);
+    s_slices_used = 0;
+    s_slices_peak = 0;
+    s_slice_fail = 0;
+#endif
+#if LP_OWNERS > 0
+    lp_owner_reset_(true);
+#endif
+#if LP_HIST
+    lp_hist_reset_();
+#endif
+
+    LP_UNLOCK();
+
+#if LP_MAINT_TASK
+    // Jedno zadanie na cały czas życia aplikacji (lp_init może być wołane ponownie, np. w testach).
+    static TaskHandle_t s_maint = NULL;
+    if (!s_maint) {
+        (void)xTaskCreate(lp_maint_task_, "lp_maint", 2560, NULL, tskIDLE_PRIORITY + 1, &s_maint);
+    }
+#endif
+
+#if CONFIG_CORE_LEASEPOOL_SELFTEST_ON_BOOT
+    const int issues = lp_check(false);
+    if (issues == 0) {
+        LP_DIAG_PRINTF("LeasePool selftest: OK (classes=%u slots=%u cap_max=%u)\n",
+                       (unsigned)LP_NUM_CLASSES,
+                       (unsigned)lp_total_slots_(),
+                       (unsigned)s_cls[LP_NUM_CLASSES - 1].cap);
+    } else {
+        LP_DIAG_PRINTF("LeasePool selftest: FAIL (issues=%d classes=%u slots=%u)\n",
+                       issues,
+                       (unsigned)LP_NUM_CLASSES,
+                       (unsigned)lp_total_slots_());
+    }
+#endif
+}
+
+/*
+ * Wolny slot (zdjęty z free‑listy / magazynu albo odłożony w ringu) staje się leasem h
+ * z refcnt=1. Slot jest wyłącznie nasz — wystarczy publikacja stanu. Pod LP_LOCK.
+ */
+static void lp_slot_arm_(const lp_class_t* c, lp_slot_t* s, lp_handle_t h, const char* api)
+{
+#if CONFIG_CORE_LEASEPOOL_GUARD
+    // Slot właśnie zszedł z listy FREE: musi wyglądać jak FREE.
+    lp_guard_check_canary_(c, s, api, h);
+    lp_guard_check_free_(s, api, h);
+
+    // Zatruty slot (FULL zawsze, SAMPLED co N‑ty): weryfikacja UAF‑write + wzorzec ALLOC.
+    // W trybie SCRUB weryfikację robi lp_scrub_step() poza ścieżką alloc.
+    const bool poisoned = (LP_POISON_MODE != LP_POISON_SCRUB_) && (s->magic == LP_MAGIC_FREE);
+    if (poisoned) lp_guard_poison_expect_(c, s, (uint8_t)LP_POISON_FREE, api, h);
+
+    lp_guard_set_used_(c, s, poisoned);
+#else
+    (void)c;
+    (void)api;
+#endif
+
+    s->len = 0;
+    s->chain_next = LP_CHAIN_END_;
+#if LP_OWNERS > 0
+    __atomic_store_n(&s->t_alloc_ms, lp_now_ms_(), __ATOMIC_RELAXED);
+    __atomic_store_n(&s->owner, (uint8_t)0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->own_flags, (uint8_t)0u, __ATOMIC_RELAXED);
+#endif
+#if LP_HIST
+    s->t_alloc_us = lp_now_us_();
+#endif
+    __atomic_store_n(&s->state, LP_ST_(h.gen, 1u), __ATOMIC_RELEASE);
+}
+
+lp_handle_t lp_alloc_try(uint32_t want_len)
+{
+    return lp_alloc_try_prio(want_len, LP_PRIO_NORMAL);
+}
+
+lp_handle_t lp_alloc_try_prio(uint32_t want_len, lp_prio_t prio)
+{
+    lp_handle_t h = lp_invalid_handle();
+    if ((unsigned)prio >= LP_PRIO_COUNT) prio = LP_PRIO_NORMAL;
+
+    // Best-fit: najmniejsza klasa, która pomieści want_len.
+    size_t fit = 0;
+    while (fit < LP_NUM_CLASSES && want_len > s_cls[fit].cap) fit++;
+    if (fit == LP_NUM_CLASSES) {
+        return h;
+    }
+
+    LP_LOCK();
+
+    // Pusta klasa best-fit -> przelew do najbliższej większej (kosztem pamięci, nie dropu).
+    size_t k = fit;
+    uint16_t local = 0;
+    bool via_mag = false;
+    for (; k < LP_NUM_CLASSES; ++k) {
+        const uint16_t floor = s_cls[k].floor[prio];
+#if LP_MAG_SIZE > 0
+        if (s_cls[k].mag_cap) {
+            const bool refill = (prio != LP_PRIO_CRITICAL);
+            if (lp_mag_alloc_(k, want_len, floor, refill, &local)) {
+                via_mag = true;
+                break;
+            }
+            if (refill) continue; // partia nie przeszła progu — klasa wyczerpana dla prio
+        }
+#endif
+        if (lp_fl_take_(&s_cls[k], floor, &local)) break;
+    }
+
+    if (k == LP_NUM_CLASSES) {
+        LP_ADD_(&s_cls[fit].alloc_fail, 1u);
+        LP_ADD_(&s_cls[fit].fail_prio[prio], 1u);
+        LP_UNLOCK();
+        return h;
+    }
+
+    lp_class_t* c = &s_cls[k];
+    lp_slot_t* s = lp_slot_at_(c, local);
+
+    h.idx = lp_make_idx_(k, local);
+    h.gen = LP_ST_GEN_(LP_LOAD_(&s->state));
+    lp_slot_arm_(c, s, h, "lp_alloc_try");
+
+    // statystyki (ścieżka magazynu liczy lokalnie w lp_mag_alloc_)
+    if (!via_mag) {
+        LP_ADD_(&c->alloc_ok, 1u);
+        LP_ADD_(&c->bytes_req, (uint64_t)want_len);
+        LP_ADD_(&c->bytes_cap, (uint64_t)c->cap);
+
+        lp_peak_update_(&c->peak_used, (uint16_t)(__atomic_add_fetch(&c->used, 1u, __ATOMIC_RELAXED)));
+        lp_peak_update_(&s_peak_used, (uint16_t)(__atomic_add_fetch(&s_used, 1u, __ATOMIC_RELAXED)));
+    }
+    if (k != fit) LP_ADD_(&s_cls[fit].alloc_spill, 1u);
+
+    LP_UNLOCK();
+    return h;
+}
+
+#if LP_SLICES > 0
+static inline lp_slice_t* lp_slice_locate_(lp_handle_t h)
+{
+    if (!lp_handle_is_slice(h)) return NULL;
+    const uint16_t i = (uint16_t)(h.idx & LP_HANDLE_LOCAL_MASK);
+    return (i < LP_SLICES) ? &s_slices[i] : NULL;
+}
+
+/* Ważny slice: zgodna generacja i refcnt>0; dla nieważnego NULL. */
+static lp_slice_t* lp_slice_live_(lp_handle_t h)
+{
+    lp_slice_t* d = lp_slice_locate_(h);
+    if (!d) return NULL;
+    const uint32_t st = LP_LOAD_(&d->state);
+    return (LP_ST_GEN_(st) == h.gen && LP_ST_REF_(st) > 0) ? d : NULL;
+}
+#endif
+
+/*
+ * Przejście po segmentach leasa (głowa: refcnt>0, segmenty łańcucha: własne refcnt==1).
+ * clip=false: każdy segment (ptr, len z commit, cap); clip=true: tylko część zatwierdzonych
+ * danych w [off, off+len) (widok tylko do odczytu, cap = len). Pod LP_LOCK.
+ * Zwraca liczbę segmentów widoku (może być > iovcnt); 0 = nieważny uchwyt.
+ */
+static size_t lp_walk_(lp_handle_t h, bool clip, uint32_t off, uint32_t len, lp_iov_t* iov, size_t iovcnt)
+{
+    size_t n = 0;
+    bool first = true;
+
+    for (;;) {
+        lp_class_t* c = NULL;
+        lp_slot_t* s = lp_locate_(h.idx, &c);
+        if (!s) return 0;
+
+        const uint32_t st = LP_LOAD_(&s->state);
+        if (LP_ST_GEN_(st) != h.gen || LP_ST_REF_(st) == 0) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+            if (!first) lp_guard_fail_("lp_acquire_iov", "broken chain link", h);
+#endif
+            return 0;
+        }
+        first = false;
+        (void)first;
+#if CONFIG_CORE_LEASEPOOL_GUARD
+        lp_guard_check_canary_(c, s, "lp_acquire_iov", h);
+        lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_acquire_iov", h);
+#endif
+        uint8_t* ptr = lp_buf_(c, s);
+        uint32_t seg_len = s->len;
+        uint32_t seg_cap = c->cap;
+        bool emit = true;
+
+        if (clip) {
+            // część segmentu w [off, off+len) (off liczone od początku bieżącego segmentu)
+            if (off >= seg_len) {
+                off -= seg_len;
+                emit = false;
+            } else {
+                ptr += off;
+                seg_len -= off;
+                off = 0;
+                if (seg_len > len) seg_len = len;
+                len -= seg_len;
+                seg_cap = seg_len;
+            }
+        }
+
+        if (emit) {
+            if (iov && n < iovcnt) {
+                iov[n].ptr = (void*)ptr;
+                iov[n].len = seg_len;
+                iov[n].cap = seg_cap;
+            }
+            n++;
+        }
+
+        if ((clip && len == 0) || s->chain_next == LP_CHAIN_END_) break;
+        h = lp_unpack_handle_u32(s->chain_next);
+    }
+
+    return n;
+}
+
+bool lp_acquire(lp_handle_t h, lp_view_t* out)
+{
+    if (!out) return false;
+
+#if LP_SLICES > 0
+    if (lp_handle_is_slice(h)) {
+        // pierwszy (zwykle jedyny) kawałek zakresu; całość przez lp_acquire_iov()
+        LP_LOCK();
+        const lp_slice_t* d = lp_slice_live_(h);
+        const size_t n = d ? lp_walk_(lp_unpack_handle_u32(d->parent), true, d->off, d->len, out, 1) : 0;
+        LP_UNLOCK();
+        return n > 0;
+    }
+#endif
+
+    lp_class_t* c = NULL;
+    lp_slot_t* s = lp_locate_(h.idx, &c);
+    if (!s) return false;
+
+    bool ok = false;
+
+    LP_LOCK();
+
+    const uint32_t st = LP_LOAD_(&s->state);
+    if (LP_ST_GEN_(st) == h.gen && LP_ST_REF_(st) > 0) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+        lp_guard_check_canary_(c, s, "lp_acquire", h);
+        lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_acquire", h);
+#endif
+        out->ptr = (void*)lp_buf_(c, s);
+        out->len = s->len;
+        out->cap = c->cap;
+        ok = true;
+    }
+
+    LP_UNLOCK();
+    return ok;
+}
+
+void lp_commit(lp_handle_t h, uint32_t len)
+{
+#if LP_SLICES > 0
+    if (lp_handle_is_slice(h)) {
+        // slice to widok tylko do odczytu — długość wyznacza lp_slice()
+#if CONFIG_CORE_LEASEPOOL_GUARD
+        lp_guard_fail_("lp_commit", "commit on slice (read-only view)", h);
+#endif
+        return;
+    }
+#endif
+
+    lp_class_t* c = NULL;
+    lp_slot_t* s = lp_locate_(h.idx, &c);
+    if (!s) return;
+
+    LP_LOCK();
+
+    const uint32_t st = LP_LOAD_(&s->state);
+    if (LP_ST_GEN_(st) != h.gen || LP_ST_REF_(st) == 0) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+        lp_guard_fail_("lp_commit", "invalid handle or refcnt==0", h);
+#endif
+        LP_UNLOCK();
+        return;
+    }
+
+    // bariera przed publikacją len (dane bufora widoczne przed długością)
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    // Łańcuch: len to długość całkowita, segmenty wypełniane po kolei do pełna.
+    for (;;) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+        lp_guard_check_canary_(c, s, "lp_commit", h);
+        lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_commit", h);
+#endif
+        const uint32_t seg = (len > c->cap) ? c->cap : len;
+        s->len = seg;
+        len -= seg;
+
+        if (s->chain_next == LP_CHAIN_END_) break;
+        h = lp_unpack_handle_u32(s->chain_next);
+        s = lp_locate_(h.idx, &c);
+        if (!s) break;
+    }
+    __asm__ __volatile__("" ::: "memory");
+
+    if (len > 0) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+        lp_guard_fail_("lp_commit", "len > cap", h);
+#endif
+    }
+
+    LP_UNLOCK();
+}
+
+void lp_addref_n(lp_handle_t h, uint16_t n)
+{
+    if (n == 0) return;
+
+    lp_class_t* c = NULL;
+    lp_slot_t* s = lp_locate_(h.idx, &c);
+    uint32_t* state = s ? &s->state : NULL;
+#if LP_SLICES > 0
+    lp_slice_t* d = lp_slice_locate_(h);
+    if (d) state = &d->state;
+#endif
+    if (!state) return;
+
+    LP_LOCK();
+
+    uint32_t st = LP_LOAD_(state);
+    for (;;) {
+        if (LP_ST_GEN_(st) != h.gen || LP_ST_REF_(st) == 0) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+            lp_guard_fail_("lp_addref_n", "invalid handle or refcnt==0", h);
+#endif
+            LP_UNLOCK();
+            return;
+        }
+        if ((uint32_t)LP_ST_REF_(st) + (uint32_t)n > 0xFFFFu) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+            lp_guard_fail_("lp_addref_n", "refcnt overflow", h);
+#endif
+            LP_UNLOCK();
+            return;
+        }
+        if (LP_CAS_(state, &st, st + n)) break;
+    }
+
+#if CONFIG_CORE_LEASEPOOL_GUARD
+    if (s) {
+        lp_guard_check_canary_(c, s, "lp_addref_n", h);
+        lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_addref_n", h);
+    }
+#endif
+
+    LP_UNLOCK();
+}
+
+/* Zdejmuje n referencji jednym CAS; gdy slot wrócił do puli, zwraca kolejny segment łańcucha
+ * do zwolnienia (segmenty mają refcnt=1). Pod LP_LOCK. */
+static lp_handle_t lp_release_one_locked_(lp_handle_t h, uint16_t n)
+{
+#if LP_SLICES > 0
+    lp_slice_t* d = lp_slice_locate_(h);
+    if (d) {
+        uint32_t st = LP_LOAD_(&d->state);
+        uint32_t next;
+        do {
+            if (LP_ST_GEN_(st) != h.gen || LP_ST_REF_(st) < n) {
+#if CONFIG_CORE_LEASEPOOL_GUARD
+                lp_guard_fail_("lp_release", "stale slice handle or double free", h);
+#endif
+                return lp_invalid_handle();
+            }
+            next = (LP_ST_REF_(st) == n) ? LP_ST_(LP_GEN_NEXT_(h.gen), 0u) : (st - n);
+        } while (!LP_CAS_(&d->state, &st, next));
+
+        lp_handle_t parent = lp_invalid_handle();
+        if (LP_ST_REF_(next) == 0) {
+            // ostatnia referencja slice'a -> oddaj deskryptor i referencję rodzica
+            parent = lp_unpack_handle_u32(d->parent);
+            d->parent = LP_CHAIN_END_;
+            (void)__atomic_sub_fetch(&s_slices_used, 1u, __ATOMIC_RELAXED);
+            lp_stack_push_(&s_slice_head, s_slice_next, (uint16_t)(h.idx & LP_HANDLE_LOCAL_MASK));
+        }
+        return parent;
+    }
+#endif
+
+    lp_class_t* c = NULL;
+    lp_slot_t* s = lp_locate_(h.idx, &c);
+    if (!s) return lp_invalid_handle();
+
+#if CONFIG_CORE_LEASEPOOL_GUARD
+    // wykrywa overflow jeszcze przed oddaniem slota do puli
+    lp_guard_check_canary_(c, s, "lp_release", h);
+#endif
+
+    uint32_t st = LP_LOAD_(&s->state);
+    uint32_t next;
+    do {
+        if (LP_ST_GEN_(st) != h.gen) {
+            // stale handle / UAF
+#if CONFIG_CORE_LEASEPOOL_GUARD
+            lp_guard_fail_("lp_release", "gen mismatch (stale handle)", h);
+#endif
+            return lp_invalid_handle();
+        }
+        if (LP_ST_REF_(st) < n) {
+            // double free (albo zwolnienie większej liczby referencji niż trzymane)
+#if CONFIG_CORE_LEASEPOOL_GUARD
+            lp_guard_fail_("lp_release", "refcnt underflow (double free)", h);
+#endif
+            return lp_invalid_handle();
+        }
+        // Ostatnia referencja: gen++ w tym samym CAS (stare uchwyty natychmiast nieważne).
+        next = (LP_ST_REF_(st) == n) ? LP_ST_(LP_GEN_NEXT_(h.gen), 0u) : (st - n);
+    } while (!LP_CAS_(&s->state, &st, next));
+
+    lp_handle_t chain = lp_invalid_handle();
+
+    if (LP_ST_REF_(next) == 0) {
+        // Od tej chwili slot jest wyłącznie nasz, aż do push na free‑listę.
+        chain = lp_unpack_handle_u32(s->chain_next);
+        s->chain_next = LP_CHAIN_END_;
+        s->len = 0;
+#if LP_HIST
+        lp_hist_record_(lp_handle_class(h), s);
+#endif
+
+#if CONFIG_CORE_LEASEPOOL_GUARD
+        lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_release", h);
+        lp_guard_set_free_(c, s, lp_guard_poison_now_());
+#endif
+
+        // Slot ringu wraca do ringu (producent zobaczy FREE po acquire), nie na free‑listę.
+        if (__atomic_load_n(&s->ring, __ATOMIC_RELAXED) & LP_RING_OWNED_) {
+            (void)__atomic_fetch_or(&s->ring, LP_RING_FREE_, __ATOMIC_RELEASE);
+            return chain;
+        }
+
+        const uint16_t local = (uint16_t)(h.idx & LP_HANDLE_LOCAL_MASK);
+#if LP_MAG_SIZE > 0
+        if (c->mag_cap) {
+            lp_mag_free_(lp_handle_class(h), local);
+            return chain;
+        }
+#endif
+        (void)__atomic_sub_fetch(&c->used, 1u, __ATOMIC_RELAXED);
+        (void)__atomic_sub_fetch(&s_used, 1u, __ATOMIC_RELAXED);
+        lp_fl_push_(c, local);
+    }
+
+    return chain;
 }
 
-static inline void lp_guard_check_canary_(const lp_slot_t* s, const char* api, lp_handle_t h)
+/* n referencji uchwytu h, a po ostatniej cały łańcuch / referencja rodzica slice'a. Pod LP_LOCK. */
+static void lp_release_locked_(lp_handle_t h, uint16_t n)
 {
-    if (!s) lp_guard_fail_(api, "null slot", h);
-    if (s->canary_head != LP_CANARY_VALUE) lp_guard_fail_(api, "canary_head corrupted", h);
-    if (s->canary_tail != LP_CANARY_VALUE) lp_guard_fail_(api, "canary_tail corrupted", h);
+    h = lp_release_one_locked_(h, n);
+    while (lp_handle_is_valid(h)) h = lp_release_one_locked_(h, 1u);
 }
 
-static inline void lp_guard_check_magic_(const lp_slot_t* s, uint32_t expected, const char* api, lp_handle_t h)
+void lp_release(lp_handle_t h)
 {
-    if (!s) lp_guard_fail_(api, "null slot", h);
-    if (s->magic != expected) lp_guard_fail_(api, (expected == LP_MAGIC_FREE) ? "magic != FREE" : "magic != USED", h);
+    // Ostatnia referencja głowy zwalnia cały łańcuch (segmenty mają refcnt=1).
+    LP_LOCK();
+    lp_release_locked_(h, 1u);
+    LP_UNLOCK();
 }
 
-static inline void lp_guard_poison_fill_(uint8_t* p, uint32_t n, uint8_t v)
+void lp_release_ref_n(lp_handle_t h, uint16_t n)
 {
-    if (!p || n == 0) return;
-    memset(p, (int)v, (size_t)n);
-}
+    if (n == 0) return;
 
-static inline void lp_guard_poison_expect_(const lp_slot_t* s, uint8_t expected, const char* api, lp_handle_t h)
-{
-    // wykrywa UAF-writes: slot powinien być w całości wypełniony wzorcem.
-    const uint8_t* p = (const uint8_t*)s->buf;
-    for (uint32_t i = 0; i < (uint32_t)LP_BUF_SIZE; ++i) {
-        if (p[i] != expected) {
-            lp_guard_fail_(api, "poison mismatch (UAF write?)", h);
-        }
-    }
+    LP_LOCK();
+    lp_release_locked_(h, n);
+    LP_UNLOCK();
 }
 
-static inline void lp_guard_set_free_(lp_slot_t* s)
+void lp_release_n(const lp_handle_t* hs, size_t n)
 {
-    s->canary_head = LP_CANARY_VALUE;
-    s->canary_tail = LP_CANARY_VALUE;
-    s->magic = LP_MAGIC_FREE;
-    lp_guard_poison_fill_(s->buf, (uint32_t)LP_BUF_SIZE, (uint8_t)LP_POISON_FREE);
-}
+    if (!hs || n == 0) return;
 
-static inline void lp_guard_set_used_(lp_slot_t* s)
-{
-    s->canary_head = LP_CANARY_VALUE;
-    s->canary_tail = LP_CANARY_VALUE;
-    s->magic = LP_MAGIC_USED;
-    lp_guard_poison_fill_(s->buf, (uint32_t)LP_BUF_SIZE, (uint8_t)LP_POISON_ALLOC);
+    LP_LOCK();
+    for (size_t i = 0; i < n; ++i) {
+        if (lp_handle_is_valid(hs[i])) lp_release_locked_(hs[i], 1u);
+    }
+    LP_UNLOCK();
 }
-#endif // CONFIG_CORE_LEASEPOOL_GUARD
 
-void lp_init(void)
+/*
+ * Ring: sloty zdjęte z free‑listy raz, w lp_ring_init(), i do lp_ring_deinit() liczone jako zajęte.
+ * Obieg slotu: FREE w ringu -> lp_ring_acquire (refcnt=1) -> ... -> ostatni release ustawia
+ * LP_RING_FREE_ (release) -> producent widzi go (acquire) przy następnym okrążeniu.
+ */
+bool lp_ring_init(lp_ring_t* r, uint32_t seg_bytes, uint16_t count)
 {
-    portENTER_CRITICAL(&s_mux);
+    if (!r || count == 0 || count > LP_RING_MAX_SLOTS) return false;
 
-    s_free_top = (uint16_t)LP_NUM_SLOTS;
-    for (uint16_t i = 0; i < (uint16_t)LP_NUM_SLOTS; ++i) {
-        s_free[i] = i;
+    size_t k = 0;
+    while (k < LP_NUM_CLASSES && seg_bytes > s_cls[k].cap) k++;
 
-        s_slots[i].gen = 1;
-        s_slots[i].refcnt = 0;
-        s_slots[i].len = 0;
+    LP_LOCK();
 
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_set_free_(&s_slots[i]);
-#endif
+    // Cały ring z jednej klasy albo nic; rezerwa CRITICAL zostaje na free‑liście.
+    for (; k < LP_NUM_CLASSES; ++k) {
+        lp_class_t* c = &s_cls[k];
+        const uint16_t got = lp_fl_claim_(c, count, c->floor[LP_PRIO_NORMAL]);
+        if (got == count) break;
+        if (got) (void)__atomic_add_fetch(&c->fl_count, got, __ATOMIC_RELEASE); // nic nie zdjęte — oddaj licznik
+    }
+    if (k == LP_NUM_CLASSES) {
+        LP_UNLOCK();
+        return false;
     }
 
-    s_alloc_ok = 0;
-    s_alloc_fail = 0;
-    s_peak_used = 0;
-    s_guard_failures = 0;
-
-    portEXIT_CRITICAL(&s_mux);
-
-#if CONFIG_CORE_LEASEPOOL_SELFTEST_ON_BOOT
-    const int issues = lp_check(false);
-    if (issues == 0) {
-        LP_DIAG_PRINTF("LeasePool selftest: OK (slots=%u cap=%u)\n",
-                       (unsigned)LP_NUM_SLOTS,
-                       (unsigned)LP_BUF_SIZE);
-    } else {
-        LP_DIAG_PRINTF("LeasePool selftest: FAIL (issues=%d slots=%u cap=%u)\n",
-                       issues,
-                       (unsigned)LP_NUM_SLOTS,
-                       (unsigned)LP_BUF_SIZE);
+    lp_class_t* c = &s_cls[k];
+    for (uint16_t i = 0; i < count; ++i) {
+        const uint16_t local = lp_fl_pop_claimed_(c);
+        __atomic_store_n(&lp_slot_at_(c, local)->ring, LP_RING_OWNED_ | LP_RING_FREE_, __ATOMIC_RELEASE);
+        r->local[i] = local;
     }
-#endif
+    (void)__atomic_add_fetch(&c->ring_slots, count, __ATOMIC_RELAXED);
+    lp_peak_update_(&c->peak_used, (uint16_t)(__atomic_add_fetch(&c->used, count, __ATOMIC_RELAXED)));
+    lp_peak_update_(&s_peak_used, (uint16_t)(__atomic_add_fetch(&s_used, count, __ATOMIC_RELAXED)));
+
+    LP_UNLOCK();
+
+    r->cls = (uint8_t)k;
+    r->count = count;
+    r->head = 0;
+    r->acquired = 0;
+    r->full = 0;
+    return true;
 }
 
-lp_handle_t lp_alloc_try(uint32_t want_len)
+lp_handle_t lp_ring_acquire(lp_ring_t* r)
 {
-    lp_handle_t h = lp_invalid_handle();
-
-    if (want_len > (uint32_t)LP_BUF_SIZE) {
-        return h;
-    }
+    if (!r || r->count == 0) return lp_invalid_handle();
 
-    portENTER_CRITICAL(&s_mux);
+    lp_class_t* c = &s_cls[r->cls];
+    const uint16_t local = r->local[r->head];
+    lp_slot_t* s = lp_slot_at_(c, local);
 
-    if (s_free_top == 0) {
-        s_alloc_fail++;
-        portEXIT_CRITICAL(&s_mux);
-        return h;
+    // Zwolnienia w kolejności publikacji -> najstarszy slot ringu jest już wolny.
+    if (!(__atomic_load_n(&s->ring, __ATOMIC_ACQUIRE) & LP_RING_FREE_)) {
+        r->full++;
+        return lp_invalid_handle();
     }
+    (void)__atomic_fetch_and(&s->ring, ~LP_RING_FREE_, __ATOMIC_RELAXED);
+    r->head = (uint16_t)((r->head + 1u == r->count) ? 0u : r->head + 1u);
 
-    const uint16_t idx = s_free[--s_free_top];
-    lp_slot_t* s = &s_slots[idx];
+    const lp_handle_t h = { .idx = lp_make_idx_(r->cls, local), .gen = LP_ST_GEN_(LP_LOAD_(&s->state)) };
 
-#if CONFIG_CORE_LEASEPOOL_GUARD
-    // Slot właśnie zszedł z listy FREE: musi wyglądać jak FREE.
-    h.idx = idx;
-    h.gen = s->gen;
-    lp_guard_check_canary_(s, "lp_alloc_try", h);
-    lp_guard_check_magic_(s, LP_MAGIC_FREE, "lp_alloc_try", h);
-    lp_guard_poison_expect_(s, (uint8_t)LP_POISON_FREE, "lp_alloc_try", h);
+    LP_LOCK();
+    lp_slot_arm_(c, s, h, "lp_ring_acquire");
+    LP_UNLOCK();
 
-    lp_guard_set_used_(s);
-#endif
+    r->acquired++;
+    return h;
+}
 
-    s->refcnt = 1;
-    s->len = 0;
+bool lp_ring_deinit(lp_ring_t* r)
+{
+    if (!r) return false;
+    if (r->count == 0) return true;
 
-    // handle
-    h.idx = idx;
-    h.gen = s->gen;
+    lp_class_t* c = &s_cls[r->cls];
+    for (uint16_t i = 0; i < r->count; ++i) {
+        if (!(__atomic_load_n(&lp_slot_at_(c, r->local[i])->ring, __ATOMIC_ACQUIRE) & LP_RING_FREE_)) return false;
+    }
 
-    // statystyki
-    s_alloc_ok++;
-    const uint16_t used = (uint16_t)((uint16_t)LP_NUM_SLOTS - s_free_top);
-    if (used > s_peak_used) s_peak_used = used;
+    LP_LOCK();
+    for (uint16_t i = 0; i < r->count; ++i) {
+        __atomic_store_n(&lp_slot_at_(c, r->local[i])->ring, 0u, __ATOMIC_RELAXED);
+        lp_fl_push_(c, r->local[i]);
+    }
+    (void)__atomic_sub_fetch(&c->ring_slots, r->count, __ATOMIC_RELAXED);
+    (void)__atomic_sub_fetch(&c->used, r->count, __ATOMIC_RELAXED);
+    (void)__atomic_sub_fetch(&s_used, r->count, __ATOMIC_RELAXED);
+    LP_UNLOCK();
 
-    portEXIT_CRITICAL(&s_mux);
-    return h;
+    r->count = 0;
+    return true;
 }
 
-bool lp_acquire(lp_handle_t h, lp_view_t* out)
+lp_handle_t lp_alloc_chain_try(uint32_t want_len)
 {
-    if (!out) return false;
-    if (!lp_valid_idx_(h.idx)) return false;
+    return lp_alloc_chain_try_prio(want_len, LP_PRIO_NORMAL);
+}
 
-    bool ok = false;
+lp_handle_t lp_alloc_chain_try_prio(uint32_t want_len, lp_prio_t prio)
+{
+    const uint32_t max_cap = s_cls[LP_NUM_CLASSES - 1].cap;
+    if (want_len <= max_cap) return lp_alloc_try_prio(want_len, prio);
+
+    lp_handle_t head = lp_invalid_handle();
+    lp_slot_t* tail = NULL;
+    uint32_t remaining = want_len;
+
+    while (remaining > 0) {
+        // Największa klasa dla reszty; gdy pusta — kolejne mniejsze (więcej, ale krótszych segmentów).
+        lp_handle_t seg = lp_invalid_handle();
+        for (size_t k = LP_NUM_CLASSES; k-- > 0 && !lp_handle_is_valid(seg);) {
+            const uint32_t cap = s_cls[k].cap;
+            seg = lp_alloc_try_prio(remaining < cap ? remaining : cap, prio);
+        }
+        if (!lp_handle_is_valid(seg)) {
+            lp_release(head); // zwalnia zbudowaną część łańcucha
+            return lp_invalid_handle();
+        }
 
-    portENTER_CRITICAL(&s_mux);
-    lp_slot_t* s = &s_slots[h.idx];
+        lp_class_t* c = NULL;
+        lp_slot_t* s = lp_locate_(seg.idx, &c);
+        remaining -= (remaining < c->cap) ? remaining : c->cap;
 
-    if (s->gen == h.gen && s->refcnt > 0) {
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_check_canary_(s, "lp_acquire", h);
-        lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_acquire", h);
+        // Łańcuch jest jeszcze prywatny — wystarczy zwykły zapis linku.
+        if (tail) {
+            tail->chain_next = lp_pack_handle_u32(seg);
+#if LP_OWNERS > 0
+            __atomic_store_n(&s->own_flags, (uint8_t)LP_OWN_SEG_, __ATOMIC_RELAXED);
 #endif
-        out->ptr = (void*)s->buf;
-        out->len = s->len;
-        out->cap = (uint32_t)LP_BUF_SIZE;
-        ok = true;
+        } else {
+            head = seg;
+        }
+        tail = s;
     }
 
-    portEXIT_CRITICAL(&s_mux);
-    return ok;
+    return head;
 }
 
-void lp_commit(lp_handle_t h, uint32_t len)
+size_t lp_acquire_iov(lp_handle_t h, lp_iov_t* iov, size_t iovcnt)
+{
+    size_t n = 0;
+
+    LP_LOCK();
+#if LP_SLICES > 0
+    if (lp_handle_is_slice(h)) {
+        const lp_slice_t* d = lp_slice_live_(h);
+        n = d ? lp_walk_(lp_unpack_handle_u32(d->parent), true, d->off, d->len, iov, iovcnt) : 0;
+        LP_UNLOCK();
+        return n;
+    }
+#endif
+    n = lp_walk_(h, false, 0, 0, iov, iovcnt);
+    LP_UNLOCK();
+    return n;
+}
+
+lp_handle_t lp_slice(lp_handle_t h, uint32_t off, uint32_t len)
 {
-    if (!lp_valid_idx_(h.idx)) return;
+#if LP_SLICES > 0
+    if (len == 0) return lp_invalid_handle();
+
+    LP_LOCK();
+
+    // Slice ze slice'a: zakres względem korzenia, w granicach slice'a.
+    lp_handle_t parent = h;
+    if (lp_handle_is_slice(h)) {
+        const lp_slice_t* p = lp_slice_live_(h);
+        if (!p || off > p->len || len > p->len - off) {
+            LP_UNLOCK();
+            return lp_invalid_handle();
+        }
+        parent = lp_unpack_handle_u32(p->parent);
+        off += p->off;
+    }
 
-    portENTER_CRITICAL(&s_mux);
-    lp_slot_t* s = &s_slots[h.idx];
+    // Rodzic musi być żywy, a zakres leżeć w jego zatwierdzonych danych.
+    if (lp_walk_(parent, false, 0, 0, NULL, 0) == 0) {
+        LP_UNLOCK();
+        return lp_invalid_handle();
+    }
+    uint32_t total = 0;
+    for (lp_handle_t cur = parent; lp_handle_is_valid(cur);) {
+        lp_slot_t* s = lp_locate_(cur.idx, NULL);
+        if (!s) break;
+        total += s->len;
+        cur = lp_unpack_handle_u32(s->chain_next);
+    }
+    if (off > total || len > total - off) {
+        LP_UNLOCK();
+        return lp_invalid_handle();
+    }
 
-    if (s->gen != h.gen || s->refcnt == 0) {
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_fail_("lp_commit", "invalid handle or refcnt==0", h);
-#endif
-        portEXIT_CRITICAL(&s_mux);
-        return;
+    uint16_t i = 0;
+    if (!lp_stack_pop_(&s_slice_head, s_slice_next, &i)) {
+        LP_ADD_(&s_slice_fail, 1u);
+        LP_UNLOCK();
+        return lp_invalid_handle();
     }
 
-#if CONFIG_CORE_LEASEPOOL_GUARD
-    lp_guard_check_canary_(s, "lp_commit", h);
-    lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_commit", h);
+    // referencja rodzica należy do slice'a
+    lp_addref_n(parent, 1);
+
+    lp_slice_t* d = &s_slices[i];
+    d->parent = lp_pack_handle_u32(parent);
+    d->off = off;
+    d->len = len;
+    const uint16_t gen = LP_ST_GEN_(LP_LOAD_(&d->state));
+    __atomic_store_n(&d->state, LP_ST_(gen, 1u), __ATOMIC_RELEASE);
+
+    lp_peak_update_(&s_slices_peak, (uint16_t)__atomic_add_fetch(&s_slices_used, 1u, __ATOMIC_RELAXED));
+
+    LP_UNLOCK();
+    return (lp_handle_t){ .idx = (uint16_t)((LP_HANDLE_SLICE_CLASS << LP_HANDLE_CLASS_SHIFT) | i), .gen = gen };
+#else
+    (void)h; (void)off; (void)len;
+    return lp_invalid_handle();
 #endif
+}
 
-    if (len > (uint32_t)LP_BUF_SIZE) {
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_fail_("lp_commit", "len > cap", h);
+lp_handle_t lp_make_writable(lp_handle_t h)
+{
+    // Źródło kopii: korzeń (lease/łańcuch) i zakres [off, off+len); slice = zakres rodzica.
+    lp_handle_t root = h;
+    uint32_t off = 0, len = 0;
+
+#if LP_SLICES > 0
+    if (lp_handle_is_slice(h)) {
+        LP_LOCK();
+        const lp_slice_t* d = lp_slice_live_(h);
+        if (d) {
+            root = lp_unpack_handle_u32(d->parent);
+            off = d->off;
+            len = d->len;
+        }
+        LP_UNLOCK();
+        if (!d) return lp_invalid_handle();
+    } else
 #endif
-        len = (uint32_t)LP_BUF_SIZE;
+    {
+        lp_slot_t* s = lp_locate_(h.idx, NULL);
+        if (!s) return lp_invalid_handle();
+        const uint32_t st = LP_LOAD_(&s->state);
+        if (LP_ST_GEN_(st) != h.gen || LP_ST_REF_(st) == 0) return lp_invalid_handle();
+
+        // Jedyna referencja = nikt inny nie widzi danych (slice'y też trzymają referencję
+        // rodzica), a bez referencji nie da się zrobić addref — można pisać w miejscu.
+        if (LP_ST_REF_(st) == 1u) {
+            LP_ADD_(&s_cow_inplace, 1u);
+            return h;
+        }
+        for (lp_handle_t cur = h; lp_handle_is_valid(cur);) {
+            lp_slot_t* seg = lp_locate_(cur.idx, NULL);
+            if (!seg) break;
+            len += seg->len;
+            cur = lp_unpack_handle_u32(seg->chain_next);
+        }
     }
 
-    // bariera kompilatora przed publikacją len
-    __asm__ __volatile__("" ::: "memory");
-    s->len = len;
-    __asm__ __volatile__("" ::: "memory");
+    lp_handle_t w = lp_alloc_chain_try(len ? len : 1u);
+    if (!lp_handle_is_valid(w)) return lp_invalid_handle(); // h zostaje u wołającego
+
+    // Trzymamy referencję h, więc łańcuch źródła jest stabilny; kopia jest jeszcze prywatna.
+    lp_class_t* dc = NULL;
+    lp_slot_t* dst = lp_locate_(w.idx, &dc);
+    uint32_t dpos = 0;
+    uint32_t left = len;
+    for (lp_handle_t cur = root; left > 0 && lp_handle_is_valid(cur);) {
+        lp_class_t* sc = NULL;
+        lp_slot_t* src = lp_locate_(cur.idx, &sc);
+        if (!src) break;
+        uint32_t spos = 0;
+        if (off >= src->len) {
+            off -= src->len;
+        } else {
+            spos = off;
+            off = 0;
+            while (spos < src->len && left > 0) {
+                if (dpos == dc->cap) {
+                    dst = lp_locate_(lp_unpack_handle_u32(dst->chain_next).idx, &dc);
+                    dpos = 0;
+                }
+                uint32_t k = src->len - spos;
+                if (k > dc->cap - dpos) k = dc->cap - dpos;
+                if (k > left) k = left;
+                memcpy(lp_buf_(dc, dst) + dpos, lp_buf_(sc, src) + spos, k);
+                spos += k;
+                dpos += k;
+                left -= k;
+            }
+        }
+        cur = lp_unpack_handle_u32(src->chain_next);
+    }
+    lp_commit(w, len);
+
+#if LP_OWNERS > 0
+    // Kopia należy do tego samego właściciela co oryginał (liczniki i wycieki per tag).
+    const lp_slot_t* rs = lp_locate_(root.idx, NULL);
+    const uint8_t id = rs ? __atomic_load_n(&rs->owner, __ATOMIC_RELAXED) : 0u;
+    for (lp_handle_t cur = w; lp_handle_is_valid(cur);) {
+        lp_slot_t* s = lp_locate_(cur.idx, NULL);
+        if (!s) break;
+        __atomic_store_n(&s->owner, id, __ATOMIC_RELAXED);
+        cur = lp_unpack_handle_u32(s->chain_next);
+    }
+#endif
 
-    portEXIT_CRITICAL(&s_mux);
+    LP_ADD_(&s_cow_copies, 1u);
+    lp_release(h);
+    return w;
 }
 
-void lp_addref_n(lp_handle_t h, uint16_t n)
+#if LP_POISON_MODE == LP_POISON_SCRUB_
+static uint32_t s_scrubbed = 0;
+static size_t   s_scrub_cls = 0;
+#endif
+
+uint16_t lp_scrub_step(uint16_t budget)
 {
-    if (n == 0) return;
-    if (!lp_valid_idx_(h.idx)) return;
+#if LP_POISON_MODE == LP_POISON_SCRUB_
+    if (budget == 0) budget = LP_SCRUB_BUDGET;
+    if (budget > LP_SCRUB_MAX) budget = LP_SCRUB_MAX;
+
+    // Klasy po kolei (round‑robin między krokami); sloty zdjęte z free‑listy są na czas
+    // sprawdzania wyłącznie nasze, więc brak wyścigu z alloc. Wierzchołek stosu = ostatnio
+    // zwolnione — tam UAF‑write jest najbardziej prawdopodobny.
+    const size_t k = s_scrub_cls;
+    s_scrub_cls = (k + 1u) % LP_NUM_CLASSES;
+    lp_class_t* c = &s_cls[k];
+
+    uint16_t taken[LP_SCRUB_MAX];
+    uint16_t n = 0;
+
+    // Tylko ponad rezerwami (próg LOW) — scrubber nie może chwilowo zabrać slotów CRITICAL.
+    LP_LOCK();
+    n = lp_fl_claim_(c, budget, c->floor[LP_PRIO_LOW]);
+    for (uint16_t i = 0; i < n; ++i) taken[i] = lp_fl_pop_claimed_(c);
+    LP_UNLOCK();
+
+    for (uint16_t i = 0; i < n; ++i) {
+        lp_slot_t* sl = lp_slot_at_(c, taken[i]);
+        const lp_handle_t h = { .idx = lp_make_idx_(k, taken[i]), .gen = LP_ST_GEN_(LP_LOAD_(&sl->state)) };
+
+        lp_guard_check_canary_(c, sl, "lp_scrub_step", h);
+        lp_guard_check_free_(sl, "lp_scrub_step", h);
+        if (sl->magic == LP_MAGIC_FREE) {
+            lp_guard_poison_expect_(c, sl, (uint8_t)LP_POISON_FREE, "lp_scrub_step", h);
+        } else {
+            lp_guard_set_free_(c, sl, true);
+        }
+    }
 
-    portENTER_CRITICAL(&s_mux);
-    lp_slot_t* s = &s_slots[h.idx];
+    // Odwrotna kolejność = pierwotny układ stosu.
+    LP_LOCK();
+    for (uint16_t i = n; i-- > 0;) lp_fl_push_(c, taken[i]);
+    LP_UNLOCK();
 
-    if (s->gen != h.gen || s->refcnt == 0) {
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_fail_("lp_addref_n", "invalid handle or refcnt==0", h);
+    LP_ADD_(&s_scrubbed, (uint32_t)n);
+    return n;
+#else
+    (void)budget;
+    return 0;
 #endif
-        portEXIT_CRITICAL(&s_mux);
-        return;
-    }
+}
 
-#if CONFIG_CORE_LEASEPOOL_GUARD
-    lp_guard_check_canary_(s, "lp_addref_n", h);
-    lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_addref_n", h);
-#endif
+/* ===================== właściciele / wycieki ===================== */
 
-    if ((uint32_t)s->refcnt + (uint32_t)n > 0xFFFFu) {
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_fail_("lp_addref_n", "refcnt overflow", h);
-#endif
-        s->refcnt = 0xFFFFu;
-        portEXIT_CRITICAL(&s_mux);
-        return;
+bool lp_set_owner(lp_handle_t h, const char* owner)
+{
+#if LP_OWNERS > 0
+    if (lp_handle_is_slice(h)) return false;
+
+    const uint8_t id = lp_owner_id_(owner);
+    bool head = true;
+    for (;;) {
+        lp_class_t* c = NULL;
+        lp_slot_t* s = lp_locate_(h.idx, &c);
+        if (!s) return false;
+        const uint32_t st = LP_LOAD_(&s->state);
+        if (LP_ST_GEN_(st) != h.gen || LP_ST_REF_(st) == 0) return !head;
+
+        __atomic_store_n(&s->owner, id, __ATOMIC_RELAXED);
+        head = false;
+
+        const uint32_t next = s->chain_next;
+        if (next == LP_CHAIN_END_) break;
+        h = lp_unpack_handle_u32(next);
     }
-
-    s->refcnt = (uint16_t)(s->refcnt + n);
-    portEXIT_CRITICAL(&s_mux);
+    LP_ADD_(&s_owner_tagged[id], 1u);
+    return true;
+#else
+    (void)h;
+    (void)owner;
+    return false;
+#endif
 }
 
-void lp_release(lp_handle_t h)
+uint16_t lp_leak_scan(uint32_t min_age_ms, bool report)
 {
-    if (!lp_valid_idx_(h.idx)) return;
+#if LP_OWNERS > 0
+    if (min_age_ms == 0) min_age_ms = LP_LEAK_AGE_MS;
+
+    const uint32_t now = lp_now_ms_();
+    uint16_t stale = 0;
+
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        lp_class_t* c = &s_cls[k];
+        for (uint16_t i = 0; i < c->slots; ++i) {
+            lp_slot_t* s = lp_slot_at_(c, i);
+            const uint32_t st = LP_LOAD_(&s->state);
+            const uint8_t fl = __atomic_load_n(&s->own_flags, __ATOMIC_RELAXED);
+            if (LP_ST_REF_(st) == 0 || (fl & LP_OWN_SEG_)) continue;
+
+            const uint32_t age = now - __atomic_load_n(&s->t_alloc_ms, __ATOMIC_RELAXED);
+            if (age < min_age_ms) continue;
+            stale++;
+
+            // Każdy lease zgłaszany raz (flaga czyszczona przy następnym alloc slotu).
+            // Best‑effort: slot może zostać równolegle zwolniony i przydzielony ponownie.
+            if (__atomic_fetch_or(&s->own_flags, (uint8_t)LP_OWN_LEAK_, __ATOMIC_RELAXED) & LP_OWN_LEAK_) continue;
+            const uint8_t id = __atomic_load_n(&s->owner, __ATOMIC_RELAXED);
+            LP_ADD_(&s_leaks, 1u);
+            LP_ADD_(&s_owner_leaks[id < LP_OWNERS ? id : 0], 1u);
+            if (report) {
+                const char* tag = (id > 0 && id < LP_OWNERS) ? __atomic_load_n(&s_owner_tag[id], __ATOMIC_ACQUIRE) : NULL;
+                LP_DIAG_PRINTF("LeasePool leak? idx=0x%04X gen=%u ref=%u len=%u owner=%s age=%ums\n",
+                               (unsigned)lp_make_idx_(k, i), (unsigned)LP_ST_GEN_(st), (unsigned)LP_ST_REF_(st),
+                               (unsigned)s->len, tag ? tag : "-", (unsigned)age);
+            }
+        }
+    }
+    return stale;
+#else
+    (void)min_age_ms;
+    (void)report;
+    return 0;
+#endif
+}
 
-    portENTER_CRITICAL(&s_mux);
-    lp_slot_t* s = &s_slots[h.idx];
+size_t lp_get_owner_stats(lp_owner_stats_t* out, size_t max)
+{
+#if LP_OWNERS > 0
+    if (!out || max == 0) return 0;
+
+    size_t n = 1;
+    while (n < LP_OWNERS && n < max && __atomic_load_n(&s_owner_tag[n], __ATOMIC_ACQUIRE)) n++;
+
+    for (size_t i = 0; i < n; ++i) {
+        const char* tag = (i > 0) ? __atomic_load_n(&s_owner_tag[i], __ATOMIC_ACQUIRE) : NULL;
+        out[i] = (lp_owner_stats_t){
+            .tag    = tag ? tag : "-",
+            .tagged = __atomic_load_n(&s_owner_tagged[i], __ATOMIC_RELAXED),
+            .leaks  = __atomic_load_n(&s_owner_leaks[i], __ATOMIC_RELAXED),
+        };
+    }
 
-    if (s->gen != h.gen) {
-        // stale handle / UAF
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_fail_("lp_release", "gen mismatch (stale handle)", h);
-#endif
-        portEXIT_CRITICAL(&s_mux);
-        return;
+    const uint32_t now = lp_now_ms_();
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        lp_class_t* c = &s_cls[k];
+        for (uint16_t i = 0; i < c->slots; ++i) {
+            lp_slot_t* s = lp_slot_at_(c, i);
+            if (LP_ST_REF_(LP_LOAD_(&s->state)) == 0) continue;
+
+            const uint8_t id = __atomic_load_n(&s->owner, __ATOMIC_RELAXED);
+            if (id >= n) continue; // tag zarejestrowany po odczycie tablicy
+            lp_owner_stats_t* o = &out[id];
+            o->slots_held++;
+            if (__atomic_load_n(&s->own_flags, __ATOMIC_RELAXED) & LP_OWN_SEG_) continue;
+
+            const uint32_t age = now - __atomic_load_n(&s->t_alloc_ms, __ATOMIC_RELAXED);
+            o->leases++;
+            if (age >= LP_LEAK_AGE_MS) o->stale++;
+            if (age > o->oldest_ms) o->oldest_ms = age;
+        }
     }
-    if (s->refcnt == 0) {
-        // double free
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_fail_("lp_release", "refcnt==0 (double free)", h);
+    return n;
+#else
+    (void)out;
+    (void)max;
+    return 0;
 #endif
-        portEXIT_CRITICAL(&s_mux);
-        return;
+}
+
+/* ===================== histogramy (wymiarowanie puli) ===================== */
+
+void lp_occ_sample(void)
+{
+#if LP_HIST
+    lp_occ_sample_t smp = { .t_ms = lp_now_ms_() };
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        smp.cls_used[k] = lp_class_used_(k);
+        smp.used = (uint16_t)(smp.used + smp.cls_used[k]);
     }
+    const uint32_t seq = __atomic_fetch_add(&s_occ_seq, 1u, __ATOMIC_RELAXED);
+    s_occ[seq % LP_OCC_SAMPLES] = smp;
+#endif
+}
 
-#if CONFIG_CORE_LEASEPOOL_GUARD
-    // wykrywa overflow jeszcze przed oddaniem slota do puli
-    lp_guard_check_canary_(s, "lp_release", h);
-    lp_guard_check_magic_(s, LP_MAGIC_USED, "lp_release", h);
+size_t lp_get_occupancy(lp_occ_sample_t* out, size_t max)
+{
+#if LP_HIST
+    if (!out) return 0;
+    const uint32_t seq = __atomic_load_n(&s_occ_seq, __ATOMIC_RELAXED);
+    size_t n = seq < LP_OCC_SAMPLES ? seq : LP_OCC_SAMPLES;
+    if (n > max) n = max;
+    // n najnowszych, od najstarszej
+    for (size_t i = 0; i < n; ++i) out[i] = s_occ[(seq - n + i) % LP_OCC_SAMPLES];
+    return n;
+#else
+    (void)out;
+    (void)max;
+    return 0;
+#endif
+}
+
+bool lp_get_lifetime_hist(size_t cls, lp_lifetime_hist_t* out)
+{
+#if LP_HIST
+    if (!out || cls >= LP_NUM_CLASSES) return false;
+    out->cap = s_cls[cls].cap;
+    out->count = 0;
+    for (size_t b = 0; b < LP_HIST_BUCKETS; ++b) {
+        out->bucket[b] = __atomic_load_n(&s_life[cls][b], __ATOMIC_RELAXED);
+        out->count += out->bucket[b];
+    }
+    return true;
+#else
+    (void)cls;
+    (void)out;
+    return false;
 #endif
+}
 
-    s->refcnt--;
+#if LP_HIST
+/* Górna granica (µs) kubełka, w którym leży percentyl pct histogramu czasu życia. */
+static uint32_t lp_hist_pct_us_(const lp_lifetime_hist_t* h, uint32_t pct)
+{
+    if (h->count == 0) return 0;
+    const uint64_t rank = ((uint64_t)h->count * pct + 99u) / 100u;
+    uint64_t acc = 0;
+    for (uint32_t b = 0; b < LP_HIST_BUCKETS; ++b) {
+        acc += h->bucket[b];
+        if (acc >= rank) return b ? (1u << b) : 1u;
+    }
+    return 1u << (LP_HIST_BUCKETS - 1u);
+}
 
-    if (s->refcnt == 0) {
-        s->len = 0;
-        s->gen++;
+static int lp_cmp_u16_(const void* a, const void* b)
+{
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
 
-#if CONFIG_CORE_LEASEPOOL_GUARD
-        lp_guard_set_free_(s);
+/* Percentyl zajętości z próbek ringu (sortuje kopię; v ma n pozycji). */
+static uint16_t lp_occ_pct_(uint16_t* v, size_t n, uint32_t pct)
+{
+    if (n == 0) return 0;
+    qsort(v, n, sizeof(v[0]), lp_cmp_u16_);
+    size_t i = (n * pct + 99u) / 100u;
+    return v[i ? i - 1u : 0u];
+}
 #endif
 
-        if (s_free_top >= (uint16_t)LP_NUM_SLOTS) {
-#if CONFIG_CORE_LEASEPOOL_GUARD
-            lp_guard_fail_("lp_release", "free list overflow", h);
-#endif
-            // best-effort: nie zapisujemy poza tablicę
+void lp_hist_dump(bool json)
+{
+#if LP_HIST
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        lp_lifetime_hist_t h;
+        (void)lp_get_lifetime_hist(k, &h);
+        if (json) {
+            LP_DIAG_PRINTF("{\"lp_hist\":\"lifetime\",\"cls\":%u,\"cap\":%u,\"n\":%u,\"us_log2\":[",
+                           (unsigned)k, (unsigned)h.cap, (unsigned)h.count);
+            for (size_t b = 0; b < LP_HIST_BUCKETS; ++b) {
+                LP_DIAG_PRINTF("%s%u", b ? "," : "", (unsigned)h.bucket[b]);
+            }
+            LP_DIAG_PRINTF("]}\n");
         } else {
-            s_free[s_free_top++] = h.idx;
+            LP_DIAG_PRINTF("lifetime class %u (cap=%u): n=%u p50<=%uus p90<=%uus p99<=%uus\n",
+                           (unsigned)k, (unsigned)h.cap, (unsigned)h.count, (unsigned)lp_hist_pct_us_(&h, 50),
+                           (unsigned)lp_hist_pct_us_(&h, 90), (unsigned)lp_hist_pct_us_(&h, 99));
+            for (uint32_t b = 0; b < LP_HIST_BUCKETS; ++b) {
+                if (!h.bucket[b]) continue;
+                LP_DIAG_PRINTF("  <%8uus %u\n", (unsigned)(b ? (1u << b) : 1u), (unsigned)h.bucket[b]);
+            }
+        }
+    }
+
+    static lp_occ_sample_t smp[LP_OCC_SAMPLES];
+    static uint16_t        v[LP_OCC_SAMPLES];
+    const size_t n = lp_get_occupancy(smp, LP_OCC_SAMPLES);
+    if (json) {
+        LP_DIAG_PRINTF("{\"lp_hist\":\"occupancy\",\"period_ms\":%u,\"slots\":[", (unsigned)LP_OCC_PERIOD_MS);
+        for (size_t k = 0; k < LP_NUM_CLASSES; ++k) LP_DIAG_PRINTF("%s%u", k ? "," : "", (unsigned)s_cls[k].slots);
+        LP_DIAG_PRINTF("],\"samples\":[");
+        for (size_t i = 0; i < n; ++i) {
+            LP_DIAG_PRINTF("%s[%u", i ? "," : "", (unsigned)smp[i].t_ms);
+            for (size_t k = 0; k < LP_NUM_CLASSES; ++k) LP_DIAG_PRINTF(",%u", (unsigned)smp[i].cls_used[k]);
+            LP_DIAG_PRINTF("]");
         }
+        LP_DIAG_PRINTF("]}\n");
+        return;
     }
 
-    portEXIT_CRITICAL(&s_mux);
+    LP_DIAG_PRINTF("occupancy: samples=%u period=%ums\n", (unsigned)n, (unsigned)LP_OCC_PERIOD_MS);
+    const size_t rows = LP_NUM_CLASSES + (LP_NUM_CLASSES > 1 ? 1u : 0u);
+    for (size_t k = 0; k < rows && n > 0; ++k) {
+        // k == LP_NUM_CLASSES: cała pula (tylko przy kilku klasach)
+        for (size_t i = 0; i < n; ++i) v[i] = (k < LP_NUM_CLASSES) ? smp[i].cls_used[k] : smp[i].used;
+        const uint16_t p50 = lp_occ_pct_(v, n, 50), p95 = lp_occ_pct_(v, n, 95), mx = v[n - 1];
+        if (k < LP_NUM_CLASSES) {
+            LP_DIAG_PRINTF("  class %u: p50=%u p95=%u max=%u / %u slots\n", (unsigned)k, (unsigned)p50,
+                           (unsigned)p95, (unsigned)mx, (unsigned)s_cls[k].slots);
+        } else {
+            LP_DIAG_PRINTF("  total:   p50=%u p95=%u max=%u / %u slots\n", (unsigned)p50, (unsigned)p95,
+                           (unsigned)mx, (unsigned)lp_total_slots_());
+        }
+    }
+#else
+    (void)json;
+    LP_DIAG_PRINTF("LeasePool histograms disabled (CONFIG_CORE_LEASEPOOL_HIST=n)\n");
+#endif
 }
 
 uint16_t lp_free_count(void)
 {
-    return s_free_top;
+    return (uint16_t)(lp_total_slots_() - lp_used_total_());
 }
 
 uint16_t lp_used_count(void)
 {
-    return (uint16_t)((uint16_t)LP_NUM_SLOTS - s_free_top);
+    return lp_used_total_();
 }
 
 void lp_get_stats(lp_stats_t* out)
 {
     if (!out) return;
 
-    portENTER_CRITICAL(&s_mux);
-    const uint16_t free_ = s_free_top;
-    const uint16_t used_ = (uint16_t)((uint16_t)LP_NUM_SLOTS - free_);
+    LP_LOCK();
+
+    uint32_t ok = 0, fail = 0;
+    for (size_t p = 0; p < LP_PRIO_COUNT; ++p) out->drops_prio[p] = 0;
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        ok += __atomic_load_n(&s_cls[k].alloc_ok, __ATOMIC_RELAXED);
+        fail += __atomic_load_n(&s_cls[k].alloc_fail, __ATOMIC_RELAXED);
+        for (size_t p = 0; p < LP_PRIO_COUNT; ++p) {
+            out->drops_prio[p] += __atomic_load_n(&s_cls[k].fail_prio[p], __ATOMIC_RELAXED);
+        }
+#if LP_MAG_SIZE > 0
+        for (size_t core = 0; core < LP_NUM_CORES; ++core) ok += LP_MAG_GET_(&s_mag[core][k].alloc_ok);
+#endif
+    }
 
-    out->slots_total     = (uint16_t)LP_NUM_SLOTS;
-    out->slots_free      = free_;
+    const uint16_t used_ = lp_used_total_();
+    out->slots_total     = lp_total_slots_();
     out->slots_used      = used_;
-    out->slots_peak_used = s_peak_used;
-    out->alloc_ok        = s_alloc_ok;
-    out->drops_alloc_fail= s_alloc_fail;
+    out->slots_free      = (uint16_t)(out->slots_total - used_);
+    out->slots_peak_used = __atomic_load_n(&s_peak_used, __ATOMIC_RELAXED);
+    out->alloc_ok        = ok;
+    out->drops_alloc_fail= fail;
     out->guard_failures  = s_guard_failures;
+    out->cow_inplace     = __atomic_load_n(&s_cow_inplace, __ATOMIC_RELAXED);
+    out->cow_copies      = __atomic_load_n(&s_cow_copies, __ATOMIC_RELAXED);
+#if LP_LOCKFREE
+    out->lock_rounds     = 0;
+#else
+    out->lock_rounds     = s_lock_rounds - 1u; // bez wejścia tego lp_get_stats()
+#endif
+#if LP_POISON_MODE == LP_POISON_SCRUB_
+    out->guard_scrubbed  = __atomic_load_n(&s_scrubbed, __ATOMIC_RELAXED);
+#else
+    out->guard_scrubbed  = 0;
+#endif
+#if LP_OWNERS > 0
+    out->leaks_detected  = __atomic_load_n(&s_leaks, __ATOMIC_RELAXED);
+#else
+    out->leaks_detected  = 0;
+#endif
+#if LP_SLICES > 0
+    out->slices_total    = LP_SLICES;
+    out->slices_used     = __atomic_load_n(&s_slices_used, __ATOMIC_RELAXED);
+    out->slices_peak_used= __atomic_load_n(&s_slices_peak, __ATOMIC_RELAXED);
+    out->drops_slice_fail= __atomic_load_n(&s_slice_fail, __ATOMIC_RELAXED);
+#else
+    out->slices_total    = 0;
+    out->slices_used     = 0;
+    out->slices_peak_used= 0;
+    out->drops_slice_fail= 0;
+#endif
+
+    LP_UNLOCK();
+}
+
+size_t lp_class_count(void)
+{
+    return LP_NUM_CLASSES;
+}
+
+bool lp_get_class_stats(size_t cls, lp_class_stats_t* out)
+{
+    if (!out || cls >= LP_NUM_CLASSES) return false;
+
+    LP_LOCK();
+    lp_class_t* c = &s_cls[cls];
+
+    const uint16_t used_ = lp_class_used_(cls);
+    out->cap             = c->cap;
+    out->slots_total     = c->slots;
+    out->slots_free      = (uint16_t)(c->slots - used_);
+    out->slots_used      = used_;
+    out->slots_peak_used = __atomic_load_n(&c->peak_used, __ATOMIC_RELAXED);
+    out->alloc_ok        = __atomic_load_n(&c->alloc_ok, __ATOMIC_RELAXED);
+    out->alloc_spill     = __atomic_load_n(&c->alloc_spill, __ATOMIC_RELAXED);
+    out->drops_alloc_fail= __atomic_load_n(&c->alloc_fail, __ATOMIC_RELAXED);
+    out->bytes_req       = __atomic_load_n(&c->bytes_req, __ATOMIC_RELAXED);
+    out->bytes_cap       = __atomic_load_n(&c->bytes_cap, __ATOMIC_RELAXED);
+    out->arena_bytes     = (uint32_t)c->slots * (c->stride + (uint32_t)sizeof(lp_slot_t));
+    out->free_global     = __atomic_load_n(&c->fl_count, __ATOMIC_RELAXED);
+    out->reserve_critical= (uint16_t)(c->floor[LP_PRIO_NORMAL] - c->floor[LP_PRIO_CRITICAL]);
+    out->reserve_normal  = (uint16_t)(c->floor[LP_PRIO_LOW] - c->floor[LP_PRIO_NORMAL]);
+    for (size_t p = 0; p < LP_PRIO_COUNT; ++p) {
+        out->drops_prio[p] = __atomic_load_n(&c->fail_prio[p], __ATOMIC_RELAXED);
+    }
+
+    out->ring_slots      = __atomic_load_n(&c->ring_slots, __ATOMIC_RELAXED);
+    out->mag_cap         = c->mag_cap;
+    out->mag_cached      = 0;
+    out->mag_hits        = 0;
+    out->mag_misses      = 0;
+    out->mag_spills      = 0;
+#if LP_MAG_SIZE > 0
+    for (size_t core = 0; core < LP_NUM_CORES; ++core) {
+        const lp_mag_t* m = &s_mag[core][cls];
+        out->mag_cached += LP_MAG_GET_(&m->count);
+        out->mag_hits   += LP_MAG_GET_(&m->hits);
+        out->mag_misses += LP_MAG_GET_(&m->misses);
+        out->mag_spills += LP_MAG_GET_(&m->spills);
+        out->alloc_ok   += LP_MAG_GET_(&m->alloc_ok);
+        out->bytes_req  += LP_MAG_GET64_(&m->bytes_req);
+        out->bytes_cap  += LP_MAG_GET64_(&m->bytes_cap);
+    }
+#endif
 
-    portEXIT_CRITICAL(&s_mux);
+    LP_UNLOCK();
+    return true;
 }
 
 void lp_reset_stats(void)
 {
-    portENTER_CRITICAL(&s_mux);
-    s_alloc_ok = 0;
-    s_alloc_fail = 0;
+    LP_LOCK();
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        lp_class_t* c = &s_cls[k];
+        __atomic_store_n(&c->alloc_ok, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&c->alloc_spill, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&c->alloc_fail, 0u, __ATOMIC_RELAXED);
+        for (size_t p = 0; p < LP_PRIO_COUNT; ++p) __atomic_store_n(&c->fail_prio[p], 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&c->bytes_req, (uint64_t)0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&c->bytes_cap, (uint64_t)0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&c->peak_used, lp_class_used_(k), __ATOMIC_RELAXED);
+#if LP_MAG_SIZE > 0
+        // Liczniki cudzego rdzenia: reset best‑effort (równoległy ++ może przetrwać).
+        for (size_t core = 0; core < LP_NUM_CORES; ++core) {
+            lp_mag_t* m = &s_mag[core][k];
+            LP_MAG_SET_(&m->alloc_ok, 0u);
+            LP_MAG_SET_(&m->hits, 0u);
+            LP_MAG_SET_(&m->misses, 0u);
+            LP_MAG_SET_(&m->spills, 0u);
+            LP_MAG_SET64_(&m->bytes_req, (uint64_t)0u);
+            LP_MAG_SET64_(&m->bytes_cap, (uint64_t)0u);
+        }
+#endif
+    }
     s_guard_failures = 0;
+    __atomic_store_n(&s_cow_inplace, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_cow_copies, 0u, __ATOMIC_RELAXED);
+#if !LP_LOCKFREE
+    s_lock_rounds = 0;
+#endif
+    __atomic_store_n(&s_peak_used, lp_used_total_(), __ATOMIC_RELAXED);
+#if LP_SLICES > 0
+    __atomic_store_n(&s_slices_peak, __atomic_load_n(&s_slices_used, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_store_n(&s_slice_fail, 0u, __ATOMIC_RELAXED);
+#endif
+#if LP_OWNERS > 0
+    lp_owner_reset_(false);
+#endif
+#if LP_HIST
+    lp_hist_reset_();
+#endif
 
-    const uint16_t used_ = (uint16_t)((uint16_t)LP_NUM_SLOTS - s_free_top);
-    s_peak_used = used_;
-
-    portEXIT_CRITICAL(&s_mux);
+    LP_UNLOCK();
 }
 
 typedef struct {
@@ -403,126 +2244,170 @@ typedef struct {
     uint16_t gen;
     uint16_t refcnt;
     uint32_t len;
+    uint32_t ring;
+#if LP_OWNERS > 0
+    uint32_t t_alloc_ms;
+    uint8_t  owner;
+    uint8_t  own_flags;
+#endif
 } lp_slot_snap_t;
 
+/* Snapshot jednej klasy (spójny w obrębie klasy; stos ograniczony do największej klasy). */
 typedef struct {
+    uint16_t slots;
+    uint32_t cap;
     uint16_t free_top;
-    uint16_t free_list[LP_NUM_SLOTS];
-    lp_slot_snap_t slots[LP_NUM_SLOTS];
-    lp_stats_t stats;
+    uint16_t free_list[LP_MAX_CLASS_SLOTS];
+    lp_slot_snap_t slot[LP_MAX_CLASS_SLOTS];
+    lp_class_stats_t stats;
 } lp_snapshot_t;
 
-static void lp_snapshot_(lp_snapshot_t* snap)
+/* W trybie lock-free snapshot jest best-effort (równoległe alloc/release mogą dać fałszywe alarmy). */
+static void lp_snapshot_(size_t cls, lp_snapshot_t* snap)
 {
     if (!snap) return;
 
-    portENTER_CRITICAL(&s_mux);
+    LP_LOCK();
+    lp_class_t* c = &s_cls[cls];
 
-    snap->free_top = s_free_top;
-    for (uint16_t i = 0; i < (uint16_t)LP_NUM_SLOTS; ++i) {
-        if (i < s_free_top) {
-            snap->free_list[i] = s_free[i];
-        } else {
-            snap->free_list[i] = 0xFFFFu;
+    snap->slots = c->slots;
+    snap->cap = c->cap;
+
+    // Free‑lista: przejście po linkach, najwyżej `slots` kroków (cykl = uszkodzenie).
+    snap->free_top = 0;
+    uint16_t cur = LP_FL_TOP_(__atomic_load_n(&c->fl_head, __ATOMIC_ACQUIRE));
+    while (cur != LP_FL_NIL && snap->free_top <= c->slots) {
+        if (snap->free_top == c->slots) {
+            snap->free_top++; // sygnał przepełnienia dla lp_check
+            break;
+        }
+        snap->free_list[snap->free_top++] = cur;
+        if (cur >= c->slots) break;
+        cur = __atomic_load_n(&c->next[cur], __ATOMIC_RELAXED);
+    }
+
+#if LP_MAG_SIZE > 0
+    // Sloty w magazynach rdzeni też są wolne (dopisane za free‑listą).
+    for (size_t core = 0; core < LP_NUM_CORES; ++core) {
+        const lp_mag_t* m = &s_mag[core][cls];
+        const uint16_t n = LP_MAG_GET_(&m->count);
+        for (uint16_t i = 0; i < n && snap->free_top <= c->slots; ++i) {
+            if (snap->free_top == c->slots) {
+                snap->free_top++;
+                break;
+            }
+            snap->free_list[snap->free_top++] = m->idx[i];
         }
+    }
+#endif
 
-        lp_slot_t* s = &s_slots[i];
-        snap->slots[i].gen = s->gen;
-        snap->slots[i].refcnt = s->refcnt;
-        snap->slots[i].len = s->len;
+    for (uint16_t i = 0; i < c->slots; ++i) {
+        lp_slot_t* s = lp_slot_at_(c, i);
+        const uint32_t st = LP_LOAD_(&s->state);
+        snap->slot[i].gen = LP_ST_GEN_(st);
+        snap->slot[i].refcnt = LP_ST_REF_(st);
+        snap->slot[i].len = s->len;
+        snap->slot[i].ring = __atomic_load_n(&s->ring, __ATOMIC_ACQUIRE);
 #if CONFIG_CORE_LEASEPOOL_GUARD
-        snap->slots[i].canary_head = s->canary_head;
-        snap->slots[i].canary_tail = s->canary_tail;
-        snap->slots[i].magic = s->magic;
+        snap->slot[i].canary_head = s->canary_head;
+        snap->slot[i].canary_tail = lp_tail_get_(c, s);
+        snap->slot[i].magic = s->magic;
+#endif
+#if LP_OWNERS > 0
+        snap->slot[i].t_alloc_ms = __atomic_load_n(&s->t_alloc_ms, __ATOMIC_RELAXED);
+        snap->slot[i].owner = __atomic_load_n(&s->owner, __ATOMIC_RELAXED);
+        snap->slot[i].own_flags = __atomic_load_n(&s->own_flags, __ATOMIC_RELAXED);
 #endif
     }
 
-    snap->stats.slots_total = (uint16_t)LP_NUM_SLOTS;
-    snap->stats.slots_free  = s_free_top;
-    snap->stats.slots_used  = (uint16_t)((uint16_t)LP_NUM_SLOTS - s_free_top);
-    snap->stats.slots_peak_used = s_peak_used;
-    snap->stats.alloc_ok = s_alloc_ok;
-    snap->stats.drops_alloc_fail = s_alloc_fail;
-    snap->stats.guard_failures = s_guard_failures;
+    LP_UNLOCK();
 
-    portEXIT_CRITICAL(&s_mux);
+    (void)lp_get_class_stats(cls, &snap->stats);
 }
 
-static void lp_check_print_(bool verbose, int issues, const lp_stats_t* st)
+static void lp_check_print_(bool verbose, int issues)
 {
     if (!verbose) return;
 
+    lp_stats_t st;
+    lp_get_stats(&st);
+
     if (issues == 0) {
-        LP_DIAG_PRINTF("lp_check: OK (slots=%u used=%u free=%u peak=%u alloc_ok=%u alloc_fail=%u)\n",
-                       (unsigned)st->slots_total,
-                       (unsigned)st->slots_used,
-                       (unsigned)st->slots_free,
-                       (unsigned)st->slots_peak_used,
-                       (unsigned)st->alloc_ok,
-                       (unsigned)st->drops_alloc_fail);
+        LP_DIAG_PRINTF("lp_check: OK (classes=%u slots=%u used=%u free=%u peak=%u alloc_ok=%u alloc_fail=%u)\n",
+                       (unsigned)LP_NUM_CLASSES,
+                       (unsigned)st.slots_total,
+                       (unsigned)st.slots_used,
+                       (unsigned)st.slots_free,
+                       (unsigned)st.slots_peak_used,
+                       (unsigned)st.alloc_ok,
+                       (unsigned)st.drops_alloc_fail);
     } else {
-        LP_DIAG_PRINTF("lp_check: FAIL (issues=%d slots=%u used=%u free=%u peak=%u alloc_ok=%u alloc_fail=%u)\n",
+        LP_DIAG_PRINTF("lp_check: FAIL (issues=%d classes=%u slots=%u used=%u free=%u peak=%u alloc_ok=%u alloc_fail=%u)\n",
                        issues,
-                       (unsigned)st->slots_total,
-                       (unsigned)st->slots_used,
-                       (unsigned)st->slots_free,
-                       (unsigned)st->slots_peak_used,
-                       (unsigned)st->alloc_ok,
-                       (unsigned)st->drops_alloc_fail);
+                       (unsigned)LP_NUM_CLASSES,
+                       (unsigned)st.slots_total,
+                       (unsigned)st.slots_used,
+                       (unsigned)st.slots_free,
+                       (unsigned)st.slots_peak_used,
+                       (unsigned)st.alloc_ok,
+                       (unsigned)st.drops_alloc_fail);
     }
 }
 
-int lp_check(bool verbose)
+static int lp_check_class_(size_t cls, bool verbose)
 {
     lp_snapshot_t snap;
-    lp_snapshot_(&snap);
+    lp_snapshot_(cls, &snap);
 
     int issues = 0;
 
     // 1) sanity free_top
-    if (snap.free_top > (uint16_t)LP_NUM_SLOTS) {
+    if (snap.free_top > snap.slots) {
         if (verbose) {
-            LP_DIAG_PRINTF("FAIL: free_top out of range: %u (max=%u)\n",
+            LP_DIAG_PRINTF("FAIL: class %u free_top out of range: %u (max=%u)\n",
+                           (unsigned)cls,
                            (unsigned)snap.free_top,
-                           (unsigned)LP_NUM_SLOTS);
+                           (unsigned)snap.slots);
         }
         issues++;
-        snap.free_top = (uint16_t)LP_NUM_SLOTS;
+        snap.free_top = snap.slots;
     }
 
     // 2) free list: zakres + duplikaty
-    bool in_free[LP_NUM_SLOTS];
-    for (uint16_t i = 0; i < (uint16_t)LP_NUM_SLOTS; ++i) in_free[i] = false;
+    bool in_free[LP_MAX_CLASS_SLOTS];
+    for (uint16_t i = 0; i < snap.slots; ++i) in_free[i] = false;
 
     for (uint16_t i = 0; i < snap.free_top; ++i) {
-        const uint16_t idx = snap.free_list[i];
-        if (!lp_valid_idx_(idx)) {
+        const uint16_t local = snap.free_list[i];
+        if (local >= snap.slots) {
             if (verbose) {
-                LP_DIAG_PRINTF("FAIL: free_list[%u] invalid idx=%u\n",
+                LP_DIAG_PRINTF("FAIL: class %u free_list[%u] invalid idx=%u\n",
+                               (unsigned)cls,
                                (unsigned)i,
-                               (unsigned)idx);
+                               (unsigned)local);
             }
             issues++;
             continue;
         }
-        if (in_free[idx]) {
+        if (in_free[local]) {
             if (verbose) {
-                LP_DIAG_PRINTF("FAIL: free_list duplicate idx=%u\n", (unsigned)idx);
+                LP_DIAG_PRINTF("FAIL: class %u free_list duplicate idx=%u\n", (unsigned)cls, (unsigned)local);
             }
             issues++;
         }
-        in_free[idx] = true;
+        in_free[local] = true;
     }
 
     // 3) per-slot invariants
-    for (uint16_t i = 0; i < (uint16_t)LP_NUM_SLOTS; ++i) {
-        const lp_slot_snap_t* s = &snap.slots[i];
+    for (uint16_t i = 0; i < snap.slots; ++i) {
+        const lp_slot_snap_t* s = &snap.slot[i];
+        const unsigned idx = lp_make_idx_(cls, i);
 
 #if CONFIG_CORE_LEASEPOOL_GUARD
         if (s->canary_head != LP_CANARY_VALUE || s->canary_tail != LP_CANARY_VALUE) {
             if (verbose) {
-                LP_DIAG_PRINTF("FAIL: canary corrupted idx=%u head=0x%08X tail=0x%08X\n",
-                               (unsigned)i,
+                LP_DIAG_PRINTF("FAIL: canary corrupted idx=0x%04X head=0x%08X tail=0x%08X\n",
+                               idx,
                                (unsigned)s->canary_head,
                                (unsigned)s->canary_tail);
             }
@@ -530,29 +2415,38 @@ int lp_check(bool verbose)
         }
 #endif
 
-        if (in_free[i]) {
+        // Slot odłożony w ringu: wolny, ale nie może leżeć na free‑liście.
+        const bool parked = (s->ring & LP_RING_FREE_) != 0;
+        if (parked && in_free[i]) {
+            if (verbose) {
+                LP_DIAG_PRINTF("FAIL: ring slot on free_list idx=0x%04X\n", idx);
+            }
+            issues++;
+        }
+
+        if (in_free[i] || parked) {
             // FREE slot: refcnt==0, len==0
             if (s->refcnt != 0) {
                 if (verbose) {
-                    LP_DIAG_PRINTF("FAIL: FREE slot has refcnt!=0 idx=%u ref=%u\n",
-                                   (unsigned)i,
+                    LP_DIAG_PRINTF("FAIL: FREE slot has refcnt!=0 idx=0x%04X ref=%u\n",
+                                   idx,
                                    (unsigned)s->refcnt);
                 }
                 issues++;
             }
             if (s->len != 0) {
                 if (verbose) {
-                    LP_DIAG_PRINTF("FAIL: FREE slot has len!=0 idx=%u len=%u\n",
-                                   (unsigned)i,
+                    LP_DIAG_PRINTF("FAIL: FREE slot has len!=0 idx=0x%04X len=%u\n",
+                                   idx,
                                    (unsigned)s->len);
                 }
                 issues++;
             }
 #if CONFIG_CORE_LEASEPOOL_GUARD
-            if (s->magic != LP_MAGIC_FREE) {
+            if (!lp_guard_is_free_magic_(s->magic)) {
                 if (verbose) {
-                    LP_DIAG_PRINTF("FAIL: FREE slot magic mismatch idx=%u magic=0x%08X\n",
-                                   (unsigned)i,
+                    LP_DIAG_PRINTF("FAIL: FREE slot magic mismatch idx=0x%04X magic=0x%08X\n",
+                                   idx,
                                    (unsigned)s->magic);
                 }
                 issues++;
@@ -562,24 +2456,24 @@ int lp_check(bool verbose)
             // USED slot: refcnt>0, len<=cap
             if (s->refcnt == 0) {
                 if (verbose) {
-                    LP_DIAG_PRINTF("FAIL: USED slot has refcnt==0 idx=%u\n", (unsigned)i);
+                    LP_DIAG_PRINTF("FAIL: USED slot has refcnt==0 idx=0x%04X\n", idx);
                 }
                 issues++;
             }
-            if (s->len > (uint32_t)LP_BUF_SIZE) {
+            if (s->len > snap.cap) {
                 if (verbose) {
-                    LP_DIAG_PRINTF("FAIL: USED slot len>cap idx=%u len=%u cap=%u\n",
-                                   (unsigned)i,
+                    LP_DIAG_PRINTF("FAIL: USED slot len>cap idx=0x%04X len=%u cap=%u\n",
+                                   idx,
                                    (unsigned)s->len,
-                                   (unsigned)LP_BUF_SIZE);
+                                   (unsigned)snap.cap);
                 }
                 issues++;
             }
 #if CONFIG_CORE_LEASEPOOL_GUARD
             if (s->magic != LP_MAGIC_USED) {
                 if (verbose) {
-                    LP_DIAG_PRINTF("FAIL: USED slot magic mismatch idx=%u magic=0x%08X\n",
-                                   (unsigned)i,
+                    LP_DIAG_PRINTF("FAIL: USED slot magic mismatch idx=0x%04X magic=0x%08X\n",
+                                   idx,
                                    (unsigned)s->magic);
                 }
                 issues++;
@@ -588,55 +2482,92 @@ int lp_check(bool verbose)
         }
     }
 
-    lp_check_print_(verbose, issues, &snap.stats);
+    return issues;
+}
+
+int lp_check(bool verbose)
+{
+    int issues = 0;
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        issues += lp_check_class_(k, verbose);
+    }
+
+    lp_check_print_(verbose, issues);
     return issues;
 }
 
 void lp_dump(void)
 {
-    lp_snapshot_t snap;
-    lp_snapshot_(&snap);
-
-    LP_DIAG_PRINTF("leasepool: slots=%u cap=%u used=%u free=%u peak=%u alloc_ok=%u alloc_fail=%u guard_fail=%u\n",
-                   (unsigned)snap.stats.slots_total,
-                   (unsigned)LP_BUF_SIZE,
-                   (unsigned)snap.stats.slots_used,
-                   (unsigned)snap.stats.slots_free,
-                   (unsigned)snap.stats.slots_peak_used,
-                   (unsigned)snap.stats.alloc_ok,
-                   (unsigned)snap.stats.drops_alloc_fail,
-                   (unsigned)snap.stats.guard_failures);
+    lp_stats_t st;
+    lp_get_stats(&st);
+
+    LP_DIAG_PRINTF("leasepool: classes=%u slots=%u used=%u free=%u peak=%u alloc_ok=%u alloc_fail=%u guard_fail=%u\n",
+                   (unsigned)LP_NUM_CLASSES,
+                   (unsigned)st.slots_total,
+                   (unsigned)st.slots_used,
+                   (unsigned)st.slots_free,
+                   (unsigned)st.slots_peak_used,
+                   (unsigned)st.alloc_ok,
+                   (unsigned)st.drops_alloc_fail,
+                   (unsigned)st.guard_failures);
+
+    for (size_t k = 0; k < LP_NUM_CLASSES; ++k) {
+        lp_snapshot_t snap;
+        lp_snapshot_(k, &snap);
+
+        LP_DIAG_PRINTF("class %u: cap=%u slots=%u used=%u peak=%u\n",
+                       (unsigned)k,
+                       (unsigned)snap.cap,
+                       (unsigned)snap.slots,
+                       (unsigned)snap.stats.slots_used,
+                       (unsigned)snap.stats.slots_peak_used);
 
 #if CONFIG_CORE_LEASEPOOL_GUARD
-    LP_DIAG_PRINTF("idx gen  ref  len   magic      canary\n");
-    LP_DIAG_PRINTF("--- ---- ---- ----- ---------- ----------\n");
+        LP_DIAG_PRINTF("idx    gen  ref  len   magic      canary    ");
+#else
+        LP_DIAG_PRINTF("idx    gen  ref  len  ");
+#endif
+#if LP_OWNERS > 0
+        LP_DIAG_PRINTF(" owner        age_ms\n");
+        const uint32_t now = lp_now_ms_();
 #else
-    LP_DIAG_PRINTF("idx gen  ref  len\n");
-    LP_DIAG_PRINTF("--- ---- ---- -----\n");
+        LP_DIAG_PRINTF("\n");
 #endif
 
-    for (uint16_t i = 0; i < (uint16_t)LP_NUM_SLOTS; ++i) {
-        const lp_slot_snap_t* s = &snap.slots[i];
+        for (uint16_t i = 0; i < snap.slots; ++i) {
+            const lp_slot_snap_t* s = &snap.slot[i];
 #if CONFIG_CORE_LEASEPOOL_GUARD
-        LP_DIAG_PRINTF("%3u %4u %4u %5u 0x%08X 0x%08X\n",
-                       (unsigned)i,
-                       (unsigned)s->gen,
-                       (unsigned)s->refcnt,
-                       (unsigned)s->len,
-                       (unsigned)s->magic,
-                       (unsigned)s->canary_head);
+            LP_DIAG_PRINTF("0x%04X %4u %4u %5u 0x%08X 0x%08X",
+                           (unsigned)lp_make_idx_(k, i),
+                           (unsigned)s->gen,
+                           (unsigned)s->refcnt,
+                           (unsigned)s->len,
+                           (unsigned)s->magic,
+                           (unsigned)s->canary_head);
 #else
-        LP_DIAG_PRINTF("%3u %4u %4u %5u\n",
-                       (unsigned)i,
-                       (unsigned)s->gen,
-                       (unsigned)s->refcnt,
-                       (unsigned)s->len);
+            LP_DIAG_PRINTF("0x%04X %4u %4u %5u",
+                           (unsigned)lp_make_idx_(k, i),
+                           (unsigned)s->gen,
+                           (unsigned)s->refcnt,
+                           (unsigned)s->len);
 #endif
-    }
+#if LP_OWNERS > 0
+            if (s->refcnt > 0) {
+                const char* tag = (s->owner > 0 && s->owner < LP_OWNERS) ? s_owner_tag[s->owner] : NULL;
+                LP_DIAG_PRINTF(" %-12s %6u%s\n", tag ? tag : "-", (unsigned)(now - s->t_alloc_ms),
+                               (s->own_flags & LP_OWN_SEG_) ? " seg" : ((s->own_flags & LP_OWN_LEAK_) ? " LEAK?" : ""));
+            } else {
+                LP_DIAG_PRINTF("\n");
+            }
+#else
+            LP_DIAG_PRINTF("\n");
+#endif
+        }
 
-    LP_DIAG_PRINTF("free_top=%u\nfree_list:", (unsigned)snap.free_top);
-    for (uint16_t i = 0; i < snap.free_top; ++i) {
-        LP_DIAG_PRINTF(" %u", (unsigned)snap.free_list[i]);
+        LP_DIAG_PRINTF("free_top=%u\nfree_list:", (unsigned)snap.free_top);
+        for (uint16_t i = 0; i < snap.free_top; ++i) {
+            LP_DIAG_PRINTF(" %u", (unsigned)snap.free_list[i]);
+        }
+        LP_DIAG_PRINTF("\n");
     }
-    LP_DIAG_PRINTF("\n");
 }
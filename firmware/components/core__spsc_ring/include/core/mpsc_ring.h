@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "core/spsc_ring.h" // SPSC_RING_CACHE_LINE
+
+/**
+ * @brief MPSC ring rekordów (Multi Producer / Single Consumer), lock‑free po stronie producentów.
+ *
+ * Wzorzec użycia:
+ *  - producent (dowolny task/rdzeń): reserve(n, &r) -> zapis n bajtów -> commit(&r, len)
+ *  - konsument (jeden):               peek(&n) -> odczyt -> consume()
+ *
+ * Rezerwacja to CAS na head (miejsce sprawdzane względem tail, więc head nie przekracza
+ * pojemności). Każdy rekord ma własny nagłówek‑flagę: 0 = zarezerwowany, jeszcze nie
+ * zatwierdzony; commit zapisuje (długość | READY) ze store‑release. Producenci zatwierdzają
+ * niezależnie; konsument oddaje rekordy w kolejności rezerwacji, więc niezatwierdzony
+ * rekord wstrzymuje odczyt kolejnych (peek zwraca NULL) do czasu jego commit.
+ *
+ * Rekordy są zawsze ciągłe (jak spsc_ring w trybie rekordowym): ogon bufora, w którym
+ * rekord się nie mieści, producent zatwierdza jako pusty rekord‑wypełniacz. Konsument
+ * zeruje oddawane bajty — wolna część bufora jest zawsze wyzerowana, więc nagłówek
+ * w nowym miejscu startuje jako "niezatwierdzony".
+ *
+ * Kontrakt:
+ *  - storage wyrównany do 4 B, cap potęgą 2 i >= 16; rekord najwyżej mpsc_ring_record_max(),
+ *  - commit wołany dokładnie raz na udaną rezerwację (len=0 porzuca rekord, miejsce
+ *    zwalnia się jak po wypełniaczu); zawieszony producent między reserve a commit
+ *    wstrzymuje konsumenta, nie innych producentów.
+ */
+typedef struct
+{
+    uint8_t* buf;
+    uint32_t cap;   // bytes (power‑of‑two)
+    uint32_t mask;  // cap - 1
+    bool     waitable; // mpsc_ring_enable_wait(): commit sprawdza czekającego konsumenta
+
+    // producenci (CAS)
+    __attribute__((aligned(SPSC_RING_CACHE_LINE)))
+    uint32_t head;
+
+    // konsument
+    __attribute__((aligned(SPSC_RING_CACHE_LINE)))
+    uint32_t tail;
+
+    // czekający konsument: TaskHandle_t (wait_readable) albo znacznik dzwonka (arm_readable)
+    __attribute__((aligned(SPSC_RING_CACHE_LINE)))
+    void* rd_waiter;
+} mpsc_ring_t;
+
+/** @brief Rezerwacja jednego producenta (na stosie wołającego). */
+typedef struct
+{
+    uint32_t pos;   // pozycja nagłówka rekordu
+    uint32_t skip;  // pominięty ogon bufora przed rekordem (0 = brak)
+    uint32_t span;  // nagłówek + n, wyrównane do 4 B
+} mpsc_ring_resv_t;
+
+/** @brief Inicjalizuje ring i zeruje storage (cap_bytes: potęga 2, >= 16). */
+bool mpsc_ring_init(mpsc_ring_t* rb, void* storage, uint32_t cap_bytes);
+
+/** @brief Największy payload rekordu dla danego ringu. */
+size_t mpsc_ring_record_max(const mpsc_ring_t* rb);
+
+/** @brief Bajty zajęte (rekordy + nagłówki + wypełniacze, także niezatwierdzone). */
+size_t mpsc_ring_used(const mpsc_ring_t* rb);
+
+/**
+ * @brief Rezerwuje ciągłe miejsce na rekord n bajtów; bezpieczne z wielu tasków naraz.
+ * @return wskaźnik zapisu albo NULL (brak miejsca / n poza zakresem)
+ */
+uint8_t* mpsc_ring_reserve(mpsc_ring_t* rb, size_t n, mpsc_ring_resv_t* out);
+
+/**
+ * @brief Publikuje rekord (len <= n z reserve; 0 = porzucenie).
+ * @return true = konsument uzbroił dzwonek (arm_readable) i ten commit go zdjął —
+ *         wołający wysyła konsumentowi zdarzenie (np. EV_LOG_READY); inaczej false
+ */
+bool mpsc_ring_commit(mpsc_ring_t* rb, const mpsc_ring_resv_t* r, size_t len);
+
+/**
+ * @brief Najstarszy zatwierdzony rekord (tylko konsument).
+ * @return payload albo NULL (pusto albo najstarszy rekord jeszcze niezatwierdzony)
+ */
+const uint8_t* mpsc_ring_peek(mpsc_ring_t* rb, size_t* out_n);
+
+/** @brief Zwalnia rekord zwrócony przez peek (tylko konsument). */
+void mpsc_ring_consume(mpsc_ring_t* rb);
+
+/**
+ * @brief Budzenie konsumenta raz na paczkę (jak spsc_ring_wait_readable).
+ *
+ * enable_wait: po init, przed startem producentów (bez niego commit nie płaci za barierę).
+ * wait_readable: task konsumenta śpi w ulTaskNotifyTake(), aż peek zwróci rekord;
+ *   budzi go pierwszy commit, po którym najstarszy rekord jest zatwierdzony.
+ * arm_readable: wariant dla konsumenta, który czeka na kolejce zdarzeń, nie na ringu —
+ *   po opróżnieniu uzbraja dzwonek; pierwszy commit dostaje true i wysyła zdarzenie.
+ *   false = w międzyczasie przyszedł rekord (dzwonek nieuzbrojony, czytaj dalej).
+ */
+void mpsc_ring_enable_wait(mpsc_ring_t* rb);
+bool mpsc_ring_wait_readable(mpsc_ring_t* rb, TickType_t timeout);
+bool mpsc_ring_arm_readable(mpsc_ring_t* rb);
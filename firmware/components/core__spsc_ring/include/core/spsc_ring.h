@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "freertos/FreeRTOS.h"
+
 /**
  * @brief SPSC ring buffer (Single Producer / Single Consumer) dla strumieni bajtów.
  *
@@ -19,15 +21,43 @@
  * Uwaga:
  *  - implementacja jest lock‑free przy założeniu 1 producent + 1 konsument.
  *    Dla wielu producentów/konsumentów wymagane jest zewnętrzne serializowanie.
+ *  - head (+ kopia tail producenta) i tail (+ kopia head konsumenta) leżą na osobnych
+ *    liniach cache; indeks drugiej strony jest czytany dopiero, gdy kopia mówi
+ *    "pełny" (reserve: mniej wolnego niż want) albo "pusty" (peek).
  */
+#if defined(ESP_PLATFORM)
+#define SPSC_RING_CACHE_LINE 32u
+#else
+#define SPSC_RING_CACHE_LINE 64u
+#endif
+
 typedef struct
 {
     uint8_t* buf;
     uint32_t cap;   // bytes (power‑of‑two)
     uint32_t mask;  // cap - 1
+    bool     waitable; // spsc_ring_enable_wait(): commit/consume sprawdzają czekających
+
+    // producent
+    __attribute__((aligned(SPSC_RING_CACHE_LINE)))
+    uint32_t head;        // producer writes, consumer reads
+    uint32_t tail_cache;  // ostatnio widziany tail (tylko producent)
+    uint32_t rec_skip;    // reserve_record: bajty pominięte do końca bufora (tylko producent)
+    uint32_t ovw_resv;    // write_overwrite: koniec zapisywanego bloku, publikowany przed danymi
+    uint32_t ovw_lost;    // write_overwrite: bajty, nad którymi producent przeciągnął tail (nasyca się)
 
-    uint32_t head;  // producer writes, consumer reads
-    uint32_t tail;  // consumer writes, producer reads
+    // konsument
+    __attribute__((aligned(SPSC_RING_CACHE_LINE)))
+    uint32_t tail;        // consumer writes, producer reads
+    uint32_t head_cache;  // ostatnio widziany head (tylko konsument)
+    uint32_t ovw_rd;      // read_overwrite: pozycja za ostatnio zwróconym bajtem (tylko konsument)
+
+    // oczekiwanie (wait_readable/wait_writable): zapis przy rejestracji, odczyt po commit/consume
+    __attribute__((aligned(SPSC_RING_CACHE_LINE)))
+    void*    rd_waiter;   // TaskHandle_t konsumenta czekającego na dane (NULL = brak)
+    uint32_t rd_want;     // ile bajtów do odczytu go budzi
+    void*    wr_waiter;   // TaskHandle_t producenta czekającego na miejsce (NULL = brak)
+    uint32_t wr_want;     // ile wolnych bajtów go budzi
 } spsc_ring_t;
 
 /**
@@ -43,7 +73,7 @@ static inline size_t spsc_ring_capacity(const spsc_ring_t* rb)
     return rb ? (size_t)rb->cap : 0u;
 }
 
-/** @brief Ilość bajtów dostępnych do odczytu (przybliżone, ale spójne dla SPSC). */
+/** @brief Ilość bajtów dostępnych do odczytu (przybliżone, ale spójne dla SPSC; najwyżej cap). */
 size_t spsc_ring_used(const spsc_ring_t* rb);
 
 /** @brief Ilość wolnego miejsca w bajtach. */
@@ -65,7 +95,110 @@ void spsc_ring_commit(spsc_ring_t* rb, size_t n);
  * @param out_n ile bajtów *ciągłych* jest dostępne pod zwróconym wskaźnikiem
  * @return wskaźnik do bufora odczytu albo NULL jeśli ring pusty
  */
-const uint8_t* spsc_ring_peek(const spsc_ring_t* rb, size_t* out_n);
+const uint8_t* spsc_ring_peek(spsc_ring_t* rb, size_t* out_n);
 
 /** @brief Zużywa odczytane bajty (n <= out_n z peek). */
 void spsc_ring_consume(spsc_ring_t* rb, size_t n);
+
+/**
+ * @brief Operacje blokowe: kopia z/do ringu z obsługą zawinięcia.
+ *
+ * Najwyżej dwa memcpy (do końca bufora + od początku) i jedna publikacja indeksu
+ * na wywołanie — zamiast pętli reserve/commit albo peek/consume po fragmentach.
+ *
+ * spsc_ring_write(): all=true -> wszystko albo nic (za mało miejsca = 0, ring bez zmian);
+ *   all=false -> tyle, ile się mieści.
+ * spsc_ring_read(): najwyżej max bajtów (0 = ring pusty).
+ * spsc_ring_read_until(): jak read, ale kończy na pierwszym `delim` (skopiowany jako ostatni
+ *   bajt, *out_found=true); bez delim w dostępnych danych/max — kopiuje i zużywa to, co jest
+ *   (fragment linii), *out_found=false.
+ * @return liczba skopiowanych bajtów
+ */
+size_t spsc_ring_write(spsc_ring_t* rb, const void* src, size_t len, bool all);
+size_t spsc_ring_read(spsc_ring_t* rb, void* dst, size_t max);
+size_t spsc_ring_read_until(spsc_ring_t* rb, void* dst, size_t max, uint8_t delim, bool* out_found);
+
+/**
+ * @brief Blokujące czekanie na dane (konsument) / miejsce (producent), task notifications.
+ *
+ * Wołający rejestruje się w ringu z progiem min_bytes i śpi w ulTaskNotifyTake().
+ * Druga strona po commit/consume sprawdza rejestrację i budzi go tylko, gdy próg
+ * został osiągnięty (pusty -> niepusty dla min_bytes=1) — jedna notyfikacja na
+ * oczekiwanie, konsument budzi się raz na paczkę zamiast raz na rekord. Bez
+ * czekającego koszt po drugiej stronie to bariera + odczyt jednego pola.
+ *
+ * Kontrakt:
+ *  - ring włączony przez spsc_ring_enable_wait() po init, przed startem producenta
+ *    i konsumenta (ringi bez czekania nie płacą za barierę); inaczej wait zwraca false,
+ *  - tylko z tasku (nie z ISR); druga strona może commitować/konsumować z ISR,
+ *  - czekający task nie używa w tym czasie notyfikacji (indeks 0) do innych celów,
+ *  - min_bytes w trybie rekordowym liczy się z nagłówkami (used/free).
+ * @return true, gdy warunek spełniony; false po timeout (albo min_bytes > cap)
+ */
+void spsc_ring_enable_wait(spsc_ring_t* rb);
+bool spsc_ring_wait_readable(spsc_ring_t* rb, size_t min_bytes, TickType_t timeout);
+bool spsc_ring_wait_writable(spsc_ring_t* rb, size_t min_bytes, TickType_t timeout);
+
+/** @brief Konsument: porzuca wszystkie dane do odczytu (tail = head); każdy tryb. */
+void spsc_ring_discard(spsc_ring_t* rb);
+
+/**
+ * @brief Tryb nadpisywania (stratny): ring trzyma najnowsze cap bajtów, producent nigdy nie czeka.
+ *
+ * Dla strumieni, w których świeże dane są ważniejsze od kompletnych (ślady diagnostyczne,
+ * historia czujników, bufor logów). write_overwrite() zawsze zapisuje cały blok (z bloku
+ * dłuższego niż cap zostaje końcówka) i przesuwa head; okrążając czytelnika podciąga tail
+ * (CAS) do head - cap, więc head - tail nie przekracza cap także po 4 GiB bez żadnego odczytu.
+ *
+ * Odczyt jest sprawdzany sekwencją zamiast blokady: producent publikuje koniec bloku
+ * (ovw_resv) przed zapisem danych, czytelnik kopiuje, a po kopii sprawdza ovw_resv i odrzuca
+ * prefiks, który mógł zostać nadpisany w trakcie. Zwrócone bajty są zawsze spójne;
+ * okrążony czytelnik traci najstarsze dane, nigdy nie dostaje wymieszanych.
+ *
+ *  - write_overwrite(): tylko producent (jeden; wielu — zewnętrzna serializacja samych zapisów),
+ *  - read_overwrite(): konsument; czyta od najstarszego ważnego bajtu i go zużywa,
+ *    *out_lost = ile bajtów przepadło przed tym odczytem,
+ *  - copy_overwrite(): migawka bez zużywania, z dowolnego tasku (też kilku naraz):
+ *    newest=false — najstarsze max bajtów, newest=true — ostatnie max bajtów,
+ *  - spsc_ring_overwritten(): ile nieprzeczytanych bajtów zostało nadpisanych od ostatniego
+ *    read/discard (0 = bez strat; nasyca się na UINT32_MAX; przy odczycie w toku przybliżone),
+ *  - discard() czyści ring (np. "clear" w CLI); used() nie przekracza cap.
+ *
+ * Kontrakt: na jednym ringu nie mieszać z zapisem bajtowym/rekordowym (reserve/write);
+ * wait_readable działa, wait_writable nie ma sensu.
+ * @return liczba skopiowanych bajtów
+ */
+void spsc_ring_write_overwrite(spsc_ring_t* rb, const void* src, size_t len);
+size_t spsc_ring_read_overwrite(spsc_ring_t* rb, void* dst, size_t max, uint32_t* out_lost);
+size_t spsc_ring_copy_overwrite(const spsc_ring_t* rb, void* dst, size_t max, bool newest);
+size_t spsc_ring_overwritten(const spsc_ring_t* rb);
+
+/**
+ * @brief Tryb rekordowy (bip-buffer): rekordy o zmiennej długości, zawsze ciągłe.
+ *
+ * Rekord = nagłówek u32 (długość) + payload, wyrównany do 4 B. Gdy rekord nie mieści
+ * się przed końcem bufora, producent zostawia tam znacznik WRAP i zapisuje rekord od
+ * początku — konsument dostaje payload jednym wskaźnikiem, bez kopiowania i skanowania.
+ *
+ *  - producent: reserve_record(n) -> zapis n bajtów -> commit_record(len), len <= n
+ *  - konsument: peek_record(&n) -> odczyt -> consume_record()
+ *
+ * Kontrakt:
+ *  - na jednym ringu tylko jeden tryb (bajtowy albo rekordowy) — nie mieszać,
+ *  - storage wyrównany do 4 B, cap >= 16; rekord zajmuje najwyżej cap/2 (z nagłówkiem),
+ *    dzięki czemu pominięty ogon bufora zawsze zwalnia się razem z poprzednimi rekordami,
+ *  - spsc_ring_used()/free() liczą bajty razem z nagłówkami i pominiętymi ogonami.
+ *
+ * @return reserve: wskaźnik na n ciągłych bajtów albo NULL (brak miejsca / n poza zakresem);
+ *         peek: payload najstarszego rekordu albo NULL (ring pusty)
+ */
+uint8_t* spsc_ring_reserve_record(spsc_ring_t* rb, size_t n);
+void spsc_ring_commit_record(spsc_ring_t* rb, size_t len);
+const uint8_t* spsc_ring_peek_record(spsc_ring_t* rb, size_t* out_n);
+void spsc_ring_consume_record(spsc_ring_t* rb);
+
+/** @brief Największy payload rekordu dla danego ringu. */
+static inline size_t spsc_ring_record_max(const spsc_ring_t* rb)
+{
+    return (rb && rb->cap >= 16u) ? (size_t)(rb->cap / 2u - 4u) : 0u;
+}
@@ -0,0 +1,328 @@
+#include "core/mpsc_ring.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <string.h>
+
+// Nagłówek rekordu (u32): READY | span/4 << 16 | len. 0 = zarezerwowany, niezatwierdzony.
+#define MPSC_REC_HDR_       4u
+#define MPSC_REC_READY_     0x80000000u
+#define MPSC_REC_SPAN_SHIFT 16u
+#define MPSC_REC_SPAN_MASK  0x7FFFu
+#define MPSC_REC_LEN_MASK   0xFFFFu
+
+// rd_waiter: konsument czeka na zdarzenie od producenta (arm_readable), nie na notyfikację.
+#define MPSC_WAITER_ARMED_  ((void*)(uintptr_t)1u)
+
+static inline bool is_pow2_u32_(const uint32_t x)
+{
+    return (x != 0u) && ((x & (x - 1u)) == 0u);
+}
+
+static inline uint32_t* hdr_at_(const mpsc_ring_t* rb, const uint32_t pos)
+{
+    return (uint32_t*)(void*)(rb->buf + (pos & rb->mask));
+}
+
+static inline uint32_t rec_span_(const size_t n)
+{
+    return ((uint32_t)n + MPSC_REC_HDR_ + 3u) & ~3u;
+}
+
+static inline uint32_t hdr_span_(const uint32_t hdr)
+{
+    return ((hdr >> MPSC_REC_SPAN_SHIFT) & MPSC_REC_SPAN_MASK) << 2;
+}
+
+static inline void publish_(const mpsc_ring_t* rb, const uint32_t pos, const uint32_t span, const size_t len)
+{
+    const uint32_t hdr = MPSC_REC_READY_ | ((span >> 2) << MPSC_REC_SPAN_SHIFT) | (uint32_t)len;
+    __atomic_store_n(hdr_at_(rb, pos), hdr, __ATOMIC_RELEASE);
+}
+
+bool mpsc_ring_init(mpsc_ring_t* rb, void* storage, const uint32_t cap_bytes)
+{
+    if (!rb || !storage)
+    {
+        return false;
+    }
+
+    if (!is_pow2_u32_(cap_bytes) || cap_bytes < 16u)
+    {
+        return false;
+    }
+
+    rb->buf  = (uint8_t*)storage;
+    rb->cap  = cap_bytes;
+    rb->mask = cap_bytes - 1u;
+
+    // Wolna część bufora musi być wyzerowana (nagłówek 0 = niezatwierdzony).
+    memset(rb->buf, 0, cap_bytes);
+    rb->waitable  = false;
+    rb->rd_waiter = NULL;
+    __atomic_store_n(&rb->head, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&rb->tail, 0u, __ATOMIC_RELAXED);
+    return true;
+}
+
+size_t mpsc_ring_record_max(const mpsc_ring_t* rb)
+{
+    if (!rb || rb->cap < 16u)
+    {
+        return 0u;
+    }
+    const size_t half = (size_t)(rb->cap / 2u - MPSC_REC_HDR_);
+    return (half < MPSC_REC_LEN_MASK) ? half : (size_t)MPSC_REC_LEN_MASK;
+}
+
+size_t mpsc_ring_used(const mpsc_ring_t* rb)
+{
+    if (!rb)
+    {
+        return 0u;
+    }
+    const uint32_t head = __atomic_load_n(&rb->head, __ATOMIC_ACQUIRE);
+    const uint32_t tail = __atomic_load_n(&rb->tail, __ATOMIC_ACQUIRE);
+    return (size_t)(head - tail);
+}
+
+uint8_t* mpsc_ring_reserve(mpsc_ring_t* rb, const size_t n, mpsc_ring_resv_t* out)
+{
+    if (!rb || !out || n == 0u || n > mpsc_ring_record_max(rb))
+    {
+        return NULL;
+    }
+
+    const uint32_t span = rec_span_(n);
+    uint32_t head       = __atomic_load_n(&rb->head, __ATOMIC_RELAXED);
+    uint32_t skip;
+    for (;;)
+    {
+        const uint32_t contig = rb->cap - (head & rb->mask);
+        skip                  = (contig < span) ? contig : 0u;
+
+        // tail (acquire): bajty oddane przez konsumenta są już wyzerowane.
+        const uint32_t tail = __atomic_load_n(&rb->tail, __ATOMIC_ACQUIRE);
+        if (rb->cap - (head - tail) < skip + span)
+        {
+            return NULL;
+        }
+
+        // Gotowość danych niesie nagłówek rekordu, nie head — CAS może być relaxed.
+        if (__atomic_compare_exchange_n(&rb->head, &head, head + skip + span, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+    }
+
+    out->pos  = head + skip;
+    out->skip = skip;
+    out->span = span;
+    return rb->buf + ((head + skip) & rb->mask) + MPSC_REC_HDR_;
+}
+
+static inline void notify_(void* task)
+{
+#if defined(ESP_PLATFORM)
+    if (xPortInIsrContext())
+    {
+        BaseType_t hpw = pdFALSE;
+        vTaskNotifyGiveFromISR((TaskHandle_t)task, &hpw);
+        if (hpw == pdTRUE)
+        {
+            portYIELD_FROM_ISR();
+        }
+        return;
+    }
+#endif
+    (void)xTaskNotifyGive((TaskHandle_t)task);
+}
+
+/*
+ * Po publikacji nagłówka: zdejmuje czekającego, jeśli najstarszy rekord jest już
+ * zatwierdzony (commit w środku kolejki nie budzi — konsument i tak by go nie oddał).
+ * Bariera paruje się z barierą po rejestracji konsumenta.
+ */
+static bool wake_reader_(mpsc_ring_t* rb)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    void* w = __atomic_load_n(&rb->rd_waiter, __ATOMIC_ACQUIRE);
+    if (w == NULL)
+    {
+        return false;
+    }
+
+    const uint32_t tail = __atomic_load_n(&rb->tail, __ATOMIC_ACQUIRE);
+    if ((__atomic_load_n(hdr_at_(rb, tail), __ATOMIC_ACQUIRE) & MPSC_REC_READY_) == 0u)
+    {
+        return false;
+    }
+    if (!__atomic_compare_exchange_n(&rb->rd_waiter, &w, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        return false; // inny producent był szybszy
+    }
+    if (w == MPSC_WAITER_ARMED_)
+    {
+        return true;
+    }
+    notify_(w);
+    return false;
+}
+
+bool mpsc_ring_commit(mpsc_ring_t* rb, const mpsc_ring_resv_t* r, const size_t len)
+{
+    if (!rb || !r || r->span == 0u)
+    {
+        return false;
+    }
+
+    // Wypełniacz ogona to pusty rekord; len=0 porzuca rezerwację tak samo.
+    if (r->skip != 0u)
+    {
+        publish_(rb, r->pos - r->skip, r->skip, 0u);
+    }
+    const size_t max = (size_t)(r->span - MPSC_REC_HDR_);
+    publish_(rb, r->pos, r->span, (len <= max) ? len : max);
+    return rb->waitable ? wake_reader_(rb) : false;
+}
+
+/*
+ * Zeruje oddawane bajty (przyszłe nagłówki) i publikuje tail. Tylko konsument.
+ * Nagłówek atomowo: producent w wake_reader_ może go właśnie czytać.
+ */
+static inline void release_(mpsc_ring_t* rb, const uint32_t tail, const uint32_t span)
+{
+    __atomic_store_n(hdr_at_(rb, tail), 0u, __ATOMIC_RELAXED);
+    memset(rb->buf + (tail & rb->mask) + MPSC_REC_HDR_, 0, span - MPSC_REC_HDR_);
+    __atomic_store_n(&rb->tail, tail + span, __ATOMIC_RELEASE);
+}
+
+const uint8_t* mpsc_ring_peek(mpsc_ring_t* rb, size_t* out_n)
+{
+    if (!rb || !out_n)
+    {
+        return NULL;
+    }
+
+    // head nie jest potrzebny: za ostatnim rekordem bufor jest wyzerowany (nagłówek 0).
+    for (;;)
+    {
+        const uint32_t tail = __atomic_load_n(&rb->tail, __ATOMIC_RELAXED);
+        const uint32_t hdr  = __atomic_load_n(hdr_at_(rb, tail), __ATOMIC_ACQUIRE);
+        if ((hdr & MPSC_REC_READY_) == 0u)
+        {
+            *out_n = 0u;
+            return NULL;
+        }
+
+        const uint32_t len = hdr & MPSC_REC_LEN_MASK;
+        if (len != 0u)
+        {
+            *out_n = (size_t)len;
+            return rb->buf + (tail & rb->mask) + MPSC_REC_HDR_;
+        }
+        release_(rb, tail, hdr_span_(hdr)); // wypełniacz / porzucony rekord
+    }
+}
+
+void mpsc_ring_consume(mpsc_ring_t* rb)
+{
+    if (!rb)
+    {
+        return;
+    }
+
+    const uint32_t tail = __atomic_load_n(&rb->tail, __ATOMIC_RELAXED);
+    const uint32_t hdr  = __atomic_load_n(hdr_at_(rb, tail), __ATOMIC_ACQUIRE);
+    if ((hdr & MPSC_REC_READY_) == 0u)
+    {
+        return;
+    }
+    release_(rb, tail, hdr_span_(hdr));
+}
+
+void mpsc_ring_enable_wait(mpsc_ring_t* rb)
+{
+    if (rb)
+    {
+        rb->waitable = true;
+    }
+}
+
+static bool readable_now_(mpsc_ring_t* rb)
+{
+    size_t n = 0;
+    return mpsc_ring_peek(rb, &n) != NULL; // przy okazji zwalnia wypełniacze
+}
+
+/* Rejestracja + ponowny test; false = rekord już jest (rejestracja zdjęta). */
+static bool register_(mpsc_ring_t* rb, void* self)
+{
+    __atomic_store_n(&rb->rd_waiter, self, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!readable_now_(rb))
+    {
+        return true;
+    }
+    void* expected = self;
+    if (!__atomic_compare_exchange_n(&rb->rd_waiter, &expected, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) &&
+        self != MPSC_WAITER_ARMED_)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // producent już zdjął i notyfikuje
+    }
+    return false;
+}
+
+bool mpsc_ring_wait_readable(mpsc_ring_t* rb, const TickType_t timeout)
+{
+    if (!rb || !rb->waitable)
+    {
+        return false;
+    }
+
+    const TickType_t t0   = xTaskGetTickCount();
+    void* const      self = xTaskGetCurrentTaskHandle();
+    for (;;)
+    {
+        if (readable_now_(rb))
+        {
+            return true;
+        }
+
+        TickType_t left = timeout;
+        if (timeout != portMAX_DELAY)
+        {
+            const TickType_t spent = xTaskGetTickCount() - t0;
+            left = (spent >= timeout) ? 0 : timeout - spent;
+        }
+        if (left == 0)
+        {
+            return false;
+        }
+
+        if (!register_(rb, self))
+        {
+            return true;
+        }
+        if (ulTaskNotifyTake(pdTRUE, left) == 0u)
+        {
+            void* expected = self;
+            if (!__atomic_compare_exchange_n(&rb->rd_waiter, &expected, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            {
+                (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            return readable_now_(rb);
+        }
+    }
+}
+
+bool mpsc_ring_arm_readable(mpsc_ring_t* rb)
+{
+    if (!rb || !rb->waitable)
+    {
+        return rb ? !readable_now_(rb) : true;
+    }
+    return register_(rb, MPSC_WAITER_ARMED_);
+}
@@ -1,5 +1,13 @@
 #include "core/spsc_ring.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <string.h>
+
+#define SPSC_REC_HDR_  4u          // nagłówek rekordu: u32 długość payloadu
+#define SPSC_REC_WRAP_ 0xFFFFFFFFu // znacznik: reszta bufora pominięta, rekord od początku
+
 static inline bool is_pow2_u32_(const uint32_t x)
 {
     return (x != 0u) && ((x & (x - 1u)) == 0u);
@@ -20,6 +28,94 @@ static inline void store_release_u32_(uint32_t* p, const uint32_t v)
     __atomic_store_n(p, v, __ATOMIC_RELEASE);
 }
 
+#if defined(__SANITIZE_THREAD__)
+#define SPSC_RING_TSAN_ 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define SPSC_RING_TSAN_ 1
+#endif
+#endif
+
+/*
+ * Kopia w trybie nadpisywania: producent i czytelnik celowo dotykają tych samych bajtów
+ * naraz (spójność sprawdza sekwencja, copy_checked_). Pod TSAN bajtami przez relaxed
+ * atomiki — forma seqlocka poprawna w modelu C11; na targecie zwykły memcpy.
+ */
+static inline void racy_copy_(uint8_t* dst, const uint8_t* src, const size_t n)
+{
+#if defined(SPSC_RING_TSAN_)
+    for (size_t i = 0; i < n; i++)
+    {
+        __atomic_store_n(&dst[i], __atomic_load_n(&src[i], __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    }
+#else
+    memcpy(dst, src, n);
+#endif
+}
+
+static inline void notify_(void* task)
+{
+#if defined(ESP_PLATFORM)
+    if (xPortInIsrContext())
+    {
+        BaseType_t hpw = pdFALSE;
+        vTaskNotifyGiveFromISR((TaskHandle_t)task, &hpw);
+        if (hpw == pdTRUE)
+        {
+            portYIELD_FROM_ISR();
+        }
+        return;
+    }
+#endif
+    (void)xTaskNotifyGive((TaskHandle_t)task);
+}
+
+/*
+ * Po publikacji indeksu: budzi czekającego, jeśli jego próg jest osiągnięty.
+ * Bariera SEQ_CST paruje się z barierą w wait_() (rejestracja -> ponowny test),
+ * więc albo my widzimy rejestrację, albo czekający widzi nasz indeks.
+ */
+static inline void wake_(void** waiter, const uint32_t* want, const uint32_t have)
+{
+    void* w = __atomic_load_n(waiter, __ATOMIC_ACQUIRE); // paruje się z release rejestracji (want)
+    if (w == NULL || have < __atomic_load_n(want, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+    if (__atomic_compare_exchange_n(waiter, &w, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        notify_(w);
+    }
+}
+
+static inline void publish_head_(spsc_ring_t* rb, const uint32_t head)
+{
+    store_release_u32_(&rb->head, head);
+    if (!rb->waitable)
+    {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&rb->rd_waiter, __ATOMIC_RELAXED) != NULL)
+    {
+        wake_(&rb->rd_waiter, &rb->rd_want, head - load_acquire_u32_(&rb->tail));
+    }
+}
+
+static inline void publish_tail_(spsc_ring_t* rb, const uint32_t tail)
+{
+    store_release_u32_(&rb->tail, tail);
+    if (!rb->waitable)
+    {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&rb->wr_waiter, __ATOMIC_RELAXED) != NULL)
+    {
+        wake_(&rb->wr_waiter, &rb->wr_want, rb->cap - (load_acquire_u32_(&rb->head) - tail));
+    }
+}
+
 bool spsc_ring_init(spsc_ring_t* rb, void* storage, const uint32_t cap_bytes)
 {
     if (!rb || !storage)
@@ -40,6 +136,17 @@ bool spsc_ring_init(spsc_ring_t* rb, void* storage, const uint32_t cap_bytes)
     // ring jest czysto bajtowy; nie inicjalizujemy bufora (caller może chcieć zachować śmieci dla debug).
     __atomic_store_n(&rb->head, 0u, __ATOMIC_RELAXED);
     __atomic_store_n(&rb->tail, 0u, __ATOMIC_RELAXED);
+    rb->tail_cache = 0u;
+    rb->head_cache = 0u;
+    rb->rec_skip   = 0u;
+    rb->ovw_resv   = 0u;
+    rb->ovw_lost   = 0u;
+    rb->ovw_rd     = 0u;
+    rb->waitable   = false;
+    rb->rd_waiter  = NULL;
+    rb->rd_want    = 0u;
+    rb->wr_waiter  = NULL;
+    rb->wr_want    = 0u;
     return true;
 }
 
@@ -51,7 +158,8 @@ size_t spsc_ring_used(const spsc_ring_t* rb)
     }
     const uint32_t head = load_acquire_u32_(&rb->head);
     const uint32_t tail = load_acquire_u32_(&rb->tail);
-    return (size_t)(head - tail);
+    const uint32_t used = head - tail;
+    return (used > rb->cap) ? (size_t)rb->cap : (size_t)used; // > cap tylko w trybie nadpisywania
 }
 
 size_t spsc_ring_free(const spsc_ring_t* rb)
@@ -74,8 +182,14 @@ uint8_t* spsc_ring_reserve(spsc_ring_t* rb, const size_t want, size_t* out_n)
     }
 
     const uint32_t head = load_relaxed_u32_(&rb->head);              // producer‑only writer
-    const uint32_t tail = load_acquire_u32_(&rb->tail);              // consumer publishes tail
-    const uint32_t used = head - tail;
+    uint32_t used       = head - rb->tail_cache;
+
+    // Kopia tail wystarcza, dopóki mieści want; inaczej odśwież (consumer publishes tail).
+    if ((size_t)(rb->cap - used) < want)
+    {
+        rb->tail_cache = load_acquire_u32_(&rb->tail);
+        used           = head - rb->tail_cache;
+    }
 
     if (used >= rb->cap)
     {
@@ -110,10 +224,10 @@ void spsc_ring_commit(spsc_ring_t* rb, const size_t n)
 
     const uint32_t head = load_relaxed_u32_(&rb->head);
     const uint32_t next = head + (uint32_t)n;
-    store_release_u32_(&rb->head, next);
+    publish_head_(rb, next);
 }
 
-const uint8_t* spsc_ring_peek(const spsc_ring_t* rb, size_t* out_n)
+const uint8_t* spsc_ring_peek(spsc_ring_t* rb, size_t* out_n)
 {
     if (!rb || !out_n)
     {
@@ -121,8 +235,14 @@ const uint8_t* spsc_ring_peek(const spsc_ring_t* rb, size_t* out_n)
     }
 
     const uint32_t tail = load_relaxed_u32_(&rb->tail);              // consumer‑only writer
-    const uint32_t head = load_acquire_u32_(&rb->head);              // producer publishes head
-    const uint32_t used = head - tail;
+    uint32_t used       = rb->head_cache - tail;
+
+    // Kopia head pusta -> odśwież (producer publishes head).
+    if (used == 0u)
+    {
+        rb->head_cache = load_acquire_u32_(&rb->head);
+        used           = rb->head_cache - tail;
+    }
 
     if (used == 0u)
     {
@@ -151,5 +271,525 @@ void spsc_ring_consume(spsc_ring_t* rb, const size_t n)
 
     const uint32_t tail = load_relaxed_u32_(&rb->tail);
     const uint32_t next = tail + (uint32_t)n;
-    store_release_u32_(&rb->tail, next);
+    publish_tail_(rb, next);
+}
+
+/* Bajty do odczytu; kopia head odświeżana, gdy nie pokrywa want. Tylko konsument. */
+static inline uint32_t readable_(spsc_ring_t* rb, const uint32_t tail, const size_t want)
+{
+    uint32_t used = rb->head_cache - tail;
+    if ((size_t)used < want)
+    {
+        rb->head_cache = load_acquire_u32_(&rb->head);
+        used           = rb->head_cache - tail;
+    }
+    return used;
+}
+
+/* n bajtów od pozycji tail (≤ 2 memcpy przez zawinięcie). */
+static inline void copy_out_(const spsc_ring_t* rb, const uint32_t tail, uint8_t* dst, const size_t n)
+{
+    const uint32_t off   = tail & rb->mask;
+    const size_t   first = (n < (size_t)(rb->cap - off)) ? n : (size_t)(rb->cap - off);
+    memcpy(dst, rb->buf + off, first);
+    if (n > first)
+    {
+        memcpy(dst + first, rb->buf, n - first);
+    }
+}
+
+size_t spsc_ring_write(spsc_ring_t* rb, const void* src, const size_t len, const bool all)
+{
+    if (!rb || !src || len == 0u)
+    {
+        return 0u;
+    }
+
+    const uint32_t head = load_relaxed_u32_(&rb->head);
+    uint32_t free_total = rb->cap - (head - rb->tail_cache);
+    if ((size_t)free_total < len)
+    {
+        rb->tail_cache = load_acquire_u32_(&rb->tail);
+        free_total     = rb->cap - (head - rb->tail_cache);
+    }
+
+    size_t n = len;
+    if (n > (size_t)free_total)
+    {
+        if (all)
+        {
+            return 0u;
+        }
+        n = (size_t)free_total;
+    }
+    if (n == 0u)
+    {
+        return 0u;
+    }
+
+    const uint32_t off   = head & rb->mask;
+    const size_t   first = (n < (size_t)(rb->cap - off)) ? n : (size_t)(rb->cap - off);
+    memcpy(rb->buf + off, src, first);
+    if (n > first)
+    {
+        memcpy(rb->buf, (const uint8_t*)src + first, n - first);
+    }
+
+    publish_head_(rb, head + (uint32_t)n);
+    return n;
+}
+
+size_t spsc_ring_read(spsc_ring_t* rb, void* dst, const size_t max)
+{
+    if (!rb || !dst || max == 0u)
+    {
+        return 0u;
+    }
+
+    const uint32_t tail = load_relaxed_u32_(&rb->tail);
+    const uint32_t used = readable_(rb, tail, max);
+    const size_t   n    = ((size_t)used < max) ? (size_t)used : max;
+    if (n == 0u)
+    {
+        return 0u;
+    }
+
+    copy_out_(rb, tail, (uint8_t*)dst, n);
+    publish_tail_(rb, tail + (uint32_t)n);
+    return n;
+}
+
+size_t spsc_ring_read_until(spsc_ring_t* rb, void* dst, const size_t max, const uint8_t delim, bool* out_found)
+{
+    if (out_found)
+    {
+        *out_found = false;
+    }
+    if (!rb || !dst || max == 0u)
+    {
+        return 0u;
+    }
+
+    const uint32_t tail = load_relaxed_u32_(&rb->tail);
+    const uint32_t used = readable_(rb, tail, max);
+    size_t         n    = ((size_t)used < max) ? (size_t)used : max;
+    if (n == 0u)
+    {
+        return 0u;
+    }
+
+    // Szukanie delim w najwyżej dwóch ciągłych kawałkach.
+    const uint32_t off   = tail & rb->mask;
+    const size_t   first = (n < (size_t)(rb->cap - off)) ? n : (size_t)(rb->cap - off);
+    const uint8_t* hit   = memchr(rb->buf + off, delim, first);
+    if (hit)
+    {
+        n = (size_t)(hit - (rb->buf + off)) + 1u;
+    }
+    else if (n > first && (hit = memchr(rb->buf, delim, n - first)) != NULL)
+    {
+        n = first + (size_t)(hit - rb->buf) + 1u;
+    }
+    if (hit && out_found)
+    {
+        *out_found = true;
+    }
+
+    copy_out_(rb, tail, (uint8_t*)dst, n);
+    publish_tail_(rb, tail + (uint32_t)n);
+    return n;
+}
+
+/* Miejsce zajmowane przez rekord: nagłówek + payload, wyrównane do 4 B. */
+static inline uint32_t rec_span_(const size_t n)
+{
+    return ((uint32_t)n + SPSC_REC_HDR_ + 3u) & ~3u;
+}
+
+uint8_t* spsc_ring_reserve_record(spsc_ring_t* rb, const size_t n)
+{
+    if (!rb || n == 0u || n > spsc_ring_record_max(rb))
+    {
+        return NULL;
+    }
+
+    // W trybie rekordowym head jest zawsze wyrównany do 4, więc contig >= nagłówek.
+    const uint32_t head   = load_relaxed_u32_(&rb->head);
+    const uint32_t span   = rec_span_(n);
+    const uint32_t contig = rb->cap - (head & rb->mask);
+    const uint32_t skip   = (contig < span) ? contig : 0u;
+
+    uint32_t free_total = rb->cap - (head - rb->tail_cache);
+    if (free_total < skip + span)
+    {
+        rb->tail_cache = load_acquire_u32_(&rb->tail);
+        free_total     = rb->cap - (head - rb->tail_cache);
+    }
+    if (free_total < skip + span)
+    {
+        return NULL;
+    }
+
+    rb->rec_skip = skip;
+    return rb->buf + ((head + skip) & rb->mask) + SPSC_REC_HDR_;
+}
+
+void spsc_ring_commit_record(spsc_ring_t* rb, const size_t len)
+{
+    if (!rb)
+    {
+        return;
+    }
+    if (len == 0u)
+    {
+        rb->rec_skip = 0u; // rezerwacja porzucona
+        return;
+    }
+
+    // Znacznik WRAP i nagłówek trafiają do bufora przed publikacją head (release).
+    uint32_t head = load_relaxed_u32_(&rb->head);
+    if (rb->rec_skip != 0u)
+    {
+        const uint32_t wrap = SPSC_REC_WRAP_;
+        memcpy(rb->buf + (head & rb->mask), &wrap, sizeof(wrap));
+        head += rb->rec_skip;
+        rb->rec_skip = 0u;
+    }
+
+    const uint32_t hdr = (uint32_t)len;
+    memcpy(rb->buf + (head & rb->mask), &hdr, sizeof(hdr));
+    publish_head_(rb, head + rec_span_(len));
+}
+
+const uint8_t* spsc_ring_peek_record(spsc_ring_t* rb, size_t* out_n)
+{
+    if (!rb || !out_n)
+    {
+        return NULL;
+    }
+
+    uint32_t tail = load_relaxed_u32_(&rb->tail);
+    if (readable_(rb, tail, 1u) == 0u)
+    {
+        *out_n = 0u;
+        return NULL;
+    }
+
+    uint32_t off = tail & rb->mask;
+    uint32_t hdr;
+    memcpy(&hdr, rb->buf + off, sizeof(hdr));
+    if (hdr == SPSC_REC_WRAP_)
+    {
+        // Rekord za znacznikiem opublikowano tym samym head; ogon oddajemy od razu.
+        tail += rb->cap - off;
+        publish_tail_(rb, tail);
+        off = 0u;
+        memcpy(&hdr, rb->buf, sizeof(hdr));
+    }
+
+    *out_n = (size_t)hdr;
+    return rb->buf + off + SPSC_REC_HDR_;
+}
+
+void spsc_ring_consume_record(spsc_ring_t* rb)
+{
+    if (!rb)
+    {
+        return;
+    }
+
+    // Po peek_record: tail stoi na nagłówku rekordu (znacznik WRAP już pominięty).
+    const uint32_t tail = load_relaxed_u32_(&rb->tail);
+    if (readable_(rb, tail, 1u) == 0u)
+    {
+        return;
+    }
+
+    uint32_t hdr;
+    memcpy(&hdr, rb->buf + (tail & rb->mask), sizeof(hdr));
+    publish_tail_(rb, tail + rec_span_(hdr));
+}
+
+void spsc_ring_discard(spsc_ring_t* rb)
+{
+    if (!rb)
+    {
+        return;
+    }
+    const uint32_t head = load_acquire_u32_(&rb->head);
+    rb->ovw_rd          = head;
+    __atomic_store_n(&rb->ovw_lost, 0u, __ATOMIC_RELAXED);
+    publish_tail_(rb, head);
+}
+
+size_t spsc_ring_overwritten(const spsc_ring_t* rb)
+{
+    if (!rb)
+    {
+        return 0u;
+    }
+    return (size_t)load_relaxed_u32_(&rb->ovw_lost);
+}
+
+/* Producent doliczył d utraconych bajtów; konsument zeruje licznik zwykłym zapisem (stąd CAS). */
+static void ovw_count_lost_(spsc_ring_t* rb, const uint32_t d)
+{
+    uint32_t cur = load_relaxed_u32_(&rb->ovw_lost);
+    uint32_t nxt;
+    do
+    {
+        nxt = (cur + d < cur) ? UINT32_MAX : cur + d;
+    } while (!__atomic_compare_exchange_n(&rb->ovw_lost, &cur, nxt, false, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+}
+
+/*
+ * Producent okrążył czytelnika: tail podciągany do end - cap. Bez tego tail stoi (bufor logów
+ * zużywa tylko discard), a head - tail po 4 GiB zawija się przez 2^32 i ring wygląda na pusty.
+ * CAS, bo konsument przesuwa tail równolegle (ovw_advance_tail_); obie strony tylko do przodu.
+ */
+static void ovw_drag_tail_(spsc_ring_t* rb, const uint32_t end)
+{
+    const uint32_t floor = end - rb->cap;
+    uint32_t       tail  = load_acquire_u32_(&rb->tail);
+    while (end - tail > rb->cap)
+    {
+        if (__atomic_compare_exchange_n(&rb->tail, &tail, floor, false, __ATOMIC_RELEASE,
+                                        __ATOMIC_ACQUIRE))
+        {
+            ovw_count_lost_(rb, floor - tail);
+            return;
+        }
+    }
+}
+
+/* Konsument: tail do przodu do to, chyba że producent przeciągnął go już dalej. */
+static void ovw_advance_tail_(spsc_ring_t* rb, const uint32_t to)
+{
+    uint32_t tail = load_relaxed_u32_(&rb->tail);
+    while ((int32_t)(to - tail) > 0)
+    {
+        if (__atomic_compare_exchange_n(&rb->tail, &tail, to, false, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED))
+        {
+            return;
+        }
+    }
+}
+
+void spsc_ring_write_overwrite(spsc_ring_t* rb, const void* src, const size_t len)
+{
+    if (!rb || !src || len == 0u)
+    {
+        return;
+    }
+
+    // Z bloku dłuższego niż cap zostaje tylko końcówka; początek od razu liczy się jako nadpisany.
+    const uint32_t head = load_relaxed_u32_(&rb->head);
+    const uint32_t end  = head + (uint32_t)len;
+    const size_t   n    = (len < (size_t)rb->cap) ? len : (size_t)rb->cap;
+
+    // Zapowiedź zakresu przed danymi: czytelnik, który skopiował choć jeden nowy bajt,
+    // po swojej barierze acquire widzi też nowe ovw_resv (copy_checked_).
+    __atomic_store_n(&rb->ovw_resv, end, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    const uint8_t* s     = (const uint8_t*)src + (len - n);
+    const uint32_t off   = (end - (uint32_t)n) & rb->mask;
+    const size_t   first = (n < (size_t)(rb->cap - off)) ? n : (size_t)(rb->cap - off);
+    racy_copy_(rb->buf + off, s, first);
+    if (n > first)
+    {
+        racy_copy_(rb->buf, s + first, n - first);
+    }
+
+    // Przed head: kto wczyta head, a potem tail, widzi head - tail <= cap.
+    ovw_drag_tail_(rb, end);
+    publish_head_(rb, end);
+}
+
+/* Najstarszy ważny bajt: tail albo head - cap, jeśli tail wczytany przed podciągnięciem. */
+static inline uint32_t ovw_oldest_(const spsc_ring_t* rb, const uint32_t head, const uint32_t tail)
+{
+    return (head - tail > rb->cap) ? head - rb->cap : tail;
+}
+
+/*
+ * Kopia n bajtów od *from sprawdzana sekwencją: po kopii bariera acquire i ovw_resv mówią,
+ * ile początkowych bajtów producent mógł w międzyczasie nadpisać. Ten prefiks jest
+ * odrzucany (memmove), *from przesuwa się za niego. 0 = nadpisane wszystko, ponów.
+ */
+static size_t copy_checked_(const spsc_ring_t* rb, uint32_t* from, uint8_t* dst, const size_t n)
+{
+    const uint32_t off   = *from & rb->mask;
+    const size_t   first = (n < (size_t)(rb->cap - off)) ? n : (size_t)(rb->cap - off);
+    racy_copy_(dst, rb->buf + off, first);
+    if (n > first)
+    {
+        racy_copy_(dst + first, rb->buf, n - first);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    const uint32_t oldest = load_relaxed_u32_(&rb->ovw_resv) - rb->cap;
+    const int32_t  lost   = (int32_t)(oldest - *from);
+    if (lost <= 0)
+    {
+        return n;
+    }
+    if ((size_t)lost >= n)
+    {
+        return 0u;
+    }
+
+    memmove(dst, dst + lost, n - (size_t)lost);
+    *from += (uint32_t)lost;
+    return n - (size_t)lost;
+}
+
+size_t spsc_ring_read_overwrite(spsc_ring_t* rb, void* dst, const size_t max, uint32_t* out_lost)
+{
+    if (out_lost)
+    {
+        *out_lost = 0u;
+    }
+    if (!rb || !dst || max == 0u)
+    {
+        return 0u;
+    }
+
+    // Straty liczone od własnej pozycji: tail przesuwa też producent.
+    const uint32_t prev = rb->ovw_rd;
+    uint32_t       from;
+    size_t         n;
+    for (;;)
+    {
+        const uint32_t head = load_acquire_u32_(&rb->head);
+        const uint32_t tail = load_acquire_u32_(&rb->tail);
+        from                = ovw_oldest_(rb, head, tail);
+        n                   = ((size_t)(head - from) < max) ? (size_t)(head - from) : max;
+        if (n == 0u || (n = copy_checked_(rb, &from, (uint8_t*)dst, n)) != 0u)
+        {
+            break;
+        }
+    }
+    if (n == 0u)
+    {
+        return 0u;
+    }
+
+    if (out_lost)
+    {
+        *out_lost = from - prev;
+    }
+    rb->ovw_rd = from + (uint32_t)n;
+    ovw_advance_tail_(rb, rb->ovw_rd);
+    __atomic_store_n(&rb->ovw_lost, 0u, __ATOMIC_RELAXED);
+    return n;
+}
+
+size_t spsc_ring_copy_overwrite(const spsc_ring_t* rb, void* dst, const size_t max, const bool newest)
+{
+    if (!rb || !dst || max == 0u)
+    {
+        return 0u;
+    }
+
+    for (;;)
+    {
+        const uint32_t head   = load_acquire_u32_(&rb->head);
+        const uint32_t tail   = load_acquire_u32_(&rb->tail);
+        const uint32_t oldest = ovw_oldest_(rb, head, tail);
+        size_t         n      = ((size_t)(head - oldest) < max) ? (size_t)(head - oldest) : max;
+        uint32_t       from   = newest ? head - (uint32_t)n : oldest;
+        if (n == 0u || (n = copy_checked_(rb, &from, (uint8_t*)dst, n)) != 0u)
+        {
+            return n;
+        }
+    }
+}
+
+static bool readable_ok_(spsc_ring_t* rb, const uint32_t want)
+{
+    rb->head_cache = load_acquire_u32_(&rb->head);
+    return rb->head_cache - load_relaxed_u32_(&rb->tail) >= want;
+}
+
+static bool writable_ok_(spsc_ring_t* rb, const uint32_t want)
+{
+    rb->tail_cache = load_acquire_u32_(&rb->tail);
+    return rb->cap - (load_relaxed_u32_(&rb->head) - rb->tail_cache) >= want;
+}
+
+/* Zdejmuje rejestrację; jeśli druga strona już ją zdjęła, odbiera jej notyfikację. */
+static void unregister_(void** waiter, void* self)
+{
+    if (!__atomic_compare_exchange_n(waiter, &self, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+static bool wait_(spsc_ring_t* rb, void** waiter, uint32_t* want_field, const size_t min_bytes,
+                  bool (*ok)(spsc_ring_t*, uint32_t), const TickType_t timeout)
+{
+    if (!rb->waitable || min_bytes > (size_t)rb->cap)
+    {
+        return false;
+    }
+
+    const uint32_t   want = (min_bytes == 0u) ? 1u : (uint32_t)min_bytes;
+    const TickType_t t0   = xTaskGetTickCount();
+    void* const      self = xTaskGetCurrentTaskHandle();
+
+    for (;;)
+    {
+        if (ok(rb, want))
+        {
+            return true;
+        }
+
+        TickType_t left = timeout;
+        if (timeout != portMAX_DELAY)
+        {
+            const TickType_t spent = xTaskGetTickCount() - t0;
+            left = (spent >= timeout) ? 0 : timeout - spent;
+        }
+        if (left == 0)
+        {
+            return false;
+        }
+
+        __atomic_store_n(want_field, want, __ATOMIC_RELAXED);
+        __atomic_store_n(waiter, self, __ATOMIC_RELEASE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (ok(rb, want))
+        {
+            unregister_(waiter, self);
+            return true;
+        }
+
+        if (ulTaskNotifyTake(pdTRUE, left) == 0u)
+        {
+            unregister_(waiter, self);
+            return ok(rb, want);
+        }
+    }
+}
+
+void spsc_ring_enable_wait(spsc_ring_t* rb)
+{
+    if (rb)
+    {
+        rb->waitable = true;
+    }
+}
+
+bool spsc_ring_wait_readable(spsc_ring_t* rb, const size_t min_bytes, const TickType_t timeout)
+{
+    return rb ? wait_(rb, &rb->rd_waiter, &rb->rd_want, min_bytes, readable_ok_, timeout) : false;
+}
+
+bool spsc_ring_wait_writable(spsc_ring_t* rb, const size_t min_bytes, const TickType_t timeout)
+{
+    return rb ? wait_(rb, &rb->wr_waiter, &rb->wr_want, min_bytes, writable_ok_, timeout) : false;
 }
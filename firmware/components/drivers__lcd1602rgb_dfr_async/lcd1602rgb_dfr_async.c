@@ -440,7 +440,7 @@ static void task_ev(void* arg)
     ev_msg_t m;
     for (;;)
     {
-        if (xQueueReceive(s_q, &m, portMAX_DELAY) != pdTRUE)
+        if (!ev_recv(s_q, &m, portMAX_DELAY))
             continue;
 
         if (m.src == EV_SRC_SYS && m.code == EV_SYS_START)
@@ -56,7 +56,8 @@ static void lcd_ev_task(void* arg)
 
     ev_msg_t m;
     for (;;) {
-        if (xQueueReceive(q, &m, portMAX_DELAY) != pdTRUE) continue;
+        // ev_recv(): przeterminowane DRAW_ROW/FLUSH (TTL ze schemy) są pomijane.
+        if (!ev_recv(q, &m, portMAX_DELAY)) continue;
 
         if (m.src == EV_SRC_SYS && m.code == EV_SYS_START) {
             i2c_bus_cfg_t buscfg = {
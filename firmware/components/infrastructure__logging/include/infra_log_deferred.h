@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief Odroczone logowanie binarne: formatowanie po stronie konsumenta.
+ *
+ * Hot path (log_write z CONFIG_INFRA_LOG_DEFERRED) nie woła vsnprintf: zapisuje do MPSC
+ * ringu rekord = nagłówek (czas, poziom, wskaźnik formatu, wskaźnik tagu) + surowe
+ * argumenty w kolejności konwersji z formatu. Format i tag muszą żyć statycznie
+ * (literały, `static const char* TAG`) — w ringu jest tylko ich adres. Argumenty %s są
+ * kopiowane (najwyżej CONFIG_INFRA_LOG_DEFERRED_STR_MAX bajtów), bo wskazują zwykle na stos.
+ *
+ * Kodowanie argumentów (little endian, bez wyrównania, typy z formatu):
+ *  - d i u x X o c, bez modyfikatora / hh / h: 4 B; l z t: sizeof(long/size_t/ptrdiff_t);
+ *    ll j: 8 B; p: sizeof(void*); a e f g (także L): double 8 B; '*' (szerokość/precyzja): 4 B,
+ *  - s: u8 długość + bajty (bez NUL), NULL zapisywany jako "(null)",
+ *  - %% i %n: nic.
+ * Rekord, który się nie mieści, jest ucinany na granicy argumentu (INFRA_LOG_DFR_TRUNC);
+ * brakujące argumenty konsument wypisuje jako "?".
+ *
+ * Konsument: task niskiego priorytetu (CONFIG_INFRA_LOG_DEFERRED_TASK) formatuje rekordy
+ * i wysyła je dalej jak dotychczas (esp_log_write + ring RAM). Bez taska rekordy czekają
+ * w ringu; `logrb dfr` wypisuje je jako linie "DFR:<hex>", które dekoduje na hoście
+ * scripts/log-decode.py na podstawie tablicy stringów z ELF (ten sam adres formatu).
+ */
+
+enum {
+    INFRA_LOG_DFR_TRUNC = 1u << 0, /**< argumenty ucięte (rekord za długi) */
+};
+
+/** @brief Nagłówek rekordu (w ringu przez memcpy — bez wymagań wyrównania). */
+typedef struct {
+    uint32_t    ts_ms;
+    uint8_t     lvl;      /**< log_level_t */
+    uint8_t     flags;    /**< INFRA_LOG_DFR_* */
+    uint16_t    args_len; /**< bajty argumentów za nagłówkiem */
+    const char* fmt;
+    const char* tag;
+} infra_log_dfr_hdr_t;
+
+/* ===== Kodek (bez stanu; używany też przez build hosta) ===== */
+
+/**
+ * @brief Pakuje argumenty wg formatu do dst (najwyżej max bajtów).
+ * @return flagi INFRA_LOG_DFR_* (0 = komplet); *out_len = zapisane bajty
+ */
+uint8_t infra_log_dfr_pack(uint8_t* dst, size_t max, size_t* out_len, const char* fmt, va_list ap);
+
+/**
+ * @brief Formatuje spakowane argumenty jak vsnprintf(out, max, fmt, ...).
+ * @return długość wyniku w out (bez NUL, po przycięciu do max-1)
+ */
+size_t infra_log_dfr_format(char* out, size_t max, const char* fmt, const uint8_t* args, size_t args_len);
+
+/* ===== Ring rekordów (CONFIG_INFRA_LOG_DEFERRED) ===== */
+
+/** @brief Inicjalizacja ringu (przed pierwszym zapisem; wywołanie ponowne nic nie robi). */
+void infra_log_deferred_init(void);
+
+/** @brief Hot path (MP-safe): jeden rekord albo nic (pełny ring -> drop_count++). */
+bool infra_log_deferred_vwrite(uint8_t lvl, uint32_t ts_ms, const char* tag, const char* fmt, va_list ap);
+
+/**
+ * @brief Konsument: najstarszy rekord sformatowany do msg (treść bez nagłówka linii).
+ * @return false = ring pusty
+ */
+bool infra_log_deferred_read(infra_log_dfr_hdr_t* out_hdr, char* msg, size_t max, size_t* out_len);
+
+/** @brief Konsument: surowy rekord (nagłówek + argumenty) do zrzutu na host; consume po odczycie. */
+const uint8_t* infra_log_deferred_peek_raw(size_t* out_len);
+void infra_log_deferred_consume(void);
+
+/** @brief Blokująco (task notification) do pierwszego rekordu albo timeout (jeden konsument). */
+bool infra_log_deferred_wait_readable(TickType_t timeout);
+
+uint32_t infra_log_deferred_drop_count(void);
+size_t   infra_log_deferred_used(void);
@@ -4,22 +4,39 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "freertos/FreeRTOS.h"
+
 /**
- * @brief Log-stream: SPSC ring buffer na bajty (producer->consumer) bez alokacji.
+ * @brief Log-stream: MPSC ring rekordów (producenci->konsument) bez alokacji.
+ *
+ * Jeden rekord = jedna linia logu (bez '\n'), zawsze ciągła w pamięci
+ * (core/mpsc_ring.h) — konsument przechodzi od linii do linii
+ * bez kopiowania i szukania końca linii.
+ *
+ * Producentów może być wielu (taski/rdzenie) — zapis bez blokady.
+ * Konsument jest jeden. infra_log_stream_init() przed pierwszym zapisem.
  *
- * Uwaga: rdzeń jest SPSC. Jeżeli potencjalnie masz więcej niż jednego
- * producenta, musisz go serializować zewnętrznie (np. przez mutex/critical).
+ * Budzenie raz na paczkę: konsument po opróżnieniu woła infra_log_stream_arm_ready()
+ * (albo śpi w infra_log_stream_wait_readable()). Tylko pierwszy zapis po uzbrojeniu
+ * dostaje *out_ready=true — producent wysyła wtedy jedno EV_LOG_READY na paczkę linii.
+ * Po init dzwonek jest uzbrojony (konsument startuje z pustym ringiem).
  */
 void infra_log_stream_init(void);
 
-// Producer side
-bool infra_log_stream_write_all(const void* data, size_t len);
+// Producer side (MP-safe): cały rekord albo nic (brak miejsca -> drop_count++).
+// out_ready (opcjonalne): true = konsument czekał na dzwonek, wyślij mu zdarzenie.
+bool infra_log_stream_write_record(const void* data, size_t len, bool* out_ready);
 
-// Consumer side
-const uint8_t* infra_log_stream_peek(size_t* out_len);
-void infra_log_stream_consume(size_t len);
+// Consumer side: najstarszy rekord (NULL = pusto); consume zwalnia go po odczycie.
+const uint8_t* infra_log_stream_peek_record(size_t* out_len);
+void infra_log_stream_consume_record(void);
+// true = dzwonek uzbrojony (czekaj na zdarzenie); false = przyszły nowe rekordy, czytaj dalej.
+bool infra_log_stream_arm_ready(void);
+// Blokująco (task notification) do pierwszego rekordu albo timeout.
+bool infra_log_stream_wait_readable(TickType_t timeout);
 
-// Stats
+// Stats (capacity/used w bajtach, razem z nagłówkami rekordów)
 size_t infra_log_stream_capacity(void);
+size_t infra_log_stream_record_max(void);
 size_t infra_log_stream_used(void);
 uint32_t infra_log_stream_drop_count(void);
@@ -0,0 +1,594 @@
+#include "infra_log_deferred.h"
+
+#include "sdkconfig.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifndef CONFIG_INFRA_LOG_DEFERRED_STR_MAX
+#define CONFIG_INFRA_LOG_DEFERRED_STR_MAX 32
+#endif
+
+#define DFR_PREC_NONE_ (-1)
+#define DFR_PREC_STAR_ (-2)
+
+/* Jedna specyfikacja konwersji z formatu printf. */
+typedef struct
+{
+    const char* start; // '%'
+    size_t      len;   // od '%' do litery konwersji włącznie
+    char        conv;
+    char        mod;   // 0, 'H' (hh), 'h', 'l', 'q' (ll), 'j', 'z', 't', 'L'
+    bool        star_w;
+    int         prec;  // DFR_PREC_NONE_ / DFR_PREC_STAR_ / wartość literalna
+} dfr_spec_t;
+
+/* Następna konwersja od p (NULL = koniec formatu); niekompletna specyfikacja to literał. */
+static const char* next_spec_(const char* p, dfr_spec_t* s)
+{
+    for (const char* q = strchr(p, '%'); q != NULL; q = strchr(q + 1, '%'))
+    {
+        const char* c = q + 1;
+        while (*c && strchr("-+ #0'", *c))
+        {
+            c++;
+        }
+
+        s->star_w = (*c == '*');
+        if (s->star_w)
+        {
+            c++;
+        }
+        while (*c >= '0' && *c <= '9')
+        {
+            c++;
+        }
+
+        s->prec = DFR_PREC_NONE_;
+        if (*c == '.')
+        {
+            c++;
+            if (*c == '*')
+            {
+                s->prec = DFR_PREC_STAR_;
+                c++;
+            }
+            else
+            {
+                s->prec = 0;
+                while (*c >= '0' && *c <= '9')
+                {
+                    s->prec = s->prec * 10 + (*c++ - '0');
+                }
+            }
+        }
+
+        s->mod = 0;
+        if (*c && strchr("hljztL", *c))
+        {
+            s->mod = *c++;
+            if ((s->mod == 'h' || s->mod == 'l') && *c == s->mod)
+            {
+                s->mod = (s->mod == 'h') ? 'H' : 'q';
+                c++;
+            }
+        }
+
+        if (*c == '\0')
+        {
+            return NULL;
+        }
+        s->start = q;
+        s->conv  = *c;
+        s->len   = (size_t)(c - q) + 1u;
+        return q;
+    }
+    return NULL;
+}
+
+static bool is_int_conv_(const char c)
+{
+    return c != '\0' && strchr("diuxXoc", c) != NULL;
+}
+
+static bool is_float_conv_(const char c)
+{
+    return c != '\0' && strchr("aAeEfFgG", c) != NULL;
+}
+
+/* ===================== pakowanie ===================== */
+
+static bool put_(uint8_t* dst, const size_t max, size_t* n, const void* v, const size_t len)
+{
+    if (max - *n < len)
+    {
+        return false;
+    }
+    memcpy(dst + *n, v, len);
+    *n += len;
+    return true;
+}
+
+/* Liczba całkowita w typie z modyfikatora (jak czyta ją vsnprintf). */
+static bool put_int_(uint8_t* dst, const size_t max, size_t* n, const char mod, va_list* ap)
+{
+    switch (mod)
+    {
+    case 'l':
+    {
+        const long v = va_arg(*ap, long);
+        return put_(dst, max, n, &v, sizeof(v));
+    }
+    case 'q':
+    {
+        const long long v = va_arg(*ap, long long);
+        return put_(dst, max, n, &v, sizeof(v));
+    }
+    case 'j':
+    {
+        const intmax_t v = va_arg(*ap, intmax_t);
+        return put_(dst, max, n, &v, sizeof(v));
+    }
+    case 'z':
+    {
+        const size_t v = va_arg(*ap, size_t);
+        return put_(dst, max, n, &v, sizeof(v));
+    }
+    case 't':
+    {
+        const ptrdiff_t v = va_arg(*ap, ptrdiff_t);
+        return put_(dst, max, n, &v, sizeof(v));
+    }
+    default:
+    {
+        const int v = va_arg(*ap, int); // hh/h: promocja do int
+        return put_(dst, max, n, &v, sizeof(v));
+    }
+    }
+}
+
+uint8_t infra_log_dfr_pack(uint8_t* dst, const size_t max, size_t* out_len, const char* fmt, va_list ap)
+{
+    // va_list przez wskaźnik do kopii: helpery czytają dalej z tego samego miejsca.
+    va_list aq;
+    va_copy(aq, ap);
+
+    size_t  n     = 0;
+    uint8_t flags = 0;
+    dfr_spec_t s;
+    for (const char* p = fmt ? fmt : ""; (p = next_spec_(p, &s)) != NULL; p = s.start + s.len)
+    {
+        int prec = s.prec;
+        if (s.star_w)
+        {
+            const int w = va_arg(aq, int);
+            if (!put_(dst, max, &n, &w, sizeof(w)))
+            {
+                flags |= INFRA_LOG_DFR_TRUNC;
+                break;
+            }
+        }
+        if (s.prec == DFR_PREC_STAR_)
+        {
+            prec = va_arg(aq, int);
+            if (!put_(dst, max, &n, &prec, sizeof(prec)))
+            {
+                flags |= INFRA_LOG_DFR_TRUNC;
+                break;
+            }
+        }
+
+        bool ok = true;
+        if (is_int_conv_(s.conv))
+        {
+            ok = put_int_(dst, max, &n, (s.conv == 'c') ? 0 : s.mod, &aq);
+        }
+        else if (is_float_conv_(s.conv))
+        {
+            const double v = (s.mod == 'L') ? (double)va_arg(aq, long double) : va_arg(aq, double);
+            ok = put_(dst, max, &n, &v, sizeof(v));
+        }
+        else if (s.conv == 'p')
+        {
+            const void* v = va_arg(aq, void*);
+            ok = put_(dst, max, &n, &v, sizeof(v));
+        }
+        else if (s.conv == 's')
+        {
+            const char* str = va_arg(aq, const char*);
+            if (str == NULL)
+            {
+                str = "(null)";
+            }
+            size_t lim = CONFIG_INFRA_LOG_DEFERRED_STR_MAX;
+            if (prec >= 0 && (size_t)prec < lim)
+            {
+                lim = (size_t)prec;
+            }
+            size_t len = strnlen(str, lim);
+            if (max - n < 1u + len)
+            {
+                // Ostatni argument, który się zmieści: początek napisu zamiast niczego.
+                flags |= INFRA_LOG_DFR_TRUNC;
+                len = (max - n > 1u) ? max - n - 1u : 0u;
+                if (max - n == 0u)
+                {
+                    break;
+                }
+            }
+            dst[n++] = (uint8_t)len;
+            memcpy(dst + n, str, len);
+            n += len;
+        }
+        else if (s.conv == 'n')
+        {
+            (void)va_arg(aq, void*); // zapis licznika nie ma sensu po stronie konsumenta
+        }
+        else if (s.conv != '%')
+        {
+            break; // nieznana konwersja: reszta argumentów nieczytelna
+        }
+
+        if (!ok)
+        {
+            flags |= INFRA_LOG_DFR_TRUNC;
+            break;
+        }
+    }
+    va_end(aq);
+
+    if (out_len != NULL)
+    {
+        *out_len = n;
+    }
+    return flags;
+}
+
+/* ===================== formatowanie ===================== */
+
+typedef struct
+{
+    const uint8_t* p;
+    size_t         len;
+    size_t         off;
+} dfr_args_t;
+
+static bool get_(dfr_args_t* a, void* v, const size_t len)
+{
+    if (a->len - a->off < len)
+    {
+        a->off = a->len; // po pierwszym braku wszystkie kolejne to "?"
+        return false;
+    }
+    memcpy(v, a->p + a->off, len);
+    a->off += len;
+    return true;
+}
+
+/* Specyfikacja jest z formatu (nie literał) — typ wartości dobiera get_* zgodnie z nią. */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+
+#define DFR_PRINT_(val)                                                                    \
+    ((nstar == 0) ? snprintf(out, room, sp, (val))                                         \
+                  : (nstar == 1) ? snprintf(out, room, sp, st[0], (val))                   \
+                                 : snprintf(out, room, sp, st[0], st[1], (val)))
+
+/* Jedna konwersja do out (room bajtów z NUL); -1 = brak argumentów. */
+static int format_one_(char* out, const size_t room, const dfr_spec_t* s, dfr_args_t* a)
+{
+    char sp[24];
+    if (s->len >= sizeof(sp))
+    {
+        return -1;
+    }
+    memcpy(sp, s->start, s->len);
+    sp[s->len] = '\0';
+
+    int st[2];
+    int nstar = 0;
+    if (s->star_w && !get_(a, &st[nstar++], sizeof(int)))
+    {
+        return -1;
+    }
+    if (s->prec == DFR_PREC_STAR_ && !get_(a, &st[nstar++], sizeof(int)))
+    {
+        return -1;
+    }
+
+    if (is_int_conv_(s->conv))
+    {
+        switch ((s->conv == 'c') ? 0 : s->mod)
+        {
+        case 'l':
+        {
+            long v;
+            return get_(a, &v, sizeof(v)) ? DFR_PRINT_(v) : -1;
+        }
+        case 'q':
+        {
+            long long v;
+            return get_(a, &v, sizeof(v)) ? DFR_PRINT_(v) : -1;
+        }
+        case 'j':
+        {
+            intmax_t v;
+            return get_(a, &v, sizeof(v)) ? DFR_PRINT_(v) : -1;
+        }
+        case 'z':
+        {
+            size_t v;
+            return get_(a, &v, sizeof(v)) ? DFR_PRINT_(v) : -1;
+        }
+        case 't':
+        {
+            ptrdiff_t v;
+            return get_(a, &v, sizeof(v)) ? DFR_PRINT_(v) : -1;
+        }
+        default:
+        {
+            int v;
+            return get_(a, &v, sizeof(v)) ? DFR_PRINT_(v) : -1;
+        }
+        }
+    }
+    if (is_float_conv_(s->conv))
+    {
+        double v;
+        if (!get_(a, &v, sizeof(v)))
+        {
+            return -1;
+        }
+        return (s->mod == 'L') ? DFR_PRINT_((long double)v) : DFR_PRINT_(v);
+    }
+    if (s->conv == 'p')
+    {
+        void* v;
+        return get_(a, &v, sizeof(v)) ? DFR_PRINT_(v) : -1;
+    }
+    if (s->conv == 's')
+    {
+        uint8_t len;
+        char    str[256];
+        if (!get_(a, &len, 1u) || !get_(a, str, len))
+        {
+            return -1;
+        }
+        str[len] = '\0';
+        return DFR_PRINT_(str);
+    }
+    if (s->conv == '%')
+    {
+        return snprintf(out, room, "%%");
+    }
+    return 0; // %n i nieznane: nic
+}
+
+#undef DFR_PRINT_
+#pragma GCC diagnostic pop
+
+static void emit_(char* out, const size_t max, size_t* o, const char* s, const size_t len)
+{
+    const size_t room = max - 1u - *o;
+    const size_t n    = (len < room) ? len : room;
+    memcpy(out + *o, s, n);
+    *o += n;
+}
+
+size_t infra_log_dfr_format(char* out, const size_t max, const char* fmt, const uint8_t* args, const size_t args_len)
+{
+    if (out == NULL || max == 0u)
+    {
+        return 0u;
+    }
+
+    dfr_args_t a = { .p = args, .len = (args != NULL) ? args_len : 0u, .off = 0u };
+    size_t     o = 0;
+    const char* p = fmt ? fmt : "";
+    dfr_spec_t s;
+    while (o + 1u < max)
+    {
+        const char* q = next_spec_(p, &s);
+        emit_(out, max, &o, p, q ? (size_t)(q - p) : strlen(p));
+        if (q == NULL || o + 1u >= max)
+        {
+            break;
+        }
+        p = s.start + s.len;
+
+        const int n = format_one_(out + o, max - o, &s, &a);
+        if (n < 0)
+        {
+            emit_(out, max, &o, "?", 1u);
+        }
+        else
+        {
+            o += ((size_t)n < max - 1u - o) ? (size_t)n : max - 1u - o;
+        }
+    }
+    out[o] = '\0';
+    return o;
+}
+
+/* ===================== ring rekordów ===================== */
+
+#if CONFIG_INFRA_LOG_DEFERRED
+
+#include "core/mpsc_ring.h"
+
+#ifndef CONFIG_INFRA_LOG_DEFERRED_RING_SIZE
+#define CONFIG_INFRA_LOG_DEFERRED_RING_SIZE 4096
+#endif
+
+#if ((CONFIG_INFRA_LOG_DEFERRED_RING_SIZE & (CONFIG_INFRA_LOG_DEFERRED_RING_SIZE - 1)) != 0)
+#error "CONFIG_INFRA_LOG_DEFERRED_RING_SIZE musi być potęgą 2 (np. 1024, 2048, 4096)"
+#endif
+
+// Argumenty jednego rekordu: kilka liczb + 2-3 napisy po CONFIG_INFRA_LOG_DEFERRED_STR_MAX.
+#define DFR_ARGS_MAX_ 128u
+
+static uint8_t s_storage_[CONFIG_INFRA_LOG_DEFERRED_RING_SIZE] __attribute__((aligned(4)));
+static mpsc_ring_t s_rb_;
+static bool s_init_ = false;
+static uint32_t s_drop_ = 0;
+
+void infra_log_deferred_init(void)
+{
+    if (s_init_)
+    {
+        return;
+    }
+
+    s_init_ = mpsc_ring_init(&s_rb_, s_storage_, (uint32_t)sizeof(s_storage_));
+    if (s_init_)
+    {
+        mpsc_ring_enable_wait(&s_rb_);
+    }
+}
+
+bool infra_log_deferred_vwrite(const uint8_t lvl, const uint32_t ts_ms, const char* tag, const char* fmt, va_list ap)
+{
+    if (!s_init_)
+    {
+        return false;
+    }
+
+    // Pakowanie na stosie, potem rezerwacja dokładnego rozmiaru: rezerwacja "na zapas"
+    // zajęłaby w ringu pełne DFR_ARGS_MAX_ także dla rekordów bez argumentów.
+    uint8_t args[DFR_ARGS_MAX_];
+    size_t  n = 0;
+    const infra_log_dfr_hdr_t hdr = {
+        .ts_ms    = ts_ms,
+        .lvl      = lvl,
+        .flags    = infra_log_dfr_pack(args, sizeof(args), &n, fmt, ap),
+        .args_len = (uint16_t)n,
+        .fmt      = fmt,
+        .tag      = tag,
+    };
+
+    mpsc_ring_resv_t r;
+    uint8_t* dst = mpsc_ring_reserve(&s_rb_, sizeof(hdr) + n, &r);
+    if (dst == NULL)
+    {
+        __atomic_fetch_add(&s_drop_, 1u, __ATOMIC_RELAXED);
+        return false;
+    }
+    memcpy(dst, &hdr, sizeof(hdr));
+    memcpy(dst + sizeof(hdr), args, n);
+    (void)mpsc_ring_commit(&s_rb_, &r, sizeof(hdr) + n);
+    return true;
+}
+
+bool infra_log_deferred_read(infra_log_dfr_hdr_t* out_hdr, char* msg, const size_t max, size_t* out_len)
+{
+    size_t n = 0;
+    const uint8_t* rec = s_init_ ? mpsc_ring_peek(&s_rb_, &n) : NULL;
+    if (rec == NULL || n < sizeof(infra_log_dfr_hdr_t))
+    {
+        return false;
+    }
+
+    infra_log_dfr_hdr_t hdr;
+    memcpy(&hdr, rec, sizeof(hdr));
+    const size_t len = infra_log_dfr_format(msg, max, hdr.fmt, rec + sizeof(hdr), n - sizeof(hdr));
+    mpsc_ring_consume(&s_rb_);
+
+    if (out_hdr != NULL)
+    {
+        *out_hdr = hdr;
+    }
+    if (out_len != NULL)
+    {
+        *out_len = len;
+    }
+    return true;
+}
+
+const uint8_t* infra_log_deferred_peek_raw(size_t* out_len)
+{
+    if (!s_init_)
+    {
+        if (out_len != NULL)
+        {
+            *out_len = 0u;
+        }
+        return NULL;
+    }
+
+    return mpsc_ring_peek(&s_rb_, out_len);
+}
+
+void infra_log_deferred_consume(void)
+{
+    if (s_init_)
+    {
+        mpsc_ring_consume(&s_rb_);
+    }
+}
+
+bool infra_log_deferred_wait_readable(const TickType_t timeout)
+{
+    return s_init_ ? mpsc_ring_wait_readable(&s_rb_, timeout) : false;
+}
+
+uint32_t infra_log_deferred_drop_count(void)
+{
+    return __atomic_load_n(&s_drop_, __ATOMIC_RELAXED);
+}
+
+size_t infra_log_deferred_used(void)
+{
+    return s_init_ ? mpsc_ring_used(&s_rb_) : 0u;
+}
+
+#else // !CONFIG_INFRA_LOG_DEFERRED
+
+void infra_log_deferred_init(void) {}
+
+bool infra_log_deferred_vwrite(const uint8_t lvl, const uint32_t ts_ms, const char* tag, const char* fmt, va_list ap)
+{
+    (void)lvl;
+    (void)ts_ms;
+    (void)tag;
+    (void)fmt;
+    (void)ap;
+    return false;
+}
+
+bool infra_log_deferred_read(infra_log_dfr_hdr_t* out_hdr, char* msg, const size_t max, size_t* out_len)
+{
+    (void)out_hdr;
+    (void)msg;
+    (void)max;
+    (void)out_len;
+    return false;
+}
+
+const uint8_t* infra_log_deferred_peek_raw(size_t* out_len)
+{
+    if (out_len != NULL)
+    {
+        *out_len = 0u;
+    }
+    return NULL;
+}
+
+void infra_log_deferred_consume(void) {}
+
+bool infra_log_deferred_wait_readable(const TickType_t timeout)
+{
+    (void)timeout;
+    return false;
+}
+
+uint32_t infra_log_deferred_drop_count(void)
+{
+    return 0u;
+}
+
+size_t infra_log_deferred_used(void)
+{
+    return 0u;
+}
+
+#endif
@@ -4,7 +4,7 @@
 
 #if CONFIG_INFRA_LOG_STREAM
 
-#include "core/spsc_ring.h"
+#include "core/mpsc_ring.h"
 
 #include <string.h>
 
@@ -16,8 +16,8 @@
 #error "CONFIG_INFRA_LOG_STREAM_RING_SIZE musi być potęgą 2 (np. 1024, 2048, 4096)"
 #endif
 
-static uint8_t s_storage_[CONFIG_INFRA_LOG_STREAM_RING_SIZE];
-static spsc_ring_t s_rb_;
+static uint8_t s_storage_[CONFIG_INFRA_LOG_STREAM_RING_SIZE] __attribute__((aligned(4)));
+static mpsc_ring_t s_rb_;
 static bool s_init_ = false;
 static uint32_t s_drop_ = 0;
 
@@ -28,51 +28,46 @@ void infra_log_stream_init(void)
         return;
     }
 
-    s_init_ = spsc_ring_init(&s_rb_, s_storage_, (uint32_t)sizeof(s_storage_));
+    s_init_ = mpsc_ring_init(&s_rb_, s_storage_, (uint32_t)sizeof(s_storage_));
+    if (s_init_)
+    {
+        mpsc_ring_enable_wait(&s_rb_);
+        (void)mpsc_ring_arm_readable(&s_rb_);
+    }
 }
 
-bool infra_log_stream_write_all(const void* data, const size_t len)
+bool infra_log_stream_write_record(const void* data, const size_t len, bool* out_ready)
 {
-    if (!s_init_)
+    if (out_ready != NULL)
     {
-        infra_log_stream_init();
+        *out_ready = false;
     }
 
+    // Bez leniwego init: producenci są współbieżni, init robi start (przed pierwszym zapisem).
     if (!s_init_ || (data == NULL) || (len == 0u))
     {
         return false;
     }
 
-    if (spsc_ring_free(&s_rb_) < len)
+    // Wszystko albo nic: ucięta linia logu jest gorsza niż brak linii.
+    mpsc_ring_resv_t r;
+    uint8_t* dst = mpsc_ring_reserve(&s_rb_, len, &r);
+    if (dst == NULL)
     {
-        s_drop_++;
+        __atomic_fetch_add(&s_drop_, 1u, __ATOMIC_RELAXED);
         return false;
     }
 
-    const uint8_t* p = (const uint8_t*)data;
-    size_t rem = len;
-
-    while (rem > 0u)
+    memcpy(dst, data, len);
+    const bool ready = mpsc_ring_commit(&s_rb_, &r, len);
+    if (out_ready != NULL)
     {
-        size_t n = 0u;
-        uint8_t* dst = spsc_ring_reserve(&s_rb_, rem, &n);
-        if ((dst == NULL) || (n == 0u))
-        {
-            s_drop_++;
-            return false;
-        }
-
-        memcpy(dst, p, n);
-        spsc_ring_commit(&s_rb_, n);
-
-        p += n;
-        rem -= n;
+        *out_ready = ready;
     }
-
     return true;
 }
 
-const uint8_t* infra_log_stream_peek(size_t* out_len)
+const uint8_t* infra_log_stream_peek_record(size_t* out_len)
 {
     if (!s_init_)
     {
@@ -83,17 +78,37 @@ const uint8_t* infra_log_stream_peek(size_t* out_len)
         return NULL;
     }
 
-    return spsc_ring_peek(&s_rb_, out_len);
+    return mpsc_ring_peek(&s_rb_, out_len);
 }
 
-void infra_log_stream_consume(const size_t len)
+void infra_log_stream_consume_record(void)
 {
     if (!s_init_)
     {
         return;
     }
 
-    spsc_ring_consume(&s_rb_, len);
+    mpsc_ring_consume(&s_rb_);
+}
+
+bool infra_log_stream_arm_ready(void)
+{
+    if (!s_init_)
+    {
+        return true;
+    }
+
+    return mpsc_ring_arm_readable(&s_rb_);
+}
+
+bool infra_log_stream_wait_readable(const TickType_t timeout)
+{
+    if (!s_init_)
+    {
+        return false;
+    }
+
+    return mpsc_ring_wait_readable(&s_rb_, timeout);
 }
 
 size_t infra_log_stream_capacity(void)
@@ -101,6 +116,11 @@ size_t infra_log_stream_capacity(void)
     return (size_t)sizeof(s_storage_);
 }
 
+size_t infra_log_stream_record_max(void)
+{
+    return s_init_ ? mpsc_ring_record_max(&s_rb_) : 0u;
+}
+
 size_t infra_log_stream_used(void)
 {
     if (!s_init_)
@@ -108,26 +128,30 @@ size_t infra_log_stream_used(void)
         return 0u;
     }
 
-    return spsc_ring_used(&s_rb_);
+    return mpsc_ring_used(&s_rb_);
 }
 
 uint32_t infra_log_stream_drop_count(void)
 {
-    return s_drop_;
+    return __atomic_load_n(&s_drop_, __ATOMIC_RELAXED);
 }
 
 #else // !CONFIG_INFRA_LOG_STREAM
 
 void infra_log_stream_init(void) {}
 
-bool infra_log_stream_write_all(const void* data, const size_t len)
+bool infra_log_stream_write_record(const void* data, const size_t len, bool* out_ready)
 {
     (void)data;
     (void)len;
+    if (out_ready != NULL)
+    {
+        *out_ready = false;
+    }
     return false;
 }
 
-const uint8_t* infra_log_stream_peek(size_t* out_len)
+const uint8_t* infra_log_stream_peek_record(size_t* out_len)
 {
     if (out_len != NULL)
     {
@@ -136,9 +160,17 @@ const uint8_t* infra_log_stream_peek(size_t* out_len)
     return NULL;
 }
 
-void infra_log_stream_consume(const size_t len)
+void infra_log_stream_consume_record(void) {}
+
+bool infra_log_stream_arm_ready(void)
+{
+    return true;
+}
+
+bool infra_log_stream_wait_readable(const TickType_t timeout)
 {
-    (void)len;
+    (void)timeout;
+    return false;
 }
 
 size_t infra_log_stream_capacity(void)
@@ -146,6 +178,11 @@ size_t infra_log_stream_capacity(void)
     return 0u;
 }
 
+size_t infra_log_stream_record_max(void)
+{
+    return 0u;
+}
+
 size_t infra_log_stream_used(void)
 {
     return 0u;
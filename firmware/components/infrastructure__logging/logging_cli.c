@@ -2,6 +2,7 @@
 #include "logging_cli.h"
 
 #include "infra_log_rb.h"
+#include "infra_log_deferred.h"
 #include "ports/log_port.h"
 #include "ports/spi_port.h"
 
@@ -95,7 +96,11 @@ static int cmd_logrb(int argc, char** argv)
     return 0;
 #else
     if (argc < 2) {
+#if CONFIG_INFRA_LOG_DEFERRED && !CONFIG_INFRA_LOG_DEFERRED_TASK
+        printf("użycie: logrb {stat|clear|dump [--limit N]|tail [N]|dfr [text]}\n");
+#else
         printf("użycie: logrb {stat|clear|dump [--limit N]|tail [N]}\n");
+#endif
         return 0;
     }
 
@@ -160,6 +165,36 @@ static int cmd_logrb(int argc, char** argv)
         return 0;
     }
 
+#if CONFIG_INFRA_LOG_DEFERRED && !CONFIG_INFRA_LOG_DEFERRED_TASK
+    /* Odroczone rekordy (bez taska konsumenta): "DFR:<hex>" na linię — dekoduje host
+       (scripts/log-decode.py --elf build/<app>.elf), "dfr text" formatuje na miejscu. */
+    if (strcmp(argv[1], "dfr") == 0) {
+        const bool text = (argc >= 3 && strcmp(argv[2], "text") == 0);
+        unsigned recs = 0;
+        if (text) {
+            infra_log_dfr_hdr_t h;
+            char msg[192];
+            size_t len = 0;
+            while (infra_log_deferred_read(&h, msg, sizeof(msg), &len)) {
+                printf("(%u) %s: %s\n", (unsigned)h.ts_ms, h.tag ? h.tag : "", msg);
+                recs++;
+            }
+        } else {
+            const uint8_t* r;
+            size_t len = 0;
+            while ((r = infra_log_deferred_peek_raw(&len)) != NULL) {
+                printf("DFR:");
+                for (size_t i = 0; i < len; i++) printf("%02x", r[i]);
+                printf("\n");
+                infra_log_deferred_consume();
+                recs++;
+            }
+        }
+        printf("dfr: %u record(s), dropped=%u\n", recs, (unsigned)infra_log_deferred_drop_count());
+        return 0;
+    }
+#endif
+
     printf("nieznana podkomenda: %s\n", argv[1]);
     return 0;
 #endif // CONFIG_INFRA_LOG_RINGBUF
@@ -300,13 +335,13 @@ static const char* ev_api_hint_(ev_kind_t kind, ev_qos_t qos)
 
 static void evstat_usage_(void)
 {
-    printf("użycie:\n evstat [--reset] | stat [--per-event] | list [...] | show <ID> | check\n");
+    printf("użycie:\n evstat [--reset] | stat [--per-event] | list [...] | show <ID> | check | subs\n");
 }
 
 static unsigned ev_schema_total_(void)
 {
     unsigned n = 0;
-#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, DOC) n++;
+#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, TTL_MS, DOC) n++;
     EV_SCHEMA(X)
 #undef X
     return n;
@@ -317,7 +352,7 @@ typedef struct {
 } ev_schema_row_t;
 
 static const ev_schema_row_t s_schema_rows[] = {
-#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, DOC) { .name = #NAME, .src = (SRC), .code = (uint16_t)(CODE), .kind = EVK_##KIND, .qos = EVQ_##QOS, .flags = (uint16_t)(FLAGS), .doc = (DOC) },
+#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, TTL_MS, DOC) { .name = #NAME, .src = (SRC), .code = (uint16_t)(CODE), .kind = EVK_##KIND, .qos = EVQ_##QOS, .flags = (uint16_t)(FLAGS), .doc = (DOC) },
     EV_SCHEMA(X)
 #undef X
 };
@@ -360,7 +395,7 @@ static int cmd_evstat_list(int argc, char** argv)
         else if (!strcmp(argv[i], "--doc")) c.show_doc = true;
     }
     c.idx = 0; c.shown = 0;
-#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, DOC) evstat_list_one_(&c, #NAME, (SRC), (uint16_t)(CODE), EVK_##KIND, EVQ_##QOS, (DOC));
+#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, TTL_MS, DOC) evstat_list_one_(&c, #NAME, (SRC), (uint16_t)(CODE), EVK_##KIND, EVQ_##QOS, (DOC));
     EV_SCHEMA(X)
 #undef X
     return 0;
@@ -373,11 +408,11 @@ typedef enum {
 typedef struct {
     evshow_mode_t mode;
     unsigned target_id; const char* target_name; ev_src_t target_src; uint16_t target_code;
-    bool found; unsigned id; const char* name; ev_src_t src; uint16_t code; ev_kind_t kind; ev_qos_t qos; uint16_t flags; const char* doc;
+    bool found; unsigned id; const char* name; ev_src_t src; uint16_t code; ev_kind_t kind; ev_qos_t qos; uint16_t flags; uint16_t ttl_ms; const char* doc;
     unsigned idx;
 } evstat_show_ctx_t;
 
-static void evstat_show_one_(evstat_show_ctx_t* c, const char* name, ev_src_t src, uint16_t code, ev_kind_t kind, ev_qos_t qos, uint16_t flags, const char* doc)
+static void evstat_show_one_(evstat_show_ctx_t* c, const char* name, ev_src_t src, uint16_t code, ev_kind_t kind, ev_qos_t qos, uint16_t flags, uint16_t ttl_ms, const char* doc)
 {
     const unsigned id = c->idx++;
     if (c->found) return;
@@ -390,7 +425,7 @@ static void evstat_show_one_(evstat_show_ctx_t* c, const char* name, ev_src_t sr
     }
 
     if (match) {
-        c->found=true; c->id=id; c->name=name; c->src=src; c->code=code; c->kind=kind; c->qos=qos; c->flags=flags; c->doc=doc;
+        c->found=true; c->id=id; c->name=name; c->src=src; c->code=code; c->kind=kind; c->qos=qos; c->flags=flags; c->ttl_ms=ttl_ms; c->doc=doc;
     }
 }
 
@@ -407,14 +442,14 @@ static int cmd_evstat_show(int argc, char** argv)
         c.mode = EVSHOW_BY_NAME; c.target_name = key;
     }
 
-#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, DOC) evstat_show_one_(&c, #NAME, (SRC), (uint16_t)(CODE), EVK_##KIND, EVQ_##QOS, (uint16_t)(FLAGS), (DOC));
+#define X(NAME, SRC, CODE, KIND, QOS, FLAGS, TTL_MS, DOC) evstat_show_one_(&c, #NAME, (SRC), (uint16_t)(CODE), EVK_##KIND, EVQ_##QOS, (uint16_t)(FLAGS), (uint16_t)(TTL_MS), (DOC));
     EV_SCHEMA(X)
 #undef X
 
     if (!c.found) { printf("ERR: not found: %s\n", key); return 1; }
-    printf("EV[%u] %s\n src: %s(0x%04X) code:0x%04X kind:%s\n api: %s\n", 
+    printf("EV[%u] %s\n src: %s(0x%04X) code:0x%04X kind:%s ttl_ms:%u\n api: %s\n", 
            (unsigned)c.id, c.name, ev_src_str_short(c.src), (unsigned)c.src, (unsigned)c.code, 
-           ev_kind_str_short(c.kind), ev_api_hint_(c.kind, c.qos));
+           ev_kind_str_short(c.kind), (unsigned)c.ttl_ms, ev_api_hint_(c.kind, c.qos));
     return 0;
 }
 
@@ -442,17 +477,19 @@ static int cmd_evstat_stat(int argc, char** argv)
     ev_get_stats(&s);
     printf("evstat: subs=%u (max=%u) depth_max=%u total_ev=%u\n",
            (unsigned)s.subs_active, (unsigned)s.subs_max, (unsigned)s.q_depth_max, (unsigned)ev_schema_total_());
-    printf("  posts_ok=%u posts_drop=%u enq_fail=%u\n",
-           (unsigned)s.posts_ok, (unsigned)s.posts_drop, (unsigned)s.enq_fail);
+    printf("  posts_ok=%u posts_drop=%u enq_fail=%u expired=%u lost=%u\n",
+           (unsigned)s.posts_ok, (unsigned)s.posts_drop, (unsigned)s.enq_fail, (unsigned)s.expired, (unsigned)s.lost);
+    printf("  lane_delivered=%u lane_full=%u (EVF_CRITICAL)\n", (unsigned)s.lane_delivered, (unsigned)s.lane_full);
 
     if (per_event) {
         ev_event_stats_t* st = calloc(s_schema_rows_len, sizeof(*st));
         if (st) {
             ev_get_event_stats(st, s_schema_rows_len);
-            printf("id  src   code   posts_ok   name\n");
+            printf("id  src   code   posts_ok   expired    lost       name\n");
             for(unsigned i=0; i<s_schema_rows_len; ++i) {
-                 printf("%-3u %-5s 0x%04X %-10u %s\n", (unsigned)i, ev_src_str_short(s_schema_rows[i].src), 
-                        (unsigned)s_schema_rows[i].code, (unsigned)st[i].posts_ok, s_schema_rows[i].name);
+                 printf("%-3u %-5s 0x%04X %-10u %-10u %-10u %s\n", (unsigned)i, ev_src_str_short(s_schema_rows[i].src), 
+                        (unsigned)s_schema_rows[i].code, (unsigned)st[i].posts_ok, (unsigned)st[i].expired,
+                        (unsigned)st[i].lost, s_schema_rows[i].name);
             }
             free(st);
         }
@@ -460,6 +497,19 @@ static int cmd_evstat_stat(int argc, char** argv)
     return 0;
 }
 
+static int cmd_evstat_subs(int argc, char** argv)
+{
+    (void)argc; (void)argv;
+    ev_sub_stats_t st[EV_MAX_SUBS];
+    const size_t n = ev_get_sub_stats(st, EV_MAX_SUBS);
+    printf("sub depth received   lost       expired    queue\n");
+    for (size_t i = 0; i < n; ++i) {
+        printf("%-3u %-5u %-10u %-10u %-10u %p\n", (unsigned)i, (unsigned)st[i].depth,
+               (unsigned)st[i].received, (unsigned)st[i].lost, (unsigned)st[i].expired, (void*)st[i].q);
+    }
+    return 0;
+}
+
 static int cmd_evstat(int argc, char **argv)
 {
     if (argc < 2) return cmd_evstat_stat(argc, argv);
@@ -467,14 +517,19 @@ static int cmd_evstat(int argc, char **argv)
     if (!strcmp(argv[1], "list")) return cmd_evstat_list(argc-1, argv+1);
     if (!strcmp(argv[1], "show")) return cmd_evstat_show(argc-1, argv+1);
     if (!strcmp(argv[1], "check")) return cmd_evstat_check(argc-1, argv+1);
+    if (!strcmp(argv[1], "subs")) return cmd_evstat_subs(argc-1, argv+1);
     evstat_usage_();
     return 0;
 }
 
 /* ===================== komendy: lpstat ===================== */
-static int cmd_lpstat(int argc, char **argv)
+static void lpstat_usage_(void)
+{
+    printf("użycie: lpstat [stat|classes|owners [age_ms]|hist [json|reset]|check|dump]\n");
+}
+
+static int cmd_lpstat_stat(void)
 {
-    (void)argc; (void)argv;
     lp_stats_t st = {0};
     lp_get_stats(&st);
     printf("lp: total=%u free=%u used=%u peak=%u alloc_ok=%u alloc_fail=%u guard_fail=%u\n",
@@ -482,6 +537,97 @@ static int cmd_lpstat(int argc, char **argv)
            (unsigned)st.slots_used, (unsigned)st.slots_peak_used,
            (unsigned)st.alloc_ok, (unsigned)st.drops_alloc_fail,
            (unsigned)st.guard_failures);
+    if (st.slices_total > 0) {
+        printf("lp: slices total=%u used=%u peak=%u fail=%u\n",
+               (unsigned)st.slices_total, (unsigned)st.slices_used,
+               (unsigned)st.slices_peak_used, (unsigned)st.drops_slice_fail);
+    }
+    printf("lp: fail by prio low=%u normal=%u critical=%u\n",
+           (unsigned)st.drops_prio[LP_PRIO_LOW], (unsigned)st.drops_prio[LP_PRIO_NORMAL],
+           (unsigned)st.drops_prio[LP_PRIO_CRITICAL]);
+    if (st.cow_inplace + st.cow_copies > 0) {
+        printf("lp: make_writable inplace=%u copies=%u\n", (unsigned)st.cow_inplace, (unsigned)st.cow_copies);
+    }
+    if (st.guard_scrubbed > 0) printf("lp: guard scrubbed=%u\n", (unsigned)st.guard_scrubbed);
+    if (st.leaks_detected > 0) printf("lp: leaks detected=%u (lpstat owners)\n", (unsigned)st.leaks_detected);
+    return 0;
+}
+
+static int cmd_lpstat_classes(void)
+{
+    printf("cls cap    slots used peak alloc_ok   spill      fail       eff%%  arena\n");
+    for (size_t k = 0; k < lp_class_count(); k++) {
+        lp_class_stats_t cs;
+        if (!lp_get_class_stats(k, &cs)) continue;
+        const unsigned eff = cs.bytes_cap ? (unsigned)((cs.bytes_req * 100u) / cs.bytes_cap) : 0u;
+        printf("%-3u %-6u %-5u %-4u %-4u %-10u %-10u %-10u %-5u %u\n",
+               (unsigned)k, (unsigned)cs.cap, (unsigned)cs.slots_total, (unsigned)cs.slots_used,
+               (unsigned)cs.slots_peak_used, (unsigned)cs.alloc_ok, (unsigned)cs.alloc_spill,
+               (unsigned)cs.drops_alloc_fail, eff, (unsigned)cs.arena_bytes);
+    }
+
+    printf("cls mag cached hits       misses     spills     hit%%\n");
+    for (size_t k = 0; k < lp_class_count(); k++) {
+        lp_class_stats_t cs;
+        if (!lp_get_class_stats(k, &cs) || cs.mag_cap == 0) continue;
+        const uint64_t n = (uint64_t)cs.mag_hits + cs.mag_misses;
+        printf("%-3u %-3u %-6u %-10u %-10u %-10u %u\n",
+               (unsigned)k, (unsigned)cs.mag_cap, (unsigned)cs.mag_cached, (unsigned)cs.mag_hits,
+               (unsigned)cs.mag_misses, (unsigned)cs.mag_spills,
+               n ? (unsigned)((cs.mag_hits * 100u) / n) : 0u);
+    }
+
+    printf("cls free_gl ring rsv_crit rsv_norm fail_low   fail_norm  fail_crit\n");
+    for (size_t k = 0; k < lp_class_count(); k++) {
+        lp_class_stats_t cs;
+        if (!lp_get_class_stats(k, &cs)) continue;
+        printf("%-3u %-7u %-4u %-8u %-8u %-10u %-10u %u\n",
+               (unsigned)k, (unsigned)cs.free_global, (unsigned)cs.ring_slots, (unsigned)cs.reserve_critical,
+               (unsigned)cs.reserve_normal, (unsigned)cs.drops_prio[LP_PRIO_LOW],
+               (unsigned)cs.drops_prio[LP_PRIO_NORMAL], (unsigned)cs.drops_prio[LP_PRIO_CRITICAL]);
+    }
+    return 0;
+}
+
+static int cmd_lpstat_owners(uint32_t age_ms)
+{
+    lp_owner_stats_t os[32];
+    const size_t n = lp_get_owner_stats(os, sizeof(os) / sizeof(os[0]));
+    if (n == 0) {
+        printf("lp: owner tracking disabled (CONFIG_CORE_LEASEPOOL_OWNERS=0)\n");
+        return 0;
+    }
+
+    printf("owner            slots leases stale oldest_ms  tagged     leaks\n");
+    for (size_t i = 0; i < n; i++) {
+        printf("%-16s %5u %6u %5u %9u  %-10u %u\n",
+               os[i].tag, (unsigned)os[i].slots_held, (unsigned)os[i].leases, (unsigned)os[i].stale,
+               (unsigned)os[i].oldest_ms, (unsigned)os[i].tagged, (unsigned)os[i].leaks);
+    }
+
+    // Skan z wypisaniem nowo wykrytych leasów starszych niż próg (0 = próg z Kconfig).
+    const uint16_t stale = lp_leak_scan(age_ms, true);
+    printf("lp: stale leases=%u\n", (unsigned)stale);
+    return 0;
+}
+
+static int cmd_lpstat(int argc, char **argv)
+{
+    if (argc < 2 || !strcmp(argv[1], "stat")) return cmd_lpstat_stat();
+    if (!strcmp(argv[1], "classes")) return cmd_lpstat_classes();
+    if (!strcmp(argv[1], "hist")) {
+        if (argc > 2 && !strcmp(argv[2], "reset")) {
+            lp_reset_stats();
+            printf("lp: stats and histograms reset\n");
+        } else {
+            lp_hist_dump(argc > 2 && !strcmp(argv[2], "json"));
+        }
+        return 0;
+    }
+    if (!strcmp(argv[1], "owners")) return cmd_lpstat_owners(argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 0u);
+    if (!strcmp(argv[1], "check")) { (void)lp_check(true); return 0; }
+    if (!strcmp(argv[1], "dump")) { lp_dump(); return 0; }
+    lpstat_usage_();
     return 0;
 }
 
@@ -493,6 +639,7 @@ static int cmd_uart_send(int argc, char** argv)
     size_t len = strlen(msg);
     lp_handle_t h = lp_alloc_try((uint32_t)len + 1);
     if (lp_handle_is_valid(h)) {
+        (void)lp_set_owner(h, "cli_uart_send");
         lp_view_t v;
         if (lp_acquire(h, &v)) {
             memcpy(v.ptr, msg, len); ((char*)v.ptr)[len] = 0;
@@ -540,16 +687,16 @@ esp_err_t infra_log_cli_register(void)
 
     ESP_ERROR_CHECK_WITHOUT_ABORT(esp_console_register_help_command());
 
-    const esp_console_cmd_t c_logrb = { .command="logrb", .help="logrb stat|clear|dump|tail", .func=&cmd_logrb };
+    const esp_console_cmd_t c_logrb = { .command="logrb", .help="logrb stat|clear|dump|tail|dfr", .func=&cmd_logrb };
     esp_console_cmd_register(&c_logrb);
 
     const esp_console_cmd_t c_loglvl = { .command="loglvl", .help="loglvl <TAG> <L>", .func=&cmd_loglvl };
     esp_console_cmd_register(&c_loglvl);
 
-    const esp_console_cmd_t c_evstat = { .command="evstat", .help="evstat stat|list|check", .func=&cmd_evstat };
+    const esp_console_cmd_t c_evstat = { .command="evstat", .help="evstat stat|list|check|subs", .func=&cmd_evstat };
     esp_console_cmd_register(&c_evstat);
 
-    const esp_console_cmd_t c_lpstat = { .command="lpstat", .help="lpstat", .func=&cmd_lpstat };
+    const esp_console_cmd_t c_lpstat = { .command="lpstat", .help="lpstat stat|classes|owners [age_ms]|hist [json|reset]|check|dump", .func=&cmd_lpstat };
     esp_console_cmd_register(&c_lpstat);
 
     const esp_console_cmd_t c_uart = { .command="uart_send", .help="uart_send <msg>", .func=&cmd_uart_send };
@@ -5,15 +5,20 @@
  * @details
  *  - Główna funkcja: ::log_write() – pojedyncze formatowanie i emisja do ESP log + (opcjonalnie) do ring-bufora.
  *  - Ring-buffer:
- *      - stałorozmiarowy, circular, chroniony krótką sekcją krytyczną (portMUX),
+ *      - stałorozmiarowy spsc_ring w trybie nadpisywania (najnowsze bajty wypierają najstarsze),
+ *      - zapisy z wielu tasków serializowane krótką sekcją krytyczną (portMUX),
+ *        odczyty (snapshot/tail/stat) bez blokady — migawki sprawdzane sekwencją,
  *      - przechowuje **pełne linie** z nagłówkiem „(ts) tag: ...\n”,
  *      - publiczne API: \ref infra_log_rb_stat \ref infra_log_rb_clear \ref infra_log_rb_snapshot \ref infra_log_rb_tail
+ *  - Tryb odroczony (CONFIG_INFRA_LOG_DEFERRED): log_write zapisuje rekord binarny
+ *    (infra_log_deferred.h), formatowanie i emisja w tasku `log_dfr` albo na hoście.
  *
  * @par Konfiguracja (menuconfig)
  *  - Components → Infrastructure logging:
  *      - Globalny poziom logowania (ERROR..VERBOSE),
  *      - Włącz ring-buffer loggera,
  *      - Rozmiar ring-buffer (KB),
+ *      - Odroczone logowanie binarne (+ task formatujący),
  *      - (opcjonalnie) CLI `logrb` – zob. logging_cli.c.
  *
  * @dot
@@ -29,7 +34,9 @@
 #include "ports/log_port.h"
 #include "esp_log.h"
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 static int s_threshold = 4; /**< 0..4: ERROR..VERBOSE */
 
@@ -58,174 +65,120 @@ static void _init_log_threshold(void) { s_threshold = cfg2level(); }
 #include <stdlib.h>
 #include <string.h>
 #include "infra_log_rb.h"      /* publiczne API – nagłówek dodasz w pkt 4a */
+#include "core/spsc_ring.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
 
-/** @brief Pamięć bufora (circular), rozmiar, indeks zapisu, długość i flaga overflow. */
-static char*  s_rb       = NULL;
-static size_t s_rb_sz    = 0;      /* pojemność (B) */
-static size_t s_w        = 0;      /* indeks zapisu [0..s_rb_sz-1] */
-static size_t s_len      = 0;      /* bieżąca ilość ważnych bajtów (<= s_rb_sz) */
-static bool   s_overflow = false;  /* czy kiedykolwiek nadpisaliśmy najstarsze */
+/** @brief Ring w trybie nadpisywania: trzyma najnowsze bajty, czytelnicy bez blokady. */
+static spsc_ring_t s_rb;
+static bool        s_rb_ok = false;
 
-/** @brief Krótka sekcja krytyczna – wystarcza portMUX (spinlock). */
+/** @brief Serializuje tylko producentów (log_write z wielu tasków); odczyty jej nie biorą. */
 static portMUX_TYPE s_rb_lock = portMUX_INITIALIZER_UNLOCKED;
 
-/** @brief Alokacja pamięci ring‑bufora. */
+/** @brief Alokacja pamięci ring‑bufora (pojemność zaokrąglona w dół do potęgi 2). */
 __attribute__((constructor))
 static void _init_rb(void) {
-  s_rb_sz = (size_t)CONFIG_INFRA_LOG_RINGBUF_KB * 1024u;
-  if (s_rb_sz < 1024u) s_rb_sz = 1024u;  /* sanity */
-  s_rb = (char*)malloc(s_rb_sz);
-  s_w = 0;
-  s_len = 0;
-  s_overflow = false;
-}
-
-/** @brief Zapis pojedynczego bajtu do ringu (wewnątrz sekcji krytycznej). */
-static inline void rb_write_byte(char b) {
-  s_rb[s_w] = b;
-  s_w = (s_w + 1) % s_rb_sz;
-  if (s_len < s_rb_sz) {
-    s_len++;
-  } else {
-    s_overflow = true; /* nadpisujemy najstarsze */
-  }
+  size_t sz = (size_t)CONFIG_INFRA_LOG_RINGBUF_KB * 1024u;
+  if (sz < 1024u) sz = 1024u;  /* sanity */
+  while (sz & (sz - 1u)) sz &= sz - 1u;
+  void* mem = malloc(sz);
+  s_rb_ok = mem && spsc_ring_init(&s_rb, mem, (uint32_t)sz);
 }
 
 /**
  * @brief Zapis sformatowanej linii: "(timestamp_ms) tag: msg...\n".
  * @param tag  Nazwa tagu (może być NULL → pusty).
  * @param lvl  Poziom logowania (nieużywany do bufora; filtr na wejściu).
+ * @param ts   Znacznik czasu wywołania logu (ms).
  * @param msg  Treść linii (bez znaku nowej linii).
  * @param msg_len Długość treści.
  *
- * @note Zapis jest krótki (tylko kopiowanie bajtów). Nagłówek jest lekki.
+ * @note Linia jest składana poza sekcją krytyczną w jeden bufor i trafia do ringu jednym
+ *       spsc_ring_write_overwrite(): jedna publikacja `head` na linię, więc migawka
+ *       nigdy nie widzi samego nagłówka bez treści i '\n'.
  */
-static void rb_push_line(const char* tag, log_level_t lvl, const char* msg, size_t msg_len) {
+static void rb_push_line(const char* tag, log_level_t lvl, uint32_t ts, const char* msg, size_t msg_len) {
   (void)lvl;
-  if (!s_rb || s_rb_sz < 32u || !msg) return;
+  if (!s_rb_ok || !msg) return;
 
-  char   head[64];
-  size_t head_len = 0;
+  /* Nagłówek + treść z log_write()/taska odroczonego (msg[192]) + '\n'. */
+  char   line[64 + 192];
+  size_t len = 0;
 
   {
-    int hn = snprintf(head, sizeof(head), "(%u) %s: ",
-                      (unsigned)esp_log_timestamp(), tag ? tag : "");
+    int hn = snprintf(line, 64, "(%u) %s: ",
+                      (unsigned)ts, tag ? tag : "");
     if (hn < 0) hn = 0;
-    head_len = (size_t)hn;
+    len = ((size_t)hn < 64u) ? (size_t)hn : 63u;
   }
 
-  portENTER_CRITICAL(&s_rb_lock);
-
-  /* nagłówek */
-  for (size_t i = 0; i < head_len; ++i) rb_write_byte(head[i]);
-  /* treść */
-  for (size_t i = 0; i < msg_len;  ++i) rb_write_byte(msg[i]);
-  /* newline */
-  rb_write_byte('\n');
+  const size_t room = sizeof(line) - len - 1u;
+  if (msg_len > room) msg_len = room;
+  memcpy(line + len, msg, msg_len);
+  len += msg_len;
+  line[len++] = '\n';
 
+  portENTER_CRITICAL(&s_rb_lock);
+  spsc_ring_write_overwrite(&s_rb, line, len);
   portEXIT_CRITICAL(&s_rb_lock);
 }
 
-/* ===== Publiczne API ring‑bufora – implementacje (patrz: infra_log_rb.h) ===== */
+/* ===== Publiczne API ring‑bufora – implementacje (patrz: infra_log_rb.h) =====
+ * Odczyty to migawki sprawdzane sekwencją (spsc_ring_copy_overwrite): nie blokują
+ * producentów, a linia nadpisana w trakcie kopii jest odcinana, nie mieszana.
+ */
 
 void infra_log_rb_stat(size_t* capacity, size_t* used, bool* overflowed)
 {
-  size_t cap, len; bool ov;
-  portENTER_CRITICAL(&s_rb_lock);
-  cap = s_rb_sz; len = s_len; ov = s_overflow;
-  portEXIT_CRITICAL(&s_rb_lock);
-  if (capacity)   *capacity   = cap;
-  if (used)       *used       = len;
-  if (overflowed) *overflowed = ov;
+  if (capacity)   *capacity   = s_rb_ok ? spsc_ring_capacity(&s_rb) : 0u;
+  if (used)       *used       = s_rb_ok ? spsc_ring_used(&s_rb) : 0u;
+  if (overflowed) *overflowed = s_rb_ok && spsc_ring_overwritten(&s_rb) > 0u;
 }
 
 void infra_log_rb_clear(void)
 {
-  portENTER_CRITICAL(&s_rb_lock);
-  s_w = 0; s_len = 0; s_overflow = false;
-  portEXIT_CRITICAL(&s_rb_lock);
-}
-
-/** @brief Pomocnicze kopiowanie n bajtów ringu od „start” z zawinięciem. */
-static bool rb_copy_from_start(size_t start, char* out, size_t n)
-{
-  if (!out || !s_rb || n == 0) return false;
-  const size_t first = (n < (s_rb_sz - start)) ? n : (s_rb_sz - start);
-  memcpy(out, s_rb + start, first);
-  if (n > first) memcpy(out + first, s_rb, n - first);
-  return true;
+  if (s_rb_ok) spsc_ring_discard(&s_rb);
 }
 
 bool infra_log_rb_snapshot(char* out, size_t max, size_t* out_len)
 {
-  if (!s_rb || !out || max == 0) return false;
+  if (!s_rb_ok || !out || max == 0) return false;
 
-  size_t len, start; bool ok;
-  portENTER_CRITICAL(&s_rb_lock);
-  len   = s_len;
-  start = (s_w + s_rb_sz - s_len) % s_rb_sz; /* najstarszy */
-  if (len > max) len = max;
-  ok = rb_copy_from_start(start, out, len);
-  portEXIT_CRITICAL(&s_rb_lock);
-
-  if (out_len) *out_len = ok ? len : 0;
-  return ok;
+  const size_t n = spsc_ring_copy_overwrite(&s_rb, out, max, false);
+  if (out_len) *out_len = n;
+  return n != 0u;
 }
 
 bool infra_log_rb_tail(char* out, size_t max, size_t tail_bytes, size_t* out_len)
 {
-  if (!s_rb || !out || max == 0) return false;
+  if (!s_rb_ok || !out || max == 0) return false;
 
-  size_t len, take, start; bool ok;
-  portENTER_CRITICAL(&s_rb_lock);
-  len  = s_len;
-  take = (tail_bytes < len) ? tail_bytes : len;
-  if (take > max) take = max;
-  start = (s_w + s_rb_sz - take) % s_rb_sz; /* bierzemy końcówkę */
-  ok = rb_copy_from_start(start, out, take);
-  portEXIT_CRITICAL(&s_rb_lock);
-
-  if (out_len) *out_len = ok ? take : 0;
-  return ok;
+  const size_t take = (tail_bytes < max) ? tail_bytes : max;
+  const size_t n    = spsc_ring_copy_overwrite(&s_rb, out, take, true);
+  if (out_len) *out_len = n;
+  return n != 0u;
 }
 #endif /* CONFIG_INFRA_LOG_RINGBUF */
 
 /* ================================  LOG WRITE  ================================ */
 
 /**
- * @brief Główny punkt logowania z progiem i poprawnym LOG_FORMAT(...).
- *
- * @param lvl  Poziom (ERROR..VERBOSE).
- * @param tag  Tag ESP-IDF (np. "APP").
- * @param fmt  Format printf‑owy (może być NULL → pusty string).
- * @param ...  Argumenty do @p fmt.
+ * @brief Emisja gotowej treści: ring RAM (opcjonalnie) + `esp_log_write()`.
  *
- * @note
- *  - Wykonujemy **jedno** formatowanie do lokalnego bufora i przekazujemy
- *    je do `esp_log_write()` (przez `LOG_FORMAT(letter, "%s")`), co jest
- *    szybsze i bezpieczne.
- *  - Jeśli włączony ring‑buffer, identyczną treść (z nagłówkiem) zapisujemy w RAM.
+ * Wołana z log_write() (tryb natychmiastowy) albo z taska odroczonego logu —
+ * @p ts to zawsze czas wywołania logu, nie emisji.
  */
-void log_write(log_level_t lvl, const char* tag, const char* fmt, ...)
+static void log_emit(log_level_t lvl, const char* tag, uint32_t ts, const char* msg, size_t msg_len)
 {
-    if ((int)lvl > s_threshold) return;
-
-    char msg[192];
-    va_list ap;
-    va_start(ap, fmt);
-    int nn = vsnprintf(msg, sizeof(msg), fmt ? fmt : "", ap);
-    va_end(ap);
-    if (nn < 0) msg[0] = '\0';
-
 #if CONFIG_INFRA_LOG_RINGBUF
-    rb_push_line(tag, lvl, msg, (size_t)strnlen(msg, sizeof(msg)));
+    rb_push_line(tag, lvl, ts, msg, msg_len);
+#else
+    (void)msg_len;
 #endif
 
     /* Uwaga: LOG_FORMAT(letter, fmt) rozwinie się do:
        "<kolor>#letter (ts) %s: " fmt "\n", więc musimy podać: (ts, tag, msg) */
-    uint32_t ts = esp_log_timestamp();
     const char* t = tag ? tag : "";
 
     switch (lvl) {
@@ -246,3 +199,113 @@ void log_write(log_level_t lvl, const char* tag, const char* fmt, ...)
         break;
     }
 }
+
+#if CONFIG_INFRA_LOG_DEFERRED
+/* ===============================  DEFERRED  =============================== */
+
+#include "infra_log_deferred.h"
+#include "freertos/task.h"
+
+/** @brief Ring rekordów w pamięci statycznej — gotowy przed pierwszym log_write. */
+__attribute__((constructor))
+static void _init_dfr(void) { infra_log_deferred_init(); }
+
+#if CONFIG_INFRA_LOG_DEFERRED_TASK
+enum { DFR_TASK_NONE = 0, DFR_TASK_STARTING, DFR_TASK_RUNNING, DFR_TASK_FAILED };
+static uint8_t s_dfr_task = DFR_TASK_NONE;
+
+/**
+ * @brief Konsument: formatuje rekordy i emituje je jak tryb natychmiastowy.
+ * @note Niski priorytet: formatowanie (vsnprintf per konwersja) i UART idą w czasie bezczynności.
+ */
+static void dfr_task(void* arg)
+{
+  (void)arg;
+  uint32_t dropped_seen = 0;
+  char     msg[192];
+
+  for (;;) {
+    (void)infra_log_deferred_wait_readable(portMAX_DELAY);
+
+    infra_log_dfr_hdr_t h;
+    size_t n = 0;
+    while (infra_log_deferred_read(&h, msg, sizeof(msg), &n)) {
+      log_emit((log_level_t)h.lvl, h.tag, h.ts_ms, msg, n);
+    }
+
+    const uint32_t dropped = infra_log_deferred_drop_count();
+    if (dropped != dropped_seen) {
+      const int dn = snprintf(msg, sizeof(msg), "deferred log: %u record(s) dropped (ring full)",
+                              (unsigned)(dropped - dropped_seen));
+      dropped_seen = dropped;
+      log_emit(LOG_WARN, "LOG", esp_log_timestamp(), msg, (dn > 0) ? (size_t)dn : 0u);
+    }
+  }
+}
+#endif
+
+/**
+ * @brief Czy log_write ma iść ścieżką odroczoną.
+ *
+ * Z taskiem: task startuje przy pierwszym logu (jeden wygrywa CAS); do czasu startu
+ * i po nieudanym xTaskCreate logi idą ścieżką natychmiastową, nic nie ginie.
+ * Bez taska: zawsze — rekordy czekają na `logrb dfr` (dekodowanie na hoście).
+ */
+static bool dfr_active(void)
+{
+#if CONFIG_INFRA_LOG_DEFERRED_TASK
+  uint8_t st = __atomic_load_n(&s_dfr_task, __ATOMIC_ACQUIRE);
+  if (st == DFR_TASK_RUNNING) return true;
+  if (st != DFR_TASK_NONE) return false;
+  if (!__atomic_compare_exchange_n(&s_dfr_task, &st, DFR_TASK_STARTING, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+    return false;
+  }
+  const bool ok = xTaskCreate(dfr_task, "log_dfr", 3072, NULL, tskIDLE_PRIORITY + 1, NULL) == pdPASS;
+  __atomic_store_n(&s_dfr_task, ok ? DFR_TASK_RUNNING : DFR_TASK_FAILED, __ATOMIC_RELEASE);
+  return ok;
+#else
+  return true;
+#endif
+}
+#endif /* CONFIG_INFRA_LOG_DEFERRED */
+
+/**
+ * @brief Główny punkt logowania z progiem i poprawnym LOG_FORMAT(...).
+ *
+ * @param lvl  Poziom (ERROR..VERBOSE).
+ * @param tag  Tag ESP-IDF (np. "APP").
+ * @param fmt  Format printf‑owy (może być NULL → pusty string).
+ * @param ...  Argumenty do @p fmt.
+ *
+ * @note
+ *  - Wykonujemy **jedno** formatowanie do lokalnego bufora i przekazujemy
+ *    je do `esp_log_write()` (przez `LOG_FORMAT(letter, "%s")`), co jest
+ *    szybsze i bezpieczne.
+ *  - Jeśli włączony ring‑buffer, identyczną treść (z nagłówkiem) zapisujemy w RAM.
+ *  - CONFIG_INFRA_LOG_DEFERRED: bez formatowania — rekord binarny (adres formatu i tagu
+ *    + surowe argumenty) do ringu, format w tasku niskiego priorytetu albo na hoście
+ *    (zob. infra_log_deferred.h; fmt i tag muszą być statyczne).
+ */
+void log_write(log_level_t lvl, const char* tag, const char* fmt, ...)
+{
+    if ((int)lvl > s_threshold) return;
+
+    va_list ap;
+#if CONFIG_INFRA_LOG_DEFERRED
+    if (dfr_active()) {
+        va_start(ap, fmt);
+        (void)infra_log_deferred_vwrite((uint8_t)lvl, esp_log_timestamp(), tag, fmt, ap);
+        va_end(ap);
+        return;
+    }
+#endif
+
+    char msg[192];
+    va_start(ap, fmt);
+    int nn = vsnprintf(msg, sizeof(msg), fmt ? fmt : "", ap);
+    va_end(ap);
+    if (nn < 0) msg[0] = '\0';
+
+    log_emit(lvl, tag, esp_log_timestamp(), msg, (size_t)strnlen(msg, sizeof(msg)));
+}
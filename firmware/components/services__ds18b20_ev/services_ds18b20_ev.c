@@ -143,8 +143,10 @@ static void process_sm(void)
                 /* 12-bit: 1 LSB = 0.0625°C */
                 float temp_c = raw * 0.0625f;
                 
-                lp_handle_t h = lp_alloc_try(sizeof(ds18_result_t));
+                /* Pomiar jest rzadki i mały: CRITICAL sięga do rezerwy, której nie zje zalew UART. */
+                lp_handle_t h = lp_alloc_try_prio(sizeof(ds18_result_t), LP_PRIO_CRITICAL);
                 if (lp_handle_is_valid(h)) {
+                    (void)lp_set_owner(h, "ds18");
                     lp_view_t v; lp_acquire(h, &v);
                     ds18_result_t* r = (ds18_result_t*)v.ptr;
                     r->rom_code = 0; // SKIP_ROM used
@@ -181,7 +183,7 @@ static void ds18_task(void* arg)
     {
         /* 2. Odbiór z timeoutem (Heartbeat 1000ms) */
         /* Dzięki temu task budzi się min. raz na sekundę, żeby zresetować psa */
-        if (xQueueReceive(s_q, &m, pdMS_TO_TICKS(1000)) == pdTRUE)
+        if (ev_bus_recv(s_bus, s_q, &m, pdMS_TO_TICKS(1000)))
         {
             /* 3. Reset psa po odebraniu zdarzenia (task żyje i przetwarza) */
             wdt_reset();
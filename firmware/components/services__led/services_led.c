@@ -53,7 +53,7 @@ static void led_task(void* arg)
     for (;;) {
         /* 2. Odbiór zdarzeń z timeoutem (Heartbeat pattern) */
         /* Timeout 1000ms gwarantuje, że task "zamelduje się" psu nawet przy braku pracy */
-        if (xQueueReceive(s_q, &msg, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        if (ev_bus_recv(s_bus, s_q, &msg, pdMS_TO_TICKS(1000))) {
             
             /* 3. Reset WDT (Task przetwarza dane -> żyje) */
             wdt_reset();
@@ -14,6 +14,11 @@ typedef struct {
     char pattern_char; // Np. '\n'
 } uart_svc_cfg_t;
 
+// Kody błędów publikowane w EV_UART_ERROR (a0)
+enum {
+    UART_SVC_ERR_TX_GAP = 1, // wykryto lukę w seq EV_UART_TX_REQ (a1 = 0)
+};
+
 // Startuje asynchroniczny serwis UART (task RX + subskrypcja TX)
 bool services_uart_start(const ev_bus_t* bus, const uart_svc_cfg_t* cfg);
 
@@ -1,3 +1,4 @@
+#include "sdkconfig.h"
 #include "services_uart.h"
 #include "ports/uart_port.h"
 #include "ports/wdt_port.h"
@@ -12,6 +13,10 @@
 
 static const char* TAG = "SVC_UART";
 
+// Maks. segmentów leasa łańcuchowego: cały bufor RX (+1 B terminatora) w najmniejszych slotach (klasa 0).
+#define UART_RX_BUF_SIZE  2048
+#define UART_RX_MAX_SEGS  ((UART_RX_BUF_SIZE + 1) / CONFIG_CORE_LEASEPOOL_SLOT_BYTES + 1)
+
 typedef struct {
     int type;
     size_t size;
@@ -22,6 +27,89 @@ static const ev_bus_t* s_bus = NULL;
 static QueueSetHandle_t s_qset = NULL;
 static ev_queue_t s_tx_sub_q = NULL;
 static TaskHandle_t s_task = NULL;
+static char s_pattern_char = 0;
+#if defined(CONFIG_SERVICES_UART_RX_LEASE_RING) && CONFIG_SERVICES_UART_RX_LEASE_RING
+static lp_ring_t s_rx_ring;
+static bool s_rx_ring_ok = false;
+#endif
+
+static void post_rx_frame_(lp_handle_t parent, uint32_t off, uint32_t len)
+{
+    lp_handle_t f = lp_slice(parent, off, len);
+    if (!lp_handle_is_valid(f)) {
+        ESP_LOGW(TAG, "RX frame drop: no slice descriptors (%u bytes)", (unsigned)len);
+        return;
+    }
+    ev_bus_post_lease(s_bus, EV_SRC_UART, EV_UART_FRAME, f, (uint16_t)len);
+}
+
+/*
+ * Paczka RX z kilkoma ramkami (pattern_char jako terminator) -> osobne EV_UART_FRAME
+ * jako slice'y tego samego leasa (bez kopiowania). Jedna ramka / brak patternu -> cały lease.
+ * Przejmuje referencję producenta do h.
+ */
+static void publish_rx_frames_(lp_handle_t h, const lp_iov_t* iov, size_t nseg, uint32_t len)
+{
+    uint32_t start = 0;
+    uint32_t pos = 0;
+
+    if (s_pattern_char != 0) {
+        for (size_t i = 0; i < nseg && pos < len; i++) {
+            const uint8_t* p = iov[i].ptr;
+            const uint32_t n = (len - pos < iov[i].cap) ? (len - pos) : iov[i].cap;
+            for (uint32_t j = 0; j < n; j++, pos++) {
+                if (p[j] != (uint8_t)s_pattern_char) continue;
+                if (start == 0 && pos + 1 == len) continue; // jedyna ramka = cały lease
+                post_rx_frame_(h, start, pos + 1 - start);
+                start = pos + 1;
+            }
+        }
+    }
+
+    if (start == 0) {
+        ev_bus_post_lease(s_bus, EV_SRC_UART, EV_UART_FRAME, h, (uint16_t)len);
+        return;
+    }
+    if (start < len) post_rx_frame_(h, start, len - start); // ogon bez terminatora
+
+    lp_release(h); // ramki (slice'y) trzymają własne referencje rodzica
+}
+
+#if defined(CONFIG_SERVICES_UART_RX_LEASE_RING) && CONFIG_SERVICES_UART_RX_LEASE_RING
+/*
+ * Tryb ringu: paczka RX do kolejnych leasów ringu (segment = osobny EV_UART_FRAME).
+ * Zwraca liczbę przeczytanych bajtów; mniej niż len = ring pełny (konsument nie nadąża)
+ * albo błąd odczytu — resztę obsłuży ścieżka leasa łańcuchowego.
+ */
+static size_t rx_into_ring_(size_t len)
+{
+    size_t done = 0;
+    while (done < len) {
+        lp_handle_t h = lp_ring_acquire(&s_rx_ring);
+        if (!lp_handle_is_valid(h)) break;
+
+        lp_iov_t v;
+        if (!lp_acquire(h, &v) || v.cap < 2u) {
+            lp_release(h);
+            break;
+        }
+        const size_t want = (len - done < v.cap - 1u) ? (len - done) : (v.cap - 1u); // +1 na terminator
+        const int r = uart_port_read(s_port, v.ptr, want, 0);
+        if (r <= 0) {
+            lp_release(h);
+            break;
+        }
+        ((uint8_t*)v.ptr)[r] = 0;
+        lp_commit(h, (uint32_t)r);
+        (void)lp_set_owner(h, "uart_rx");
+
+        publish_rx_frames_(h, &v, 1, (uint32_t)r);
+        done += (size_t)r;
+        if ((size_t)r < want) break;
+    }
+    return done;
+}
+#endif
 
 static void handle_rx_event(uart_evt_t* evt)
 {
@@ -43,8 +131,17 @@ static void handle_rx_event(uart_evt_t* evt)
     // Jeśli bufor pusty, wychodzimy.
     if (buffered_len == 0) return;
 
-    // Alokacja slotu na CAŁĄ dostępną paczkę (+1 na null-terminator)
-    lp_handle_t h = lp_alloc_try((uint32_t)buffered_len + 1);
+#if defined(CONFIG_SERVICES_UART_RX_LEASE_RING) && CONFIG_SERVICES_UART_RX_LEASE_RING
+    if (s_rx_ring_ok) {
+        buffered_len -= rx_into_ring_(buffered_len);
+        if (buffered_len == 0) return;
+    }
+#endif
+
+    // Alokacja leasa na CAŁĄ dostępną paczkę (+1 na null-terminator).
+    // Większa niż slot -> lease łańcuchowy (segmenty z wolnych slotów, bez kopiowania).
+    // Ruch masowy = LP_PRIO_LOW: nie sięga po rezerwy NORMAL/CRITICAL (np. DS18).
+    lp_handle_t h = lp_alloc_chain_try_prio((uint32_t)buffered_len + 1, LP_PRIO_LOW);
     if (!lp_handle_is_valid(h)) {
         ESP_LOGE(TAG, "RX Drop: LeasePool full (%u bytes)", (unsigned)buffered_len);
         // Opróżnij bufor w nicość, żeby nie zatkać UART
@@ -57,34 +154,57 @@ static void handle_rx_event(uart_evt_t* evt)
         }
         return;
     }
+    (void)lp_set_owner(h, "uart_rx");
+
+    // Odczyt danych ("Zero-Copy" prosto do segmentów)
+    lp_iov_t iov[UART_RX_MAX_SEGS];
+    const size_t nseg = lp_acquire_iov(h, iov, UART_RX_MAX_SEGS);
+    if (nseg == 0 || nseg > UART_RX_MAX_SEGS) {
+        ESP_LOGE(TAG, "RX Drop: bad lease chain (segs=%u)", (unsigned)nseg);
+        lp_release(h);
+        return;
+    }
+
+    // Czytamy dokładnie tyle, ile namierzyliśmy (timeout 0, bo dane są w RAM)
+    size_t read = 0;
+    size_t seg = 0;
+    while (read < buffered_len && seg < nseg) {
+        const size_t want = (buffered_len - read < iov[seg].cap) ? (buffered_len - read) : iov[seg].cap;
+        const int r = uart_port_read(s_port, iov[seg].ptr, want, 0);
+        if (r <= 0) break;
+        read += (size_t)r;
+        if ((size_t)r < want) break;
+        seg++;
+    }
 
-    // Odczyt danych ("Zero-Copy" do slotu)
-    lp_view_t v;
-    if (lp_acquire(h, &v)) {
-        // Czytamy dokładnie tyle, ile namierzyliśmy (timeout 0, bo dane są w RAM)
-        int read = uart_port_read(s_port, v.ptr, buffered_len, 0);
-        if (read > 0) {
-            ((uint8_t*)v.ptr)[read] = 0; // Null-terminator dla wygody
-            lp_commit(h, read);
-            
-            // Wysyłamy LEASE z poprawnym źródłem
-            ev_bus_post_lease(s_bus, EV_SRC_UART, EV_UART_FRAME, h, read);
-        } else {
-            lp_release(h); // Błąd odczytu? Zwalniamy slot.
+    if (read > 0) {
+        // Null-terminator dla wygody (za danymi, w segmencie, w którym się kończą)
+        size_t off = read;
+        for (size_t i = 0; i < nseg; i++) {
+            if (off < iov[i].cap) { ((uint8_t*)iov[i].ptr)[off] = 0; break; }
+            off -= iov[i].cap;
         }
+        lp_commit(h, (uint32_t)read);
+
+        // Wysyłamy LEASE (ramka lub slice ramki) z poprawnym źródłem (konsument: lp_acquire_iov)
+        publish_rx_frames_(h, iov, nseg, (uint32_t)read);
     } else {
-        lp_release(h);
+        lp_release(h); // Błąd odczytu? Zwalniamy lease.
     }
 }
 
 static void handle_tx_request(ev_msg_t* m)
 {
     lp_handle_t h = lp_unpack_handle_u32(m->a0);
-    lp_view_t v;
+    lp_iov_t iov[UART_RX_MAX_SEGS];
 
-    if (lp_acquire(h, &v)) {
-        if (v.ptr && v.len > 0) {
-            uart_port_write(s_port, v.ptr, v.len);
+    // Lease pojedynczy albo łańcuchowy — segmenty wysyłane po kolei.
+    const size_t nseg = lp_acquire_iov(h, iov, UART_RX_MAX_SEGS);
+    if (nseg > 0) {
+        for (size_t i = 0; i < nseg && i < UART_RX_MAX_SEGS; i++) {
+            if (iov[i].ptr && iov[i].len > 0) {
+                uart_port_write(s_port, iov[i].ptr, iov[i].len);
+            }
         }
         lp_release(h);
     } else {
@@ -116,12 +236,21 @@ static void uart_worker_task(void* arg)
                 handle_rx_event(&evt);
             }
         }
-        else if (active_q == s_tx_sub_q) {
-            ev_msg_t msg;
-            if (xQueueReceive(active_q, &msg, 0)) {
-                if (msg.code == EV_UART_TX_REQ) {
-                    handle_tx_request(&msg);
-                }
+        else {
+            // Kolejka subskrypcji albo jej pas priorytetowy: jeden token = jeden element.
+            ev_msg_t msg = {0};
+            ev_recv_info_t info = {0};
+            // TTL: zaległe EV_UART_TX_REQ są odrzucane (i zwalniane) w ev_recv_set().
+            const bool fresh = ev_bus_recv_set(s_bus, s_tx_sub_q, active_q, &msg, &info);
+            if (info.lost > 0) {
+                // Luka w seq: ramki TX przepadły po drodze (kolejka pełna), także gdy
+                // następna ramka się przeterminowała. Strona odbiorcza musi się
+                // zresynchronizować — sygnalizujemy to.
+                ESP_LOGW(TAG, "TX stream gap: lost=%u (seq=%u)", (unsigned)info.lost, (unsigned)msg.seq);
+                ev_bus_post(s_bus, EV_SRC_UART, EV_UART_ERROR, UART_SVC_ERR_TX_GAP, 0);
+            }
+            if (fresh && msg.code == EV_UART_TX_REQ) {
+                handle_tx_request(&msg);
             }
         }
         
@@ -144,7 +273,7 @@ bool services_uart_start(const ev_bus_t* bus, const uart_svc_cfg_t* cfg)
         .tx_pin = cfg->tx_pin,
         .rx_pin = cfg->rx_pin,
         .baud_rate = cfg->baud_rate,
-        .rx_buf_size = 2048, // Zwiększony bufor RX dla batchingu
+        .rx_buf_size = UART_RX_BUF_SIZE, // Zwiększony bufor RX dla batchingu
         .tx_buf_size = 1024
     };
 
@@ -154,14 +283,19 @@ bool services_uart_start(const ev_bus_t* bus, const uart_svc_cfg_t* cfg)
     }
 
     if (cfg->pattern_char != 0) {
+        s_pattern_char = cfg->pattern_char;
         uart_port_enable_pattern_det(s_port, cfg->pattern_char);
     }
 
-    if (!ev_bus_subscribe(s_bus, &s_tx_sub_q, 8)) {
-        ESP_LOGE(TAG, "Failed to subscribe to EV bus");
-        return false;
+#if defined(CONFIG_SERVICES_UART_RX_LEASE_RING) && CONFIG_SERVICES_UART_RX_LEASE_RING
+    s_rx_ring_ok = lp_ring_init(&s_rx_ring, CONFIG_SERVICES_UART_RX_RING_SEG_BYTES, CONFIG_SERVICES_UART_RX_RING_SLOTS);
+    if (!s_rx_ring_ok) {
+        ESP_LOGW(TAG, "RX lease ring unavailable (%u x %u B), using chain leases",
+                 (unsigned)CONFIG_SERVICES_UART_RX_RING_SLOTS, (unsigned)CONFIG_SERVICES_UART_RX_RING_SEG_BYTES);
     }
+#endif
 
+    // Zbiór: 20 zdarzeń drivera UART + subskrypcja (8) i jej pas priorytetowy.
     s_qset = xQueueCreateSet(16 + 20);
     QueueHandle_t uart_q = uart_port_get_event_queue(s_port);
 
@@ -171,7 +305,12 @@ bool services_uart_start(const ev_bus_t* bus, const uart_svc_cfg_t* cfg)
     }
 
     xQueueAddToSet(uart_q, s_qset);
-    xQueueAddToSet(s_tx_sub_q, s_qset);
+
+    // Subskrypcja na zbiorze: kolejka i pas dodawane przez bus, odbiór ev_bus_recv_set().
+    if (!ev_bus_subscribe_set(s_bus, &s_tx_sub_q, 8, s_qset)) {
+        ESP_LOGE(TAG, "Failed to subscribe to EV bus");
+        return false;
+    }
 
     if (xTaskCreate(uart_worker_task, "svc_uart", 4096, NULL, 5, &s_task) != pdPASS) {
         ESP_LOGE(TAG, "Task creation failed");
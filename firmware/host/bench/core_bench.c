@@ -0,0 +1,1481 @@
+/*
+ * core_bench — benchmarki core__ev / core__leasepool / core__spsc_ring (+ kodek odroczonego logu) na hoście.
+ *
+ * Wyjście: JSON Lines na stdout (jeden obiekt na pomiar), np.
+ *   {"bench":"ev_post","subs":4,"ops":2000000,"ns":...,"ns_per_op":...,"ops_per_s":...}
+ * Pierwsza linia ("bench":"meta") opisuje konfigurację buildu.
+ *
+ * Użycie:
+ *   core_bench [--quick] [--filter <prefix>]
+ */
+#include "sdkconfig.h"
+#include "core_ev.h"
+#include "core/leasepool.h"
+#include "core/spsc_ring.h"
+#include "core/mpsc_ring.h"
+#include "infra_log_deferred.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    bool        quick;
+    const char* filter;
+} bench_opts_t;
+
+static bench_opts_t s_opt;
+
+static uint64_t now_ns_(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool enabled_(const char* name)
+{
+    return !s_opt.filter || strncmp(name, s_opt.filter, strlen(s_opt.filter)) == 0;
+}
+
+static uint64_t scale_(const uint64_t full)
+{
+    return s_opt.quick ? (full / 64u ? full / 64u : 1u) : full;
+}
+
+/* params: gotowy fragment JSON (bez nawiasów), np. "\"subs\":4". bytes=0 -> bez mb_per_s. */
+static void report_(const char* bench, const char* params, const uint64_t ops, const uint64_t ns, const uint64_t bytes)
+{
+    const double ns_per_op = ops ? (double)ns / (double)ops : 0.0;
+    const double ops_per_s = ns ? (double)ops * 1e9 / (double)ns : 0.0;
+
+    printf("{\"bench\":\"%s\"%s%s,\"ops\":%llu,\"ns\":%llu,\"ns_per_op\":%.2f,\"ops_per_s\":%.0f",
+           bench, params[0] ? "," : "", params,
+           (unsigned long long)ops, (unsigned long long)ns, ns_per_op, ops_per_s);
+    if (bytes) {
+        printf(",\"mb_per_s\":%.1f", ns ? (double)bytes * 1e3 / (double)ns : 0.0);
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+/* ===================== core__ev ===================== */
+
+enum { EV_BENCH_DEPTH = 64, EV_BENCH_BATCH = 32 };
+
+static size_t ev_open_subs_(ev_queue_t* qs, const size_t n)
+{
+    ev_init();
+    for (size_t i = 0; i < n; i++) {
+        if (!ev_subscribe(&qs[i], EV_BENCH_DEPTH)) return i;
+    }
+    return n;
+}
+
+static void ev_close_subs_(ev_queue_t* qs, const size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        ev_unsubscribe(qs[i]);
+        vQueueDelete(qs[i]);
+    }
+}
+
+/* Fan-out COPY: post (timed) + odbiór wszystkimi subskrybentami (timed osobno). */
+static void bench_ev_post_(const size_t subs)
+{
+    ev_queue_t qs[EV_MAX_SUBS];
+    const size_t n = ev_open_subs_(qs, subs);
+    if (n != subs) {
+        ev_close_subs_(qs, n);
+        return;
+    }
+
+    const uint64_t iters = scale_(2000000u) / EV_BENCH_BATCH * EV_BENCH_BATCH;
+    uint64_t post_ns = 0, recv_ns = 0, recv_ops = 0, fails = 0;
+    ev_msg_t m;
+
+    for (uint64_t i = 0; i < iters; i += EV_BENCH_BATCH) {
+        const uint64_t t0 = now_ns_();
+        for (uint32_t k = 0; k < EV_BENCH_BATCH; k++) {
+            if (!ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, k & 1u)) fails++;
+        }
+        const uint64_t t1 = now_ns_();
+        for (size_t s = 0; s < n; s++) {
+            while (ev_recv(qs[s], &m, 0)) recv_ops++;
+        }
+        recv_ns += now_ns_() - t1;
+        post_ns += t1 - t0;
+    }
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"subs\":%u,\"fails\":%llu", (unsigned)subs, (unsigned long long)fails);
+    report_("ev_post", params, iters, post_ns, 0);
+    snprintf(params, sizeof(params), "\"subs\":%u", (unsigned)subs);
+    report_("ev_recv", params, recv_ops, recv_ns, 0);
+
+    ev_close_subs_(qs, n);
+}
+
+/* Fan-out LEASE: alloc + zapis + post_lease (timed), odbiór z lp_release() u każdego subskrybenta. */
+static void bench_ev_post_lease_(const size_t subs)
+{
+    ev_queue_t qs[EV_MAX_SUBS];
+    lp_init();
+    const size_t n = ev_open_subs_(qs, subs);
+    if (n != subs) {
+        ev_close_subs_(qs, n);
+        return;
+    }
+
+    // Partia nie może przekroczyć slotów dostępnych dla NORMAL (każdy post trzyma slot do odbioru).
+    lp_class_stats_t cs = {0};
+    (void)lp_get_class_stats(0, &cs);
+    const uint32_t normal = (uint32_t)(cs.slots_total - cs.reserve_critical);
+    const uint32_t batch = (normal < EV_BENCH_BATCH) ? normal : EV_BENCH_BATCH;
+    const uint64_t iters = scale_(1000000u) / batch * batch;
+    uint64_t post_ns = 0, fails = 0;
+    ev_msg_t m;
+
+    for (uint64_t i = 0; i < iters; i += batch) {
+        const uint64_t t0 = now_ns_();
+        for (uint32_t k = 0; k < batch; k++) {
+            lp_handle_t h = lp_alloc_try(16);
+            lp_view_t v;
+            if (!lp_acquire(h, &v)) {
+                fails++;
+                continue;
+            }
+            memset(v.ptr, (int)k, 16);
+            lp_commit(h, 16);
+            if (!ev_post_lease(EV_SRC_LOG, EV_LOG_NEW, h, 16)) fails++;
+        }
+        post_ns += now_ns_() - t0;
+
+        for (size_t s = 0; s < n; s++) {
+            while (ev_recv(qs[s], &m, 0)) lp_release(lp_unpack_handle_u32(m.a0));
+        }
+    }
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"subs\":%u,\"fails\":%llu", (unsigned)subs, (unsigned long long)fails);
+    report_("ev_post_lease", params, iters, post_ns, 0);
+
+    ev_close_subs_(qs, n);
+}
+
+static int cmp_u64_(const void* a, const void* b)
+{
+    const uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * EVF_CRITICAL przy nasyceniu: kolejka główna pełna (EV_BENCH_DEPTH zdarzeń zwykłych), potem
+ * jedno krytyczne. Z pasem priorytetowym jest doręczane od razu; bez pasa (wariant _ev_nolane)
+ * DROP_NEW je odrzuca. Opóźnienie liczone tylko dla doręczonych.
+ */
+static void bench_ev_crit_latency_(void)
+{
+    ev_queue_t q;
+    if (ev_open_subs_(&q, 1) != 1) return;
+
+    const size_t rounds = (size_t)scale_(20000u);
+    uint64_t* lat = malloc(rounds * sizeof(*lat));
+    if (!lat) {
+        ev_close_subs_(&q, 1);
+        return;
+    }
+
+    ev_msg_t m;
+    uint64_t total = 0, delivered = 0, dropped = 0, not_full = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        for (uint32_t k = 0; k < EV_BENCH_DEPTH; k++) (void)ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, 4, 0);
+        if (uxQueueSpacesAvailable(q) != 0) not_full++;
+
+        const uint64_t t0 = now_ns_();
+        (void)ev_post(EV_SRC_I2C, EV_I2C_ERROR, (uint32_t)r, 0);
+        bool got = false;
+        while (ev_recv(q, &m, 0)) {
+            if (m.code == EV_I2C_ERROR) {
+                got = true;
+                break;
+            }
+        }
+        if (got) {
+            lat[delivered] = now_ns_() - t0;
+            total += lat[delivered];
+            delivered++;
+        } else {
+            dropped++;
+        }
+
+        while (ev_recv(q, &m, 0)) {
+        }
+    }
+
+    uint64_t p50 = 0, p99 = 0, max = 0;
+    if (delivered > 0) {
+        qsort(lat, (size_t)delivered, sizeof(*lat), cmp_u64_);
+        p50 = lat[delivered / 2];
+        p99 = lat[(delivered * 99u) / 100u];
+        max = lat[delivered - 1];
+    }
+    char params[200];
+    snprintf(params, sizeof(params),
+             "\"backlog\":%u,\"lane_depth\":%u,\"delivered\":%llu,\"dropped\":%llu,\"not_full\":%llu,"
+             "\"p50_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu",
+             (unsigned)EV_BENCH_DEPTH, (unsigned)EV_PRIO_LANE_DEPTH, (unsigned long long)delivered,
+             (unsigned long long)dropped, (unsigned long long)not_full, (unsigned long long)p50,
+             (unsigned long long)p99, (unsigned long long)max);
+    report_("ev_crit_latency", params, delivered, total, 0);
+
+    free(lat);
+    ev_close_subs_(&q, 1);
+}
+
+/* ===================== core__leasepool ===================== */
+
+static void bench_lp_alloc_release_(void)
+{
+    lp_init();
+    const uint64_t iters = scale_(5000000u);
+    uint64_t fails = 0;
+
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < iters; i++) {
+        lp_handle_t h = lp_alloc_try(32);
+        if (h.idx == lp_invalid_handle().idx) {
+            fails++;
+            continue;
+        }
+        lp_release(h);
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"want\":32,\"fails\":%llu", (unsigned long long)fails);
+    report_("lp_alloc_release", params, iters, ns, 0);
+}
+
+/*
+ * Koszt guardu przy pełnym slocie: alloc(cap) + zapis ≤64 B + release. W trybie SCRUB co 64
+ * operacje krok lp_scrub_step() (budżet domyślny) — emulacja zadania w tle, wliczona w czas.
+ */
+static const char* lp_poison_name_(void)
+{
+#if !CONFIG_CORE_LEASEPOOL_GUARD
+    return "none";
+#elif defined(CONFIG_CORE_LEASEPOOL_GUARD_POISON_SAMPLED) && CONFIG_CORE_LEASEPOOL_GUARD_POISON_SAMPLED
+    return "sampled";
+#elif defined(CONFIG_CORE_LEASEPOOL_GUARD_POISON_SCRUB) && CONFIG_CORE_LEASEPOOL_GUARD_POISON_SCRUB
+    return "scrub";
+#elif defined(CONFIG_CORE_LEASEPOOL_GUARD_POISON_OFF) && CONFIG_CORE_LEASEPOOL_GUARD_POISON_OFF
+    return "off";
+#else
+    return "full";
+#endif
+}
+
+static void bench_lp_guard_(void)
+{
+    lp_init();
+    lp_reset_stats();
+    const uint64_t iters = scale_(2000000u);
+    uint64_t fails = 0;
+
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < iters; i++) {
+        lp_handle_t h = lp_alloc_try(CONFIG_CORE_LEASEPOOL_SLOT_BYTES);
+        lp_view_t v;
+        if (!lp_acquire(h, &v)) {
+            fails++;
+            continue;
+        }
+        const uint32_t n = v.cap < 64u ? v.cap : 64u;
+        memset(v.ptr, (int)i, n);
+        lp_commit(h, n);
+        lp_release(h);
+        if ((i & 63u) == 0u) (void)lp_scrub_step(0);
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    char params[128];
+    snprintf(params, sizeof(params), "\"poison\":\"%s\",\"cap\":%u,\"scrubbed\":%u,\"fails\":%llu",
+             lp_poison_name_(), (unsigned)CONFIG_CORE_LEASEPOOL_SLOT_BYTES, (unsigned)st.guard_scrubbed,
+             (unsigned long long)fails);
+    report_("lp_guard", params, iters, ns, 0);
+}
+
+/* Cała pula naraz (CRITICAL — łącznie z rezerwami): alloc wszystkich slotów, potem release wszystkich (LIFO). */
+static void bench_lp_burst_(void)
+{
+    lp_init();
+    enum { N = CONFIG_CORE_LEASEPOOL_SLOTS }; // klasa 0
+    lp_handle_t hs[N];
+    const uint64_t rounds = scale_(200000u);
+
+    const uint64_t t0 = now_ns_();
+    for (uint64_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < N; i++) hs[i] = lp_alloc_try_prio(CONFIG_CORE_LEASEPOOL_SLOT_BYTES, LP_PRIO_CRITICAL);
+        for (size_t i = N; i-- > 0;) lp_release(hs[i]);
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"slots\":%u", (unsigned)N);
+    report_("lp_burst", params, rounds * N * 2u, ns, 0);
+}
+
+/*
+ * Obciążenie mieszane (rozkład z firmware): 50% ~12 B (wynik DS18), 30% 40..120 B (linie logu),
+ * 20% 200..1000 B (ramki UART). Okno FIFO 16 żywych leasów; mierzy alloc+release, porażki
+ * i efektywność pamięci (bajty żądane / pojemność przydzielonych slotów).
+ */
+static uint32_t lp_mixed_size_(uint32_t* rng)
+{
+    *rng = *rng * 1664525u + 1013904223u;
+    const uint32_t r = *rng >> 8;
+    const uint32_t pct = r % 100u;
+    if (pct < 50u) return 12u;
+    if (pct < 80u) return 40u + (r >> 8) % 81u;
+    return 200u + (r >> 8) % 801u;
+}
+
+static void bench_lp_mixed_(void)
+{
+    lp_init();
+    enum { WINDOW = 16 };
+    lp_handle_t live[WINDOW];
+    for (size_t i = 0; i < WINDOW; i++) live[i] = lp_invalid_handle();
+
+    const uint64_t iters = scale_(2000000u);
+    uint32_t rng = 12345u;
+    uint64_t fails = 0;
+
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < iters; i++) {
+        const size_t w = (size_t)(i % WINDOW);
+        if (lp_handle_is_valid(live[w])) lp_release(live[w]);
+        live[w] = lp_alloc_try(lp_mixed_size_(&rng));
+        if (!lp_handle_is_valid(live[w])) fails++;
+    }
+    const uint64_t ns = now_ns_() - t0;
+    for (size_t i = 0; i < WINDOW; i++) {
+        if (lp_handle_is_valid(live[i])) lp_release(live[i]);
+    }
+
+    uint64_t req = 0, cap = 0, spill = 0, arena = 0;
+    for (size_t k = 0; k < lp_class_count(); k++) {
+        lp_class_stats_t cs;
+        if (!lp_get_class_stats(k, &cs)) continue;
+        req += cs.bytes_req;
+        cap += cs.bytes_cap;
+        spill += cs.alloc_spill;
+        arena += cs.arena_bytes;
+    }
+
+    char params[160];
+    snprintf(params, sizeof(params),
+             "\"classes\":%u,\"arena_bytes\":%llu,\"fails\":%llu,\"spill\":%llu,\"efficiency\":%.3f",
+             (unsigned)lp_class_count(), (unsigned long long)arena, (unsigned long long)fails,
+             (unsigned long long)spill, cap ? (double)req / (double)cap : 0.0);
+    report_("lp_mixed", params, iters, ns, 0);
+}
+
+/*
+ * Dane do wymiarowania puli (CONFIG_CORE_LEASEPOOL_HIST): błądzenie losowe po oknie 48 leasów
+ * (pozycja żywa -> release, pusta -> alloc z rozkładu lp_mixed), próbka zajętości co 1024 operacje.
+ * Po pomiarze wypisuje histogramy jako JSON Lines {"lp_hist":...} (jak `lpstat hist json`).
+ */
+static void bench_lp_hist_(void)
+{
+#if CONFIG_CORE_LEASEPOOL_HIST
+    lp_init();
+    enum { WINDOW = 48 };
+    lp_handle_t live[WINDOW];
+    for (size_t i = 0; i < WINDOW; i++) live[i] = lp_invalid_handle();
+
+    const uint64_t iters = scale_(1000000u);
+    uint32_t rng = 777u;
+    uint64_t fails = 0;
+
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < iters; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        const size_t w = (size_t)((rng >> 16) % WINDOW);
+        if (lp_handle_is_valid(live[w])) {
+            lp_release(live[w]);
+            live[w] = lp_invalid_handle();
+        } else {
+            live[w] = lp_alloc_try(lp_mixed_size_(&rng));
+            if (!lp_handle_is_valid(live[w])) fails++;
+        }
+        if ((i & 1023u) == 0u) lp_occ_sample();
+    }
+    const uint64_t ns = now_ns_() - t0;
+    for (size_t i = 0; i < WINDOW; i++) {
+        if (lp_handle_is_valid(live[i])) lp_release(live[i]);
+    }
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"window\":%u,\"fails\":%llu", (unsigned)WINDOW, (unsigned long long)fails);
+    report_("lp_hist", params, iters, ns, 0);
+    fflush(stdout);
+    lp_hist_dump(true);
+#endif
+}
+
+/* Wiele wątków: każdy alloc+release w pętli na wspólnej puli (kontencja na free‑liście). */
+typedef struct {
+    uint64_t iters;
+    uint64_t fails;
+} lp_mt_arg_t;
+
+static void* lp_mt_worker_(void* arg)
+{
+    lp_mt_arg_t* a = arg;
+    for (uint64_t i = 0; i < a->iters; i++) {
+        lp_handle_t h = lp_alloc_try(32);
+        if (!lp_handle_is_valid(h)) {
+            a->fails++;
+            continue;
+        }
+        lp_release(h);
+        if ((i & 63u) == 0u) (void)sched_yield(); // przy 1 CPU wymusza przeplot w środku operacji
+    }
+    return NULL;
+}
+
+static void bench_lp_mt_(const size_t threads)
+{
+    enum { MAX_T = 8 };
+    lp_init();
+    pthread_t th[MAX_T];
+    lp_mt_arg_t args[MAX_T];
+    const uint64_t per = scale_(2000000u) / threads;
+
+    const uint64_t t0 = now_ns_();
+    size_t started = 0;
+    for (; started < threads && started < MAX_T; started++) {
+        args[started] = (lp_mt_arg_t){ .iters = per, .fails = 0 };
+        if (pthread_create(&th[started], NULL, lp_mt_worker_, &args[started]) != 0) break;
+    }
+    uint64_t fails = 0;
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(th[i], NULL);
+        fails += args[i].fails;
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    lp_class_stats_t cs;
+    (void)lp_get_class_stats(0, &cs);
+    const uint64_t mag_n = (uint64_t)cs.mag_hits + cs.mag_misses;
+
+    char params[160];
+    snprintf(params, sizeof(params), "\"threads\":%u,\"lockfree\":%u,\"mag_cap\":%u,\"mag_hit_rate\":%.3f,\"fails\":%llu",
+             (unsigned)started, (unsigned)CONFIG_CORE_LEASEPOOL_LOCKFREE, (unsigned)cs.mag_cap,
+             mag_n ? (double)cs.mag_hits / (double)mag_n : 0.0, (unsigned long long)fails);
+    report_("lp_mt", params, per * started, ns, 0);
+}
+
+/*
+ * Rozgłoszenie (wzorzec ev_post_lease): alloc, referencje dla fan odbiorców, release producenta;
+ * każdy odbiorca opróżnia partię LP_BCAST_BATCH leasów.
+ *  - batch=0: addref(1) per odbiorca, release producenta, odbiorca lp_release() per lease,
+ *  - batch=1: lp_addref_n(fan) + jedno lp_release_ref_n(), odbiorca jedno lp_release_n() na partię.
+ * lock_rounds_per_op: wejścia w sekcję krytyczną puli na rozgłoszenie (tylko build LOCKFREE=0).
+ */
+enum { LP_BCAST_BATCH = 8 };
+
+static void bench_lp_broadcast_(const uint16_t fan, const bool batch)
+{
+    enum { MAX_FAN = 8 };
+    lp_init();
+    const uint64_t iters = scale_(1000000u) / LP_BCAST_BATCH * LP_BCAST_BATCH;
+    lp_handle_t held[MAX_FAN][LP_BCAST_BATCH];
+    lp_stats_t st0, st1;
+
+    lp_get_stats(&st0);
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < iters; i += LP_BCAST_BATCH) {
+        for (size_t b = 0; b < LP_BCAST_BATCH; b++) {
+            lp_handle_t h = lp_alloc_try(32);
+            if (batch) lp_addref_n(h, fan);
+            for (uint16_t k = 0; k < fan; k++) {
+                if (!batch) lp_addref_n(h, 1);
+                held[k][b] = h;
+            }
+            if (batch) lp_release_ref_n(h, 1);
+            else       lp_release(h);
+        }
+        for (uint16_t k = 0; k < fan; k++) {
+            if (batch) lp_release_n(held[k], LP_BCAST_BATCH);
+            else for (size_t b = 0; b < LP_BCAST_BATCH; b++) lp_release(held[k][b]);
+        }
+    }
+    const uint64_t ns = now_ns_() - t0;
+    lp_get_stats(&st1);
+    // -1: wejście pierwszego lp_get_stats(); w buildzie lock‑free licznik stoi na 0.
+    const uint32_t rounds = CONFIG_CORE_LEASEPOOL_LOCKFREE ? 0u : st1.lock_rounds - st0.lock_rounds - 1u;
+
+    char params[128];
+    snprintf(params, sizeof(params), "\"fan\":%u,\"batch\":%u,\"lockfree\":%u,\"lock_rounds_per_op\":%.2f",
+             (unsigned)fan, (unsigned)batch, (unsigned)CONFIG_CORE_LEASEPOOL_LOCKFREE,
+             iters ? (double)rounds / (double)iters : 0.0);
+    report_("lp_broadcast", params, iters, ns, 0);
+}
+
+/*
+ * Copy‑on‑write: konsument modyfikuje ramkę (do 256 B, w jednym slocie) przez lp_make_writable().
+ * shared=0 — jedyny subskrybent (ten sam slot), shared=1 — drugi posiadacz wymusza kopię.
+ */
+static void bench_lp_cow_(const bool shared)
+{
+    lp_init();
+    lp_reset_stats();
+    lp_class_stats_t top = {0};
+    (void)lp_get_class_stats(lp_class_count() - 1, &top);
+    const uint32_t LEN = top.cap < 256u ? top.cap : 256u;
+    const uint64_t iters = scale_(1000000u);
+    uint64_t fails = 0;
+
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < iters; i++) {
+        lp_handle_t h = lp_alloc_try(LEN);
+        lp_view_t v;
+        if (!lp_acquire(h, &v)) {
+            fails++;
+            continue;
+        }
+        memset(v.ptr, (int)i, LEN);
+        lp_commit(h, LEN);
+        if (shared) lp_addref_n(h, 1);
+
+        lp_handle_t w = lp_make_writable(h);
+        if (lp_acquire(w, &v)) ((uint8_t*)v.ptr)[0] ^= 0x20u;
+        else fails++;
+        lp_release(w);
+        if (shared) lp_release(h);
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    char params[128];
+    snprintf(params, sizeof(params), "\"shared\":%u,\"bytes\":%u,\"copies\":%u,\"fails\":%llu",
+             (unsigned)shared, (unsigned)LEN, (unsigned)st.cow_copies, (unsigned long long)fails);
+    report_("lp_cow", params, iters, ns, 0);
+}
+
+/*
+ * Współdzielenie linii cache: wątek "ref" robi addref+release na leasie (zapisy state),
+ * wątek "read" w tym czasie czyta pierwsze 64 B payloadu (konsument). Gdy nagłówek slotu
+ * leży w tej samej linii co początek bufora, każdy zapis refcountu unieważnia linię czytelnika.
+ */
+typedef struct {
+    lp_handle_t h;
+    uint64_t    iters;
+    uint64_t    ns;
+    uint32_t    sum;
+} lp_share_arg_t;
+
+static bool s_share_go = false; // start obu wątków naraz (atomiki: czysty przebieg pod TSAN)
+
+static void* lp_share_ref_(void* arg)
+{
+    lp_share_arg_t* a = arg;
+    while (!__atomic_load_n(&s_share_go, __ATOMIC_ACQUIRE)) { }
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < a->iters; i++) {
+        lp_addref_n(a->h, 1);
+        lp_release(a->h);
+    }
+    a->ns = now_ns_() - t0;
+    return NULL;
+}
+
+static void* lp_share_read_(void* arg)
+{
+    lp_share_arg_t* a = arg;
+    lp_view_t v;
+    if (!lp_acquire(a->h, &v)) return NULL;
+    const volatile uint8_t* p = v.ptr;
+    while (!__atomic_load_n(&s_share_go, __ATOMIC_ACQUIRE)) { }
+    const uint64_t t0 = now_ns_();
+    uint32_t sum = 0;
+    for (uint64_t i = 0; i < a->iters; i++) {
+        for (size_t j = 0; j < 64u; j += 4u) sum += p[j];
+    }
+    a->ns = now_ns_() - t0;
+    a->sum = sum;
+    return NULL;
+}
+
+static void bench_lp_share_(void)
+{
+    lp_init();
+    lp_handle_t h = lp_alloc_try(64);
+    lp_view_t v;
+    if (!lp_acquire(h, &v)) return;
+    memset(v.ptr, 1, 64);
+    lp_commit(h, 64);
+
+    const uint64_t iters = scale_(5000000u);
+    lp_share_arg_t ref = { .h = h, .iters = iters }, rd = { .h = h, .iters = iters };
+    pthread_t tr, tw;
+    __atomic_store_n(&s_share_go, false, __ATOMIC_RELAXED);
+    if (pthread_create(&tw, NULL, lp_share_ref_, &ref) != 0) return;
+    if (pthread_create(&tr, NULL, lp_share_read_, &rd) != 0) {
+        __atomic_store_n(&s_share_go, true, __ATOMIC_RELEASE);
+        pthread_join(tw, NULL);
+        return;
+    }
+    __atomic_store_n(&s_share_go, true, __ATOMIC_RELEASE);
+    pthread_join(tw, NULL);
+    pthread_join(tr, NULL);
+
+    const uintptr_t off = (uintptr_t)v.ptr % 64u;
+    char params[96];
+    snprintf(params, sizeof(params), "\"side\":\"ref\",\"buf_align64\":%u", (unsigned)off);
+    report_("lp_share", params, iters, ref.ns, 0);
+    snprintf(params, sizeof(params), "\"side\":\"read\",\"buf_align64\":%u", (unsigned)off);
+    report_("lp_share", params, iters, rd.ns, iters * 64u);
+    lp_release(h);
+}
+
+/*
+ * UART RX w pętli zwrotnej 921600 bod (8N1 = 92160 B/s): wątek "linii" co 120 B (próg RX FIFO
+ * sterownika IDF) dopisuje bajty do bufora sterownika (spsc_ring 2048 B jak UART_RX_BUF_SIZE)
+ * i wysyła zdarzenie; wątek RX jak handle_rx_event() w services_uart czyta całą paczkę do leasa
+ * i publikuje EV_UART_FRAME; subskrybent czyta payload i zwalnia.
+ *  - mode=chain: lp_alloc_chain_try_prio(paczka+1, LOW) na każde zdarzenie,
+ *  - mode=ring:  kolejne leasy lp_ring_t (SERVICES_UART_RX_LEASE_RING), przy pełnym ringu chain.
+ * kb_per_s = dostarczone bajty / czas ściany; rx_cpu_pct = CPU wątku RX / czas ściany;
+ * pool_allocs = alloc z free‑list/magazynów puli (w trybie ring tylko przelew przy pełnym ringu).
+ */
+enum { UART_BAUD = 921600, UART_BPS = UART_BAUD / 10, UART_CHUNK = 120, UART_DRV_BUF = 2048, UART_RING_SLOTS = 8 };
+
+static uint8_t s_uart_drv[UART_DRV_BUF];
+
+typedef struct {
+    spsc_ring_t*  drv;
+    QueueHandle_t evq;
+    ev_queue_t    sub;
+    uint64_t      dur_ns;
+    uint64_t      sent;
+    uint64_t      overflow;   /* bajty odrzucone przez pełny bufor sterownika */
+    uint64_t      received;
+    bool          rx_done;    /* atomik: konsument kończy po opróżnieniu */
+} uart_loop_t;
+
+static uint64_t thread_cpu_ns_(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void* uart_line_(void* arg)
+{
+    uart_loop_t* u = arg;
+    uint8_t chunk[UART_CHUNK];
+    const uint64_t period = (uint64_t)UART_CHUNK * 1000000000ull / UART_BPS;
+    const uint64_t t0 = now_ns_();
+    uint64_t next = t0;
+
+    while (next - t0 < u->dur_ns) {
+        next += period;
+        const struct timespec ts = { .tv_sec = (time_t)(next / 1000000000ull), .tv_nsec = (long)(next % 1000000000ull) };
+        (void)clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+        for (size_t i = 0; i < UART_CHUNK; i++) chunk[i] = (uint8_t)(u->sent + i);
+        size_t done = 0;
+        while (done < UART_CHUNK) {
+            size_t n = 0;
+            uint8_t* w = spsc_ring_reserve(u->drv, UART_CHUNK - done, &n);
+            if (!w) break;
+            memcpy(w, chunk + done, n);
+            spsc_ring_commit(u->drv, n);
+            done += n;
+        }
+        u->overflow += UART_CHUNK - done;
+        u->sent += UART_CHUNK;
+
+        const uint32_t evt = UART_CHUNK;
+        (void)xQueueSend(u->evq, &evt, 0); // pełna kolejka zdarzeń: dane i tak czekają w buforze
+    }
+    const uint32_t stop = 0;
+    (void)xQueueSend(u->evq, &stop, portMAX_DELAY);
+    return NULL;
+}
+
+static void* uart_consumer_(void* arg)
+{
+    uart_loop_t* u = arg;
+    ev_msg_t m;
+    lp_iov_t iov[UART_DRV_BUF / 16 + 1]; // cała paczka w najmniejszych slotach
+    uint32_t sum = 0;
+
+    for (;;) {
+        if (!ev_recv(u->sub, &m, pdMS_TO_TICKS(20))) {
+            if (__atomic_load_n(&u->rx_done, __ATOMIC_ACQUIRE)) break;
+            continue;
+        }
+        const lp_handle_t h = lp_unpack_handle_u32(m.a0);
+        const size_t n = lp_acquire_iov(h, iov, sizeof(iov) / sizeof(iov[0]));
+        for (size_t i = 0; i < n && i < sizeof(iov) / sizeof(iov[0]); i++) {
+            const uint8_t* p = iov[i].ptr;
+            for (uint32_t j = 0; j < iov[i].len; j++) sum += p[j];
+            u->received += iov[i].len;
+        }
+        lp_release(h);
+    }
+    return (void*)(uintptr_t)sum;
+}
+
+/* Odczyt z "bufora sterownika" (uart_port_read z timeoutem 0). */
+static size_t uart_drv_read_(spsc_ring_t* drv, uint8_t* dst, size_t want)
+{
+    size_t done = 0;
+    while (done < want) {
+        size_t n = 0;
+        const uint8_t* r = spsc_ring_peek(drv, &n);
+        if (!r) break;
+        if (n > want - done) n = want - done;
+        memcpy(dst + done, r, n);
+        spsc_ring_consume(drv, n);
+        done += n;
+    }
+    return done;
+}
+
+static bool uart_publish_(lp_handle_t h, size_t len)
+{
+    lp_commit(h, (uint32_t)len);
+    return ev_post_lease(EV_SRC_UART, EV_UART_FRAME, h, (uint16_t)len);
+}
+
+static void bench_lp_uart_rx_(const bool ring_mode)
+{
+    lp_init();
+    ev_init();
+
+    spsc_ring_t drv;
+    (void)spsc_ring_init(&drv, s_uart_drv, UART_DRV_BUF);
+    uart_loop_t u = { .drv = &drv, .evq = xQueueCreate(20, sizeof(uint32_t)), .dur_ns = s_opt.quick ? 200000000ull : 2000000000ull };
+    if (!u.evq || !ev_subscribe(&u.sub, 32)) return;
+
+    // Segment ringu: 256 B jak domyślne SERVICES_UART_RX_RING_SEG_BYTES, o ile pula ma taką klasę.
+    lp_class_stats_t top = {0};
+    (void)lp_get_class_stats(lp_class_count() - 1, &top);
+    const uint32_t seg = (top.cap < 256u) ? top.cap : 256u;
+    lp_ring_t ring = {0};
+    if (ring_mode && !lp_ring_init(&ring, seg, UART_RING_SLOTS)) {
+        ev_unsubscribe(u.sub);
+        vQueueDelete(u.sub);
+        vQueueDelete(u.evq);
+        return;
+    }
+
+    pthread_t tl, tc;
+    if (pthread_create(&tc, NULL, uart_consumer_, &u) != 0) return;
+    if (pthread_create(&tl, NULL, uart_line_, &u) != 0) {
+        __atomic_store_n(&u.rx_done, true, __ATOMIC_RELEASE);
+        pthread_join(tc, NULL);
+        return;
+    }
+
+    uint64_t events = 0, drops = 0, ring_leases = 0;
+    const uint64_t t0 = now_ns_();
+    const uint64_t cpu0 = thread_cpu_ns_();
+    for (;;) {
+        uint32_t evt = 0;
+        if (!xQueueReceive(u.evq, &evt, portMAX_DELAY)) continue;
+        const bool stop = (evt == 0);
+        size_t len = spsc_ring_used(&drv);
+        events++;
+
+        // Tryb ringu: kolejne leasy po seg-1 B (+ terminator), dopóki najstarszy slot wolny.
+        while (ring_mode && len > 0) {
+            lp_handle_t h = lp_ring_acquire(&ring);
+            lp_view_t v;
+            if (!lp_acquire(h, &v)) break;
+            const size_t n = uart_drv_read_(&drv, v.ptr, (len < v.cap - 1u) ? len : v.cap - 1u);
+            ((uint8_t*)v.ptr)[n] = 0;
+            if (!uart_publish_(h, n)) drops += n;
+            ring_leases++;
+            len -= n;
+        }
+
+        if (len > 0) {
+            lp_handle_t h = lp_alloc_chain_try_prio((uint32_t)len + 1u, LP_PRIO_LOW);
+            lp_iov_t iov[UART_DRV_BUF / 16 + 1];
+            const size_t nseg = lp_acquire_iov(h, iov, sizeof(iov) / sizeof(iov[0]));
+            if (nseg == 0) {
+                // Brak slotów: paczka w nicość, żeby nie zatkać bufora sterownika.
+                uint8_t trash[64];
+                while (len > 0) {
+                    const size_t n = uart_drv_read_(&drv, trash, len < sizeof(trash) ? len : sizeof(trash));
+                    if (n == 0) break;
+                    len -= n;
+                    drops += n;
+                }
+            } else {
+                size_t got = 0;
+                for (size_t i = 0; i < nseg && got < len; i++) {
+                    got += uart_drv_read_(&drv, iov[i].ptr, (len - got < iov[i].cap) ? len - got : iov[i].cap);
+                }
+                if (!uart_publish_(h, got)) drops += got;
+            }
+        }
+        if (stop) break;
+    }
+    const uint64_t cpu = thread_cpu_ns_() - cpu0;
+    pthread_join(tl, NULL);
+    const uint64_t wall = now_ns_() - t0;
+    __atomic_store_n(&u.rx_done, true, __ATOMIC_RELEASE);
+    pthread_join(tc, NULL);
+
+    lp_stats_t st = {0};
+    lp_get_stats(&st);
+    char params[256];
+    snprintf(params, sizeof(params),
+             "\"mode\":\"%s\",\"baud\":%u,\"seg\":%u,\"sent\":%llu,\"received\":%llu,\"overflow\":%llu,"
+             "\"kb_per_s\":%.1f,\"lease_fail\":%u,\"drops\":%llu,\"pool_allocs\":%u,\"ring_leases\":%llu,\"ring_full\":%u,"
+             "\"rx_cpu_pct\":%.2f,\"rx_ns_per_byte\":%.2f",
+             ring_mode ? "ring" : "chain", (unsigned)UART_BAUD, (unsigned)(ring_mode ? seg : 0u),
+             (unsigned long long)u.sent, (unsigned long long)u.received, (unsigned long long)u.overflow,
+             wall ? (double)u.received * 1e6 / (double)wall : 0.0,
+             (unsigned)st.drops_prio[LP_PRIO_LOW], (unsigned long long)drops, (unsigned)st.alloc_ok, (unsigned long long)ring_leases,
+             (unsigned)ring.full, wall ? 100.0 * (double)cpu / (double)wall : 0.0,
+             u.received ? (double)cpu / (double)u.received : 0.0);
+    report_("lp_uart_rx", params, events, wall, u.received);
+
+    if (ring_mode) (void)lp_ring_deinit(&ring);
+    ev_unsubscribe(u.sub);
+    vQueueDelete(u.sub);
+    vQueueDelete(u.evq);
+}
+
+/* ===================== core__spsc_ring ===================== */
+
+enum { RING_CAP = 64u * 1024u };
+
+static uint8_t s_ring_storage[RING_CAP];
+
+/* Wolumen na przebieg: 1 GiB, dla małych wiadomości najwyżej 16M operacji. */
+static uint64_t ring_total_(const size_t chunk)
+{
+    const uint64_t full = 1024ull * 1024u * 1024u;
+    const uint64_t by_ops = (uint64_t)chunk * 16u * 1024u * 1024u;
+    return scale_(by_ops < full ? by_ops : full);
+}
+
+/*
+ * Jeden wątek: zapis i odczyt wiadomości po chunk bajtów (koszt ścieżki + memcpy).
+ * bulk=0: pętle reserve/commit + peek/consume (publikacja indeksu na fragment),
+ * bulk=1: spsc_ring_write(all) + spsc_ring_read (≤ 2 memcpy, jedna publikacja).
+ */
+static void bench_ring_st_(const size_t chunk, const bool bulk)
+{
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_storage, RING_CAP);
+
+    uint8_t src[4096], dst[4096];
+    memset(src, 0x5A, sizeof(src));
+
+    const uint64_t total = ring_total_(chunk);
+    uint64_t moved = 0, ops = 0;
+
+    const uint64_t t0 = now_ns_();
+    while (moved < total) {
+        if (bulk) {
+            (void)spsc_ring_write(&rb, src, chunk, true);
+            (void)spsc_ring_read(&rb, dst, chunk);
+        } else {
+            size_t done = 0;
+            while (done < chunk) {
+                size_t n = 0;
+                uint8_t* w = spsc_ring_reserve(&rb, chunk - done, &n);
+                if (!w) break;
+                memcpy(w, src + done, n);
+                spsc_ring_commit(&rb, n);
+                done += n;
+            }
+            done = 0;
+            while (done < chunk) {
+                size_t n = 0;
+                const uint8_t* r = spsc_ring_peek(&rb, &n);
+                if (!r) break;
+                if (n > chunk - done) n = chunk - done;
+                memcpy(dst + done, r, n);
+                spsc_ring_consume(&rb, n);
+                done += n;
+            }
+        }
+        moved += chunk;
+        ops++;
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    char params[80];
+    snprintf(params, sizeof(params), "\"threads\":1,\"chunk\":%u,\"api\":\"%s\"", (unsigned)chunk, bulk ? "bulk" : "reserve");
+    report_("spsc_ring", params, ops, ns, moved);
+}
+
+typedef struct {
+    spsc_ring_t* rb;
+    size_t       chunk;
+    uint64_t     total;
+    bool         bulk;
+} ring_mt_arg_t;
+
+static void* ring_producer_(void* arg)
+{
+    const ring_mt_arg_t* a = arg;
+    uint8_t src[4096];
+    memset(src, 0xA5, sizeof(src));
+
+    uint64_t sent = 0;
+    while (sent < a->total) {
+        const size_t want = (a->total - sent < a->chunk) ? (size_t)(a->total - sent) : a->chunk;
+        size_t n = 0;
+        if (a->bulk) {
+            n = spsc_ring_write(a->rb, src, want, true);
+        } else {
+            uint8_t* w = spsc_ring_reserve(a->rb, want, &n);
+            if (w) {
+                memcpy(w, src, n);
+                spsc_ring_commit(a->rb, n);
+            }
+        }
+        if (n == 0) {
+            (void)sched_yield(); // przy 1 CPU spin bez yield mierzy tylko kwant schedulera
+            continue;
+        }
+        sent += n;
+    }
+    return NULL;
+}
+
+/* Dwa wątki: producent i konsument na osobnych rdzeniach (jeśli system pozwoli). */
+static void bench_ring_mt_(const size_t chunk, const bool bulk)
+{
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_storage, RING_CAP);
+
+    ring_mt_arg_t a = { .rb = &rb, .chunk = chunk, .total = ring_total_(chunk), .bulk = bulk };
+    uint8_t dst[4096];
+    uint64_t got = 0, ops = 0;
+
+    const uint64_t t0 = now_ns_();
+    pthread_t th;
+    if (pthread_create(&th, NULL, ring_producer_, &a) != 0) return;
+    while (got < a.total) {
+        size_t n = 0;
+        if (bulk) {
+            n = spsc_ring_read(&rb, dst, chunk);
+        } else {
+            const uint8_t* r = spsc_ring_peek(&rb, &n);
+            if (r) {
+                if (n > chunk) n = chunk;
+                memcpy(dst, r, n);
+                spsc_ring_consume(&rb, n);
+            }
+        }
+        if (n == 0) {
+            (void)sched_yield();
+            continue;
+        }
+        got += n;
+        ops++;
+    }
+    pthread_join(th, NULL);
+    const uint64_t ns = now_ns_() - t0;
+
+    char params[80];
+    snprintf(params, sizeof(params), "\"threads\":2,\"chunk\":%u,\"api\":\"%s\"", (unsigned)chunk, bulk ? "bulk" : "reserve");
+    report_("spsc_ring", params, ops, ns, got);
+}
+
+/*
+ * Linie logu o zmiennej długości (24..151 B) po 8 na raz, konsument bierze ogon 16 znaków (LCD).
+ * record=0: write(all) linii + '\n', odczyt read_until po 64 B i ogon z każdego kawałka,
+ * record=1: reserve_record/commit_record, peek_record -> ostatnie 16 B bez skanowania.
+ */
+static volatile uint8_t s_ring_tail_sink;
+
+static void bench_ring_lines_(const bool record)
+{
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_storage, 4096u);
+
+    static const uint8_t nl = '\n';
+    uint8_t line[160];
+    memset(line, 'L', sizeof(line));
+
+    const uint64_t total = scale_(4u * 1024u * 1024u);
+    uint64_t ops = 0, moved = 0;
+    uint8_t tail[16] = {0};
+
+    const uint64_t t0 = now_ns_();
+    while (ops < total) {
+        for (uint32_t i = 0; i < 8u; i++) {
+            const size_t len = 24u + (size_t)((ops + i) * 37u % 128u);
+            if (record) {
+                uint8_t* w = spsc_ring_reserve_record(&rb, len);
+                if (!w) break;
+                memcpy(w, line, len);
+                spsc_ring_commit_record(&rb, len);
+            } else {
+                if (spsc_ring_free(&rb) < len + 1u) break;
+                (void)spsc_ring_write(&rb, line, len, true);
+                (void)spsc_ring_write(&rb, &nl, 1u, true);
+            }
+            moved += len;
+        }
+
+        if (record) {
+            size_t n = 0;
+            const uint8_t* r;
+            while ((r = spsc_ring_peek_record(&rb, &n)) != NULL) {
+                memcpy(tail, r + n - 16u, 16u);
+                spsc_ring_consume_record(&rb);
+                ops++;
+            }
+        } else {
+            uint8_t chunk[64];
+            bool eol = false;
+            size_t n;
+            while ((n = spsc_ring_read_until(&rb, chunk, sizeof(chunk), (uint8_t)'\n', &eol)) != 0) {
+                const size_t text = eol ? n - 1u : n;
+                if (text >= 16u) memcpy(tail, chunk + text - 16u, 16u);
+                if (eol) ops++;
+            }
+        }
+    }
+    const uint64_t ns = now_ns_() - t0;
+    s_ring_tail_sink = tail[15];
+
+    char params[80];
+    snprintf(params, sizeof(params), "\"threads\":1,\"line\":\"24..151\",\"api\":\"%s\"",
+             record ? "record" : "read_until");
+    report_("spsc_log_lines", params, ops, ns, moved);
+}
+
+/*
+ * Bufor logów w RAM (logging_idf.c): linia = nagłówek "(ts) tag: " + treść + '\n',
+ * ring 8 KiB nadpisujący najstarsze bajty; co 64 linie migawka ostatnich 512 B.
+ * api=byte_loop: dawny rb_write_byte (bajt po bajcie, modulo, licznik długości),
+ * api=overwrite: spsc_ring_write_overwrite (≤ 2 memcpy na kawałek), migawka copy_overwrite.
+ */
+static size_t s_bl_w, s_bl_len;
+
+static void byte_loop_put_(const uint8_t* src, const size_t n, const size_t cap)
+{
+    for (size_t i = 0; i < n; i++) {
+        s_ring_storage[s_bl_w] = src[i];
+        s_bl_w = (s_bl_w + 1u) % cap;
+        if (s_bl_len < cap) s_bl_len++;
+    }
+}
+
+static void bench_ring_overwrite_(const bool overwrite)
+{
+    volatile size_t cap_v = 8192u; // jak CONFIG_INFRA_LOG_RINGBUF_KB=8; volatile: bez stałego modulo
+    const size_t cap = cap_v;
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_storage, (uint32_t)cap);
+    s_bl_w = s_bl_len = 0;
+
+    static const uint8_t head[] = "(123456) APP: ";
+    uint8_t line[160], snap[512];
+    memset(line, 'L', sizeof(line));
+
+    const uint64_t total = scale_(4u * 1024u * 1024u);
+    uint64_t moved = 0;
+    const uint64_t t0 = now_ns_();
+    for (uint64_t i = 0; i < total; i++) {
+        const size_t len = 24u + (size_t)(i * 37u % 128u);
+        if (overwrite) {
+            spsc_ring_write_overwrite(&rb, head, sizeof(head) - 1u);
+            spsc_ring_write_overwrite(&rb, line, len);
+            spsc_ring_write_overwrite(&rb, "\n", 1u);
+        } else {
+            byte_loop_put_(head, sizeof(head) - 1u, cap);
+            byte_loop_put_(line, len, cap);
+            byte_loop_put_((const uint8_t*)"\n", 1u, cap);
+        }
+        moved += sizeof(head) + len;
+
+        if ((i & 63u) == 63u) {
+            if (overwrite) {
+                (void)spsc_ring_copy_overwrite(&rb, snap, sizeof(snap), true);
+            } else {
+                const size_t start = (s_bl_w + cap - sizeof(snap)) % cap;
+                const size_t first = (sizeof(snap) < cap - start) ? sizeof(snap) : cap - start;
+                memcpy(snap, s_ring_storage + start, first);
+                memcpy(snap + first, s_ring_storage, sizeof(snap) - first);
+            }
+            s_ring_tail_sink = snap[sizeof(snap) - 1u];
+        }
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    char params[80];
+    snprintf(params, sizeof(params), "\"threads\":1,\"line\":\"38..165\",\"api\":\"%s\"",
+             overwrite ? "overwrite" : "byte_loop");
+    report_("spsc_overwrite", params, total, ns, moved);
+}
+
+/*
+ * Wielu producentów linii logu (24..151 B) do jednego konsumenta, ring 4 KiB jak log stream.
+ * api=mpsc:       mpsc_ring_reserve/commit bez blokady (CAS na head, flaga w nagłówku),
+ * api=spsc_mutex: spsc_ring w trybie rekordowym, producenci serializowani mutexem
+ *                 (odpowiednik portMUX w app__log_bus przed MPSC).
+ * Pełny ring -> producent robi sched_yield() i ponawia (bez dropów, liczymy każdy rekord).
+ */
+static uint8_t s_mp_storage[4096] __attribute__((aligned(4)));
+
+typedef struct {
+    bool             mpsc;
+    mpsc_ring_t*     mp;
+    spsc_ring_t*     sp;
+    pthread_mutex_t* mu;
+    uint32_t         id;
+    uint64_t         per;
+} mp_prod_arg_t;
+
+static void* mp_producer_(void* arg)
+{
+    const mp_prod_arg_t* a = arg;
+    uint8_t line[160];
+    memset(line, 'A' + (int)a->id, sizeof(line));
+
+    for (uint64_t i = 0; i < a->per;) {
+        const size_t len = 24u + (size_t)((i * 37u + a->id * 11u) % 128u);
+        uint8_t* w;
+        if (a->mpsc) {
+            mpsc_ring_resv_t r;
+            w = mpsc_ring_reserve(a->mp, len, &r);
+            if (w) {
+                memcpy(w, line, len);
+                mpsc_ring_commit(a->mp, &r, len);
+            }
+        } else {
+            pthread_mutex_lock(a->mu);
+            w = spsc_ring_reserve_record(a->sp, len);
+            if (w) {
+                memcpy(w, line, len);
+                spsc_ring_commit_record(a->sp, len);
+            }
+            pthread_mutex_unlock(a->mu);
+        }
+        if (!w) {
+            (void)sched_yield();
+            continue;
+        }
+        i++;
+    }
+    return NULL;
+}
+
+static void bench_mpsc_(const uint32_t producers, const bool mpsc)
+{
+    enum { MP_MAX_PROD = 8 };
+    mpsc_ring_t mp;
+    spsc_ring_t sp;
+    pthread_mutex_t mu = PTHREAD_MUTEX_INITIALIZER;
+    if (mpsc) (void)mpsc_ring_init(&mp, s_mp_storage, sizeof(s_mp_storage));
+    else (void)spsc_ring_init(&sp, s_mp_storage, sizeof(s_mp_storage));
+
+    const uint64_t per = scale_(2u * 1024u * 1024u) / producers;
+    const uint64_t total = per * producers;
+    mp_prod_arg_t args[MP_MAX_PROD];
+    pthread_t th[MP_MAX_PROD];
+
+    const uint64_t t0 = now_ns_();
+    uint32_t started = 0;
+    for (; started < producers; started++) {
+        args[started] = (mp_prod_arg_t){ .mpsc = mpsc, .mp = &mp, .sp = &sp, .mu = &mu, .id = started, .per = per };
+        if (pthread_create(&th[started], NULL, mp_producer_, &args[started]) != 0) break;
+    }
+
+    uint64_t got = 0, bytes = 0;
+    const uint64_t want = per * started;
+    while (got < want) {
+        size_t n = 0;
+        const uint8_t* r = mpsc ? mpsc_ring_peek(&mp, &n) : spsc_ring_peek_record(&sp, &n);
+        if (!r) {
+            (void)sched_yield();
+            continue;
+        }
+        bytes += n;
+        if (mpsc) mpsc_ring_consume(&mp);
+        else spsc_ring_consume_record(&sp);
+        got++;
+    }
+    for (uint32_t i = 0; i < started; i++) pthread_join(th[i], NULL);
+    const uint64_t ns = now_ns_() - t0;
+    pthread_mutex_destroy(&mu);
+    if (started != producers || got != total) return;
+
+    char params[80];
+    snprintf(params, sizeof(params), "\"producers\":%u,\"api\":\"%s\"", (unsigned)producers, mpsc ? "mpsc" : "spsc_mutex");
+    report_("mpsc_ring", params, got, ns, bytes);
+}
+
+/*
+ * Budzenie konsumenta: rekordy 32 B od producenta (wątek), konsument śpi między paczkami.
+ * api=doorbell: kolejka "dzwonków" — jeden xQueueSend na rekord (jak EV_LOG_READY na linię),
+ * api=wait:     spsc_ring_wait_readable(min_bytes) — notyfikacja tylko po przekroczeniu progu.
+ * Pole wakeups: ile razy konsument się obudził (rec_per_wake = ops / wakeups).
+ */
+typedef struct {
+    spsc_ring_t*  rb;
+    QueueHandle_t bell;
+    uint64_t      total;
+} wait_prod_arg_t;
+
+static void* wait_producer_(void* arg)
+{
+    const wait_prod_arg_t* a = arg;
+    uint8_t rec[32];
+    memset(rec, 'w', sizeof(rec));
+    for (uint64_t i = 0; i < a->total;) {
+        if (spsc_ring_write(a->rb, rec, sizeof(rec), true) == 0) {
+            (void)sched_yield();
+            continue;
+        }
+        if (a->bell) {
+            const uint32_t one = 1u;
+            (void)xQueueSend(a->bell, &one, 0); // pełna kolejka = dzwonek już czeka
+        }
+        i++;
+    }
+    return NULL;
+}
+
+static void bench_ring_wait_(const size_t min_bytes, const bool doorbell)
+{
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_storage, 4096u);
+    spsc_ring_enable_wait(&rb);
+
+    wait_prod_arg_t a = { .rb = &rb, .bell = doorbell ? xQueueCreate(16, sizeof(uint32_t)) : NULL,
+                          .total = scale_(1024u * 1024u) };
+    uint8_t dst[32];
+    uint64_t got = 0, wakeups = 0;
+
+    const uint64_t t0 = now_ns_();
+    pthread_t th;
+    if (pthread_create(&th, NULL, wait_producer_, &a) != 0) return;
+    while (got < a.total) {
+        while (spsc_ring_read(&rb, dst, sizeof(dst)) == sizeof(dst)) got++;
+        if (got >= a.total) break;
+
+        if (doorbell) {
+            uint32_t v;
+            (void)xQueueReceive(a.bell, &v, portMAX_DELAY);
+        } else {
+            const uint64_t left = (a.total - got) * sizeof(dst);
+            (void)spsc_ring_wait_readable(&rb, left < min_bytes ? (size_t)left : min_bytes, portMAX_DELAY);
+        }
+        wakeups++;
+    }
+    pthread_join(th, NULL);
+    const uint64_t ns = now_ns_() - t0;
+    if (a.bell) vQueueDelete(a.bell);
+
+    char params[96];
+    snprintf(params, sizeof(params), "\"api\":\"%s\",\"min_bytes\":%u,\"wakeups\":%llu",
+             doorbell ? "doorbell" : "wait", (unsigned)(doorbell ? 32u : min_bytes), (unsigned long long)wakeups);
+    report_("spsc_wait", params, got, ns, got * sizeof(dst));
+}
+
+/* ===================== infrastructure__logging ===================== */
+
+/*
+ * Koszt wywołania logu po stronie wołającego taska, typowe linie (liczby / napisy / double).
+ * api=vsnprintf: dzisiejszy log_write przed esp_log_write (formatowanie do msg[192]),
+ * api=deferred:  infra_log_deferred_vwrite (pakowanie argumentów + rekord w MPSC ringu),
+ * api=drain:     strona konsumenta trybu odroczonego (infra_log_deferred_read = format + consume).
+ * Ring opróżniany co 32 rekordy; czasy zapisu i opróżniania mierzone osobno.
+ */
+static volatile char s_log_sink;
+
+__attribute__((format(printf, 2, 3)))
+static void log_call_(const bool deferred, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    if (deferred) {
+        (void)infra_log_deferred_vwrite(2, 1234u, "BENCH", fmt, ap);
+    } else {
+        char msg[192];
+        (void)vsnprintf(msg, sizeof(msg), fmt, ap);
+        s_log_sink = msg[0];
+    }
+    va_end(ap);
+}
+
+static void bench_log_deferred_(const char* kind, const bool deferred)
+{
+    infra_log_deferred_init();
+    static const char* const states[] = { "IDLE", "CONNECTING", "ONLINE", "ERROR" };
+
+    const uint64_t total = scale_(2u * 1024u * 1024u);
+    uint64_t ns_call = 0, ns_drain = 0, drained = 0;
+    for (uint64_t i = 0; i < total; i += 32u) {
+        const uint64_t t0 = now_ns_();
+        for (uint32_t k = 0; k < 32u; k++) {
+            const uint32_t v = (uint32_t)(i + k);
+            if (kind[0] == 'i') {
+                log_call_(deferred, "rx frame: len=%u crc=%08x seq=%u", v & 0x3FFu, v * 2654435761u, v);
+            } else if (kind[0] == 's') {
+                log_call_(deferred, "state %s -> %s (%d)", states[v & 3u], states[(v + 1u) & 3u], (int)(v & 7u));
+            } else {
+                log_call_(deferred, "t=%.2f C rh=%.1f%%", (double)(v & 1023u) * 0.05, (double)(v & 255u) * 0.4);
+            }
+        }
+        const uint64_t t1 = now_ns_();
+        ns_call += t1 - t0;
+
+        if (deferred) {
+            char msg[192];
+            size_t len = 0;
+            while (infra_log_deferred_read(NULL, msg, sizeof(msg), &len)) {
+                drained++;
+                s_log_sink = msg[len ? len - 1u : 0u];
+            }
+            ns_drain += now_ns_() - t1;
+        }
+    }
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"line\":\"%s\",\"api\":\"%s\"", kind, deferred ? "deferred" : "vsnprintf");
+    report_("log_deferred", params, total, ns_call, 0);
+    if (deferred) {
+        snprintf(params, sizeof(params), "\"line\":\"%s\",\"api\":\"drain\",\"dropped\":%u", kind,
+                 (unsigned)infra_log_deferred_drop_count());
+        report_("log_deferred", params, drained, ns_drain, 0);
+    }
+}
+
+/* ===================== main ===================== */
+
+static void report_meta_(void)
+{
+    printf("{\"bench\":\"meta\",\"quick\":%s,\"ev_max_subs\":%u,\"ev_prio_lane_depth\":%u,"
+           "\"ev_schema_guard\":%u,\"lp_classes\":%u,\"lp_slots\":%u,\"lp_slot_bytes\":%u,\"lp_guard\":%u,\"lp_lockfree\":%u,\"lp_magazine\":%u,\"lp_poison\":\"%s\",\"lp_owners\":%u,\"lp_hist\":%u,\"cc\":\"%s\"}\n",
+           s_opt.quick ? "true" : "false",
+           (unsigned)EV_MAX_SUBS, (unsigned)EV_PRIO_LANE_DEPTH, (unsigned)CONFIG_CORE_EV_SCHEMA_GUARD,
+           (unsigned)lp_class_count(), (unsigned)CONFIG_CORE_LEASEPOOL_SLOTS, (unsigned)CONFIG_CORE_LEASEPOOL_SLOT_BYTES,
+           (unsigned)CONFIG_CORE_LEASEPOOL_GUARD, (unsigned)CONFIG_CORE_LEASEPOOL_LOCKFREE,
+           (unsigned)CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE, lp_poison_name_(),
+           (unsigned)CONFIG_CORE_LEASEPOOL_OWNERS, (unsigned)CONFIG_CORE_LEASEPOOL_HIST, __VERSION__);
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            s_opt.quick = true;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            s_opt.filter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--filter <prefix>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    report_meta_();
+
+    static const size_t subs_set[] = { 1, 2, 4, 8, 12 };
+    if (enabled_("ev_post")) {
+        for (size_t i = 0; i < sizeof(subs_set) / sizeof(subs_set[0]); i++) {
+            if (subs_set[i] <= EV_MAX_SUBS) bench_ev_post_(subs_set[i]);
+        }
+    }
+    if (enabled_("ev_post_lease")) {
+        for (size_t i = 0; i < sizeof(subs_set) / sizeof(subs_set[0]); i++) {
+            if (subs_set[i] <= EV_MAX_SUBS) bench_ev_post_lease_(subs_set[i]);
+        }
+    }
+    if (enabled_("ev_crit_latency")) bench_ev_crit_latency_();
+
+    if (enabled_("lp_alloc_release")) bench_lp_alloc_release_();
+    if (enabled_("lp_burst")) bench_lp_burst_();
+    if (enabled_("lp_guard")) bench_lp_guard_();
+    if (enabled_("lp_mixed")) bench_lp_mixed_();
+    if (enabled_("lp_hist")) bench_lp_hist_();
+    static const size_t lp_threads[] = { 1, 2, 4 };
+    if (enabled_("lp_mt")) {
+        for (size_t i = 0; i < sizeof(lp_threads) / sizeof(lp_threads[0]); i++) bench_lp_mt_(lp_threads[i]);
+    }
+    if (enabled_("lp_broadcast")) {
+        static const uint16_t fans[] = { 1, 4, 8 };
+        for (size_t i = 0; i < sizeof(fans) / sizeof(fans[0]); i++) {
+            bench_lp_broadcast_(fans[i], false);
+            bench_lp_broadcast_(fans[i], true);
+        }
+    }
+    if (enabled_("lp_share")) bench_lp_share_();
+    if (enabled_("lp_cow")) {
+        bench_lp_cow_(false);
+        bench_lp_cow_(true);
+    }
+    if (enabled_("lp_uart_rx")) {
+        bench_lp_uart_rx_(false);
+        bench_lp_uart_rx_(true);
+    }
+
+    static const size_t chunks[] = { 1, 16, 256, 4096 };
+    if (enabled_("spsc_ring")) {
+        for (int bulk = 0; bulk <= 1; bulk++) {
+            for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) bench_ring_st_(chunks[i], bulk);
+            for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) bench_ring_mt_(chunks[i], bulk);
+        }
+    }
+    if (enabled_("mpsc_ring")) {
+        static const uint32_t producers[] = { 1, 2, 4, 8 };
+        for (size_t i = 0; i < sizeof(producers) / sizeof(producers[0]); i++) {
+            bench_mpsc_(producers[i], false);
+            bench_mpsc_(producers[i], true);
+        }
+    }
+    if (enabled_("spsc_wait")) {
+        bench_ring_wait_(32u, true);
+        bench_ring_wait_(32u, false);
+        bench_ring_wait_(512u, false);
+        bench_ring_wait_(2048u, false);
+    }
+    if (enabled_("spsc_overwrite")) {
+        bench_ring_overwrite_(false);
+        bench_ring_overwrite_(true);
+    }
+    if (enabled_("spsc_log_lines")) {
+        bench_ring_lines_(false);
+        bench_ring_lines_(true);
+    }
+    if (enabled_("log_deferred")) {
+        static const char* const kinds[] = { "ints", "strings", "doubles" };
+        for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+            bench_log_deferred_(kinds[i], false);
+            bench_log_deferred_(kinds[i], true);
+        }
+    }
+    return 0;
+}
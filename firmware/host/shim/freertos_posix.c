@@ -0,0 +1,417 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ===================== tick ===================== */
+
+static uint64_t mono_ns_(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(mono_ns_() / (1000000000ull / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    const uint64_t ns = (uint64_t)ticks * (1000000000ull / configTICK_RATE_HZ);
+    struct timespec ts = { .tv_sec = (time_t)(ns / 1000000000ull), .tv_nsec = (long)(ns % 1000000000ull) };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+void host_task_yield(void)
+{
+    (void)sched_yield();
+}
+
+/* ===================== notyfikacje tasków ===================== */
+
+struct host_task {
+    pthread_mutex_t   mtx;
+    pthread_cond_t    cv;
+    uint32_t          notify;
+    struct host_task* next;
+};
+
+/* Wszystkie uchwyty (bez free: może je trzymać inny wątek); lista = osiągalne dla LeakSanitizera. */
+static struct host_task* s_tasks;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    static __thread struct host_task* self;
+    if (!self) {
+        self = calloc(1, sizeof(*self));
+        if (!self) abort();
+        pthread_condattr_t ca;
+        pthread_condattr_init(&ca);
+        pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+        pthread_mutex_init(&self->mtx, NULL);
+        pthread_cond_init(&self->cv, &ca);
+        pthread_condattr_destroy(&ca);
+
+        self->next = __atomic_load_n(&s_tasks, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&s_tasks, &self->next, self, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+    return self;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    if (!task) return pdFALSE;
+    pthread_mutex_lock(&task->mtx);
+    task->notify++;
+    pthread_cond_signal(&task->cv);
+    pthread_mutex_unlock(&task->mtx);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* hpw)
+{
+    if (hpw) *hpw = pdFALSE;
+    (void)xTaskNotifyGive(task);
+}
+
+static void deadline_(struct timespec* ts, TickType_t wait);
+
+uint32_t ulTaskNotifyTake(const BaseType_t clear_on_exit, const TickType_t wait)
+{
+    struct host_task* t = xTaskGetCurrentTaskHandle();
+    struct timespec ts;
+    if (wait != 0 && wait != portMAX_DELAY) deadline_(&ts, wait);
+
+    pthread_mutex_lock(&t->mtx);
+    while (t->notify == 0u && wait != 0) {
+        if (wait == portMAX_DELAY) {
+            pthread_cond_wait(&t->cv, &t->mtx);
+        } else if (pthread_cond_timedwait(&t->cv, &t->mtx, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+    const uint32_t v = t->notify;
+    if (v != 0u) t->notify = clear_on_exit ? 0u : v - 1u;
+    pthread_mutex_unlock(&t->mtx);
+    return v;
+}
+
+/* ===================== portMUX ===================== */
+
+static uintptr_t self_id_(void)
+{
+    static __thread uint8_t tag;
+    return (uintptr_t)&tag;
+}
+
+void host_mux_enter(portMUX_TYPE* mux)
+{
+    const uintptr_t me = self_id_();
+    if (__atomic_load_n(&mux->owner, __ATOMIC_RELAXED) == me) {
+        mux->count++;
+        return;
+    }
+    for (;;) {
+        uintptr_t expected = 0u;
+        if (__atomic_compare_exchange_n(&mux->owner, &expected, me, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+        while (__atomic_load_n(&mux->owner, __ATOMIC_RELAXED) != 0u) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#else
+            (void)sched_yield();
+#endif
+        }
+    }
+    mux->count = 1u;
+}
+
+void host_mux_exit(portMUX_TYPE* mux)
+{
+    if (--mux->count == 0u) {
+        __atomic_store_n(&mux->owner, (uintptr_t)0u, __ATOMIC_RELEASE);
+    }
+}
+
+/* ===================== rdzenie / maska przerwań ===================== */
+
+static portMUX_TYPE s_core_mux[portNUM_PROCESSORS];
+
+int xPortGetCoreID(void)
+{
+    static unsigned next_core;
+    static __thread int core = -1;
+    if (core < 0) core = (int)(__atomic_fetch_add(&next_core, 1u, __ATOMIC_RELAXED) % portNUM_PROCESSORS);
+    return core;
+}
+
+uint32_t host_irq_mask(void)
+{
+    host_mux_enter(&s_core_mux[xPortGetCoreID()]);
+    return 0u;
+}
+
+void host_irq_unmask(uint32_t prev)
+{
+    (void)prev;
+    host_mux_exit(&s_core_mux[xPortGetCoreID()]);
+}
+
+/* ===================== kolejki ===================== */
+
+struct host_queue {
+    pthread_mutex_t mtx;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    uint8_t*        buf;
+    UBaseType_t     len;
+    UBaseType_t     item;
+    UBaseType_t     head;   /* indeks najstarszego elementu */
+    UBaseType_t     count;
+    struct host_queue* set; /* QueueSet, do którego należy kolejka (NULL = brak) */
+};
+
+static void deadline_(struct timespec* ts, const TickType_t wait)
+{
+    const uint64_t ns = mono_ns_() + (uint64_t)wait * (1000000000ull / configTICK_RATE_HZ);
+    ts->tv_sec  = (time_t)(ns / 1000000000ull);
+    ts->tv_nsec = (long)(ns % 1000000000ull);
+}
+
+/* Czeka na warunek; false = timeout. Wywoływane z zablokowanym mtx. */
+static bool wait_until_(struct host_queue* q, pthread_cond_t* cv,
+                        bool (*ready)(const struct host_queue*), const TickType_t wait)
+{
+    if (ready(q)) return true;
+    if (wait == 0) return false;
+
+    struct timespec ts;
+    if (wait != portMAX_DELAY) deadline_(&ts, wait);
+
+    while (!ready(q)) {
+        if (wait == portMAX_DELAY) {
+            pthread_cond_wait(cv, &q->mtx);
+        } else if (pthread_cond_timedwait(cv, &q->mtx, &ts) == ETIMEDOUT) {
+            return ready(q);
+        }
+    }
+    return true;
+}
+
+/* Token dla zbioru po dodaniu elementu (z zablokowanym mtx członka; kolejność blokad: członek -> zbiór).
+ * FreeRTOS zakłada, że zbiór ma miejsce na wszystkie elementy członków (configASSERT). */
+static void set_notify_(struct host_queue* q)
+{
+    if (!q->set) return;
+    const BaseType_t ok = xQueueSend(q->set, &q, 0);
+    assert(ok == pdTRUE);
+    (void)ok;
+}
+
+static bool has_items_(const struct host_queue* q) { return q->count > 0u; }
+static bool has_space_(const struct host_queue* q) { return q->count < q->len; }
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t item_size)
+{
+    if (length == 0u || item_size == 0u) return NULL;
+
+    struct host_queue* q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->buf = malloc((size_t)length * item_size);
+    if (!q->buf) {
+        free(q);
+        return NULL;
+    }
+    q->len  = length;
+    q->item = item_size;
+
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_mutex_init(&q->mtx, NULL);
+    pthread_cond_init(&q->not_empty, &ca);
+    pthread_cond_init(&q->not_full, &ca);
+    pthread_condattr_destroy(&ca);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (!q) return;
+    pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_mutex_destroy(&q->mtx);
+    free(q->buf);
+    free(q);
+}
+
+static BaseType_t send_(QueueHandle_t q, const void* item, const TickType_t wait, const bool front)
+{
+    if (!q || !item) return pdFALSE;
+
+    pthread_mutex_lock(&q->mtx);
+    if (!wait_until_(q, &q->not_full, has_space_, wait)) {
+        pthread_mutex_unlock(&q->mtx);
+        return pdFALSE;
+    }
+
+    UBaseType_t slot;
+    if (front) {
+        q->head = (q->head + q->len - 1u) % q->len;
+        slot = q->head;
+    } else {
+        slot = (q->head + q->count) % q->len;
+    }
+    memcpy(q->buf + (size_t)slot * q->item, item, q->item);
+    q->count++;
+    set_notify_(q);
+
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mtx);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, const TickType_t wait)
+{
+    return send_(q, item, wait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, const TickType_t wait)
+{
+    return send_(q, item, wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void* item, const TickType_t wait)
+{
+    return send_(q, item, wait, true);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void* item)
+{
+    if (!q || !item) return pdFALSE;
+
+    // Semantyka FreeRTOS: przeznaczone dla kolejek o długości 1.
+    pthread_mutex_lock(&q->mtx);
+    if (q->count == 0u) {
+        q->head  = 0u;
+        q->count = 1u;
+        set_notify_(q); // nadpisanie istniejącego elementu nie daje nowego tokenu
+    }
+    memcpy(q->buf + (size_t)((q->head + q->count - 1u) % q->len) * q->item, item, q->item);
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mtx);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* out, const TickType_t wait)
+{
+    if (!q || !out) return pdFALSE;
+
+    pthread_mutex_lock(&q->mtx);
+    if (!wait_until_(q, &q->not_empty, has_items_, wait)) {
+        pthread_mutex_unlock(&q->mtx);
+        return pdFALSE;
+    }
+
+    memcpy(out, q->buf + (size_t)q->head * q->item, q->item);
+    q->head = (q->head + 1u) % q->len;
+    q->count--;
+
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->mtx);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* hpw)
+{
+    if (hpw) *hpw = pdFALSE;
+    return send_(q, item, 0, false);
+}
+
+BaseType_t xQueueSendToFrontFromISR(QueueHandle_t q, const void* item, BaseType_t* hpw)
+{
+    if (hpw) *hpw = pdFALSE;
+    return send_(q, item, 0, true);
+}
+
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t q, const void* item, BaseType_t* hpw)
+{
+    if (hpw) *hpw = pdFALSE;
+    return xQueueOverwrite(q, item);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    if (!q) return 0u;
+    pthread_mutex_lock(&q->mtx);
+    const UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->mtx);
+    return n;
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t q)
+{
+    return uxQueueMessagesWaiting(q);
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+    if (!q) return 0u;
+    pthread_mutex_lock(&q->mtx);
+    const UBaseType_t n = q->len - q->count;
+    pthread_mutex_unlock(&q->mtx);
+    return n;
+}
+
+/* ===================== QueueSet ===================== */
+
+QueueSetHandle_t xQueueCreateSet(const UBaseType_t length)
+{
+    return xQueueCreate(length, sizeof(QueueHandle_t));
+}
+
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set)
+{
+    if (!member || !set) return pdFAIL;
+    pthread_mutex_lock(&member->mtx);
+    // Jak w FreeRTOS: tylko pusta kolejka spoza innego zbioru.
+    const bool ok = (member->set == NULL && member->count == 0u);
+    if (ok) member->set = set;
+    pthread_mutex_unlock(&member->mtx);
+    return ok ? pdPASS : pdFAIL;
+}
+
+BaseType_t xQueueRemoveFromSet(QueueSetMemberHandle_t member, QueueSetHandle_t set)
+{
+    if (!member || !set) return pdFAIL;
+    pthread_mutex_lock(&member->mtx);
+    const bool ok = (member->set == set && member->count == 0u);
+    if (ok) member->set = NULL;
+    pthread_mutex_unlock(&member->mtx);
+    return ok ? pdPASS : pdFAIL;
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, const TickType_t wait)
+{
+    QueueHandle_t member = NULL;
+    return (xQueueReceive(set, &member, wait) == pdTRUE) ? member : NULL;
+}
@@ -0,0 +1,5 @@
+#pragma once
+/* Host: sekcje pamięci IDF nie mają znaczenia — zostaje tylko wyrównanie. */
+#define DMA_ATTR __attribute__((aligned(4))) /* jak WORD_ALIGNED_ATTR w IDF */
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,4 @@
+#pragma once
+#include <stdio.h>
+
+#define esp_rom_printf(...) printf(__VA_ARGS__)
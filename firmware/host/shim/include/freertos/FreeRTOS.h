@@ -0,0 +1,27 @@
+#pragma once
+/*
+ * Minimalny shim FreeRTOS na POSIX (pthread) — tylko API używane przez
+ * core__ev / core__leasepool / core__spsc_ring. Nie jest to pełny port:
+ * brak schedulera, "taski" to zwykłe wątki, tick = 1 ms zegara monotonicznego.
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdFAIL  pdFALSE
+#define pdPASS  pdTRUE
+
+#define configTICK_RATE_HZ 1000u
+#define portMAX_DELAY      ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS ((TickType_t)(1000u / configTICK_RATE_HZ))
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000u))
+
+#include "freertos/portmacro.h"
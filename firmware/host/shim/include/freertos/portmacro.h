@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * portMUX na hoście: rekurencyjny spinlock (jak na ESP32 — ten sam wątek może
+ * wejść ponownie). Sekcje krytyczne w core są krótkie, więc spin jest tańszy
+ * niż pthread_mutex i lepiej oddaje koszt z targetu.
+ */
+typedef struct {
+    volatile uintptr_t owner;
+    volatile uint32_t  count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0u, 0u }
+
+void host_mux_enter(portMUX_TYPE* mux);
+void host_mux_exit(portMUX_TYPE* mux);
+
+#define portENTER_CRITICAL(mux)     host_mux_enter(mux)
+#define portEXIT_CRITICAL(mux)      host_mux_exit(mux)
+#define portENTER_CRITICAL_ISR(mux) host_mux_enter(mux)
+#define portEXIT_CRITICAL_ISR(mux)  host_mux_exit(mux)
+
+/*
+ * Rdzenie na hoście: każdy wątek dostaje przy pierwszym użyciu "rdzeń" (round‑robin),
+ * a maska przerwań = rekurencyjna blokada tego rdzenia — jak na targecie, pod maską
+ * nic innego nie wykonuje się na tym samym rdzeniu.
+ */
+#define portNUM_PROCESSORS 2
+
+int      xPortGetCoreID(void);
+uint32_t host_irq_mask(void);
+void     host_irq_unmask(uint32_t prev);
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()      host_irq_mask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)   host_irq_unmask(x)
+
+/* Na hoście nie ma ISR — "FromISR" to zwykłe wywołania bez blokowania. */
+#define portYIELD_FROM_ISR(...) ((void)0)
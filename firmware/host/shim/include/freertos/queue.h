@@ -0,0 +1,29 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_queue* QueueHandle_t;
+typedef struct host_queue* QueueSetHandle_t;
+typedef struct host_queue* QueueSetMemberHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void          vQueueDelete(QueueHandle_t q);
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait);
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t wait);
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void* item, TickType_t wait);
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void* item);
+BaseType_t xQueueReceive(QueueHandle_t q, void* out, TickType_t wait);
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* hpw);
+BaseType_t xQueueSendToFrontFromISR(QueueHandle_t q, const void* item, BaseType_t* hpw);
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t q, const void* item, BaseType_t* hpw);
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+UBaseType_t uxQueueMessagesWaitingFromISR(QueueHandle_t q);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q);
+
+/* QueueSet: zbiór = kolejka uchwytów, jeden token na element dodany do członka. */
+QueueSetHandle_t       xQueueCreateSet(UBaseType_t length);
+BaseType_t             xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set);
+BaseType_t             xQueueRemoveFromSet(QueueSetMemberHandle_t member, QueueSetHandle_t set);
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t wait);
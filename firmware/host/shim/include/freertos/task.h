@@ -0,0 +1,20 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+void       vTaskDelay(TickType_t ticks);
+
+#define taskYIELD() host_task_yield()
+void host_task_yield(void);
+
+/*
+ * Notyfikacje tasków (licznikowe, indeks 0): uchwyt = licznik + condvar wątku,
+ * tworzony przy pierwszym xTaskGetCurrentTaskHandle() i ważny do końca procesu.
+ */
+typedef struct host_task* TaskHandle_t;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+void         vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* hpw);
+uint32_t     ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t wait);
@@ -0,0 +1,73 @@
+#pragma once
+/*
+ * sdkconfig dla buildu hosta (Linux) — odpowiednik domyślnych wartości z Kconfig.
+ * Każdą opcję można nadpisać z CMake: -DHOST_SDKCONFIG_DEFS="CONFIG_X=1;CONFIG_Y=2".
+ */
+
+/* core__ev */
+#ifndef CONFIG_CORE_EV_MAX_SUBS
+#define CONFIG_CORE_EV_MAX_SUBS 12
+#endif
+#ifndef CONFIG_CORE_EV_PRIO_LANE_DEPTH
+#define CONFIG_CORE_EV_PRIO_LANE_DEPTH 4
+#endif
+#ifndef CONFIG_CORE_EV_SCHEMA_GUARD
+#define CONFIG_CORE_EV_SCHEMA_GUARD 1
+#endif
+/* Selftest drukuje na stdout — wyłączony, żeby nie mieszać z JSON Lines benchmarku. */
+#ifndef CONFIG_CORE_EV_SCHEMA_SELFTEST_ON_BOOT
+#define CONFIG_CORE_EV_SCHEMA_SELFTEST_ON_BOOT 0
+#endif
+
+/* core__leasepool */
+#ifndef CONFIG_CORE_LEASEPOOL_NUM_CLASSES
+#define CONFIG_CORE_LEASEPOOL_NUM_CLASSES 1
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_SLOTS
+#define CONFIG_CORE_LEASEPOOL_SLOTS 32
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_SLOT_BYTES
+#define CONFIG_CORE_LEASEPOOL_SLOT_BYTES 64
+#endif
+/* CLASS1..3_SLOTS/BYTES: tylko gdy NUM_CLASSES > 1 (podawane przez HOST_SDKCONFIG_DEFS). */
+#ifndef CONFIG_CORE_LEASEPOOL_LOCKFREE
+#define CONFIG_CORE_LEASEPOOL_LOCKFREE 1
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE
+#define CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE 8
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_SLICES
+#define CONFIG_CORE_LEASEPOOL_SLICES 16
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_RESERVE_CRITICAL
+#define CONFIG_CORE_LEASEPOOL_RESERVE_CRITICAL 2
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_RESERVE_NORMAL
+#define CONFIG_CORE_LEASEPOOL_RESERVE_NORMAL 2
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_OWNERS
+#define CONFIG_CORE_LEASEPOOL_OWNERS 8
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_LEAK_AGE_MS
+#define CONFIG_CORE_LEASEPOOL_LEAK_AGE_MS 5000
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_HIST
+#define CONFIG_CORE_LEASEPOOL_HIST 0
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_GUARD
+#define CONFIG_CORE_LEASEPOOL_GUARD 1
+#endif
+#ifndef CONFIG_CORE_LEASEPOOL_SELFTEST_ON_BOOT
+#define CONFIG_CORE_LEASEPOOL_SELFTEST_ON_BOOT 0
+#endif
+
+/* infrastructure__logging (tylko infra_log_deferred.c: kodek + ring rekordów) */
+#ifndef CONFIG_INFRA_LOG_DEFERRED
+#define CONFIG_INFRA_LOG_DEFERRED 1
+#endif
+#ifndef CONFIG_INFRA_LOG_DEFERRED_RING_SIZE
+#define CONFIG_INFRA_LOG_DEFERRED_RING_SIZE 4096
+#endif
+#ifndef CONFIG_INFRA_LOG_DEFERRED_STR_MAX
+#define CONFIG_INFRA_LOG_DEFERRED_STR_MAX 32
+#endif
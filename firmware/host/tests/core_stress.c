@@ -0,0 +1,1071 @@
+/*
+ * core_stress — wielowątkowy test prymitywów core na hoście (ctest; także pod TSAN:
+ * -DHOST_SANITIZE=thread).
+ *
+ * Scenariusze (wątki z losowymi przeplotami: sched_yield / krótki spin / usleep wstrzykiwane
+ * w losowych miejscach wg ziarna; dane weryfikuje zawsze strona odbierająca):
+ *  - spsc_bytes:     write/reserve+commit <-> read/peek+consume/read_until, bajt = f(pozycja),
+ *  - spsc_records:   rekordy (także porzucone i skrócone) <-> peek_record/consume_record,
+ *  - spsc_wait:      jak records, ale obie strony śpią w wait_readable/wait_writable
+ *                    (timeout przy aktywnej drugiej stronie = zgubiona pobudka),
+ *  - spsc_overwrite: write_overwrite <-> read_overwrite + copy_overwrite (bez wymieszanych bajtów),
+ *  - mpsc:           4 producentów <-> konsument, numeracja per producent bez luk i duplikatów,
+ *  - lp_handoff:     alloc + zapis + lp_commit u producentów, uchwyt przez mpsc_ring do konsumenta,
+ *                    część dalej (addref) przez spsc_ring do drugiego; weryfikacja len i wzorca,
+ *  - ev_fanout:      ev_post / ev_post_lease z kilku wątków <-> subskrybenci ev_recv: kolejność
+ *                    per nadawca, payload leasów; na końcu pula pusta i lp_check bez błędów,
+ *  - ev_churn:       posty krytyczne (pas priorytetowy: LEASE, "ISR", COPY) równolegle z
+ *                    ev_subscribe / ev_recv / ev_unsubscribe; pod ASAN łapie użycie usuniętego
+ *                    pasu, pusta pula na końcu — LEASE wysłany do pasu po jego opróżnieniu.
+ * Każdy scenariusz wypisuje linię JSON (jak core_bench): ops, ns, ops_per_s, errors —
+ * ten sam harness mierzy przepustowość przy zmianach lock-free.
+ *
+ * Użycie: core_stress [--seed N] [--ops N] [--soak SEKUNDY] [--only NAZWA]
+ *   --seed: powtórzenie przebiegu z raportu (domyślnie z zegara, wypisywane w linii "meta"),
+ *   --soak: producenci pracują do upływu czasu zamiast stałej liczby operacji.
+ */
+#include "sdkconfig.h"
+#include "core/spsc_ring.h"
+#include "core/mpsc_ring.h"
+#include "core/leasepool.h"
+#include "core_ev.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t    s_seed   = 0;
+static uint64_t    s_ops    = 100000u;
+static double      s_soak_s = 0.0;
+static const char* s_only   = NULL;
+static uint32_t    s_errors = 0;
+
+static uint64_t now_ns_(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* ===================== harness ===================== */
+
+typedef struct {
+    uint64_t s;
+} rng_t;
+
+static rng_t rng_for_(const uint32_t stream)
+{
+    rng_t r = { .s = (s_seed + 1u) * 0x9E3779B97F4A7C15ull ^ ((uint64_t)stream << 32 | stream) };
+    if (r.s == 0) r.s = 1;
+    return r;
+}
+
+static uint32_t rng_next_(rng_t* r)
+{
+    r->s ^= r->s << 13;
+    r->s ^= r->s >> 7;
+    r->s ^= r->s << 17;
+    return (uint32_t)(r->s >> 16);
+}
+
+/* Losowe zaburzenie przeplotu: zwykle nic, czasem yield, spin albo krótki sen. */
+static void chaos_(rng_t* r)
+{
+    const uint32_t x = rng_next_(r) & 1023u;
+    if (x < 40u) {
+        (void)sched_yield();
+    } else if (x < 48u) {
+        for (volatile uint32_t i = 0, n = rng_next_(r) & 255u; i < n; i = i + 1u) { }
+    } else if (x == 1023u) {
+        (void)usleep(50);
+    }
+}
+
+/* Budżet producenta: stała liczba operacji albo czas (--soak). */
+typedef struct {
+    uint64_t ops;
+    uint64_t t_end;
+} budget_t;
+
+static budget_t budget_(const uint64_t ops)
+{
+    budget_t b = { .ops = ops, .t_end = 0 };
+    if (s_soak_s > 0.0) b.t_end = now_ns_() + (uint64_t)(s_soak_s * 1e9);
+    return b;
+}
+
+static bool more_(const budget_t* b, const uint64_t done)
+{
+    if (b->t_end != 0) return (done & 63u) != 0u || now_ns_() < b->t_end;
+    return done < b->ops;
+}
+
+/* Pierwsze błędy na stderr; przy lawinie (np. zgubione pobudki = timeout na każdej operacji) koniec. */
+static void fail_(const char* scen, const char* why, const uint64_t at)
+{
+    const uint32_t n = __atomic_add_fetch(&s_errors, 1u, __ATOMIC_RELAXED);
+    if (n <= 20u) {
+        fprintf(stderr, "core_stress[%s]: %s (at=%llu seed=%llu)\n", scen, why,
+                (unsigned long long)at, (unsigned long long)s_seed);
+    }
+    if (n >= 100u) {
+        fprintf(stderr, "core_stress: too many errors, aborting (seed=%llu)\n", (unsigned long long)s_seed);
+        exit(1);
+    }
+}
+
+static bool enabled_(const char* name)
+{
+    return !s_only || strcmp(s_only, name) == 0;
+}
+
+static void report_(const char* scen, const unsigned threads, const uint64_t ops, const uint64_t ns,
+                    const uint32_t errors_before)
+{
+    printf("{\"stress\":\"%s\",\"seed\":%llu,\"threads\":%u,\"ops\":%llu,\"ns\":%llu,\"ops_per_s\":%.0f,\"errors\":%u}\n",
+           scen, (unsigned long long)s_seed, threads, (unsigned long long)ops, (unsigned long long)ns,
+           ns ? (double)ops * 1e9 / (double)ns : 0.0,
+           (unsigned)(__atomic_load_n(&s_errors, __ATOMIC_RELAXED) - errors_before));
+    fflush(stdout);
+}
+
+static bool spawn_(pthread_t* th, void* (*fn)(void*), void* arg)
+{
+    if (pthread_create(th, NULL, fn, arg) == 0) return true;
+    fail_("harness", "pthread_create failed", 0);
+    return false;
+}
+
+static uint8_t pat_(const uint32_t pos)
+{
+    return (uint8_t)(pos % 251u);
+}
+
+/* ===================== spsc_ring: bajty ===================== */
+
+enum { SPSC_CAP = 256u, REC_CAP = 512u };
+
+static uint8_t s_ring_mem[4096] __attribute__((aligned(64)));
+
+typedef struct {
+    spsc_ring_t* rb;
+    budget_t     budget;
+    uint32_t     seed;
+    bool         done;      /* atomik: producent skończył */
+    uint32_t     produced;  /* bajty/rekordy wyprodukowane (ważne po done) */
+    uint64_t     ops;       /* operacje konsumenta */
+} pair_t;
+
+static void* bytes_producer_(void* arg)
+{
+    pair_t* p = arg;
+    rng_t r = rng_for_(p->seed);
+    uint8_t buf[64];
+    uint32_t pos = 0;
+
+    for (uint64_t i = 0; more_(&p->budget, i); i++) {
+        const size_t len = 1u + rng_next_(&r) % sizeof(buf);
+        for (size_t k = 0; k < len; k++) buf[k] = pat_(pos + (uint32_t)k);
+
+        size_t n = 0;
+        switch (rng_next_(&r) % 3u) {
+        case 0:
+            n = spsc_ring_write(p->rb, buf, len, false);
+            break;
+        case 1: {
+            size_t got = 0;
+            uint8_t* w = spsc_ring_reserve(p->rb, len, &got);
+            if (w) {
+                n = got < len ? got : len;
+                memcpy(w, buf, n);
+                spsc_ring_commit(p->rb, n);
+            }
+            break;
+        }
+        default:
+            n = spsc_ring_write(p->rb, buf, len, true);
+            break;
+        }
+        pos += (uint32_t)n;
+        if (n == 0) (void)sched_yield();
+        chaos_(&r);
+    }
+    p->produced = pos;
+    __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* bytes_consumer_(void* arg)
+{
+    pair_t* p = arg;
+    rng_t r = rng_for_(p->seed + 1u);
+    uint8_t buf[96];
+    uint32_t pos = 0;
+
+    for (;;) {
+        const bool done = __atomic_load_n(&p->done, __ATOMIC_ACQUIRE);
+        size_t n = 0;
+        const uint8_t* src = buf;
+        switch (rng_next_(&r) % 3u) {
+        case 0:
+            n = spsc_ring_read(p->rb, buf, 1u + rng_next_(&r) % sizeof(buf));
+            break;
+        case 1: {
+            src = spsc_ring_peek(p->rb, &n);
+            if (!src) n = 0;
+            break;
+        }
+        default: {
+            bool found = false;
+            n = spsc_ring_read_until(p->rb, buf, sizeof(buf), pat_(rng_next_(&r)), &found);
+            break;
+        }
+        }
+
+        for (size_t k = 0; k < n; k++) {
+            if (src[k] != pat_(pos + (uint32_t)k)) {
+                fail_("spsc_bytes", "byte mismatch", pos + k);
+                break;
+            }
+        }
+        if (src != buf && n > 0) spsc_ring_consume(p->rb, n);
+        pos += (uint32_t)n;
+        if (n > 0) p->ops++;
+
+        if (n == 0) {
+            if (done && pos == p->produced) break;
+            (void)sched_yield();
+        }
+        chaos_(&r);
+    }
+    if (spsc_ring_used(p->rb) != 0) fail_("spsc_bytes", "ring not empty at the end", pos);
+    return NULL;
+}
+
+static void stress_spsc_bytes_(void)
+{
+    const uint32_t e0 = s_errors;
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_mem, SPSC_CAP);
+    pair_t p = { .rb = &rb, .budget = budget_(s_ops), .seed = 10u };
+
+    const uint64_t t0 = now_ns_();
+    pthread_t tp, tc;
+    if (!spawn_(&tp, bytes_producer_, &p)) return;
+    if (!spawn_(&tc, bytes_consumer_, &p)) {
+        pthread_join(tp, NULL);
+        return;
+    }
+    pthread_join(tp, NULL);
+    pthread_join(tc, NULL);
+    report_("spsc_bytes", 2, p.ops, now_ns_() - t0, e0);
+}
+
+/* ===================== spsc_ring: rekordy (+ wait) ===================== */
+
+typedef struct {
+    pair_t base;
+    bool   wait;
+} rec_pair_t;
+
+enum { WAIT_MS = 200 };
+
+/*
+ * Zgubiona pobudka: wait kończy się po pełnym timeoucie, choć warunek już jest spełniony
+ * (ok), albo timeout, gdy druga strona wciąż pracuje (przy tych progach zawsze któraś
+ * strona ma warunek spełniony, więc obie śpiące = zakleszczenie).
+ */
+static void wait_check_(const bool ok, const uint64_t ns, const bool peer_done, const uint32_t at)
+{
+    const bool full = ns >= (uint64_t)WAIT_MS * 1000000ull * 3u / 4u;
+    if (ok && full) fail_("spsc_wait", "woken only by timeout (lost wakeup)", at);
+    if (!ok && !peer_done) fail_("spsc_wait", "wait timed out while peer active", at);
+}
+
+/* Rekord: u32 numer + bajty pat_(numer + i). */
+static void* rec_producer_(void* arg)
+{
+    rec_pair_t* rp = arg;
+    pair_t* p = &rp->base;
+    rng_t r = rng_for_(p->seed);
+    const size_t max = spsc_ring_record_max(p->rb);
+    uint32_t seq = 0;
+
+    for (uint64_t i = 0; more_(&p->budget, i); i++) {
+        const size_t n = 4u + rng_next_(&r) % (max - 3u);
+        uint8_t* w = spsc_ring_reserve_record(p->rb, n);
+        if (!w) {
+            if (rp->wait) {
+                const uint64_t t0 = now_ns_();
+                const bool ok = spsc_ring_wait_writable(p->rb, n + 8u, pdMS_TO_TICKS(WAIT_MS));
+                wait_check_(ok, now_ns_() - t0, false, seq);
+            } else {
+                (void)sched_yield();
+            }
+            continue;
+        }
+
+        if ((rng_next_(&r) & 15u) == 0u) {
+            spsc_ring_commit_record(p->rb, 0); // porzucona rezerwacja
+            continue;
+        }
+        const size_t len = 4u + rng_next_(&r) % (n - 3u); // skrócony commit
+        memcpy(w, &seq, 4);
+        for (size_t k = 4; k < len; k++) w[k] = pat_(seq + (uint32_t)k);
+        chaos_(&r); // między zapisem a publikacją
+        spsc_ring_commit_record(p->rb, len);
+        seq++;
+        chaos_(&r);
+    }
+    p->produced = seq;
+    __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* rec_consumer_(void* arg)
+{
+    rec_pair_t* rp = arg;
+    pair_t* p = &rp->base;
+    const char* scen = rp->wait ? "spsc_wait" : "spsc_records";
+    rng_t r = rng_for_(p->seed + 1u);
+    uint32_t expect = 0;
+
+    for (;;) {
+        const bool done = __atomic_load_n(&p->done, __ATOMIC_ACQUIRE);
+        size_t n = 0;
+        const uint8_t* rec = spsc_ring_peek_record(p->rb, &n);
+        if (!rec) {
+            if (done && expect == p->produced) break;
+            if (!rp->wait) {
+                (void)sched_yield();
+            } else if (!done) {
+                // Próg losowy: producent może skończyć poniżej progu — wtedy timeout to nie błąd.
+                const uint64_t t0 = now_ns_();
+                const bool ok = spsc_ring_wait_readable(p->rb, 1u + rng_next_(&r) % 96u, pdMS_TO_TICKS(WAIT_MS));
+                wait_check_(ok, now_ns_() - t0, __atomic_load_n(&p->done, __ATOMIC_ACQUIRE), expect);
+            }
+            continue;
+        }
+
+        uint32_t seq;
+        memcpy(&seq, rec, 4);
+        if (n < 4u || seq != expect) {
+            fail_(scen, "record out of order", expect);
+        } else {
+            for (size_t k = 4; k < n; k++) {
+                if (rec[k] != pat_(seq + (uint32_t)k)) {
+                    fail_(scen, "record payload mismatch", seq);
+                    break;
+                }
+            }
+        }
+        expect = seq + 1u;
+        spsc_ring_consume_record(p->rb);
+        p->ops++;
+        chaos_(&r);
+    }
+    return NULL;
+}
+
+static void stress_spsc_records_(const bool wait)
+{
+    const uint32_t e0 = s_errors;
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_mem, REC_CAP);
+    if (wait) spsc_ring_enable_wait(&rb);
+    rec_pair_t p = { .base = { .rb = &rb, .budget = budget_(s_ops), .seed = wait ? 30u : 20u }, .wait = wait };
+
+    const uint64_t t0 = now_ns_();
+    pthread_t tp, tc;
+    if (!spawn_(&tp, rec_producer_, &p)) return;
+    if (!spawn_(&tc, rec_consumer_, &p)) {
+        pthread_join(tp, NULL);
+        return;
+    }
+    pthread_join(tp, NULL);
+    pthread_join(tc, NULL);
+    report_(wait ? "spsc_wait" : "spsc_records", 2, p.base.ops, now_ns_() - t0, e0);
+}
+
+/* ===================== spsc_ring: nadpisywanie ===================== */
+
+static void* ovw_writer_(void* arg)
+{
+    pair_t* p = arg;
+    rng_t r = rng_for_(p->seed);
+    uint8_t buf[100];
+    uint32_t pos = 0;
+
+    for (uint64_t i = 0; more_(&p->budget, i); i++) {
+        const size_t len = 1u + rng_next_(&r) % sizeof(buf);
+        for (size_t k = 0; k < len; k++) buf[k] = pat_(pos + (uint32_t)k);
+        spsc_ring_write_overwrite(p->rb, buf, len);
+        pos += (uint32_t)len;
+        chaos_(&r);
+    }
+    p->produced = pos;
+    __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* Migawka: kolejne bajty muszą być kolejnymi pozycjami (bez sklejenia dwóch okrążeń). */
+static void ovw_check_run_(const uint8_t* b, const size_t n)
+{
+    for (size_t k = 1; k < n; k++) {
+        if (b[k] != (uint8_t)((b[k - 1] + 1u) % 251u)) {
+            fail_("spsc_overwrite", "snapshot mixes two laps", k);
+            return;
+        }
+    }
+}
+
+static void* ovw_reader_(void* arg)
+{
+    pair_t* p = arg;
+    rng_t r = rng_for_(p->seed + 1u);
+    uint8_t buf[SPSC_CAP];
+    uint32_t pos = 0;
+
+    for (;;) {
+        const bool done = __atomic_load_n(&p->done, __ATOMIC_ACQUIRE);
+        if (rng_next_(&r) & 1u) {
+            const size_t n = spsc_ring_copy_overwrite(p->rb, buf, 1u + rng_next_(&r) % sizeof(buf),
+                                                      (rng_next_(&r) & 1u) != 0u);
+            ovw_check_run_(buf, n);
+            p->ops++;
+        } else {
+            uint32_t lost = 0;
+            const size_t n = spsc_ring_read_overwrite(p->rb, buf, 1u + rng_next_(&r) % sizeof(buf), &lost);
+            pos += lost;
+            for (size_t k = 0; k < n; k++) {
+                if (buf[k] != pat_(pos + (uint32_t)k)) {
+                    fail_("spsc_overwrite", "read returned overwritten bytes", pos + k);
+                    break;
+                }
+            }
+            pos += (uint32_t)n;
+            if (n > 0) p->ops++;
+            if (n == 0 && done) break;
+        }
+        chaos_(&r);
+    }
+    if (pos != p->produced) fail_("spsc_overwrite", "reader position != writer position", pos);
+    return NULL;
+}
+
+static void stress_spsc_overwrite_(void)
+{
+    const uint32_t e0 = s_errors;
+    spsc_ring_t rb;
+    (void)spsc_ring_init(&rb, s_ring_mem, SPSC_CAP);
+    pair_t p = { .rb = &rb, .budget = budget_(s_ops), .seed = 40u };
+
+    const uint64_t t0 = now_ns_();
+    pthread_t tp, tc;
+    if (!spawn_(&tp, ovw_writer_, &p)) return;
+    if (!spawn_(&tc, ovw_reader_, &p)) {
+        pthread_join(tp, NULL);
+        return;
+    }
+    pthread_join(tp, NULL);
+    pthread_join(tc, NULL);
+    report_("spsc_overwrite", 2, p.ops, now_ns_() - t0, e0);
+}
+
+/* ===================== mpsc_ring ===================== */
+
+enum { MPSC_PRODUCERS = 4, MPSC_CAP = 1024u };
+
+typedef struct {
+    mpsc_ring_t* rb;
+    budget_t     budget;
+    uint32_t     id;
+    uint32_t     produced;  /* ważne po done */
+    bool         done;
+} mpsc_prod_t;
+
+/* Rekord: u8 id, u32 numer (od offsetu 1, memcpy), reszta pat_(numer + i). */
+static void* mpsc_producer_(void* arg)
+{
+    mpsc_prod_t* p = arg;
+    rng_t r = rng_for_(50u + p->id);
+    const size_t max = mpsc_ring_record_max(p->rb) < 96u ? mpsc_ring_record_max(p->rb) : 96u;
+    uint32_t seq = 0;
+
+    for (uint64_t i = 0; more_(&p->budget, i); i++) {
+        const size_t n = 5u + rng_next_(&r) % (max - 4u);
+        mpsc_ring_resv_t resv;
+        uint8_t* w = mpsc_ring_reserve(p->rb, n, &resv);
+        if (!w) {
+            (void)sched_yield();
+            continue;
+        }
+        if ((rng_next_(&r) & 15u) == 0u) {
+            chaos_(&r);
+            (void)mpsc_ring_commit(p->rb, &resv, 0); // porzucona rezerwacja
+            continue;
+        }
+        w[0] = (uint8_t)p->id;
+        memcpy(w + 1, &seq, 4);
+        for (size_t k = 5; k < n; k++) w[k] = pat_(seq + (uint32_t)k);
+        chaos_(&r); // wstrzymany producent między reserve a commit
+        (void)mpsc_ring_commit(p->rb, &resv, n);
+        seq++;
+    }
+    p->produced = seq;
+    __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void stress_mpsc_(void)
+{
+    const uint32_t e0 = s_errors;
+    static mpsc_ring_t rb;
+    (void)mpsc_ring_init(&rb, s_ring_mem, MPSC_CAP);
+
+    mpsc_prod_t prod[MPSC_PRODUCERS];
+    pthread_t th[MPSC_PRODUCERS];
+    const budget_t b = budget_(s_ops / MPSC_PRODUCERS);
+    size_t started = 0;
+
+    const uint64_t t0 = now_ns_();
+    for (; started < MPSC_PRODUCERS; started++) {
+        prod[started] = (mpsc_prod_t){ .rb = &rb, .budget = b, .id = (uint32_t)started };
+        if (!spawn_(&th[started], mpsc_producer_, &prod[started])) break;
+    }
+
+    rng_t r = rng_for_(59u);
+    uint32_t expect[MPSC_PRODUCERS] = {0};
+    uint64_t ops = 0;
+    for (;;) {
+        bool all_done = true;
+        for (size_t i = 0; i < started; i++) all_done &= __atomic_load_n(&prod[i].done, __ATOMIC_ACQUIRE);
+
+        size_t n = 0;
+        const uint8_t* rec = mpsc_ring_peek(&rb, &n);
+        if (!rec) {
+            if (all_done) {
+                bool complete = true;
+                for (size_t i = 0; i < started; i++) complete &= (expect[i] == prod[i].produced);
+                if (complete || mpsc_ring_used(&rb) == 0) break;
+            }
+            (void)sched_yield();
+            continue;
+        }
+
+        uint32_t seq;
+        memcpy(&seq, rec + 1, 4);
+        const uint8_t id = rec[0];
+        if (n < 5u || id >= started || seq != expect[id]) {
+            fail_("mpsc", "record out of order / unknown producer", ops);
+        } else {
+            for (size_t k = 5; k < n; k++) {
+                if (rec[k] != pat_(seq + (uint32_t)k)) {
+                    fail_("mpsc", "record payload mismatch", seq);
+                    break;
+                }
+            }
+            expect[id] = seq + 1u;
+        }
+        mpsc_ring_consume(&rb);
+        ops++;
+        chaos_(&r);
+    }
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(th[i], NULL);
+        if (expect[i] != prod[i].produced) fail_("mpsc", "records lost", i);
+    }
+    report_("mpsc", (unsigned)started + 1u, ops, now_ns_() - t0, e0);
+}
+
+/* ===================== leasepool: przekazanie uchwytów ===================== */
+
+enum { LP_PRODUCERS = 3, LP_MAX_SEGS = 4 };
+
+typedef struct {
+    uint32_t packed;
+    uint32_t len;
+} lp_msg_t;
+
+typedef struct {
+    mpsc_ring_t* q;
+    budget_t     budget;
+    uint32_t     id;
+    uint32_t     produced;
+    bool         done;
+} lp_prod_t;
+
+static uint8_t lp_pat_(const lp_handle_t h)
+{
+    return (uint8_t)(h.idx ^ h.gen ^ 0x5Au);
+}
+
+static void lp_verify_release_(const char* who, const lp_handle_t h, const uint32_t len)
+{
+    lp_iov_t iov[LP_MAX_SEGS];
+    const size_t n = lp_acquire_iov(h, iov, LP_MAX_SEGS);
+    uint32_t total = 0;
+    bool ok = (n > 0);
+    for (size_t s = 0; s < n && s < LP_MAX_SEGS && ok; s++) {
+        const uint8_t* b = iov[s].ptr;
+        for (uint32_t i = 0; i < iov[s].len; i++) {
+            if (b[i] != lp_pat_(h)) {
+                fail_(who, "lease payload mismatch (commit not visible?)", h.idx);
+                ok = false;
+                break;
+            }
+        }
+        total += iov[s].len;
+    }
+    if (ok && total != len) fail_(who, "lease length mismatch", h.idx);
+    if (n == 0) fail_(who, "lease not acquirable", h.idx);
+    lp_release(h);
+}
+
+static void* lp_producer_(void* arg)
+{
+    lp_prod_t* p = arg;
+    rng_t r = rng_for_(60u + p->id);
+    uint32_t made = 0;
+
+    for (uint64_t i = 0; more_(&p->budget, i); i++) {
+        const uint32_t want = 1u + rng_next_(&r) % CONFIG_CORE_LEASEPOOL_SLOT_BYTES;
+        const lp_handle_t h = lp_alloc_try(want);
+        lp_view_t v;
+        if (!lp_handle_is_valid(h)) {
+            (void)sched_yield();
+            continue;
+        }
+        if (!lp_acquire(h, &v)) {
+            fail_("lp_handoff", "acquire after alloc", h.idx);
+            continue;
+        }
+        memset(v.ptr, lp_pat_(h), want);
+        chaos_(&r);
+        lp_commit(h, want);
+
+        const lp_msg_t m = { .packed = lp_pack_handle_u32(h), .len = want };
+        mpsc_ring_resv_t resv;
+        uint8_t* w;
+        while ((w = mpsc_ring_reserve(p->q, sizeof(m), &resv)) == NULL) (void)sched_yield();
+        memcpy(w, &m, sizeof(m));
+        (void)mpsc_ring_commit(p->q, &resv, sizeof(m));
+        made++;
+        chaos_(&r);
+    }
+    p->produced = made;
+    __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+typedef struct {
+    spsc_ring_t* fwd;
+    bool         done;
+    uint64_t     ops;
+} lp_fwd_t;
+
+static void* lp_second_(void* arg)
+{
+    lp_fwd_t* f = arg;
+    rng_t r = rng_for_(69u);
+    lp_msg_t m;
+    for (;;) {
+        const bool done = __atomic_load_n(&f->done, __ATOMIC_ACQUIRE);
+        if (spsc_ring_read(f->fwd, &m, sizeof(m)) == sizeof(m)) {
+            lp_verify_release_("lp_handoff", lp_unpack_handle_u32(m.packed), m.len);
+            f->ops++;
+        } else if (done) {
+            break;
+        } else {
+            (void)sched_yield();
+        }
+        chaos_(&r);
+    }
+    return NULL;
+}
+
+static void stress_lp_handoff_(void)
+{
+    const uint32_t e0 = s_errors;
+    lp_init();
+
+    static mpsc_ring_t q;
+    static spsc_ring_t fwd;
+    (void)mpsc_ring_init(&q, s_ring_mem, 1024u);
+    (void)spsc_ring_init(&fwd, s_ring_mem + 1024u, 64u);
+
+    lp_prod_t prod[LP_PRODUCERS];
+    pthread_t th[LP_PRODUCERS], t2;
+    lp_fwd_t f = { .fwd = &fwd };
+    const budget_t b = budget_(s_ops / LP_PRODUCERS);
+    size_t started = 0;
+
+    const uint64_t t0 = now_ns_();
+    if (!spawn_(&t2, lp_second_, &f)) return;
+    for (; started < LP_PRODUCERS; started++) {
+        prod[started] = (lp_prod_t){ .q = &q, .budget = b, .id = (uint32_t)started };
+        if (!spawn_(&th[started], lp_producer_, &prod[started])) break;
+    }
+
+    rng_t r = rng_for_(68u);
+    uint64_t got = 0;
+    for (;;) {
+        bool all_done = true;
+        for (size_t i = 0; i < started; i++) all_done &= __atomic_load_n(&prod[i].done, __ATOMIC_ACQUIRE);
+
+        size_t n = 0;
+        const uint8_t* rec = mpsc_ring_peek(&q, &n);
+        if (!rec) {
+            if (all_done && mpsc_ring_used(&q) == 0) break;
+            (void)sched_yield();
+            continue;
+        }
+        lp_msg_t m;
+        memcpy(&m, rec, sizeof(m));
+        mpsc_ring_consume(&q);
+        got++;
+
+        const lp_handle_t h = lp_unpack_handle_u32(m.packed);
+        switch (rng_next_(&r) % 3u) {
+        case 0: // oddanie własności drugiemu konsumentowi
+            if (spsc_ring_write(&fwd, &m, sizeof(m), true) == sizeof(m)) break;
+            lp_verify_release_("lp_handoff", h, m.len);
+            break;
+        case 1: // współdzielenie: addref, drugi weryfikuje współbieżnie
+            lp_addref_n(h, 1);
+            if (spsc_ring_write(&fwd, &m, sizeof(m), true) != sizeof(m)) lp_release(h);
+            lp_verify_release_("lp_handoff", h, m.len);
+            break;
+        default:
+            lp_verify_release_("lp_handoff", h, m.len);
+            break;
+        }
+        chaos_(&r);
+    }
+    __atomic_store_n(&f.done, true, __ATOMIC_RELEASE);
+    pthread_join(t2, NULL);
+
+    uint64_t produced = 0;
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(th[i], NULL);
+        produced += prod[i].produced;
+    }
+    if (produced != got) fail_("lp_handoff", "handles lost in transit", got);
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    if (st.slots_used != 0) fail_("lp_handoff", "pool not empty at the end (leak)", st.slots_used);
+    if (lp_check(false) != 0 || st.guard_failures != 0) fail_("lp_handoff", "lp_check/guard reported issues", 0);
+    report_("lp_handoff", (unsigned)started + 2u, got + f.ops, now_ns_() - t0, e0);
+}
+
+/* ===================== core_ev: fan-out ===================== */
+
+enum { EV_POSTERS = 2, EV_SUBS = 3, EV_DEPTH = 32 };
+
+typedef struct {
+    budget_t budget;
+    uint32_t id;
+    bool     done;
+} ev_poster_t;
+
+typedef struct {
+    ev_queue_t          q;
+    const ev_poster_t*  posters;
+    uint64_t            ops;
+} ev_sub_arg_t;
+
+/* a0/payload: id nadawcy (8 bitów) | numer (24 bity). */
+static void* ev_poster_(void* arg)
+{
+    ev_poster_t* p = arg;
+    rng_t r = rng_for_(70u + p->id);
+    uint32_t seq = 0;
+
+    for (uint64_t i = 0; more_(&p->budget, i); i++) {
+        const uint32_t tag = (p->id << 24) | (seq & 0xFFFFFFu);
+        if ((rng_next_(&r) & 3u) == 0u) {
+            const uint16_t len = (uint16_t)(4u + rng_next_(&r) % 28u);
+            const lp_handle_t h = lp_alloc_try(len);
+            lp_view_t v;
+            if (!lp_acquire(h, &v)) {
+                (void)sched_yield();
+                continue;
+            }
+            uint8_t* b = v.ptr;
+            memcpy(b, &tag, 4);
+            memset(b + 4, (int)(tag & 0xFFu), len - 4u);
+            lp_commit(h, len);
+            (void)ev_post_lease(EV_SRC_UART, EV_UART_FRAME, h, len);
+        } else {
+            (void)ev_post(EV_SRC_GPIO, EV_GPIO_INPUT, tag, ~tag);
+        }
+        seq++;
+        chaos_(&r);
+    }
+    __atomic_store_n(&p->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* ev_subscriber_(void* arg)
+{
+    ev_sub_arg_t* s = arg;
+    rng_t r = rng_for_(80u + (uint32_t)(uintptr_t)s->q);
+    int32_t last[EV_POSTERS];
+    for (size_t i = 0; i < EV_POSTERS; i++) last[i] = -1;
+
+    for (;;) {
+        ev_msg_t m;
+        if (!ev_recv(s->q, &m, pdMS_TO_TICKS(20))) {
+            bool all_done = true;
+            for (size_t i = 0; i < EV_POSTERS; i++) all_done &= __atomic_load_n(&s->posters[i].done, __ATOMIC_ACQUIRE);
+            if (all_done) break;
+            continue;
+        }
+
+        uint32_t tag = 0;
+        if (m.code == EV_UART_FRAME) {
+            const lp_handle_t h = lp_unpack_handle_u32(m.a0);
+            lp_view_t v;
+            if (!lp_acquire(h, &v) || v.len != m.a1 || v.len < 4u) {
+                fail_("ev_fanout", "lease view mismatch", m.seq);
+            } else {
+                const uint8_t* b = v.ptr;
+                memcpy(&tag, b, 4);
+                for (uint32_t k = 4; k < v.len; k++) {
+                    if (b[k] != (uint8_t)(tag & 0xFFu)) {
+                        fail_("ev_fanout", "lease payload mismatch", m.seq);
+                        break;
+                    }
+                }
+            }
+            lp_release(h);
+        } else if (m.code == EV_GPIO_INPUT) {
+            tag = m.a0;
+            if (m.a1 != ~m.a0) fail_("ev_fanout", "copy payload mismatch", m.seq);
+        } else {
+            continue;
+        }
+
+        // Per nadawca numeracja rośnie ściśle (DROP_NEW może gubić, nie może przestawiać).
+        const uint32_t id = tag >> 24;
+        const int32_t n = (int32_t)(tag & 0xFFFFFFu);
+        if (id >= EV_POSTERS || n <= last[id]) {
+            fail_("ev_fanout", "event out of order / duplicated", tag);
+        } else {
+            last[id] = n;
+        }
+        s->ops++;
+        chaos_(&r);
+    }
+    return NULL;
+}
+
+static void stress_ev_fanout_(void)
+{
+    const uint32_t e0 = s_errors;
+    lp_init();
+    ev_init();
+
+    ev_sub_arg_t subs[EV_SUBS];
+    ev_poster_t posters[EV_POSTERS];
+    pthread_t ts[EV_SUBS], tp[EV_POSTERS];
+    size_t nsub = 0, npost = 0;
+
+    const budget_t b = budget_(s_ops / EV_POSTERS / 2u);
+    for (size_t i = 0; i < EV_POSTERS; i++) posters[i] = (ev_poster_t){ .budget = b, .id = (uint32_t)i };
+    for (; nsub < EV_SUBS; nsub++) {
+        subs[nsub] = (ev_sub_arg_t){ .posters = posters };
+        if (!ev_subscribe(&subs[nsub].q, EV_DEPTH)) {
+            fail_("ev_fanout", "ev_subscribe failed", nsub);
+            break;
+        }
+    }
+
+    const uint64_t t0 = now_ns_();
+    size_t running = 0;
+    for (; running < nsub; running++) {
+        if (!spawn_(&ts[running], ev_subscriber_, &subs[running])) break;
+    }
+    for (; npost < EV_POSTERS; npost++) {
+        if (!spawn_(&tp[npost], ev_poster_, &posters[npost])) break;
+    }
+    for (size_t i = npost; i < EV_POSTERS; i++) __atomic_store_n(&posters[i].done, true, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < npost; i++) pthread_join(tp[i], NULL);
+
+    uint64_t ops = 0;
+    for (size_t i = 0; i < running; i++) {
+        pthread_join(ts[i], NULL);
+        ops += subs[i].ops;
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    for (size_t i = 0; i < nsub; i++) {
+        ev_msg_t m;
+        while (ev_recv(subs[i].q, &m, 0)) {
+            if (m.code == EV_UART_FRAME) lp_release(lp_unpack_handle_u32(m.a0));
+        }
+        ev_unsubscribe(subs[i].q);
+        vQueueDelete(subs[i].q);
+    }
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    if (st.slots_used != 0) fail_("ev_fanout", "pool not empty at the end (leak)", st.slots_used);
+    if (lp_check(false) != 0) fail_("ev_fanout", "lp_check reported issues", 0);
+    report_("ev_fanout", (unsigned)(npost + running), ops, ns, e0);
+}
+
+/* ===================== core_ev: wypinanie subskrybentów ===================== */
+
+typedef struct {
+    uint32_t id;
+    bool     stop;
+    uint64_t ops;
+} ev_churn_poster_t;
+
+static void* ev_churn_poster_(void* arg)
+{
+    ev_churn_poster_t* p = arg;
+    rng_t r = rng_for_(90u + p->id);
+
+    while (!__atomic_load_n(&p->stop, __ATOMIC_ACQUIRE)) {
+        const uint32_t kind = rng_next_(&r) % 3u;
+        if (kind == 0u) {
+            const lp_handle_t h = lp_alloc_try(8);
+            lp_view_t v;
+            if (!lp_acquire(h, &v)) {
+                (void)sched_yield();
+                continue;
+            }
+            memset(v.ptr, (int)p->id, 8);
+            lp_commit(h, 8);
+            (void)ev_post_lease(EV_SRC_LOG, EV_LOG_NEW, h, 8);
+        } else if (kind == 1u) {
+            (void)ev_post_from_isr(EV_SRC_I2C, EV_I2C_ERROR, p->id, 0);
+        } else {
+            (void)ev_post(EV_SRC_LCD, EV_LCD_ERROR, p->id, 0);
+        }
+        p->ops++;
+        chaos_(&r);
+    }
+    return NULL;
+}
+
+/* Odbiór z wypinanej kolejki (ev_recv przypina pas tylko na czas odczytu). */
+static void ev_churn_drain_(const ev_queue_t q, const TickType_t wait)
+{
+    ev_msg_t m;
+    while (ev_recv(q, &m, wait)) {
+        if (m.code == EV_LOG_NEW) lp_release(lp_unpack_handle_u32(m.a0));
+    }
+}
+
+static void* ev_churn_reader_(void* arg)
+{
+    ev_churn_drain_((ev_queue_t)arg, 1);
+    return NULL;
+}
+
+static void stress_ev_churn_(void)
+{
+    enum { POSTERS = 2 };
+    const uint32_t e0 = s_errors;
+    lp_init();
+
+    const budget_t b = budget_(s_ops / 200u);
+    const uint64_t t0 = now_ns_();
+    uint64_t cycles = 0, posts = 0;
+    unsigned threads = 0;
+
+    // Sloty subskrybentów nie są używane ponownie: runda = EV_MAX_SUBS cykli po ev_init().
+    while (more_(&b, cycles) && s_errors == e0) {
+        ev_init();
+        ev_churn_poster_t p[POSTERS];
+        pthread_t tp[POSTERS];
+        size_t np = 0;
+        for (; np < POSTERS; np++) {
+            p[np] = (ev_churn_poster_t){ .id = (uint32_t)np };
+            if (!spawn_(&tp[np], ev_churn_poster_, &p[np])) break;
+        }
+        threads = (unsigned)np + 2u;
+
+        for (unsigned k = 0; k < EV_MAX_SUBS && more_(&b, cycles); k++, cycles++) {
+            ev_queue_t q = NULL;
+            if (!ev_subscribe(&q, 4)) {
+                fail_("ev_churn", "ev_subscribe failed", cycles);
+                break;
+            }
+            // Drugi wątek odbiera w trakcie ev_unsubscribe(); kolejkę usuwamy dopiero po nim.
+            pthread_t tr;
+            const bool reader = spawn_(&tr, ev_churn_reader_, q);
+            (void)usleep(100u + (unsigned)(cycles % 7u) * 50u);
+            ev_unsubscribe(q);
+            if (reader) pthread_join(tr, NULL);
+            ev_churn_drain_(q, 0);
+            vQueueDelete(q);
+        }
+
+        for (size_t i = 0; i < np; i++) __atomic_store_n(&p[i].stop, true, __ATOMIC_RELEASE);
+        for (size_t i = 0; i < np; i++) {
+            pthread_join(tp[i], NULL);
+            posts += p[i].ops;
+        }
+    }
+    const uint64_t ns = now_ns_() - t0;
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    if (st.slots_used != 0) fail_("ev_churn", "pool not empty at the end (leak)", st.slots_used);
+    if (lp_check(false) != 0) fail_("ev_churn", "lp_check reported issues", 0);
+    report_("ev_churn", threads, cycles + posts, ns, e0);
+}
+
+/* ===================== main ===================== */
+
+int main(int argc, char** argv)
+{
+    s_seed = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            s_seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            s_ops = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--soak") == 0 && i + 1 < argc) {
+            s_soak_s = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            s_only = argv[++i];
+        } else {
+            fprintf(stderr, "użycie: %s [--seed N] [--ops N] [--soak SEKUNDY] [--only NAZWA]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (s_ops < 64u) s_ops = 64u;
+
+    printf("{\"stress\":\"meta\",\"seed\":%llu,\"ops\":%llu,\"soak_s\":%.1f,\"lp_slots\":%u,\"lp_lockfree\":%u,\"lp_magazine\":%u}\n",
+           (unsigned long long)s_seed, (unsigned long long)s_ops, s_soak_s,
+           (unsigned)CONFIG_CORE_LEASEPOOL_SLOTS, (unsigned)CONFIG_CORE_LEASEPOOL_LOCKFREE,
+           (unsigned)CONFIG_CORE_LEASEPOOL_MAGAZINE_SIZE);
+
+    if (enabled_("spsc_bytes")) stress_spsc_bytes_();
+    if (enabled_("spsc_records")) stress_spsc_records_(false);
+    if (enabled_("spsc_wait")) stress_spsc_records_(true);
+    if (enabled_("spsc_overwrite")) stress_spsc_overwrite_();
+    if (enabled_("mpsc")) stress_mpsc_();
+    if (enabled_("lp_handoff")) stress_lp_handoff_();
+    if (enabled_("ev_fanout")) stress_ev_fanout_();
+    if (enabled_("ev_churn")) stress_ev_churn_();
+
+    const uint32_t errors = __atomic_load_n(&s_errors, __ATOMIC_RELAXED);
+    if (errors) fprintf(stderr, "core_stress: %u error(s), seed=%llu\n", (unsigned)errors, (unsigned long long)s_seed);
+    return errors ? 1 : 0;
+}
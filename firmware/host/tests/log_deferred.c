@@ -0,0 +1,204 @@
+/*
+ * log_deferred — test odroczonego logowania na hoście (ctest).
+ *
+ *  - kodek: infra_log_dfr_pack + infra_log_dfr_format daje to samo co vsnprintf
+ *    dla tabeli formatów (modyfikatory, '*', %s z precyzją, %p, double, %%),
+ *  - ucinanie: napis dłuższy niż CONFIG_INFRA_LOG_DEFERRED_STR_MAX, rekord za długi
+ *    (flaga TRUNC, brakujące argumenty jako "?"),
+ *  - ring: 4 producentów infra_log_deferred_vwrite <-> konsument infra_log_deferred_read,
+ *    numeracja per producent rośnie, odczytane + dropy == zapisane.
+ */
+#include "sdkconfig.h"
+#include "infra_log_deferred.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t s_errors = 0;
+
+static uint8_t vpack_(uint8_t* dst, const size_t max, size_t* n, const char* fmt, va_list ap)
+{
+    return infra_log_dfr_pack(dst, max, n, fmt, ap);
+}
+
+__attribute__((format(printf, 1, 2)))
+static void check_(const char* fmt, ...)
+{
+    char want[256], got[256];
+    uint8_t args[256];
+    size_t n = 0;
+
+    va_list ap;
+    va_start(ap, fmt);
+    (void)vsnprintf(want, sizeof(want), fmt, ap);
+    va_end(ap);
+
+    va_start(ap, fmt);
+    const uint8_t flags = vpack_(args, sizeof(args), &n, fmt, ap);
+    va_end(ap);
+
+    (void)infra_log_dfr_format(got, sizeof(got), fmt, args, n);
+    if (flags != 0u || strcmp(want, got) != 0) {
+        fprintf(stderr, "log_deferred: \"%s\": want \"%s\" got \"%s\" (flags=%u)\n", fmt, want, got, flags);
+        s_errors++;
+    }
+}
+
+/* Jak check_, ale z małym buforem argumentów i oczekiwanym wynikiem podanym wprost. */
+__attribute__((format(printf, 3, 4)))
+static void check_trunc_(const size_t max, const char* want, const char* fmt, ...)
+{
+    char got[256];
+    uint8_t args[256];
+    size_t n = 0;
+
+    va_list ap;
+    va_start(ap, fmt);
+    const uint8_t flags = vpack_(args, max, &n, fmt, ap);
+    va_end(ap);
+
+    (void)infra_log_dfr_format(got, sizeof(got), fmt, args, n);
+    if (strcmp(want, got) != 0 || n > max) {
+        fprintf(stderr, "log_deferred: trunc \"%s\": want \"%s\" got \"%s\" (flags=%u n=%zu)\n", fmt, want, got, flags, n);
+        s_errors++;
+    }
+}
+
+static void test_codec_(void)
+{
+    int local = 0;
+
+    check_("plain text, no args");
+    check_("%d %i %u %x %X %o", -42, 7, 3000000000u, 0xBEEFu, 0xCAFEu, 8u);
+    check_("[%5d] [%-5d] [%05d] [%+d] [% d] [%#x] [%#o]", 42, 42, 42, 42, 42, 255u, 8u);
+    check_("%hhd %hd %hhu %hu", (signed char)-3, (short)-300, (unsigned char)250, (unsigned short)65000);
+    check_("%ld %lu %lld %llu %llx", -123456789L, 123456789UL, -1234567890123LL, 9876543210ULL, 0xDEADBEEFCAFEULL);
+    check_("%zu %zd %td %jd %ju", (size_t)12345, (ptrdiff_t)-5, (ptrdiff_t)77, (intmax_t)-99, (uintmax_t)99);
+    check_("[%*d] [%-*d] [%.*d] [%*.*d]", 6, 1, 6, 2, 4, 3, 7, 5, 4);
+    check_("%c%c%c %5c", 'a', 'b', 'c', 'z');
+    check_("%f %.2f %10.3f %e %g %G %a", 3.14159, 2.5, -1.0 / 3.0, 12345.678, 0.0001, 1e20, 1.0);
+    check_("%Lf", (long double)1.25);
+    check_("%s|%10s|%-10s|%.3s|%.*s", "abc", "right", "left", "truncate", 2, "xyz");
+    check_("%p %p", (void*)&local, (void*)NULL);
+    check_("100%% done, %d%%", 5);
+    check_("tag=%s rx=%u len=%u crc=%08x t=%.1f", "UART", 17u, 128u, 0x1234ABCDu, 21.5);
+}
+
+static void test_trunc_(void)
+{
+    // Napis dłuższy niż STR_MAX: kopiowany jest tylko początek.
+    char longs[CONFIG_INFRA_LOG_DEFERRED_STR_MAX + 20];
+    memset(longs, 'S', sizeof(longs) - 1u);
+    longs[sizeof(longs) - 1u] = '\0';
+    char want[sizeof(longs) + 8];
+    snprintf(want, sizeof(want), "<%.*s>", (int)CONFIG_INFRA_LOG_DEFERRED_STR_MAX, longs);
+    check_trunc_(256, want, "<%s>", longs);
+
+    // 8 B na argumenty: dwa inty wchodzą, trzeci i napis nie.
+    check_trunc_(8, "1 2 ? ?", "%d %d %d %s", 1, 2, 3, "x");
+    // Napis jako ostatni mieszczący się argument: ucięty do dostępnego miejsca.
+    check_trunc_(7, "9 ab", "%d %s", 9, "abcdef");
+
+    // NULL jako %s: zapisywany jako "(null)" (vsnprintf w glibc robi to samo, newlib też).
+    const char* volatile null_str = NULL;
+    check_trunc_(256, "[(null)]", "[%s]", null_str);
+
+    // Brak miejsca na argumenty: sam tekst, konwersje jako "?".
+    check_trunc_(0, "no args ?", "no args %d", 1);
+}
+
+/* ===================== ring ===================== */
+
+enum { PRODUCERS = 4, PER_PRODUCER = 20000 };
+
+static bool dfr_write_(const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    const bool ok = infra_log_deferred_vwrite(2, 1234u, "TEST", fmt, ap);
+    va_end(ap);
+    return ok;
+}
+
+static uint32_t s_written[PRODUCERS];
+static uint32_t s_done = 0; /* atomik: producenci, którzy skończyli */
+
+static void* producer_(void* arg)
+{
+    const unsigned id = (unsigned)(uintptr_t)arg;
+    for (unsigned i = 0; i < PER_PRODUCER; i++) {
+        // Przy pełnym ringu ponawiamy kilka razy (część i tak wpadnie w drop — to też liczymy).
+        bool ok = false;
+        for (int t = 0; t < 8 && !ok; t++) {
+            ok = dfr_write_("p%u n%u s=%s", id, i, (i & 1u) ? "odd" : "even");
+            if (!ok) (void)sched_yield();
+        }
+        if (ok) s_written[id]++;
+    }
+    __atomic_add_fetch(&s_done, 1u, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void test_ring_(void)
+{
+    infra_log_deferred_init();
+    const uint32_t drops0 = infra_log_deferred_drop_count();
+
+    pthread_t th[PRODUCERS];
+    for (uintptr_t i = 0; i < PRODUCERS; i++) pthread_create(&th[i], NULL, producer_, (void*)i);
+
+    long last[PRODUCERS];
+    for (size_t i = 0; i < PRODUCERS; i++) last[i] = -1;
+    uint32_t got = 0;
+    for (;;) {
+        const bool done = __atomic_load_n(&s_done, __ATOMIC_ACQUIRE) == PRODUCERS;
+        infra_log_dfr_hdr_t h;
+        char msg[96];
+        size_t len = 0;
+        if (!infra_log_deferred_read(&h, msg, sizeof(msg), &len)) {
+            if (done) break;
+            (void)sched_yield();
+            continue;
+        }
+
+        unsigned id = 0, n = 0;
+        char s[8] = "";
+        if (h.lvl != 2u || h.ts_ms != 1234u || strcmp(h.tag, "TEST") != 0 ||
+            sscanf(msg, "p%u n%u s=%7s", &id, &n, s) != 3 || id >= PRODUCERS || (long)n <= last[id] ||
+            strcmp(s, (n & 1u) ? "odd" : "even") != 0 || len != strlen(msg)) {
+            fprintf(stderr, "log_deferred: bad record \"%s\"\n", msg);
+            s_errors++;
+        } else {
+            last[id] = (long)n;
+        }
+        got++;
+    }
+    for (size_t i = 0; i < PRODUCERS; i++) pthread_join(th[i], NULL);
+
+    uint32_t written = 0;
+    for (size_t i = 0; i < PRODUCERS; i++) written += s_written[i];
+    const uint32_t drops = infra_log_deferred_drop_count() - drops0;
+    if (got != written || written + drops < (uint32_t)PRODUCERS * PER_PRODUCER) {
+        fprintf(stderr, "log_deferred: ring got=%u written=%u drops=%u\n", got, written, drops);
+        s_errors++;
+    }
+}
+
+int main(void)
+{
+    test_codec_();
+    test_trunc_();
+    test_ring_();
+
+    if (s_errors) {
+        fprintf(stderr, "log_deferred: %u error(s)\n", s_errors);
+        return 1;
+    }
+    printf("log_deferred: OK\n");
+    return 0;
+}
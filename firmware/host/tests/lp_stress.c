@@ -0,0 +1,147 @@
+/*
+ * lp_stress — wielowątkowy test LeasePool na hoście (ctest).
+ *
+ * Wątki naprzemiennie:
+ *  - alloc (co któryś raz łańcuchowy, kilka slotów) + wypełnienie wzorcem (idx^gen)
+ *    + commit, czasem addref i wystawienie uchwytu do wspólnej skrzynki (mailbox),
+ *  - wymiana uchwytu ze skrzynki, acquire, weryfikacja wzorca i długości, release;
+ *  - wątek 0 co jakiś czas robi lp_scrub_step() (tryb SCRUB guardu).
+ * Na końcu pula musi być pusta (used == 0), lp_check() bez błędów, a guardy
+ * (canary/poison/magic) nie mogą zgłosić naruszenia (abort).
+ *
+ * Użycie: lp_stress [iters_per_thread]
+ */
+#include "sdkconfig.h"
+#include "core/leasepool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { THREADS = 4, MAILBOXES = 8 };
+
+#define MB_EMPTY 0xFFFFFFFFu
+
+static uint32_t s_mailbox[MAILBOXES];
+static uint32_t s_errors = 0;
+static uint64_t s_iters = 200000u;
+
+static uint8_t pattern_(lp_handle_t h)
+{
+    return (uint8_t)(h.idx ^ h.gen ^ (h.gen >> 8));
+}
+
+static void fail_(const char* why, lp_handle_t h)
+{
+    fprintf(stderr, "lp_stress: %s (idx=0x%04X gen=%u)\n", why, (unsigned)h.idx, (unsigned)h.gen);
+    __atomic_add_fetch(&s_errors, 1u, __ATOMIC_RELAXED);
+}
+
+enum { MAX_SEGS = 8 };
+
+static void verify_and_release_(lp_handle_t h)
+{
+    lp_iov_t iov[MAX_SEGS];
+    const size_t n = lp_acquire_iov(h, iov, MAX_SEGS);
+    if (n == 0 || n > MAX_SEGS) {
+        fail_("acquire failed on held handle", h);
+        return;
+    }
+    const uint8_t pat = pattern_(h);
+    for (size_t s = 0; s < n; s++) {
+        const uint8_t* p = iov[s].ptr;
+        if (iov[s].len == 0 || iov[s].len > iov[s].cap) fail_("bad len", h);
+        for (uint32_t i = 0; i < iov[s].len; i++) {
+            if (p[i] != pat) {
+                fail_("payload corrupted", h);
+                break;
+            }
+        }
+    }
+    lp_release(h);
+}
+
+static void* worker_(void* arg)
+{
+    uint32_t rng = (uint32_t)(uintptr_t)arg * 2654435761u + 1u;
+
+    for (uint64_t i = 0; i < s_iters; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        const bool chain = (rng & 0x7000u) == 0u;
+        const uint32_t want = 1u + (rng >> 8) % (CONFIG_CORE_LEASEPOOL_SLOT_BYTES * (chain ? 3u : 1u));
+
+        lp_handle_t h = chain ? lp_alloc_chain_try(want) : lp_alloc_try(want);
+        if (lp_handle_is_valid(h)) {
+            lp_iov_t iov[MAX_SEGS];
+            const size_t n = lp_acquire_iov(h, iov, MAX_SEGS);
+            if (n == 0 || n > MAX_SEGS) {
+                fail_("acquire after alloc", h);
+                continue;
+            }
+            uint32_t left = want;
+            for (size_t s = 0; s < n && left > 0; s++) {
+                const uint32_t k = left < iov[s].cap ? left : iov[s].cap;
+                memset(iov[s].ptr, pattern_(h), k);
+                left -= k;
+            }
+            lp_commit(h, want);
+
+            // Udostępnij kopię innym wątkom (addref), własną referencję zweryfikuj i oddaj.
+            if (rng & 0x10000u) {
+                lp_addref_n(h, 1);
+                const uint32_t slot = (rng >> 20) % MAILBOXES;
+                const uint32_t old = __atomic_exchange_n(&s_mailbox[slot], lp_pack_handle_u32(h), __ATOMIC_ACQ_REL);
+                if (old != MB_EMPTY) verify_and_release_(lp_unpack_handle_u32(old));
+            }
+            verify_and_release_(h);
+        }
+
+        // Odbierz cudzy uchwyt ze skrzynki.
+        const uint32_t slot = (rng >> 24) % MAILBOXES;
+        const uint32_t got = __atomic_exchange_n(&s_mailbox[slot], MB_EMPTY, __ATOMIC_ACQ_REL);
+        if (got != MB_EMPTY) verify_and_release_(lp_unpack_handle_u32(got));
+
+        if ((i & 255u) == 0u) {
+            // Scrubber guardów (tryb SCRUB; w innych no-op) współbieżnie z alloc/release.
+            if (arg == NULL) (void)lp_scrub_step(0);
+            (void)sched_yield();
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) s_iters = strtoull(argv[1], NULL, 10);
+
+    lp_init();
+    for (size_t i = 0; i < MAILBOXES; i++) s_mailbox[i] = MB_EMPTY;
+
+    pthread_t th[THREADS];
+    for (uintptr_t t = 0; t < THREADS; t++) {
+        if (pthread_create(&th[t], NULL, worker_, (void*)t) != 0) {
+            fprintf(stderr, "lp_stress: pthread_create failed\n");
+            return 1;
+        }
+    }
+    for (size_t t = 0; t < THREADS; t++) pthread_join(th[t], NULL);
+
+    for (size_t i = 0; i < MAILBOXES; i++) {
+        if (s_mailbox[i] != MB_EMPTY) verify_and_release_(lp_unpack_handle_u32(s_mailbox[i]));
+    }
+
+    lp_stats_t st;
+    lp_get_stats(&st);
+    const int issues = lp_check(false);
+
+    printf("lp_stress: threads=%u iters=%llu alloc_ok=%u fails=%u used=%u peak=%u scrubbed=%u issues=%d errors=%u\n",
+           (unsigned)THREADS, (unsigned long long)s_iters, (unsigned)st.alloc_ok,
+           (unsigned)st.drops_alloc_fail, (unsigned)st.slots_used, (unsigned)st.slots_peak_used,
+           (unsigned)st.guard_scrubbed, issues, (unsigned)s_errors);
+
+    return (s_errors == 0 && st.slots_used == 0 && issues == 0 && st.guard_failures == 0) ? 0 : 1;
+}
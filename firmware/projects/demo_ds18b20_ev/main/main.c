@@ -34,7 +34,7 @@ void app_main(void)
     ev_msg_t m;
     for (;;)
     {
-        if (xQueueReceive(q, &m, portMAX_DELAY) == pdTRUE)
+        if (ev_bus_recv(bus, q, &m, portMAX_DELAY))
         {
             if (m.src == EV_SRC_DS18 && m.code == EV_DS18_READY)
             {
@@ -30,7 +30,7 @@ void app_main(void)
     ev_msg_t m;
     for (;;)
     {
-        if (xQueueReceive(q, &m, portMAX_DELAY) == pdTRUE)
+        if (ev_bus_recv(bus, q, &m, portMAX_DELAY))
         {
             if (m.src == EV_SRC_TIMER && m.code == EV_TICK_1S)
             {
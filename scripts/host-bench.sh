@@ -0,0 +1,18 @@
+#!/usr/bin/env bash
+set -Eeuo pipefail
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+
+# Build hosta (Linux, bez ESP-IDF/Dockera) + benchmarki core w formacie JSON Lines.
+# Użycie:
+#   scripts/host-bench.sh                     # pełny przebieg -> stdout
+#   scripts/host-bench.sh --quick             # szybki smoke
+#   scripts/host-bench.sh --filter ev_post    # tylko wybrane (prefiks nazwy)
+#   BUILD_DIR=/tmp/bh HOST_SDKCONFIG_DEFS="CONFIG_CORE_LEASEPOOL_GUARD=0" scripts/host-bench.sh
+BUILD_DIR="${BUILD_DIR:-${ROOT}/build-host}"
+
+cmake -S "${ROOT}/firmware/host" -B "${BUILD_DIR}" \
+      -DCMAKE_BUILD_TYPE=Release \
+      -DHOST_SDKCONFIG_DEFS="${HOST_SDKCONFIG_DEFS:-}" >&2
+cmake --build "${BUILD_DIR}" -j"$(nproc)" >&2
+
+exec "${BUILD_DIR}/core_bench" "$@"
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Dekoder odroczonych logów (CONFIG_INFRA_LOG_DEFERRED bez taska formatującego).
+
+Wejście: wyjście monitora z liniami "DFR:<hex>" (komenda `logrb dfr`); pozostałe linie
+przechodzą bez zmian. Rekord = nagłówek (ts u32, poziom u8, flagi u8, długość argumentów u16,
+adres formatu, adres tagu) + argumenty zakodowane wg infra_log_deferred.h. Format i tag
+czytamy z sekcji ELF (ten sam build co na urządzeniu), wynik jak esp_log: "I (ts) TAG: treść".
+
+Użycie:
+  scripts/log-decode.py --elf build/<app>.elf < monitor.log
+  idf.py monitor | scripts/log-decode.py --elf build/<app>.elf
+Wymaga pyelftools (jest w środowisku ESP-IDF).
+"""
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.constants import SH_FLAGS
+from elftools.elf.elffile import ELFFile
+
+LEVELS = "EWIDV"
+TRUNC = 0x01
+SPEC = re.compile(r"%([-+ #0']*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diuxXoscpaAeEfFgGn%])")
+
+
+class ElfStrings:
+    """Napisy zakończone NUL spod adresów z sekcji ładowanych (rodata, DROM)."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            elf = ELFFile(f)
+            self.sections = [
+                (s["sh_addr"], s.data())
+                for s in elf.iter_sections()
+                if s["sh_flags"] & SH_FLAGS.SHF_ALLOC and s["sh_type"] != "SHT_NOBITS" and s["sh_addr"]
+            ]
+
+    def cstr(self, addr):
+        if addr == 0:
+            return None
+        for base, data in self.sections:
+            if base <= addr < base + len(data):
+                off = addr - base
+                end = data.find(b"\0", off)
+                return data[off:end if end >= 0 else len(data)].decode("utf-8", "replace")
+        return None
+
+
+class Args:
+    def __init__(self, data):
+        self.data = data
+        self.off = 0
+
+    def take(self, n):
+        if self.off + n > len(self.data):
+            self.off = len(self.data)
+            return None
+        b = self.data[self.off:self.off + n]
+        self.off += n
+        return b
+
+    def int(self, size, signed):
+        b = self.take(size)
+        return None if b is None else int.from_bytes(b, "little", signed=signed)
+
+
+def int_size(mod, ptr_size):
+    return {"l": ptr_size, "ll": 8, "j": 8, "z": ptr_size, "t": ptr_size}.get(mod, 4)
+
+
+def format_one(m, args, ptr_size):
+    flags, width, prec, mod, conv = m.group(1), m.group(2), m.group(3), m.group(4) or "", m.group(5)
+    if conv == "%":
+        return "%"
+    if width == "*":
+        width = args.int(4, True)
+        if width is None:
+            return "?"
+        width = str(width)
+    if prec == "*":
+        prec = args.int(4, True)
+        if prec is None:
+            return "?"
+        prec = str(prec) if prec >= 0 else None
+    spec = "%" + flags.replace("'", "") + (width or "") + ("." + prec if prec is not None else "")
+
+    if conv in "diuxXoc":
+        size = 4 if conv == "c" else int_size(mod, ptr_size)
+        v = args.int(size, conv in "di")
+        if v is None:
+            return "?"
+        if conv == "c":
+            return (spec + "c") % chr(v & 0xFF)
+        bits = {"hh": 8, "h": 16}.get(mod)
+        if bits:
+            v &= (1 << bits) - 1
+            if conv in "di" and v >= 1 << (bits - 1):
+                v -= 1 << bits
+        return (spec + ("d" if conv in "diu" else conv)) % v
+    if conv in "aAeEfFgG":
+        b = args.take(8)
+        if b is None:
+            return "?"
+        v = struct.unpack("<d", b)[0]
+        return v.hex() if conv in "aA" else (spec + conv) % v
+    if conv == "p":
+        v = args.int(ptr_size, False)
+        return "?" if v is None else (spec + "s") % ("0x%x" % v)
+    if conv == "s":
+        n = args.take(1)
+        b = None if n is None else args.take(n[0])
+        return "?" if b is None else (spec + "s") % b.decode("utf-8", "replace")
+    return ""  # %n
+
+
+def decode(raw, strings, ptr_size):
+    p = "I" if ptr_size == 4 else "Q"
+    hdr = struct.Struct("<IBBH" + p + p)
+    if len(raw) < hdr.size:
+        return None
+    ts, lvl, flags, args_len, fmt_addr, tag_addr = hdr.unpack_from(raw)
+    fmt = strings.cstr(fmt_addr)
+    tag = strings.cstr(tag_addr) or ""
+    if fmt is None:
+        return "? (%u) %s: <format 0x%x poza ELF — inny build?>" % (ts, tag, fmt_addr)
+
+    args = Args(raw[hdr.size:hdr.size + args_len])
+    msg = SPEC.sub(lambda m: format_one(m, args, ptr_size), fmt)
+    if flags & TRUNC:
+        msg += " [args truncated]"
+    level = LEVELS[lvl] if lvl < len(LEVELS) else "?"
+    return "%s (%u) %s: %s" % (level, ts, tag, msg)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--elf", required=True, help="ELF aplikacji (ten sam build, który zapisał rekordy)")
+    ap.add_argument("--ptr-size", type=int, default=4, choices=(4, 8), help="rozmiar wskaźnika/long (ESP32: 4)")
+    ap.add_argument("input", nargs="?", type=argparse.FileType("r"), default=sys.stdin)
+    opt = ap.parse_args()
+
+    strings = ElfStrings(opt.elf)
+    for line in opt.input:
+        idx = line.find("DFR:")
+        if idx < 0:
+            sys.stdout.write(line)
+            continue
+        try:
+            raw = bytes.fromhex(line[idx + 4:].strip())
+        except ValueError:
+            sys.stdout.write(line)
+            continue
+        out = decode(raw, strings, opt.ptr_size)
+        sys.stdout.write((out if out is not None else line.rstrip("\n")) + "\n")
+
+
+if __name__ == "__main__":
+    main()